@@ -51,6 +51,8 @@ while [ "$STEP" -lt "$STEPS" ]; do
                 || fail "Alignment died"
             mv -f "$TMP_PATH/aln_new" "$TMP_PATH/aln_${SENSE_0}"
             mv -f "$TMP_PATH/aln_new.index" "$TMP_PATH/aln_${SENSE_0}.index"
+            mv -f "$TMP_PATH/aln_new.index.bin" "$TMP_PATH/aln_${SENSE_0}.index.bin" 2>/dev/null || rm -f "$TMP_PATH/aln_${SENSE_0}.index.bin"
+            mv -f "$TMP_PATH/aln_new.dbtype" "$TMP_PATH/aln_${SENSE_0}.dbtype" 2>/dev/null || rm -f "$TMP_PATH/aln_${SENSE_0}.dbtype"
             touch "$TMP_PATH/aln_${SENS}.hasmerge"
         fi
     fi
@@ -77,6 +79,8 @@ done
 # post processing
 (mv -f "$TMP_PATH/aln_${SENSE_0}" "$3" && mv -f "$TMP_PATH/aln_${SENSE_0}.index" "$3.index" ) \
     || fail "Could not move result to $3"
+mv -f "$TMP_PATH/aln_${SENSE_0}.index.bin" "$3.index.bin" 2>/dev/null || rm -f "$3.index.bin"
+mv -f "$TMP_PATH/aln_${SENSE_0}.dbtype" "$3.dbtype" 2>/dev/null || rm -f "$3.dbtype"
 
 if [ -n "$REMOVE_TMP" ]; then
     echo "Remove temporary files"
@@ -84,10 +88,10 @@ if [ -n "$REMOVE_TMP" ]; then
     while [ "$STEP" -lt "$STEPS" ]; do
         SENS_PARAM=SENSE_${STEP}
         eval SENS="\$$SENS_PARAM"
-        rm -f "$TMP_PATH/pref_$SENS" "$TMP_PATH/pref_$SENS.index"
-        rm -f "$TMP_PATH/aln_$SENS" "$TMP_PATH/aln_$SENS.index"
+        rm -f "$TMP_PATH/pref_$SENS" "$TMP_PATH/pref_$SENS.index" "$TMP_PATH/pref_$SENS.index.bin"
+        rm -f "$TMP_PATH/aln_$SENS" "$TMP_PATH/aln_$SENS.index" "$TMP_PATH/aln_$SENS.index.bin"
         NEXTINPUT="$TMP_PATH/input_step$SENS"
-        rm -f "$TMP_PATH/input_step$SENS" "$TMP_PATH/input_step$SENS.index"
+        rm -f "$TMP_PATH/input_step$SENS" "$TMP_PATH/input_step$SENS.index" "$TMP_PATH/input_step$SENS.index.bin"
         STEP=$((STEP+1))
     done
 
@@ -42,6 +42,8 @@ while [ $STEP -lt $NUM_IT ]; do
                 || fail "Substract died"
             mv -f "$TMP_PATH/pref_next_$STEP" "$TMP_PATH/pref_$STEP"
             mv -f "$TMP_PATH/pref_next_$STEP.index" "$TMP_PATH/pref_$STEP.index"
+            mv -f "$TMP_PATH/pref_next_$STEP.index.bin" "$TMP_PATH/pref_$STEP.index.bin" 2>/dev/null || rm -f "$TMP_PATH/pref_$STEP.index.bin"
+            mv -f "$TMP_PATH/pref_next_$STEP.dbtype" "$TMP_PATH/pref_$STEP.dbtype" 2>/dev/null || rm -f "$TMP_PATH/pref_$STEP.dbtype"
             touch "$TMP_PATH/pref_$STEP.hasnext"
         fi
     fi
@@ -61,6 +63,8 @@ while [ $STEP -lt $NUM_IT ]; do
                 || fail "Merge died"
             mv -f "$TMP_PATH/aln_new" "$TMP_PATH/aln_0"
             mv -f "$TMP_PATH/aln_new.index" "$TMP_PATH/aln_0.index"
+            mv -f "$TMP_PATH/aln_new.index.bin" "$TMP_PATH/aln_0.index.bin" 2>/dev/null || rm -f "$TMP_PATH/aln_0.index.bin"
+            mv -f "$TMP_PATH/aln_new.dbtype" "$TMP_PATH/aln_0.dbtype" 2>/dev/null || rm -f "$TMP_PATH/aln_0.dbtype"
             touch "$TMP_PATH/aln_$STEP.hasmerge"
         fi
     fi
@@ -82,14 +86,16 @@ done
 # post processing
 STEP=$((STEP-1))
 (mv -f "$TMP_PATH/aln_0" "$3" && mv -f "$TMP_PATH/aln_0.index" "$3.index") || fail "Could not move result to $3"
+mv -f "$TMP_PATH/aln_0.index.bin" "$3.index.bin" 2>/dev/null || rm -f "$3.index.bin"
+mv -f "$TMP_PATH/aln_0.dbtype" "$3.dbtype" 2>/dev/null || rm -f "$3.dbtype"
 
 if [ -n "$REMOVE_TMP" ]; then
  echo "Remove temporary files"
  STEP=0
  while [ "$STEP" -lt "$NUM_IT" ]; do
-    rm -f "$TMP_PATH/pref_$STEP" "$TMP_PATH/pref_$STEP.index"
-    rm -f "$TMP_PATH/aln_$STEP" "$TMP_PATH/aln_$STEP.index"
-    rm -f "$TMP_PATH/profile_$STEP" "$TMP_PATH/profile_$STEP.index" "$TMP_PATH/profile_${STEP}_h" "$TMP_PATH/profile_${STEP}_h.index"
+    rm -f "$TMP_PATH/pref_$STEP" "$TMP_PATH/pref_$STEP.index" "$TMP_PATH/pref_$STEP.index.bin"
+    rm -f "$TMP_PATH/aln_$STEP" "$TMP_PATH/aln_$STEP.index" "$TMP_PATH/aln_$STEP.index.bin"
+    rm -f "$TMP_PATH/profile_$STEP" "$TMP_PATH/profile_$STEP.index" "$TMP_PATH/profile_$STEP.index.bin" "$TMP_PATH/profile_${STEP}_h" "$TMP_PATH/profile_${STEP}_h.index" "$TMP_PATH/profile_${STEP}_h.index.bin"
     STEP=$((STEP+1))
  done
 
@@ -81,19 +81,21 @@ done
 # post processing
 mv -f "${TMP_PATH}/clu" "$2" || fail "Could not move result to $2"
 mv -f "${TMP_PATH}/clu.index" "$2.index" || fail "Could not move result to $2"
+mv -f "${TMP_PATH}/clu.index.bin" "$2.index.bin" 2>/dev/null || rm -f "$2.index.bin"
+mv -f "${TMP_PATH}/clu.dbtype" "$2.dbtype" 2>/dev/null || rm -f "$2.dbtype"
 
 if [ -n "$REMOVE_TMP" ]; then
  echo "Remove temporary files"
  rm -f "${TMP_PATH}/order_redundancy"
- rm -f "${TMP_PATH}/clu_redundancy" "${TMP_PATH}/clu_redundancy.index"
- rm -f "${TMP_PATH}/aln_redundancy" "${TMP_PATH}/aln_redundancy.index"
- rm -f "${TMP_PATH}/input_step_redundancy" "${TMP_PATH}/input_step_redundancy.index"
+ rm -f "${TMP_PATH}/clu_redundancy" "${TMP_PATH}/clu_redundancy.index" "${TMP_PATH}/clu_redundancy.index.bin"
+ rm -f "${TMP_PATH}/aln_redundancy" "${TMP_PATH}/aln_redundancy.index" "${TMP_PATH}/aln_redundancy.index.bin"
+ rm -f "${TMP_PATH}/input_step_redundancy" "${TMP_PATH}/input_step_redundancy.index" "${TMP_PATH}/input_step_redundancy.index.bin"
  STEP=0
  while [ "$STEP" -lt "$STEPS" ]; do
-    rm -f "${TMP_PATH}/pref_step$STEP" "${TMP_PATH}/pref_step$STEP.index"
-    rm -f "${TMP_PATH}/aln_step$STEP" "${TMP_PATH}/aln_step$STEP.index"
-    rm -f "${TMP_PATH}/clu_step$STEP" "${TMP_PATH}/clu_step$STEP.index"
-    rm -f "${TMP_PATH}/input_step$STEP" "${TMP_PATH}/input_step$STEP.index"
+    rm -f "${TMP_PATH}/pref_step$STEP" "${TMP_PATH}/pref_step$STEP.index" "${TMP_PATH}/pref_step$STEP.index.bin"
+    rm -f "${TMP_PATH}/aln_step$STEP" "${TMP_PATH}/aln_step$STEP.index" "${TMP_PATH}/aln_step$STEP.index.bin"
+    rm -f "${TMP_PATH}/clu_step$STEP" "${TMP_PATH}/clu_step$STEP.index" "${TMP_PATH}/clu_step$STEP.index.bin"
+    rm -f "${TMP_PATH}/input_step$STEP" "${TMP_PATH}/input_step$STEP.index" "${TMP_PATH}/input_step$STEP.index.bin"
     rm -f "${TMP_PATH}/order_step$STEP"
 	STEP=$((STEP+1))
  done
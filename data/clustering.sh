@@ -67,12 +67,12 @@ fi
 
 if [ -n "$REMOVE_TMP" ]; then
     echo "Remove temporary files"
-    rm -f "${TMP_PATH}/pref" "${TMP_PATH}/pref.index"
-    rm -f "${TMP_PATH}/aln" "${TMP_PATH}/aln.index"
-    rm -f "${TMP_PATH}/clu_step0" "${TMP_PATH}/clu_step0.index"
+    rm -f "${TMP_PATH}/pref" "${TMP_PATH}/pref.index" "${TMP_PATH}/pref.index.bin"
+    rm -f "${TMP_PATH}/aln" "${TMP_PATH}/aln.index" "${TMP_PATH}/aln.index.bin"
+    rm -f "${TMP_PATH}/clu_step0" "${TMP_PATH}/clu_step0.index" "${TMP_PATH}/clu_step0.index.bin"
     rm -f "${TMP_PATH}/order_redundancy"
-    rm -f "${TMP_PATH}/clu_redundancy" "${TMP_PATH}/clu_redundancy.index"
-    rm -f "${TMP_PATH}/aln_redundancy" "${TMP_PATH}/aln_redundancy.index"
-    rm -f "${TMP_PATH}/input_step_redundancy" "${TMP_PATH}/input_step_redundancy.index"
+    rm -f "${TMP_PATH}/clu_redundancy" "${TMP_PATH}/clu_redundancy.index" "${TMP_PATH}/clu_redundancy.index.bin"
+    rm -f "${TMP_PATH}/aln_redundancy" "${TMP_PATH}/aln_redundancy.index" "${TMP_PATH}/aln_redundancy.index.bin"
+    rm -f "${TMP_PATH}/input_step_redundancy" "${TMP_PATH}/input_step_redundancy.index" "${TMP_PATH}/input_step_redundancy.index.bin"
     rm -f "${TMP_PATH}/clustering.sh"
 fi
@@ -63,10 +63,10 @@ mv "${TMP_PATH}/cluster.tsv"  "${RESULTS}_cluster.tsv"
 
 if [ -n "${REMOVE_TMP}" ]; then
     echo "Removing temporary files"
-    rm -f "${TMP_PATH}/input" "${TMP_PATH}/input.index"
-    rm -f "${TMP_PATH}/clu_seqs" "${TMP_PATH}/clu_seqs.index"
-    rm -f "${TMP_PATH}/clu_rep" "${TMP_PATH}/clu_rep.index"
-    rm -f "${TMP_PATH}/clu" "${TMP_PATH}/clu.index"
+    rm -f "${TMP_PATH}/input" "${TMP_PATH}/input.index" "${TMP_PATH}/input.index.bin"
+    rm -f "${TMP_PATH}/clu_seqs" "${TMP_PATH}/clu_seqs.index" "${TMP_PATH}/clu_seqs.index.bin"
+    rm -f "${TMP_PATH}/clu_rep" "${TMP_PATH}/clu_rep.index" "${TMP_PATH}/clu_rep.index.bin"
+    rm -f "${TMP_PATH}/clu" "${TMP_PATH}/clu.index" "${TMP_PATH}/clu.index.bin"
     rm -rf "${TMP_PATH}/clu_tmp"
     rm -f "${TMP_PATH}/easycluster.sh"
 fi
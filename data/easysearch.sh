@@ -61,20 +61,22 @@ fi
 mv -f "${TMP_PATH}/alis" "${RESULTS}" || fail "Could not move result to ${RESULTS}"
 if [ -f "${TMP_PATH}/alis.index" ]; then
     mv -f "${TMP_PATH}/alis.index" "${RESULTS}.index" || fail "Could not move result index to ${RESULTS}"
+    mv -f "${TMP_PATH}/alis.index.bin" "${RESULTS}.index.bin" 2>/dev/null || rm -f "${RESULTS}.index.bin"
+    mv -f "${TMP_PATH}/alis.dbtype" "${RESULTS}.dbtype" 2>/dev/null || rm -f "${RESULTS}.dbtype"
 fi
 
 
 if [ -n "${REMOVE_TMP}" ]; then
     echo "Removing temporary files"
     if [ -n "${GREEDY_BEST_HITS}" ]; then
-        rm -f "${TMP_PATH}/result_best" "${TMP_PATH}/result_best.index"
+        rm -f "${TMP_PATH}/result_best" "${TMP_PATH}/result_best.index" "${TMP_PATH}/result_best.index.bin"
     fi
-    rm -f "${TMP_PATH}/result" "${TMP_PATH}/result.index"
+    rm -f "${TMP_PATH}/result" "${TMP_PATH}/result.index" "${TMP_PATH}/result.index.bin"
     if [ ! -n "${LEAVE_INPUT}" ]; then
         if [ -f "${TMP_PATH}/target" ]; then
-            rm -f "${TMP_PATH}/target" "${TMP_PATH}/target.index" "${TMP_PATH}/target_h" "${TMP_PATH}/target_h.index" "${TMP_PATH}/target.lookup" "${TMP_PATH}/target.dbtype"
+            rm -f "${TMP_PATH}/target" "${TMP_PATH}/target.index" "${TMP_PATH}/target.index.bin" "${TMP_PATH}/target_h" "${TMP_PATH}/target_h.index" "${TMP_PATH}/target_h.index.bin" "${TMP_PATH}/target.lookup" "${TMP_PATH}/target.dbtype"
         fi
-        rm -f "${TMP_PATH}/query" "${TMP_PATH}/query.index" "${TMP_PATH}/query_h" "${TMP_PATH}/query_h.index" "${TMP_PATH}/query.lookup" "${TMP_PATH}/query.dbtype"
+        rm -f "${TMP_PATH}/query" "${TMP_PATH}/query.index" "${TMP_PATH}/query.index.bin" "${TMP_PATH}/query_h" "${TMP_PATH}/query_h.index" "${TMP_PATH}/query_h.index.bin" "${TMP_PATH}/query.lookup" "${TMP_PATH}/query.dbtype"
     fi
     rm -rf "${TMP_PATH}/search_tmp"
     rm -f "${TMP_PATH}/easysearch.sh"
@@ -87,24 +87,26 @@ fi
 # post processing
 mv -f "${TMP_PATH}/clu" "$2" || fail "Could not move result to $2"
 mv -f "${TMP_PATH}/clu.index" "$2.index" || fail "Could not move result to $2"
+mv -f "${TMP_PATH}/clu.index.bin" "$2.index.bin" 2>/dev/null || rm -f "$2.index.bin"
+mv -f "${TMP_PATH}/clu.dbtype" "$2.dbtype" 2>/dev/null || rm -f "$2.dbtype"
 
 if [ -n "$REMOVE_TMP" ]; then
     echo "Remove temporary files"
-    rm -f "${TMP_PATH}/pref" "${TMP_PATH}/pref.index"
-    rm -f "${TMP_PATH}/pref_rescore1" "${TMP_PATH}/pref_rescore1.index"
-    rm -f "${TMP_PATH}/pre_clust" "${TMP_PATH}/pre_clust.index"
-    rm -f "${TMP_PATH}/input_step_redundancy" "${TMP_PATH}/input_step_redundancy.index" "${TMP_PATH}/order_redundancy"
+    rm -f "${TMP_PATH}/pref" "${TMP_PATH}/pref.index" "${TMP_PATH}/pref.index.bin"
+    rm -f "${TMP_PATH}/pref_rescore1" "${TMP_PATH}/pref_rescore1.index" "${TMP_PATH}/pref_rescore1.index.bin"
+    rm -f "${TMP_PATH}/pre_clust" "${TMP_PATH}/pre_clust.index" "${TMP_PATH}/pre_clust.index.bin"
+    rm -f "${TMP_PATH}/input_step_redundancy" "${TMP_PATH}/input_step_redundancy.index" "${TMP_PATH}/input_step_redundancy.index.bin" "${TMP_PATH}/order_redundancy"
 
-    rm -f "${TMP_PATH}/pref_filter1" "${TMP_PATH}/pref_filter1.index"
-    rm -f "${TMP_PATH}/pref_filter2" "${TMP_PATH}/pref_filter2.index"
+    rm -f "${TMP_PATH}/pref_filter1" "${TMP_PATH}/pref_filter1.index" "${TMP_PATH}/pref_filter1.index.bin"
+    rm -f "${TMP_PATH}/pref_filter2" "${TMP_PATH}/pref_filter2.index" "${TMP_PATH}/pref_filter2.index.bin"
 
     if [ -n "${ALIGN_GAPPED}" ]; then
         if [ -n "$FILTER" ]; then
-            rm -f "${TMP_PATH}/pref_rescore2" "${TMP_PATH}/pref_rescore2.index"
+            rm -f "${TMP_PATH}/pref_rescore2" "${TMP_PATH}/pref_rescore2.index" "${TMP_PATH}/pref_rescore2.index.bin"
         fi
-        rm -f "${TMP_PATH}/aln" "${TMP_PATH}/aln.index"
+        rm -f "${TMP_PATH}/aln" "${TMP_PATH}/aln.index" "${TMP_PATH}/aln.index.bin"
     fi
-    rm -f "${TMP_PATH}/clust" "${TMP_PATH}/clust.index"
+    rm -f "${TMP_PATH}/clust" "${TMP_PATH}/clust.index" "${TMP_PATH}/clust.index.bin"
 
     rm -f "${TMP_PATH}/linclust.sh"
 fi
@@ -19,8 +19,10 @@ fi
 if [ "$("${MMSEQS}" dbtype "${OUTDB}")" = "Nucleotide" ]; then
     mv -f "${OUTDB}" "${OUTDB}_nucl"
     mv -f "${OUTDB}.index" "${OUTDB}_nucl.index"
+    mv -f "${OUTDB}.index.bin" "${OUTDB}_nucl.index.bin" 2>/dev/null || rm -f "${OUTDB}_nucl.index.bin"
     mv -f "${OUTDB}_h" "${OUTDB}_nucl_h"
     mv -f "${OUTDB}_h.index" "${OUTDB}_nucl_h.index"
+    mv -f "${OUTDB}_h.index.bin" "${OUTDB}_nucl_h.index.bin" 2>/dev/null || rm -f "${OUTDB}_nucl_h.index.bin"
     mv -f "${OUTDB}.lookup" "${OUTDB}_nucl.lookup"
     mv -f "${OUTDB}.dbtype" "${OUTDB}_nucl.dbtype"
 
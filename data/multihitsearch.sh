@@ -43,8 +43,8 @@ fi
 if [ -n "${REMOVE_TMP}" ]; then
     echo "Remove temporary files"
     rmdir "${TMP_PATH}/search"
-    rm -f "${TMP_PATH}/result" "${TMP_PATH}/result.index"
-    rm -f "${TMP_PATH}/aggregate" "${TMP_PATH}/aggregate.index"
+    rm -f "${TMP_PATH}/result" "${TMP_PATH}/result.index" "${TMP_PATH}/result.index.bin"
+    rm -f "${TMP_PATH}/aggregate" "${TMP_PATH}/aggregate.index" "${TMP_PATH}/aggregate.index.bin"
     rm -f "${TMP_PATH}/multihitsearch.sh"
 fi
 
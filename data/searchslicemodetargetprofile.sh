@@ -99,6 +99,8 @@ do
     rm -f $TMP_PATH/searchOut.new.sorted{,.index}
     mv -f $TMP_PATH/searchOut.new.sorted.trunc $TMP_PATH/searchOut
     mv -f $TMP_PATH/searchOut.new.sorted.trunc.index $TMP_PATH/searchOut.index
+    mv -f $TMP_PATH/searchOut.new.sorted.trunc.index.bin $TMP_PATH/searchOut.index.bin 2>/dev/null || rm -f $TMP_PATH/searchOut.index.bin
+    mv -f $TMP_PATH/searchOut.new.sorted.trunc.dbtype $TMP_PATH/searchOut.dbtype 2>/dev/null || rm -f $TMP_PATH/searchOut.dbtype
 
 
     # now remove the profiles that reached their eval threshold
@@ -117,6 +119,8 @@ done
 # Save the results
 mv -f $TMP_PATH/searchOut $RESULTS
 mv -f $TMP_PATH/searchOut.index $RESULTS.index
+mv -f $TMP_PATH/searchOut.index.bin $RESULTS.index.bin 2>/dev/null || rm -f $RESULTS.index.bin
+mv -f $TMP_PATH/searchOut.dbtype $RESULTS.dbtype 2>/dev/null || rm -f $RESULTS.dbtype
 
 # Clean up
 #rm -f $TMP_PATH/searchOut.toKeep $TMP_PATH/searchOut.toKeep.index
@@ -48,11 +48,13 @@ fi
 
 # post processing
 (mv -f "${TMP_PATH}/aln" "${RESULTS}"; mv -f "${TMP_PATH}/aln.index" "${RESULTS}.index") || fail "Could not move result to ${RESULTS}"
+mv -f "${TMP_PATH}/aln.index.bin" "${RESULTS}.index.bin" 2>/dev/null || rm -f "${RESULTS}.index.bin"
+mv -f "${TMP_PATH}/aln.dbtype" "${RESULTS}.dbtype" 2>/dev/null || rm -f "${RESULTS}.dbtype"
 
 if [ -n "${REMOVE_TMP}" ]; then
     echo "Remove temporary files"
-    rm -f "${TMP_PATH}/pref" "${TMP_PATH}/pref.index"
-    rm -f "${TMP_PATH}/pref_swapped" "${TMP_PATH}/pref_swapped.index"
-    rm -f "${TMP_PATH}/aln_swapped" "${TMP_PATH}/aln_swapped.index"
+    rm -f "${TMP_PATH}/pref" "${TMP_PATH}/pref.index" "${TMP_PATH}/pref.index.bin"
+    rm -f "${TMP_PATH}/pref_swapped" "${TMP_PATH}/pref_swapped.index" "${TMP_PATH}/pref_swapped.index.bin"
+    rm -f "${TMP_PATH}/aln_swapped" "${TMP_PATH}/aln_swapped.index" "${TMP_PATH}/aln_swapped.index.bin"
     rm -f "${TMP_PATH}/searchtargetprofile.sh"
 fi
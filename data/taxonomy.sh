@@ -92,24 +92,26 @@ if [ -n "${LCA_PAR}" ]; then
 else
     mv -f "${TMP_PATH}/taxa" "${RESULTS}"
     mv -f "${TMP_PATH}/taxa.index" "${RESULTS}.index"
+    mv -f "${TMP_PATH}/taxa.index.bin" "${RESULTS}.index.bin" 2>/dev/null || rm -f "${RESULTS}.index.bin"
+    mv -f "${TMP_PATH}/taxa.dbtype" "${RESULTS}.dbtype" 2>/dev/null || rm -f "${RESULTS}.dbtype"
 fi
 
 if [ -n "${REMOVE_TMP}" ]; then
     echo "Remove temporary files"
     rm -rf "${TMP_PATH}/tmp_hsp1"
     rm -rf "${TMP_PATH}/tmp_hsp2"
-    rm -f "${TMP_PATH}/first" "${TMP_PATH}/first.index"
+    rm -f "${TMP_PATH}/first" "${TMP_PATH}/first.index" "${TMP_PATH}/first.index.bin"
 
     if [ -n "${SEARCH2_PAR}" ]; then
-        rm -f "${TMP_PATH}/top1" "${TMP_PATH}/top1.index"
-        rm -f "${TMP_PATH}/aligned" "${TMP_PATH}/aligned.index" "${TMP_PATH}/round2" "${TMP_PATH}/round2.index"
-        rm -f "${TMP_PATH}/merged" "${TMP_PATH}/merged.index" "${TMP_PATH}/2b_ali" "${TMP_PATH}/2b_ali.index"
+        rm -f "${TMP_PATH}/top1" "${TMP_PATH}/top1.index" "${TMP_PATH}/top1.index.bin"
+        rm -f "${TMP_PATH}/aligned" "${TMP_PATH}/aligned.index" "${TMP_PATH}/aligned.index.bin" "${TMP_PATH}/round2" "${TMP_PATH}/round2.index" "${TMP_PATH}/round2.index.bin"
+        rm -f "${TMP_PATH}/merged" "${TMP_PATH}/merged.index" "${TMP_PATH}/merged.index.bin" "${TMP_PATH}/2b_ali" "${TMP_PATH}/2b_ali.index" "${TMP_PATH}/2b_ali.index.bin"
     fi
 
     if [ -n "${LCA_PAR}" ]; then
-        rm -f "${TMP_PATH}/mapping" "${TMP_PATH}/mapping.index" "${TMP_PATH}/taxa" "${TMP_PATH}/taxa.index"
+        rm -f "${TMP_PATH}/mapping" "${TMP_PATH}/mapping.index" "${TMP_PATH}/mapping.index.bin" "${TMP_PATH}/taxa" "${TMP_PATH}/taxa.index" "${TMP_PATH}/taxa.index.bin"
     else
-        rm -f "${TMP_PATH}/mapping" "${TMP_PATH}/mapping.index"
+        rm -f "${TMP_PATH}/mapping" "${TMP_PATH}/mapping.index" "${TMP_PATH}/mapping.index.bin"
     fi
 
     rm -f "${TMP_PATH}/taxonomy.sh"
@@ -64,13 +64,15 @@ if notExists "$4/aln_offset"; then
 fi
 (mv -f "$4/aln_offset" "$3" && mv -f "$4/aln_offset.index" "$3.index") \
     || fail "Could not move result to $3"
+mv -f "$4/aln_offset.index.bin" "$3.index.bin" 2>/dev/null || rm -f "$3.index.bin"
+mv -f "$4/aln_offset.dbtype" "$3.dbtype" 2>/dev/null || rm -f "$3.dbtype"
 
 if [ -n "$REMOVE_TMP" ]; then
   echo "Remove temporary files"
-  rm -f "$4/q_orfs"    "$4/q_orfs.index"    "$4/q_orfs.dbtype"
-  rm -f "$4/q_orfs_aa" "$4/q_orfs_aa.index" "$4/q_orfs_aa.dbtype"
-  rm -f "$4/t_orfs"    "$4/t_orfs.index"    "$4/t_orfs.dbtype"
-  rm -f "$4/t_orfs_aa" "$4/t_orfs_aa.index" "$4/t_orfs_aa.dbtype"
+  rm -f "$4/q_orfs"    "$4/q_orfs.index" "$4/q_orfs.index.bin"    "$4/q_orfs.dbtype"
+  rm -f "$4/q_orfs_aa" "$4/q_orfs_aa.index" "$4/q_orfs_aa.index.bin" "$4/q_orfs_aa.dbtype"
+  rm -f "$4/t_orfs"    "$4/t_orfs.index" "$4/t_orfs.index.bin"    "$4/t_orfs.dbtype"
+  rm -f "$4/t_orfs_aa" "$4/t_orfs_aa.index" "$4/t_orfs_aa.index.bin" "$4/t_orfs_aa.dbtype"
 fi
 
 
@@ -52,7 +52,7 @@
 #include <xmmintrin.h> //TODO SSE
 
 #ifdef AVX512
-#include <zmmintrin.h.h> // AVX512
+#include <immintrin.h> // AVX512
 // double support
 #ifndef SIMD_DOUBLE
 #define SIMD_DOUBLE
@@ -102,23 +102,39 @@ typedef __m512  simd_float;
 #define simdf32_f2i(x) 	    _mm512_cvtps_epi32(x)  // convert s.p. float to integer
 #define simdf_f2icast(x)    _mm512_castps_si512 (x)
 #endif //SIMD_FLOAT
-// integer support 
+// integer support (needs AVX512BW for the byte and word operations)
 #ifndef SIMD_INT
 #define SIMD_INT
 #define ALIGN_INT           AVX512_ALIGN_INT
 #define VECSIZE_INT         AVX512_VECSIZE_INT
+//function header
+uint16_t simd_hmax16_avx512(const __m512i buffer);
+uint8_t simd_hmax8_avx512(const __m512i buffer);
+
+// shifts the whole register left by N bytes, _mm512_alignr_epi8 only shifts within the 128 bit lanes
+template  <unsigned int N> inline __m512i _mm512_shift_left(__m512i a)
+{
+    // lane i of lower holds lane i - 1 of a, the lowest lane is zero
+    __m512i lower = _mm512_alignr_epi64(a, _mm512_setzero_si512(), 6);
+    return _mm512_alignr_epi8(a, lower, 16 - N);
+}
+
 typedef __m512i simd_int;
 #define simdi32_add(x,y)    _mm512_add_epi32(x,y)
 #define simdi16_add(x,y)    _mm512_add_epi16(x,y)
 #define simdi16_adds(x,y)   _mm512_adds_epi16(x,y)
-#define simdui8_adds(x,y)   NOT_YET_IMP()
+#define simdui8_adds(x,y)   _mm512_adds_epu8(x,y)
 #define simdi32_sub(x,y)    _mm512_sub_epi32(x,y)
-#define simdui8_subs(x,y)   NOT_YET_IMP()
+#define simdui16_subs(x,y)  _mm512_subs_epu16(x,y)
+#define simdui8_subs(x,y)   _mm512_subs_epu8(x,y)
 #define simdi32_mul(x,y)    _mm512_mullo_epi32(x,y)
-#define simdui8_max(x,y)    NOT_YET_IMP()
-#define simdi16_max(x,y)    _mm512_max_epi32(x,y)
 #define simdi32_max(x,y)    _mm512_max_epi32(x,y)
+#define simdi16_max(x,y)    _mm512_max_epi16(x,y)
+#define simdi16_hmax(x)     simd_hmax16_avx512(x)
+#define simdui8_max(x,y)    _mm512_max_epu8(x,y)
+#define simdi8_hmax(x)      simd_hmax8_avx512(x)
 #define simdi_load(x)       _mm512_load_si512(x)
+#define simdi_loadu(x)      _mm512_loadu_si512(x)
 #define simdi_streamload(x) _mm512_stream_load_si512(x)
 #define simdi_store(x,y)    _mm512_store_si512(x,y)
 #define simdi_storeu(x,y)   _mm512_storeu_si512(x,y)
@@ -126,25 +142,25 @@ typedef __m512i simd_int;
 #define simdi16_set(x)      _mm512_set1_epi16(x)
 #define simdi8_set(x)       _mm512_set1_epi8(x)
 #define simdi32_shuffle(x,y) _mm512_shuffle_epi32(x,y)
-#define simdi16_shuffle(x,y) _mm512_shuffle_epi16(x,y)
 #define simdi8_shuffle(x,y)  _mm512_shuffle_epi8(x,y)
 #define simdi_setzero()     _mm512_setzero_si512()
-#define simdi32_gt(x,y)     _mm512_cmpgt_epi32(x,y)
-#define simdi8_gt(x,y)      NOT_YET_IMP()
-#define simdi16_gt(x,y)     NOT_YET_IMP()
-#define simdi8_eq(x,y)      NOT_YET_IMP()
-#define simdi32_lt(x,y)     _mm512_cmplt_epi32(x,y)
-#define simdi16_lt(x,y)     NOT_YET_IMP()
-#define simdi8_lt(x,y)      NOT_YET_IMP()
+// comparisons produce masks, they are expanded to vectors to behave like the SSE and AVX2 versions
+#define simdi32_gt(x,y)     _mm512_movm_epi32(_mm512_cmpgt_epi32_mask(x,y))
+#define simdi8_gt(x,y)      _mm512_movm_epi8(_mm512_cmpgt_epi8_mask(x,y))
+#define simdi16_gt(x,y)     _mm512_movm_epi16(_mm512_cmpgt_epi16_mask(x,y))
+#define simdi8_eq(x,y)      _mm512_movm_epi8(_mm512_cmpeq_epi8_mask(x,y))
+#define simdi16_eq(x,y)     _mm512_movm_epi16(_mm512_cmpeq_epi16_mask(x,y))
+#define simdi32_eq(x,y)     _mm512_movm_epi32(_mm512_cmpeq_epi32_mask(x,y))
+#define simdi32_lt(x,y)     _mm512_movm_epi32(_mm512_cmplt_epi32_mask(x,y))
+#define simdi16_lt(x,y)     _mm512_movm_epi16(_mm512_cmplt_epi16_mask(x,y))
+#define simdi8_lt(x,y)      _mm512_movm_epi8(_mm512_cmplt_epi8_mask(x,y))
 
 #define simdi_or(x,y)       _mm512_or_si512(x,y)
 #define simdi_and(x,y)      _mm512_and_si512(x,y)
 #define simdi_andnot(x,y)   _mm512_andnot_si512(x,y)
 #define simdi_xor(x,y)      _mm512_xor_si512(x,y)
-#define simdi8_shiftl(x,y)  NOT_YET_IMP()
-#define simdi8_shiftr(x,y)  NOT_YET_IMP()
-#define simdi8_movemask(x)  NOT_YET_IMP()
-#define simdi16_extract(x,y) NOT_YET_IMP()
+#define simdi8_shiftl(x,y)  _mm512_shift_left<y>(x)
+#define simdi8_movemask(x)  _mm512_movepi8_mask(x)
 #define simdi16_slli(x,y)	_mm512_slli_epi16(x,y) // shift integers in a left by y
 #define simdi16_srli(x,y)	_mm512_srli_epi16(x,y) // shift integers in a right by y
 #define simdi32_slli(x,y)	_mm512_slli_epi32(x,y) // shift integers in a left by y
@@ -425,6 +441,20 @@ inline uint8_t simd_hmax8_avx(const __m256i buffer){
 
 
 
+#ifdef AVX512
+inline uint16_t simd_hmax16_avx512(const __m512i buffer){
+    const __m256i low = _mm512_castsi512_si256(buffer);
+    const __m256i high = _mm512_extracti64x4_epi64(buffer, 1);
+    return simd_hmax16_avx(_mm256_max_epu16(low, high));
+}
+
+inline uint8_t simd_hmax8_avx512(const __m512i buffer){
+    const __m256i low = _mm512_castsi512_si256(buffer);
+    const __m256i high = _mm512_extracti64x4_epi64(buffer, 1);
+    return simd_hmax8_avx(_mm256_max_epu8(low, high));
+}
+#endif
+
 #ifdef AVX2
 inline unsigned short extract_epi16(__m256i v, int pos) {
     switch(pos){
@@ -8,13 +8,17 @@
 #include "DBWriter.h"
 #include "NucleotideMatrix.h"
 #include "SubstitutionMatrix.h"
-#include "PrefilteringIndexReader.h"
 #include "FileUtil.h"
 
+#include <climits>
+#include <sstream>
+
 #ifdef OPENMP
 #include <omp.h>
 #endif
 
+extern const char* version;
+
 Alignment::Alignment(const std::string &querySeqDB, const std::string &querySeqDBIndex,
                      const std::string &targetSeqDB, const std::string &targetSeqDBIndex,
                      const std::string &prefDB, const std::string &prefDBIndex,
@@ -22,10 +26,10 @@ Alignment::Alignment(const std::string &querySeqDB, const std::string &querySeqD
                      const Parameters &par) :
 
         covThr(par.covThr), covMode(par.covMode), seqIdMode(par.seqIdMode), evalThr(par.evalThr), seqIdThr(par.seqIdThr),
-        includeIdentity(par.includeIdentity), addBacktrace(par.addBacktrace), realign(par.realign), scoreBias(par.scoreBias),
+        includeIdentity(par.includeIdentity), addBacktrace(par.addBacktrace), realign(par.realign), binaryResult(par.binaryResult), alignTileSize(static_cast<size_t>(par.alignTileSize)), xdropBand(par.xdropBand), xdrop(par.xdrop), extensionWindow(par.extensionWindow), compressed(par.compressed), scoreBias(par.scoreBias),
         threads(static_cast<unsigned int>(par.threads)), outDB(outDB), outDBIndex(outDBIndex),
-        maxSeqLen(par.maxSeqLen), compBiasCorrection(par.compBiasCorrection), altAlignment(par.altAlignment), qdbr(NULL), qSeqLookup(NULL),
-        tdbr(NULL), tidxdbr(NULL), tSeqLookup(NULL), templateDBIsIndex(false) {
+        maxSeqLen(par.maxSeqLen), compBiasCorrection(par.compBiasCorrection), altAlignment(par.altAlignment), qdbr(NULL),
+        tdbr(NULL), tStore(NULL), cache(NULL) {
 
 
     unsigned int alignmentMode = par.alignmentMode;
@@ -61,48 +65,20 @@ Alignment::Alignment(const std::string &querySeqDB, const std::string &querySeqD
     initSWMode(alignmentMode);
 
     std::string scoringMatrixFile = par.scoringMatrixFile;
-    std::string indexDB = PrefilteringIndexReader::searchForIndex(targetSeqDB);
-    if (indexDB.length() > 0) {
-        Debug(Debug::INFO) << "Use index  " << indexDB << "\n";
-
-        tidxdbr = new DBReader<unsigned int>(indexDB.c_str(), (indexDB + ".index").c_str());
-        tidxdbr->open(DBReader<unsigned int>::NOSORT);
-
-        templateDBIsIndex = PrefilteringIndexReader::checkIfIndexFile(tidxdbr);
-        if (templateDBIsIndex == true) {
-            tSeqLookup = PrefilteringIndexReader::getUnmaskedSequenceLookup(tidxdbr, par.noPreload == false);
-            if (tSeqLookup == NULL) {
-                Debug(Debug::WARNING) << "No unmasked index available. Falling back to sequence database.\n";
-                templateDBIsIndex = false;
-            } else {
-                PrefilteringIndexReader::printSummary(tidxdbr);
-                PrefilteringIndexData meta = PrefilteringIndexReader::getMetadata(tidxdbr);
-                targetSeqType = meta.seqType;
-                tdbr = PrefilteringIndexReader::openNewReader(tidxdbr, par.noPreload == false);
-                scoringMatrixFile = PrefilteringIndexReader::getSubstitutionMatrixName(tidxdbr);
-            }
-        }
-
-        if (templateDBIsIndex == false) {
-            tidxdbr->close();
-            delete tidxdbr;
-            tidxdbr = NULL;
-        }
-    }
-
-    if (templateDBIsIndex == false) {
-        tdbr = new DBReader<unsigned int>(targetSeqDB.c_str(), targetSeqDBIndex.c_str());
-        tdbr->open(DBReader<unsigned int>::NOSORT);
-        if (par.noPreload == false) {
-            tdbr->readMmapedDataInMemory();
-            tdbr->mlock();
-        }
+    // target sequences are read from the index or encoded only once
+    tStore = new SequenceStore(targetSeqDB, targetSeqDBIndex, true, par.noPreload == false,
+                               static_cast<size_t>(par.seqCacheLimit) * 1024 * 1024);
+    tdbr = tStore->getReader();
+    if (tStore->isIndex() == true) {
+        targetSeqType = tStore->getSeqType();
+        scoringMatrixFile = tStore->getSubstitutionMatrixName();
+    } else if (par.noPreload == false) {
+        tdbr->mlock();
     }
 
     sameQTDB = (targetSeqDB.compare(querySeqDB) == 0);
     if (sameQTDB == true) {
         qdbr = tdbr;
-        qSeqLookup = tSeqLookup;
         querySeqType = targetSeqType;
     } else {
         // open the sequence, prefiltering and output databases
@@ -133,7 +109,7 @@ Alignment::Alignment(const std::string &querySeqDB, const std::string &querySeqD
     Debug(Debug::INFO) << "Using " << threads << " threads.\n";
 #endif
 
-    if (templateDBIsIndex == false) {
+    if (tStore->isIndex() == false) {
         querySeqType = qdbr->getDbtype();
         targetSeqType = tdbr->getDbtype();
     }
@@ -178,6 +154,31 @@ Alignment::Alignment(const std::string &querySeqDB, const std::string &querySeqD
     } else {
         realign_m = NULL;
     }
+
+    if (par.alignmentCache.empty() == false) {
+        const bool sequenceInput = (querySeqType == Sequence::AMINO_ACIDS || querySeqType == Sequence::NUCLEOTIDES)
+                                   && (targetSeqType == Sequence::AMINO_ACIDS || targetSeqType == Sequence::NUCLEOTIDES);
+        if (sequenceInput == false) {
+            Debug(Debug::WARNING) << "The alignment cache is only used for sequence queries and targets.\n";
+        } else if (alignTileSize > 0) {
+            Debug(Debug::WARNING) << "The alignment cache is not used with --align-tile-size.\n";
+        } else if (MMseqsMPI::numProc > 1) {
+            Debug(Debug::WARNING) << "The alignment cache is not used with MPI.\n";
+        } else {
+            cache = new AlignmentCache(par.alignmentCache, hashCacheParameters(par, scoringMatrixFile),
+                                       static_cast<unsigned int>(par.alignmentCacheAge), threads);
+        }
+    }
+}
+
+size_t Alignment::hashCacheParameters(const Parameters &par, const std::string &scoringMatrixFile) const {
+    std::ostringstream ss;
+    ss << version << " " << querySeqType << " " << targetSeqType << " " << par.scoringMatrixFile << " "
+       << scoringMatrixFile << " " << scoreBias << " " << gapOpen << " " << gapExtend << " " << swMode << " "
+       << covMode << " " << covThr << " " << evalThr << " " << seqIdMode << " " << compBiasCorrection << " "
+       << xdropBand << " " << xdrop << " " << extensionWindow;
+    const std::string parameters = ss.str();
+    return Util::hash(parameters.c_str(), parameters.size());
 }
 
 void Alignment::initSWMode(unsigned int alignmentMode) {
@@ -220,19 +221,13 @@ void Alignment::initSWMode(unsigned int alignmentMode) {
 }
 
 Alignment::~Alignment() {
+    delete cache;
     if (realign == true) {
         delete realign_m;
     }
     delete m;
 
-    tdbr->close();
-    delete tdbr;
-
-    if (templateDBIsIndex == true) {
-        delete tSeqLookup;
-        tidxdbr->close();
-        delete tidxdbr;
-    }
+    delete tStore;
 
     if (sameQTDB == false) {
         qdbr->close();
@@ -267,11 +262,20 @@ void Alignment::run(const unsigned int mpiRank, const unsigned int mpiNumProc,
 
         // merge output databases
         DBWriter::mergeResults(outDB, outDBIndex, splitFiles);
+        if (binaryResult == true) {
+            DBWriter::writeDbtypeFile(outDB.c_str(), Sequence::ALIGNMENT_RES_BINARY);
+        }
+        if (compressed == true) {
+            DBWriter::compressDatabase(outDB.c_str(), outDBIndex.c_str(), threads);
+        }
     }
 }
 
 void Alignment::run(const unsigned int maxAlnNum, const unsigned int maxRejected) {
     run(outDB, outDBIndex, 0, prefdbr->getSize(), maxAlnNum, maxRejected);
+    if (compressed == true) {
+        DBWriter::compressDatabase(outDB.c_str(), outDBIndex.c_str(), threads);
+    }
 }
 
 void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
@@ -289,6 +293,179 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
     if(totalMemory > prefdbr->getDataSize()){
         flushSize = dbSize;
     }
+    if (alignTileSize > 0) {
+        runTiled(dbw, evaluer, dbFrom, dbSize, maxAlnNum, maxRejected, alignmentsNum, totalPassedNum);
+    } else {
+#pragma omp parallel
+        {
+            unsigned int thread_idx = 0;
+#ifdef OPENMP
+            thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+#endif
+            std::string alnResultsOutString;
+            alnResultsOutString.reserve(1024*1024);
+            char buffer[1024+32768];
+            Sequence qSeq(maxSeqLen, querySeqType, m, 0, false, compBiasCorrection);
+            Sequence dbSeq(maxSeqLen, targetSeqType, m, 0, false, compBiasCorrection);
+            Matcher matcher(querySeqType, maxSeqLen, m, &evaluer, compBiasCorrection, gapOpen, gapExtend);
+            matcher.setXdropBand(xdropBand, xdrop);
+            matcher.setExtensionWindow(extensionWindow);
+            // the input can also be a previous (binary) alignment result
+            ResultCursor cursor(prefdbr);
+            std::vector<PrescoredHit> prescoredHits;
+            std::vector<InterSequenceAligner::Result> interResults;
+            AlignmentCache::QueryEntry cacheEntry;
+            Matcher *realigner = NULL;
+            if (realign ==  true) {
+                realigner = new Matcher(querySeqType, maxSeqLen, realign_m, &evaluer, compBiasCorrection, gapOpen, gapExtend);
+            }
+
+            size_t iterations = static_cast<size_t>(ceil(static_cast<double>(dbSize) / static_cast<double>(flushSize)));
+            for (size_t i = 0; i < iterations; i++) {
+                size_t start = dbFrom + (i * flushSize);
+                size_t bucketSize = std::min(dbSize - (i * flushSize), flushSize);
+
+#pragma omp for schedule(dynamic, 5) reduction(+: alignmentsNum, totalPassedNum)
+                for (size_t id = start; id < (start + bucketSize); id++) {
+                    Debug::printProgress(id);
+
+                    // get the prefiltering list
+                    cursor.reset(id);
+                    unsigned int queryDbKey = prefdbr->getDbKey(id);
+                    setQuerySequence(qSeq, id, queryDbKey);
+
+                    matcher.initQuery(&qSeq);
+                    if (cache != NULL) {
+                        cache->loadQuery(cacheEntry, qSeq);
+                    }
+                    // parse the prefiltering list and calculate a Smith-Waterman alignment for each sequence in the list
+                    std::vector<Matcher::result_t> swResults;
+                    size_t passedNum = 0;
+                    unsigned int rejected = 0;
+
+                    // short amino acid queries score their hits in batches first, the full alignment is skipped
+                    // for hits that can not pass the e-value threshold
+                    InterSequenceAligner *interAligner = (targetSeqType == Sequence::AMINO_ACIDS) ? matcher.getInterSequenceAligner() : NULL;
+                    prescoredHits.clear();
+                    size_t prescoredPos = 0;
+
+                    while (cursor.hasNext() && passedNum < maxAlnNum && rejected < maxRejected) {
+                        // DB key of the db sequence
+                        unsigned int dbKey;
+                        int diagonal = INT_MAX;
+                        char *nextData;
+                        if (interAligner != NULL) {
+                            if (prescoredPos == prescoredHits.size()) {
+                                prescoreHits(cursor, queryDbKey, qSeq, dbSeq, *interAligner, prescoredHits, interResults);
+                                prescoredPos = 0;
+                            }
+                            const PrescoredHit &hit = prescoredHits[prescoredPos++];
+                            dbKey = hit.dbKey;
+                            diagonal = hit.diagonal;
+                            nextData = hit.nextData;
+                            // the score of the full alignment is at most the prescore
+                            if (hit.prescored && hit.result.overflow == false
+                                && evaluer.computeEvalue(hit.result.score, qSeq.L) > evalThr) {
+                                alignmentsNum++;
+                                rejected++;
+                                cursor.setPosition(nextData);
+                                continue;
+                            }
+                        } else {
+                            parseHit(cursor, dbKey, diagonal);
+                            nextData = cursor.getPosition();
+                        }
+
+                        setTargetSequence(dbSeq, dbKey);
+                        // check if the sequences could pass the coverage threshold
+                        if(Util::canBeCovered(covThr, covMode, static_cast<float>(qSeq.L), static_cast<float>(dbSeq.L)) == false )
+                        {
+                            rejected++;
+                            cursor.setPosition(nextData);
+                            continue;
+                        }
+                        const bool isIdentity = (queryDbKey == dbKey && (includeIdentity || sameQTDB)) ? true : false;
+
+                        // calculate Smith-Waterman alignment, unless the pair was aligned in an earlier run
+                        Matcher::result_t res;
+                        const bool useCache = (cache != NULL && isIdentity == false);
+                        const size_t targetHash = useCache ? AlignmentCache::hashSequence(dbSeq) : 0;
+                        if (useCache == false
+                            || cache->lookup(cacheEntry, dbSeq, targetHash, diagonal, evaluer, evalThr, res, thread_idx) == false) {
+                            res = matcher.getSWResult(&dbSeq, diagonal, covMode, covThr, evalThr, swMode, seqIdMode, isIdentity);
+                            if (useCache) {
+                                cache->add(cacheEntry, targetHash, static_cast<unsigned int>(dbSeq.L), diagonal,
+                                           matcher.getLastRawScore(), res);
+                            }
+                        }
+                        alignmentsNum++;
+
+                        //set coverage and seqid if identity
+                        if (isIdentity) {
+                            res.qcov = 1.0f;
+                            res.dbcov = 1.0f;
+                            res.seqId = 1.0f;
+                        }
+                        if(checkCriteriaAndAddHitToList(res, isIdentity, swResults)){
+                            passedNum++;
+                            totalPassedNum++;
+                            rejected = 0;
+                        }else{
+                            rejected++;
+                        }
+
+                        cursor.setPosition(nextData);
+                    }
+                    writeQueryResults(queryDbKey, qSeq, dbSeq, swResults, matcher, realigner, buffer, alnResultsOutString, dbw, thread_idx);
+                    if (cache != NULL) {
+                        cache->writeQuery(cacheEntry, thread_idx);
+                    }
+                }
+
+#pragma omp barrier
+                if (thread_idx == 0) {
+                    prefdbr->remapData();
+                }
+#pragma omp barrier
+            }
+
+            if (realign == true) {
+                delete realigner;
+            }
+        }
+    }
+
+    dbw.close(binaryResult ? Sequence::ALIGNMENT_RES_BINARY : -1);
+
+    Debug(Debug::INFO) << "\nAll sequences processed.\n\n";
+    Debug(Debug::INFO) << alignmentsNum << " alignments calculated.\n";
+    if (cache != NULL) {
+        cache->close();
+    }
+    Debug(Debug::INFO) << totalPassedNum << " sequence pairs passed the thresholds ("
+                       << ((float) totalPassedNum / (float) alignmentsNum) << " of overall calculated).\n";
+
+    size_t hits = totalPassedNum / dbSize;
+    size_t hits_rest = totalPassedNum % dbSize;
+    float hits_f = ((float) hits) + ((float) hits_rest) / (float) dbSize;
+    Debug(Debug::INFO) << hits_f << " hits per query sequence.\n";
+}
+
+void Alignment::runTiled(DBWriter &dbw, EvalueComputation &evaluer, size_t dbFrom, size_t dbSize,
+                         unsigned int maxAlnNum, unsigned int maxRejected, size_t &alignmentsNumOut, size_t &totalPassedNumOut) {
+    size_t alignmentsNum = 0;
+    size_t totalPassedNum = 0;
+    // hits of all queries of a tile in prefilter order
+    std::vector<TileHit> hits;
+    std::vector<Matcher::result_t> results;
+    // the hits of query i of the tile are hits[hitOffsets[i]] to hits[hitOffsets[i + 1] - 1]
+    std::vector<size_t> hitOffsets;
+    // (target id, hit index) sorted by target
+    std::vector<std::pair<size_t, size_t> > targetOrder;
+    // the target blocks are targetOrder[targetBlocks[i]] to targetOrder[targetBlocks[i + 1] - 1]
+    std::vector<size_t> targetBlocks;
+    // profiles can not be mapped from the decoded residues
+    const bool decodeTargets = (targetSeqType != Sequence::HMM_PROFILE);
 #pragma omp parallel
     {
         unsigned int thread_idx = 0;
@@ -301,142 +478,325 @@ void Alignment::run(const std::string &outDB, const std::string &outDBIndex,
         Sequence qSeq(maxSeqLen, querySeqType, m, 0, false, compBiasCorrection);
         Sequence dbSeq(maxSeqLen, targetSeqType, m, 0, false, compBiasCorrection);
         Matcher matcher(querySeqType, maxSeqLen, m, &evaluer, compBiasCorrection, gapOpen, gapExtend);
+        matcher.setXdropBand(xdropBand, xdrop);
+        matcher.setExtensionWindow(extensionWindow);
         Matcher *realigner = NULL;
         if (realign ==  true) {
             realigner = new Matcher(querySeqType, maxSeqLen, realign_m, &evaluer, compBiasCorrection, gapOpen, gapExtend);
         }
+        // decoded targets of the current target block
+        std::vector<unsigned char> residues;
+        std::vector<size_t> residueOffsets;
+        std::vector<unsigned int> residueLengths;
+        // (hit index, decoded target) of the current target block
+        std::vector<std::pair<size_t, size_t> > blockHits;
+        std::vector<size_t> batch;
+        std::vector<InterSequenceAligner::Result> interResults;
+
+        for (size_t tileStart = dbFrom; tileStart < dbFrom + dbSize; tileStart += alignTileSize) {
+            const size_t tileEnd = std::min(dbFrom + dbSize, tileStart + alignTileSize);
+#pragma omp single
+            {
+                hits.clear();
+                hitOffsets.clear();
+                ResultCursor cursor(prefdbr);
+                for (size_t id = tileStart; id < tileEnd; id++) {
+                    hitOffsets.push_back(hits.size());
+                    cursor.reset(id);
+                    while (cursor.hasNext()) {
+                        TileHit hit;
+                        parseHit(cursor, hit.dbKey, hit.diagonal);
+                        hit.query = static_cast<unsigned int>(id - tileStart);
+                        hit.status = TILE_HIT_NOT_COVERED;
+                        hits.push_back(hit);
+                    }
+                }
+                hitOffsets.push_back(hits.size());
+                results.clear();
+                results.resize(hits.size());
+
+                targetOrder.clear();
+                for (size_t i = 0; i < hits.size(); i++) {
+                    const size_t targetId = tdbr->getId(hits[i].dbKey);
+                    if (targetId == UINT_MAX) {
+                        Debug(Debug::ERROR) << "ERROR: Sequence " << hits[i].dbKey
+                                            << " is required in the prefiltering,"
+                                            << "but is not contained in the target sequence database!\n"
+                                            << "Please check your database.\n";
+                        EXIT(EXIT_FAILURE);
+                    }
+                    targetOrder.push_back(std::make_pair(targetId, i));
+                }
+                std::sort(targetOrder.begin(), targetOrder.end());
+
+                // a target never spans two blocks
+                targetBlocks.clear();
+                targetBlocks.push_back(0);
+                size_t blockResidues = 0;
+                for (size_t i = 0; i < targetOrder.size(); i++) {
+                    if (i > 0 && targetOrder[i].first == targetOrder[i - 1].first) {
+                        continue;
+                    }
+                    if (blockResidues > TILE_TARGET_RESIDUES) {
+                        targetBlocks.push_back(i);
+                        blockResidues = 0;
+                    }
+                    blockResidues += tdbr->getSeqLens(targetOrder[i].first);
+                }
+                targetBlocks.push_back(targetOrder.size());
+            }
+
+#pragma omp for schedule(dynamic, 1)
+            for (size_t block = 0; block < targetBlocks.size() - 1; block++) {
+                // read each target of the block once in database order
+                residues.clear();
+                residueOffsets.clear();
+                residueLengths.clear();
+                blockHits.clear();
+                for (size_t i = targetBlocks[block]; i < targetBlocks[block + 1]; i++) {
+                    const size_t hitIdx = targetOrder[i].second;
+                    if (i == targetBlocks[block] || targetOrder[i].first != targetOrder[i - 1].first) {
+                        residueOffsets.push_back(residues.size());
+                        if (decodeTargets) {
+                            setTargetSequence(dbSeq, hits[hitIdx].dbKey);
+                            for (int pos = 0; pos < dbSeq.L; pos++) {
+                                residues.push_back(static_cast<unsigned char>(dbSeq.int_sequence[pos]));
+                            }
+                            residueLengths.push_back(static_cast<unsigned int>(dbSeq.L));
+                        } else {
+                            residueLengths.push_back(0);
+                        }
+                    }
+                    blockHits.push_back(std::make_pair(hitIdx, residueOffsets.size() - 1));
+                }
+                // the hits are sorted by query now, the profile of each query is built once per block
+                std::sort(blockHits.begin(), blockHits.end());
+
+                size_t groupStart = 0;
+                while (groupStart < blockHits.size()) {
+                    const unsigned int query = hits[blockHits[groupStart].first].query;
+                    size_t groupEnd = groupStart;
+                    while (groupEnd < blockHits.size() && hits[blockHits[groupEnd].first].query == query) {
+                        groupEnd++;
+                    }
+                    const size_t queryId = tileStart + query;
+                    const unsigned int queryDbKey = prefdbr->getDbKey(queryId);
+                    setQuerySequence(qSeq, queryId, queryDbKey);
+                    matcher.initQuery(&qSeq);
+
+                    // prescore as in the query by query alignment
+                    InterSequenceAligner *interAligner = (decodeTargets && targetSeqType == Sequence::AMINO_ACIDS) ? matcher.getInterSequenceAligner() : NULL;
+                    for (size_t i = groupStart; i < groupEnd; i++) {
+                        const size_t hitIdx = blockHits[i].first;
+                        const size_t target = blockHits[i].second;
+                        TileHit &hit = hits[hitIdx];
+                        if (decodeTargets) {
+                            dbSeq.mapSequence(static_cast<size_t>(-1), hit.dbKey,
+                                              std::pair<const unsigned char*, const unsigned int>(residues.data() + residueOffsets[target], residueLengths[target]));
+                        } else {
+                            setTargetSequence(dbSeq, hit.dbKey);
+                        }
+                        if (Util::canBeCovered(covThr, covMode, static_cast<float>(qSeq.L), static_cast<float>(dbSeq.L)) == false) {
+                            hit.status = TILE_HIT_NOT_COVERED;
+                            continue;
+                        }
+                        hit.status = TILE_HIT_ALIGNED;
+                        const bool isIdentity = (queryDbKey == hit.dbKey && (includeIdentity || sameQTDB));
+                        if (interAligner != NULL && isIdentity == false
+                            && static_cast<unsigned int>(dbSeq.L) <= INTER_SEQUENCE_MAX_TARGET_LEN) {
+                            interAligner->addTarget(dbSeq.int_sequence, dbSeq.L);
+                            batch.push_back(hitIdx);
+                        }
+                        if (interAligner != NULL && batch.size() == interAligner->getLanes()) {
+                            pruneTileHits(*interAligner, evaluer, qSeq.L, batch, interResults, hits);
+                        }
+                    }
+                    if (interAligner != NULL && batch.empty() == false) {
+                        pruneTileHits(*interAligner, evaluer, qSeq.L, batch, interResults, hits);
+                    }
 
-        size_t iterations = static_cast<size_t>(ceil(static_cast<double>(dbSize) / static_cast<double>(flushSize)));
-        for (size_t i = 0; i < iterations; i++) {
-            size_t start = dbFrom + (i * flushSize);
-            size_t bucketSize = std::min(dbSize - (i * flushSize), flushSize);
+                    for (size_t i = groupStart; i < groupEnd; i++) {
+                        const size_t hitIdx = blockHits[i].first;
+                        const size_t target = blockHits[i].second;
+                        const TileHit &hit = hits[hitIdx];
+                        if (hit.status != TILE_HIT_ALIGNED) {
+                            continue;
+                        }
+                        if (decodeTargets) {
+                            dbSeq.mapSequence(static_cast<size_t>(-1), hit.dbKey,
+                                              std::pair<const unsigned char*, const unsigned int>(residues.data() + residueOffsets[target], residueLengths[target]));
+                        } else {
+                            setTargetSequence(dbSeq, hit.dbKey);
+                        }
+                        const bool isIdentity = (queryDbKey == hit.dbKey && (includeIdentity || sameQTDB));
+                        results[hitIdx] = matcher.getSWResult(&dbSeq, hit.diagonal, covMode, covThr, evalThr, swMode, seqIdMode, isIdentity);
+                        //set coverage and seqid if identity
+                        if (isIdentity) {
+                            results[hitIdx].qcov = 1.0f;
+                            results[hitIdx].dbcov = 1.0f;
+                            results[hitIdx].seqId = 1.0f;
+                        }
+                    }
+                    groupStart = groupEnd;
+                }
+            }
 
+            // accept the hits in prefilter order with the same stopping criteria as the query by query alignment
 #pragma omp for schedule(dynamic, 5) reduction(+: alignmentsNum, totalPassedNum)
-            for (size_t id = start; id < (start + bucketSize); id++) {
+            for (size_t id = tileStart; id < tileEnd; id++) {
                 Debug::printProgress(id);
-
-                // get the prefiltering list
-                char *data = prefdbr->getData(id);
                 unsigned int queryDbKey = prefdbr->getDbKey(id);
                 setQuerySequence(qSeq, id, queryDbKey);
-
-                matcher.initQuery(&qSeq);
-                // parse the prefiltering list and calculate a Smith-Waterman alignment for each sequence in the list
+                if (altAlignment > 0) {
+                    matcher.initQuery(&qSeq);
+                }
                 std::vector<Matcher::result_t> swResults;
                 size_t passedNum = 0;
                 unsigned int rejected = 0;
-
-                while (*data != '\0' && passedNum < maxAlnNum && rejected < maxRejected) {
-                    // DB key of the db sequence
-                    char dbKeyBuffer[255 + 1];
-                    char * words[10];
-                    Util::parseKey(data, dbKeyBuffer);
-                    const unsigned int dbKey = (unsigned int) strtoul(dbKeyBuffer, NULL, 10);
-
-                    size_t elements = Util::getWordsOfLine(data, words, 10);
-                    int diagonal = INT_MAX;
-                    // Prefilter result (need to make this better)
-                    if(elements == 3){
-                        hit_t hit = QueryMatcher::parsePrefilterHit(data);
-                        diagonal = hit.diagonal;
-                    }
-
-                    setTargetSequence(dbSeq, dbKey);
-                    // check if the sequences could pass the coverage threshold
-                    if(Util::canBeCovered(covThr, covMode, static_cast<float>(qSeq.L), static_cast<float>(dbSeq.L)) == false )
-                    {
+                const size_t query = id - tileStart;
+                for (size_t i = hitOffsets[query]; i < hitOffsets[query + 1] && passedNum < maxAlnNum && rejected < maxRejected; i++) {
+                    if (hits[i].status == TILE_HIT_NOT_COVERED) {
                         rejected++;
-                        data = Util::skipLine(data);
                         continue;
                     }
-                    const bool isIdentity = (queryDbKey == dbKey && (includeIdentity || sameQTDB)) ? true : false;
-
-                    // calculate Smith-Waterman alignment
-                    Matcher::result_t res = matcher.getSWResult(&dbSeq, diagonal, covMode, covThr, evalThr, swMode, seqIdMode, isIdentity);
                     alignmentsNum++;
-
-                    //set coverage and seqid if identity
-                    if (isIdentity) {
-                        res.qcov = 1.0f;
-                        res.dbcov = 1.0f;
-                        res.seqId = 1.0f;
+                    if (hits[i].status == TILE_HIT_PRUNED) {
+                        rejected++;
+                        continue;
                     }
-                    if(checkCriteriaAndAddHitToList(res, isIdentity, swResults)){
+                    const bool isIdentity = (queryDbKey == hits[i].dbKey && (includeIdentity || sameQTDB));
+                    if (checkCriteriaAndAddHitToList(results[i], isIdentity, swResults)) {
                         passedNum++;
                         totalPassedNum++;
                         rejected = 0;
-                    }else{
+                    } else {
                         rejected++;
                     }
-
-                    data = Util::skipLine(data);
-                }
-                if(altAlignment > 0 && realign == false ){
-                    computeAlternativeAlignment(queryDbKey, dbSeq, swResults, matcher, evalThr, swMode);
                 }
-
-                // write the results
-                std::sort(swResults.begin(), swResults.end(), Matcher::compareHits);
-                if (realign == true) {
-                    realigner->initQuery(&qSeq);
-                    for (size_t result = 0; result < swResults.size(); result++) {
-                        setTargetSequence(dbSeq, swResults[result].dbKey);
-                        const bool isIdentity = (queryDbKey == swResults[result].dbKey && (includeIdentity || sameQTDB)) ? true : false;
-                        Matcher::result_t res = realigner->getSWResult(&dbSeq, INT_MAX, covMode, covThr, FLT_MAX,
-                                                                       Matcher::SCORE_COV_SEQID, seqIdMode, isIdentity);
-                        swResults[result].backtrace  = res.backtrace;
-                        swResults[result].qStartPos  = res.qStartPos;
-                        swResults[result].qEndPos    = res.qEndPos;
-                        swResults[result].dbStartPos = res.dbStartPos;
-                        swResults[result].dbEndPos   = res.dbEndPos;
-                        swResults[result].alnLength  = res.alnLength;
-                        swResults[result].seqId      = res.seqId;
-                        swResults[result].qcov       = res.qcov;
-                        swResults[result].dbcov      = res.dbcov;
-                    }
-                    if(altAlignment> 0 ){
-                        computeAlternativeAlignment(queryDbKey, dbSeq, swResults, matcher, FLT_MAX, Matcher::SCORE_COV_SEQID);
-                    }
-                }
-
-                // put the contents of the swResults list into ffindex DB
-                for (size_t result = 0; result < swResults.size(); result++) {
-                    size_t len = Matcher::resultToBuffer(buffer, swResults[result], addBacktrace);
-                    alnResultsOutString.append(buffer, len);
-                }
-                dbw.writeData(alnResultsOutString.c_str(), alnResultsOutString.length(), qSeq.getDbKey(), thread_idx);
-                alnResultsOutString.clear();
+                writeQueryResults(queryDbKey, qSeq, dbSeq, swResults, matcher, realigner, buffer, alnResultsOutString, dbw, thread_idx);
             }
-
-#pragma omp barrier
-            if (thread_idx == 0) {
-                prefdbr->remapData();
-            }
-#pragma omp barrier
         }
 
         if (realign == true) {
             delete realigner;
         }
     }
+    alignmentsNumOut = alignmentsNum;
+    totalPassedNumOut = totalPassedNum;
+}
 
-    dbw.close();
+void Alignment::pruneTileHits(InterSequenceAligner &interAligner, EvalueComputation &evaluer, int queryLen,
+                              std::vector<size_t> &batch, std::vector<InterSequenceAligner::Result> &interResults,
+                              std::vector<TileHit> &hits) {
+    interAligner.align(interResults);
+    for (size_t lane = 0; lane < batch.size(); lane++) {
+        // the score of the full alignment is at most the prescore
+        if (interResults[lane].overflow == false && evaluer.computeEvalue(interResults[lane].score, queryLen) > evalThr) {
+            hits[batch[lane]].status = TILE_HIT_PRUNED;
+        }
+    }
+    batch.clear();
+}
 
-    Debug(Debug::INFO) << "\nAll sequences processed.\n\n";
-    Debug(Debug::INFO) << alignmentsNum << " alignments calculated.\n";
-    Debug(Debug::INFO) << totalPassedNum << " sequence pairs passed the thresholds ("
-                       << ((float) totalPassedNum / (float) alignmentsNum) << " of overall calculated).\n";
+void Alignment::writeQueryResults(unsigned int queryDbKey, Sequence &qSeq, Sequence &dbSeq, std::vector<Matcher::result_t> &swResults,
+                                  Matcher &matcher, Matcher *realigner, char *buffer, std::string &alnResultsOutString,
+                                  DBWriter &dbw, unsigned int thread_idx) {
+    if(altAlignment > 0 && realign == false ){
+        computeAlternativeAlignment(queryDbKey, dbSeq, swResults, matcher, evalThr, swMode);
+    }
 
-    size_t hits = totalPassedNum / dbSize;
-    size_t hits_rest = totalPassedNum % dbSize;
-    float hits_f = ((float) hits) + ((float) hits_rest) / (float) dbSize;
-    Debug(Debug::INFO) << hits_f << " hits per query sequence.\n";
+    // write the results
+    std::sort(swResults.begin(), swResults.end(), Matcher::compareHits);
+    if (realign == true) {
+        realigner->initQuery(&qSeq);
+        for (size_t result = 0; result < swResults.size(); result++) {
+            setTargetSequence(dbSeq, swResults[result].dbKey);
+            const bool isIdentity = (queryDbKey == swResults[result].dbKey && (includeIdentity || sameQTDB)) ? true : false;
+            Matcher::result_t res = realigner->getSWResult(&dbSeq, INT_MAX, covMode, covThr, FLT_MAX,
+                                                           Matcher::SCORE_COV_SEQID, seqIdMode, isIdentity);
+            swResults[result].backtrace  = res.backtrace;
+            swResults[result].qStartPos  = res.qStartPos;
+            swResults[result].qEndPos    = res.qEndPos;
+            swResults[result].dbStartPos = res.dbStartPos;
+            swResults[result].dbEndPos   = res.dbEndPos;
+            swResults[result].alnLength  = res.alnLength;
+            swResults[result].seqId      = res.seqId;
+            swResults[result].qcov       = res.qcov;
+            swResults[result].dbcov      = res.dbcov;
+        }
+        if(altAlignment> 0 ){
+            computeAlternativeAlignment(queryDbKey, dbSeq, swResults, matcher, FLT_MAX, Matcher::SCORE_COV_SEQID);
+        }
+    }
+
+    // put the contents of the swResults list into ffindex DB
+    for (size_t result = 0; result < swResults.size(); result++) {
+        size_t len;
+        if (binaryResult == true) {
+            len = Matcher::resultToBinaryBuffer(buffer, swResults[result], addBacktrace);
+        } else {
+            len = Matcher::resultToBuffer(buffer, swResults[result], addBacktrace);
+        }
+        alnResultsOutString.append(buffer, len);
+    }
+    dbw.writeData(alnResultsOutString.c_str(), alnResultsOutString.length(), qSeq.getDbKey(), thread_idx);
+    alnResultsOutString.clear();
+}
+
+void Alignment::parseHit(ResultCursor &cursor, unsigned int &dbKey, int &diagonal) {
+    hit_t hit;
+    cursor.next(hit);
+    dbKey = hit.seqId;
+    diagonal = cursor.hasDiagonal() ? hit.diagonal : INT_MAX;
+}
+
+void Alignment::prescoreHits(ResultCursor &cursor, unsigned int queryDbKey, Sequence &qSeq,
+                             Sequence &dbSeq, InterSequenceAligner &interAligner, std::vector<PrescoredHit> &hits,
+                             std::vector<InterSequenceAligner::Result> &results) {
+    hits.clear();
+    // do not read far ahead if most hits can not be prescored
+    const size_t maxHits = 4 * interAligner.getLanes();
+    while (cursor.hasNext() && hits.size() < maxHits
+           && interAligner.getTargetCount() < interAligner.getLanes()) {
+        PrescoredHit hit;
+        parseHit(cursor, hit.dbKey, hit.diagonal);
+        hit.nextData = cursor.getPosition();
+        hit.prescored = false;
+        const bool isIdentity = (queryDbKey == hit.dbKey && (includeIdentity || sameQTDB));
+        if (isIdentity == false) {
+            setTargetSequence(dbSeq, hit.dbKey);
+            if (static_cast<unsigned int>(dbSeq.L) <= INTER_SEQUENCE_MAX_TARGET_LEN
+                && Util::canBeCovered(covThr, covMode, static_cast<float>(qSeq.L), static_cast<float>(dbSeq.L))) {
+                interAligner.addTarget(dbSeq.int_sequence, dbSeq.L);
+                hit.prescored = true;
+            }
+        }
+        hits.push_back(hit);
+    }
+
+    interAligner.align(results);
+    size_t lane = 0;
+    for (size_t i = 0; i < hits.size(); i++) {
+        if (hits[i].prescored) {
+            hits[i].result = results[lane++];
+        }
+    }
 }
 
 inline void Alignment::setQuerySequence(Sequence &seq, size_t id, unsigned int key) {
-    if (qSeqLookup != NULL) {
-        std::pair<const unsigned char*, const unsigned int> sequence = qSeqLookup->getSequence(id);
-        seq.mapSequence(id, key, sequence);
+    if (sameQTDB == true) {
+        size_t queryId = qdbr->getId(key);
+        if (queryId == UINT_MAX) {
+#pragma omp critical
+            {
+                Debug(Debug::ERROR) << "ERROR: Query sequence " << key
+                                    << " is required in the prefiltering, "
+                                    << "but is not contained in the query sequence database!\n"
+                                    << "Please check your database.\n";
+                EXIT(EXIT_FAILURE);
+            }
+        }
+        tStore->mapSequence(seq, queryId, key);
     } else {
         // map the query sequence
         char *querySeqData = qdbr->getDataByDBKey(key);
@@ -456,24 +816,18 @@ inline void Alignment::setQuerySequence(Sequence &seq, size_t id, unsigned int k
 }
 
 inline void Alignment::setTargetSequence(Sequence &seq, unsigned int key) {
-    if (tSeqLookup != NULL) {
-        size_t id = tdbr->getId(key);
-        std::pair<const unsigned char*, const unsigned int> sequence = tSeqLookup->getSequence(id);
-        seq.mapSequence(id, key, sequence);
-    } else {
-        char *dbSeqData = tdbr->getDataByDBKey(key);
-        if (dbSeqData == NULL) {
+    size_t id = tdbr->getId(key);
+    if (id == UINT_MAX) {
 #pragma omp critical
-            {
-                Debug(Debug::ERROR) << "ERROR: Sequence " << key
-                                    << " is required in the prefiltering,"
-                                    << "but is not contained in the target sequence database!\n"
-                                    << "Please check your database.\n";
-                EXIT(EXIT_FAILURE);
-            }
+        {
+            Debug(Debug::ERROR) << "ERROR: Sequence " << key
+                                << " is required in the prefiltering,"
+                                << "but is not contained in the target sequence database!\n"
+                                << "Please check your database.\n";
+            EXIT(EXIT_FAILURE);
         }
-        seq.mapSequence(static_cast<size_t>(-1), key, dbSeqData);
     }
+    tStore->mapSequence(seq, id, key);
 }
 
 
@@ -4,11 +4,14 @@
 #include <string>
 
 #include "DBReader.h"
+#include "DBWriter.h"
+#include "ResultCursor.h"
 #include "Parameters.h"
 #include "BaseMatrix.h"
 #include "Sequence.h"
-#include "SequenceLookup.h"
+#include "SequenceStore.h"
 #include "Matcher.h"
+#include "AlignmentCache.h"
 
 class Alignment {
 
@@ -59,6 +62,22 @@ private:
     // realign with different score matrix
     const bool realign;
 
+    // write Matcher::binary_result_t records instead of text
+    const bool binaryResult;
+
+    // number of queries aligned together in target order, 0 aligns query by query
+    const size_t alignTileSize;
+
+    // band width around the prefilter diagonal and X-drop (in bits) of the banded alignment, 0 runs full SW
+    const int xdropBand;
+    const float xdrop;
+
+    // nucleotide alignments of longer sequences are extended in windows of this many residues, 0 in one piece
+    const int extensionWindow;
+
+    // deflate the result database with a trained dictionary after merging
+    const bool compressed;
+
     bool sameQTDB;
 
     //to increase/decrease the threshold for finishing the alignment 
@@ -89,22 +108,75 @@ private:
     BaseMatrix *realign_m;
 
     DBReader<unsigned int> *qdbr;
-    SequenceLookup *qSeqLookup;
 
+    // tdbr belongs to tStore
     DBReader<unsigned int> *tdbr;
-    DBReader<unsigned int> *tidxdbr;
-    SequenceLookup *tSeqLookup;
+    SequenceStore *tStore;
 
     DBReader<unsigned int> *prefdbr;
 
-    bool templateDBIsIndex;
+    // results of earlier runs (--alignment-cache), NULL if not used
+    AlignmentCache *cache;
+
+    // targets up to this length are scored by the inter-sequence aligner before the full alignment
+    static const unsigned int INTER_SEQUENCE_MAX_TARGET_LEN = 256;
+
+    // a prefilter hit that was scored together with the following hits of the same query
+    struct PrescoredHit {
+        unsigned int dbKey;
+        int diagonal;
+        char *nextData;
+        bool prescored;
+        InterSequenceAligner::Result result;
+    };
+
+    // decoded target residues of one target block of a tile
+    static const size_t TILE_TARGET_RESIDUES = 1 << 20;
+
+    static const unsigned char TILE_HIT_NOT_COVERED = 0;
+    static const unsigned char TILE_HIT_PRUNED = 1;
+    static const unsigned char TILE_HIT_ALIGNED = 2;
+
+    // a prefilter hit of a tile, the alignment result is stored separately at the same index
+    struct TileHit {
+        unsigned int dbKey;
+        int diagonal;
+        // index of the query within the tile
+        unsigned int query;
+        unsigned char status;
+    };
 
     void initSWMode(unsigned int alignmentMode);
 
+    // hash of everything besides the sequences that changes the results of Matcher::getSWResult
+    size_t hashCacheParameters(const Parameters &par, const std::string &scoringMatrixFile) const;
+
     void setQuerySequence(Sequence &seq, size_t id, unsigned int key);
 
     void setTargetSequence(Sequence &seq, unsigned int key);
 
+    // reads the target key (and the diagonal of prefilter hits) of the next hit
+    void parseHit(ResultCursor &cursor, unsigned int &dbKey, int &diagonal);
+
+    // scores the hits starting at the cursor until all lanes of the inter-sequence aligner are filled
+    void prescoreHits(ResultCursor &cursor, unsigned int queryDbKey, Sequence &qSeq,
+                      Sequence &dbSeq, InterSequenceAligner &interAligner, std::vector<PrescoredHit> &hits,
+                      std::vector<InterSequenceAligner::Result> &results);
+
+    // aligns the queries in tiles of alignTileSize queries, each tile is aligned in blocks of targets
+    void runTiled(DBWriter &dbw, EvalueComputation &evaluer, size_t dbFrom, size_t dbSize,
+                  unsigned int maxAlnNum, unsigned int maxRejected, size_t &alignmentsNum, size_t &totalPassedNum);
+
+    // marks the hits of the scored batch that can not pass the e-value threshold
+    void pruneTileHits(InterSequenceAligner &interAligner, EvalueComputation &evaluer, int queryLen,
+                       std::vector<size_t> &batch, std::vector<InterSequenceAligner::Result> &interResults,
+                       std::vector<TileHit> &hits);
+
+    // computes the alternative alignments, realigns and writes the results of one query
+    void writeQueryResults(unsigned int queryDbKey, Sequence &qSeq, Sequence &dbSeq, std::vector<Matcher::result_t> &swResults,
+                           Matcher &matcher, Matcher *realigner, char *buffer, std::string &alnResultsOutString,
+                           DBWriter &dbw, unsigned int thread_idx);
+
     static size_t estimateHDDMemoryConsumption(int dbSize, int maxSeqs);
 
     bool checkCriteriaAndAddHitToList(Matcher::result_t &result, bool isIdentity, std::vector<Matcher::result_t> &swHits);
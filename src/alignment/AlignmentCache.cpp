@@ -0,0 +1,226 @@
+#include "AlignmentCache.h"
+#include "FileUtil.h"
+#include "Debug.h"
+#include "Util.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+
+AlignmentCache::AlignmentCache(const std::string &cacheDB, size_t parameterHash, unsigned int maxAge, unsigned int threads)
+        : cacheDB(cacheDB), newCacheDB(cacheDB + ".new"), parameterHash(parameterHash), maxAge(maxAge), threads(threads),
+          reader(NULL), writtenKeys(threads), cacheHits(threads, 0), writtenRecords(threads, 0) {
+    if (FileUtil::fileExists(cacheDB.c_str()) && FileUtil::fileExists((cacheDB + ".index").c_str())) {
+        reader = new DBReader<unsigned int>(cacheDB.c_str(), (cacheDB + ".index").c_str());
+        reader->open(DBReader<unsigned int>::NOSORT);
+        Debug(Debug::INFO) << "Alignment cache " << cacheDB << " with " << reader->getSize() << " queries.\n";
+    } else {
+        Debug(Debug::INFO) << "Create alignment cache " << cacheDB << ".\n";
+    }
+    writer = new DBWriter(newCacheDB.c_str(), (newCacheDB + ".index").c_str(), threads);
+    writer->open();
+}
+
+AlignmentCache::~AlignmentCache() {
+    if (reader != NULL) {
+        reader->close();
+        delete reader;
+    }
+    delete writer;
+}
+
+size_t AlignmentCache::hashSequence(const Sequence &seq) {
+    return Util::hash(seq.int_sequence, seq.L) * 31 + seq.L;
+}
+
+void AlignmentCache::loadQuery(QueryEntry &entry, const Sequence &query) {
+    entry.queryHash = hashSequence(query) * 31 + parameterHash;
+    // UINT_MAX is not a valid key
+    entry.key = static_cast<unsigned int>((entry.queryHash ^ (entry.queryHash >> 32)) % UINT_MAX);
+    entry.cached.clear();
+    entry.added.clear();
+    if (reader == NULL) {
+        return;
+    }
+    char *data = reader->getDataByDBKey(entry.key);
+    if (data == NULL) {
+        return;
+    }
+    char *columns[COLUMNS];
+    while (*data != '\0') {
+        const size_t count = Util::getWordsOfLine(data, columns, COLUMNS);
+        // records of another query with the same key are skipped, this run counts towards the age of the others
+        if (count == COLUMNS && strtoull(columns[0], NULL, 10) == entry.queryHash
+            && strtoull(columns[1], NULL, 10) == parameterHash) {
+            Record record;
+            record.age = static_cast<unsigned int>(strtoul(columns[2], NULL, 10)) + 1;
+            record.targetHash = strtoull(columns[3], NULL, 10);
+            record.targetLen = static_cast<unsigned int>(strtoul(columns[4], NULL, 10));
+            record.diagonal = static_cast<int>(strtol(columns[5], NULL, 10));
+            record.rawScore = static_cast<int>(strtol(columns[6], NULL, 10));
+            Matcher::result_t &result = record.result;
+            result.dbKey = 0;
+            result.score = static_cast<int>(strtol(columns[7], NULL, 10));
+            result.qcov = strtof(columns[8], NULL);
+            result.dbcov = strtof(columns[9], NULL);
+            result.seqId = strtof(columns[10], NULL);
+            result.eval = strtod(columns[11], NULL);
+            result.alnLength = static_cast<unsigned int>(strtoul(columns[12], NULL, 10));
+            result.qStartPos = static_cast<int>(strtol(columns[13], NULL, 10));
+            result.qEndPos = static_cast<int>(strtol(columns[14], NULL, 10));
+            result.qLen = static_cast<unsigned int>(strtoul(columns[15], NULL, 10));
+            result.dbStartPos = static_cast<int>(strtol(columns[16], NULL, 10));
+            result.dbEndPos = static_cast<int>(strtol(columns[17], NULL, 10));
+            result.dbLen = record.targetLen;
+            if (columns[18][0] != '*') {
+                const std::string compressed(columns[18], Util::skipNoneWhitespace(columns[18]));
+                result.backtrace = Matcher::uncompressAlignment(compressed);
+            }
+            entry.cached.push_back(record);
+        }
+        data = Util::skipLine(data);
+    }
+    std::sort(entry.cached.begin(), entry.cached.end(), Record::compareByTarget);
+}
+
+bool AlignmentCache::lookup(QueryEntry &entry, Sequence &target, size_t targetHash, int diagonal,
+                            EvalueComputation &evaluer, double evalThr, Matcher::result_t &result,
+                            unsigned int thread) {
+    Record search;
+    search.targetHash = targetHash;
+    search.targetLen = static_cast<unsigned int>(target.L);
+    search.diagonal = diagonal;
+    std::vector<Record>::iterator it = std::lower_bound(entry.cached.begin(), entry.cached.end(), search,
+                                                              Record::compareByTarget);
+    if (it == entry.cached.end() || it->targetHash != targetHash
+        || it->targetLen != search.targetLen || it->diagonal != diagonal) {
+        return false;
+    }
+    const double eval = evaluer.computeEvalue(it->rawScore, it->result.qLen);
+    if (it->result.eval > evalThr && eval <= evalThr) {
+        return false;
+    }
+    result = it->result;
+    result.dbKey = target.getDbKey();
+    result.eval = eval;
+    it->age = 0;
+    cacheHits[thread]++;
+    return true;
+}
+
+void AlignmentCache::add(QueryEntry &entry, size_t targetHash, unsigned int targetLen, int diagonal, int rawScore,
+                         const Matcher::result_t &result) {
+    Record record;
+    record.targetHash = targetHash;
+    record.targetLen = targetLen;
+    record.diagonal = diagonal;
+    record.rawScore = rawScore;
+    record.age = 0;
+    record.result = result;
+    entry.added.push_back(record);
+}
+
+void AlignmentCache::appendRecord(std::string &buffer, size_t queryHash, const Record &record) {
+    const Matcher::result_t &result = record.result;
+    char line[1024];
+    // floats with 9 and doubles with 17 significant digits read back exactly
+    int written = snprintf(line, sizeof(line), "%zu\t%zu\t%u\t%zu\t%u\t%d\t%d\t%d\t%.9g\t%.9g\t%.9g\t%.17g\t%u\t%d\t%d\t%u\t%d\t%d\t",
+                           queryHash, parameterHash, record.age, record.targetHash, record.targetLen, record.diagonal, record.rawScore,
+                           result.score, result.qcov, result.dbcov, result.seqId, result.eval, result.alnLength,
+                           result.qStartPos, result.qEndPos, result.qLen, result.dbStartPos, result.dbEndPos);
+    buffer.append(line, static_cast<size_t>(written));
+    if (result.backtrace.empty()) {
+        buffer.append("*");
+    } else {
+        buffer.append(Matcher::compressAlignment(result.backtrace));
+    }
+    buffer.append("\n");
+}
+
+void AlignmentCache::writeQuery(QueryEntry &entry, unsigned int thread) {
+    entry.buffer.clear();
+    for (size_t i = 0; i < entry.cached.size(); i++) {
+        if (entry.cached[i].age <= maxAge) {
+            appendRecord(entry.buffer, entry.queryHash, entry.cached[i]);
+            writtenRecords[thread]++;
+        }
+    }
+    for (size_t i = 0; i < entry.added.size(); i++) {
+        appendRecord(entry.buffer, entry.queryHash, entry.added[i]);
+    }
+    writtenRecords[thread] += entry.added.size();
+    writer->writeData(entry.buffer.c_str(), entry.buffer.size(), entry.key, thread);
+    writtenKeys[thread].push_back(entry.key);
+}
+
+void AlignmentCache::close() {
+    std::vector<unsigned int> written;
+    for (size_t thread = 0; thread < writtenKeys.size(); thread++) {
+        written.insert(written.end(), writtenKeys[thread].begin(), writtenKeys[thread].end());
+    }
+    std::sort(written.begin(), written.end());
+    size_t carried = 0;
+    size_t dropped = 0;
+    if (reader != NULL) {
+        // the records of the carried entries age by one run, records of other parameters are dropped
+        std::string buffer;
+        char *columns[COLUMNS];
+        for (size_t id = 0; id < reader->getSize(); id++) {
+            const unsigned int key = reader->getDbKey(id);
+            if (std::binary_search(written.begin(), written.end(), key) == true) {
+                continue;
+            }
+            buffer.clear();
+            char *data = reader->getData(id);
+            while (*data != '\0') {
+                char *next = Util::skipLine(data);
+                const size_t count = Util::getWordsOfLine(data, columns, COLUMNS);
+                const unsigned int age = (count == COLUMNS) ? static_cast<unsigned int>(strtoul(columns[2], NULL, 10)) + 1 : UINT_MAX;
+                if (age <= maxAge && strtoull(columns[1], NULL, 10) == parameterHash) {
+                    const char *ageEnd = columns[2] + Util::skipNoneWhitespace(columns[2]);
+                    buffer.append(data, columns[2] - data);
+                    buffer.append(SSTR(age));
+                    buffer.append(ageEnd, next - ageEnd);
+                    carried++;
+                } else {
+                    dropped++;
+                }
+                data = next;
+            }
+            if (buffer.empty() == false) {
+                writer->writeData(buffer.c_str(), buffer.size(), key, 0);
+            }
+        }
+        reader->close();
+        delete reader;
+        reader = NULL;
+    }
+    writer->close();
+    if (std::rename(newCacheDB.c_str(), cacheDB.c_str()) != 0
+        || std::rename((newCacheDB + ".index").c_str(), (cacheDB + ".index").c_str()) != 0) {
+        Debug(Debug::ERROR) << "Could not replace the alignment cache " << cacheDB << " with " << newCacheDB << ".\n";
+        EXIT(EXIT_FAILURE);
+    }
+    DBWriter::moveIndexSidecar(newCacheDB + ".index", cacheDB + ".index");
+    writtenRecords[0] += carried;
+    Debug(Debug::INFO) << getCacheHits() << " of them were taken from the alignment cache ("
+                       << written.size() << " queries written, " << carried << " records carried over, "
+                       << dropped << " dropped).\n";
+}
+
+size_t AlignmentCache::getCacheHits() const {
+    size_t hits = 0;
+    for (size_t thread = 0; thread < cacheHits.size(); thread++) {
+        hits += cacheHits[thread];
+    }
+    return hits;
+}
+
+size_t AlignmentCache::getRecordCount() const {
+    size_t records = 0;
+    for (size_t thread = 0; thread < writtenRecords.size(); thread++) {
+        records += writtenRecords[thread];
+    }
+    return records;
+}
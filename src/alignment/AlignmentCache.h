@@ -0,0 +1,111 @@
+#ifndef MMSEQS_ALIGNMENTCACHE_H
+#define MMSEQS_ALIGNMENTCACHE_H
+
+// Persistent cache of alignment results across runs (--alignment-cache), so that repeated searches
+// on slowly growing databases only align the pairs they have not seen before.
+// A result is keyed by the content hashes of the query and target sequence, a hash of the alignment
+// parameters and the prefilter diagonal. It is stored with its raw score and the e-value is recomputed
+// for the size of the current target database.
+//
+// The cache is a database with one entry per query, keyed by 32 bits of the query hash. The results of
+// a run are written to <cache>.new together with the entries of queries that were not aligned in this
+// run, which then replaces the cache. Entries of queries with the same key can replace each other,
+// this only costs their alignments in the next run.
+// Records of other alignment parameters are dropped when the cache is rewritten and every record counts
+// the runs since it was last used, so results of targets that left the database are dropped after maxAge runs.
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "Sequence.h"
+#include "Matcher.h"
+#include "EvalueComputation.h"
+
+class AlignmentCache {
+public:
+    struct Record {
+        size_t targetHash;
+        unsigned int targetLen;
+        int diagonal;
+        int rawScore;
+        // runs since the record was last looked up or added
+        unsigned int age;
+        Matcher::result_t result;
+
+        static bool compareByTarget(const Record &first, const Record &second) {
+            if (first.targetHash != second.targetHash) {
+                return first.targetHash < second.targetHash;
+            }
+            if (first.targetLen != second.targetLen) {
+                return first.targetLen < second.targetLen;
+            }
+            return first.diagonal < second.diagonal;
+        }
+    };
+
+    // the cached and the new results of the current query of a thread
+    struct QueryEntry {
+        size_t queryHash;
+        unsigned int key;
+        // sorted by compareByTarget
+        std::vector<Record> cached;
+        std::vector<Record> added;
+        std::string buffer;
+    };
+
+    // parameterHash has to cover everything besides the sequences that changes the results of Matcher::getSWResult
+    // records that were not used in the last maxAge runs are dropped
+    AlignmentCache(const std::string &cacheDB, size_t parameterHash, unsigned int maxAge, unsigned int threads);
+
+    ~AlignmentCache();
+
+    static size_t hashSequence(const Sequence &seq);
+
+    // reads the cached results of the query
+    void loadQuery(QueryEntry &entry, const Sequence &query);
+
+    // fills result with the cached result of the target if there is one that getSWResult would give as well:
+    // results that were cut short above the e-value threshold are only used if they are still above it
+    bool lookup(QueryEntry &entry, Sequence &target, size_t targetHash, int diagonal,
+                EvalueComputation &evaluer, double evalThr, Matcher::result_t &result, unsigned int thread);
+
+    // rawScore is the score the e-value of the result was computed from (Matcher::getLastRawScore)
+    void add(QueryEntry &entry, size_t targetHash, unsigned int targetLen, int diagonal, int rawScore,
+             const Matcher::result_t &result);
+
+    // writes the cached and the new results of the query
+    void writeQuery(QueryEntry &entry, unsigned int thread);
+
+    // carries over the entries of the queries that were not written and replaces the cache
+    void close();
+
+    // number of records the last close wrote, dropped records are not counted
+    size_t getRecordCount() const;
+
+    size_t getCacheHits() const;
+
+private:
+    const std::string cacheDB;
+    const std::string newCacheDB;
+    const size_t parameterHash;
+    const unsigned int maxAge;
+    const unsigned int threads;
+
+    // NULL if there is no cache yet
+    DBReader<unsigned int> *reader;
+    DBWriter *writer;
+
+    // keys written by each thread
+    std::vector<std::vector<unsigned int> > writtenKeys;
+    std::vector<size_t> cacheHits;
+    std::vector<size_t> writtenRecords;
+
+    static const size_t COLUMNS = 19;
+
+    void appendRecord(std::string &buffer, size_t queryHash, const Record &record);
+};
+
+#endif //MMSEQS_ALIGNMENTCACHE_H
@@ -31,6 +31,8 @@ fastMatrix(SubstitutionMatrix::createAsciiSubMat(*subMat))
     }
     this->gape = gape;
     this->gapo = gapo;
+    alphabetSize = subMat->alphabetSize;
+    extensionWindow = 0;
 }
 
 BandedNucleotideAligner::~BandedNucleotideAligner(){
@@ -53,6 +55,79 @@ void BandedNucleotideAligner::initQuery(Sequence * query){
 
 
 
+int BandedNucleotideAligner::extendInWindows(const uint8_t *query, int queryLen, const uint8_t *target, int targetLen,
+                                             int &queryEnd, int &targetEnd, std::vector<uint32_t> &cigar) {
+    const int overlap = std::max(extensionWindow / 4, 1);
+    std::vector<uint32_t> kept;
+    int keptScore = 0;
+    int queryPos = 0;
+    int targetPos = 0;
+    int bestScore = 0;
+    queryEnd = -1;
+    targetEnd = -1;
+    cigar.clear();
+    ksw_extz_t ez;
+    memset(&ez, 0, sizeof(ksw_extz_t));
+    while (queryPos < queryLen && targetPos < targetLen) {
+        const int queryWindow = std::min(extensionWindow, queryLen - queryPos);
+        const int targetWindow = std::min(extensionWindow, targetLen - targetPos);
+        ksw_extz2_sse(0, queryWindow, query + queryPos, targetWindow, target + targetPos, 5, mat, gapo, gape,
+                      BAND_WIDTH, ZDROP, KSW_EZ_EXTZ_ONLY, &ez);
+        if (ez.max_q < 0 || ez.max_t < 0) {
+            break;
+        }
+        if (keptScore + static_cast<int>(ez.max) > bestScore) {
+            bestScore = keptScore + ez.max;
+            queryEnd = queryPos + ez.max_q;
+            targetEnd = targetPos + ez.max_t;
+            cigar = kept;
+            for (int i = 0; i < ez.n_cigar; i++) {
+                if (i == 0 && cigar.empty() == false && (cigar.back() & 0xf) == (ez.cigar[i] & 0xf)) {
+                    cigar.back() += ez.cigar[i] & ~0xfu;
+                } else {
+                    cigar.push_back(ez.cigar[i]);
+                }
+            }
+        }
+        // the alignment ended inside the window or there is nothing left to extend into
+        const bool lastWindow = queryWindow == queryLen - queryPos || targetWindow == targetLen - targetPos;
+        if (lastWindow || (ez.max_q < queryWindow - overlap && ez.max_t < targetWindow - overlap)) {
+            break;
+        }
+
+        // keep the path up to a quarter window before its best cell, cutting inside matches only
+        const int queryCut = std::max(ez.max_q + 1 - overlap, 1);
+        const int targetCut = std::max(ez.max_t + 1 - overlap, 1);
+        int queryStep = 0;
+        int targetStep = 0;
+        for (int i = 0; i < ez.n_cigar && queryStep < queryCut && targetStep < targetCut; i++) {
+            const uint32_t op = ez.cigar[i] & 0xf;
+            uint32_t len = ez.cigar[i] >> 4;
+            if (op == 0) {
+                len = std::min(len, static_cast<uint32_t>(std::min(queryCut - queryStep, targetCut - targetStep)));
+                for (uint32_t pos = 0; pos < len; pos++) {
+                    keptScore += mat[query[queryPos + queryStep + pos] * alphabetSize + target[targetPos + targetStep + pos]];
+                }
+                queryStep += len;
+                targetStep += len;
+            } else {
+                keptScore -= gapo + static_cast<int>(len) * gape;
+                queryStep += (op == 1) ? len : 0;
+                targetStep += (op == 2) ? len : 0;
+            }
+            if (kept.empty() == false && (kept.back() & 0xf) == op) {
+                kept.back() += len << 4;
+            } else {
+                kept.push_back(len << 4 | op);
+            }
+        }
+        queryPos += queryStep;
+        targetPos += targetStep;
+    }
+    free(ez.cigar);
+    return bestScore;
+}
+
 s_align BandedNucleotideAligner::align(Sequence * targetSeqObj, short diagonal,
                                        EvalueComputation * evaluer)
 {
@@ -111,11 +186,39 @@ s_align BandedNucleotideAligner::align(Sequence * targetSeqObj, short diagonal,
     int qStartRev = (querySeqObj->L  - qUngappedEndPos) - 1;
     int tStartRev = (targetSeqObj->L - dbUngappedEndPos) - 1;
 
+    const bool useWindows = extensionWindow > 0 && (querySeqObj->L > extensionWindow || targetSeqObj->L > extensionWindow);
+    if (useWindows) {
+        // the start is found by extending the reversed sequences, the cigar of that pass is not needed
+        std::vector<uint32_t> cigar;
+        int qEndRev, tEndRev;
+        extendInWindows(querySeqRev + qStartRev, querySeqObj->L - qStartRev, targetSeqRev + tStartRev,
+                        targetSeqObj->L - tStartRev, qEndRev, tEndRev, cigar);
+        const int qStartPos = querySeqObj->L - (qStartRev + qEndRev) - 1;
+        const int tStartPos = targetSeqObj->L - (tStartRev + tEndRev) - 1;
+        int qEnd, tEnd;
+        const int score = extendInWindows(querySeq + qStartPos, querySeqObj->L - qStartPos, targetSeq + tStartPos,
+                                          targetSeqObj->L - tStartPos, qEnd, tEnd, cigar);
+        s_align result;
+        result.cigar = new uint32_t[std::max(cigar.size(), static_cast<size_t>(1))];
+        std::copy(cigar.begin(), cigar.end(), result.cigar);
+        result.cigarLen = cigar.size();
+        // s_align holds 16 bit scores
+        result.score1 = std::min(score, static_cast<int>(UINT16_MAX));
+        result.qStartPos1 = qStartPos;
+        result.qEndPos1 = qStartPos + qEnd;
+        result.dbEndPos1 = tStartPos + tEnd;
+        result.dbStartPos1 = tStartPos;
+        result.qCov = SmithWaterman::computeCov(result.qStartPos1, result.qEndPos1, querySeqObj->L);
+        result.tCov = SmithWaterman::computeCov(result.dbStartPos1, result.dbEndPos1, targetSeqObj->L);
+        result.evalue = evaluer->computeEvalue(result.score1, querySeqObj->L);
+        return result;
+    }
+
     ksw_extz_t ez;
     int flag = 0;
     flag |= KSW_EZ_SCORE_ONLY;
     flag |= KSW_EZ_EXTZ_ONLY;
-    ksw_extz2_sse(0, querySeqObj->L - qStartRev, querySeqRev + qStartRev, targetSeqObj->L - tStartRev, targetSeqRev + tStartRev, 5, mat, gapo, gape, 64, 40, flag, &ez);
+    ksw_extz2_sse(0, querySeqObj->L - qStartRev, querySeqRev + qStartRev, targetSeqObj->L - tStartRev, targetSeqRev + tStartRev, 5, mat, gapo, gape, BAND_WIDTH, ZDROP, flag, &ez);
 
     int qStartPos = querySeqObj->L  - ( qStartRev + ez.max_q ) -1 ;
     int tStartPos = targetSeqObj->L - ( tStartRev + ez.max_t ) -1;
@@ -128,7 +231,7 @@ s_align BandedNucleotideAligner::align(Sequence * targetSeqObj, short diagonal,
 //    printf("%d %d\n", qStartPos, tStartPos);
     memset(&ezAlign, 0, sizeof(ksw_extz_t));
     ksw_extz2_sse(0, querySeqObj->L-qStartPos, querySeq+qStartPos, targetSeqObj->L-tStartPos, targetSeq+tStartPos, 5,
-                  mat, gapo, gape, 64, 40, alignFlag, &ezAlign);
+                  mat, gapo, gape, BAND_WIDTH, ZDROP, alignFlag, &ezAlign);
 
     std::string letterCode = "MID";
     uint32_t * retCigar = new uint32_t[ezAlign.n_cigar];
@@ -11,6 +11,7 @@
 #include "SubstitutionMatrix.h"
 #include "Debug.h"
 
+#include <vector>
 
 class BandedNucleotideAligner {
 public:
@@ -24,7 +25,23 @@ public:
 
     s_align align(Sequence * targetSeqObj, short diagonal, EvalueComputation * evaluer);
 
+    // extend in windows of this many residues with a moving band, the DP memory is then bounded by the window
+    // instead of the sequence length (0: extend in one piece)
+    void setExtensionWindow(int window) {
+        extensionWindow = window;
+    }
+
 private:
+    // band width and Z-drop of the KSW2 extension
+    static const int BAND_WIDTH = 64;
+    static const int ZDROP = 40;
+
+    // extends from the first residue of query and target window by window. While the best cell of a window lies
+    // in its last quarter, the path is kept up to a quarter window before that cell and the next window starts there.
+    // Returns the best score, its end and the cigar up to there
+    int extendInWindows(const uint8_t *query, int queryLen, const uint8_t *target, int targetLen,
+                        int &queryEnd, int &targetEnd, std::vector<uint32_t> &cigar);
+
     SubstitutionMatrix::FastMatrix fastMatrix;
     uint8_t * targetSeq;
     uint8_t * targetSeqRev;
@@ -32,6 +49,8 @@ private:
     uint8_t * querySeqRev;
     Sequence * querySeqObj;
     int8_t * mat;
+    int alphabetSize;
+    int extensionWindow;
 //    uint32_t * cigar;
     int gapo;
     int gape;
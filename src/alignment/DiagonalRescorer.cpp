@@ -0,0 +1,102 @@
+#include "DiagonalRescorer.h"
+#include "Debug.h"
+#include "Util.h"
+#include "simd.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+DiagonalRescorer::DiagonalRescorer(BaseMatrix &subMat)
+        : kernels(SimdKernels::get()), lanes(kernels.vectorSize / 2),
+          fastMatrix(SubstitutionMatrix::createAsciiSubMat(subMat)),
+          profile(NULL), profileCapacity(0), querySeq(NULL), queryLen(0), maxTargetLen(0), targetCount(0) {
+    // the kernel looks up residues by their lower 5 bits, this maps the letters A to Z to 1 to 26
+    // and their lower case to the same
+    const size_t rowSize = SimdKernels::DIAGONAL_PROFILE_SIZE;
+    residueRows = new char[2 * rowSize * rowSize];
+    for (size_t residue = 0; residue < rowSize; residue++) {
+        short rowScores[SimdKernels::DIAGONAL_PROFILE_SIZE];
+        std::fill_n(rowScores, rowSize, SCHAR_MIN);
+        for (size_t target = 1; residue >= 1 && residue <= 26 && target <= 26; target++) {
+            rowScores[target] = fastMatrix.matrix['@' + residue]['@' + target];
+        }
+        char *low = residueRows + residue * 2 * rowSize;
+        char *high = low + rowSize;
+        for (size_t aa = 0; aa < rowSize; aa++) {
+            low[aa] = static_cast<char>(rowScores[aa] & 0xFF);
+            high[aa] = static_cast<char>((rowScores[aa] >> 8) & 0xFF);
+        }
+    }
+    targetSeqs = new const char*[lanes];
+    lengths = new short[lanes];
+    scores = new short[lanes];
+    starts = new short[lanes];
+    ends = new short[lanes];
+}
+
+DiagonalRescorer::~DiagonalRescorer() {
+    free(profile);
+    delete[] residueRows;
+    delete[] targetSeqs;
+    delete[] fastMatrix.matrix;
+    delete[] fastMatrix.matrixData;
+    delete[] lengths;
+    delete[] scores;
+    delete[] starts;
+    delete[] ends;
+}
+
+void DiagonalRescorer::initQuery(const char *querySeq, unsigned int queryLen) {
+    const size_t rowBytes = 2 * SimdKernels::DIAGONAL_PROFILE_SIZE;
+    if (queryLen > profileCapacity) {
+        free(profile);
+        profileCapacity = std::max(queryLen, 2 * profileCapacity);
+        profile = (char *) mem_align(MAX_ALIGN_INT, profileCapacity * rowBytes);
+    }
+    this->querySeq = querySeq;
+    this->queryLen = queryLen;
+    for (unsigned int pos = 0; pos < queryLen; pos++) {
+        const unsigned char residue = static_cast<unsigned char>(querySeq[pos]) & (SimdKernels::DIAGONAL_PROFILE_SIZE - 1);
+        memcpy(profile + pos * rowBytes, residueRows + residue * rowBytes, rowBytes);
+    }
+    targetCount = 0;
+    maxTargetLen = 0;
+}
+
+void DiagonalRescorer::addTarget(const char *targetSeq, unsigned int diagonalLen) {
+    if (targetCount >= lanes || diagonalLen > MAX_DIAGONAL_LEN) {
+        Debug(Debug::ERROR) << "Too many or too long targets for the diagonal rescoring.\n";
+        EXIT(EXIT_FAILURE);
+    }
+    maxTargetLen = std::max(maxTargetLen, diagonalLen);
+    lengths[targetCount] = static_cast<short>(diagonalLen);
+    targetSeqs[targetCount] = targetSeq;
+    targetCount++;
+}
+
+void DiagonalRescorer::rescore(unsigned int queryStart, std::vector<DistanceCalculator::LocalAlignment> &results) {
+    results.clear();
+    if (targetCount == 0) {
+        return;
+    }
+    if (queryStart + maxTargetLen > queryLen) {
+        Debug(Debug::ERROR) << "Diagonal exceeds the query in the diagonal rescoring.\n";
+        EXIT(EXIT_FAILURE);
+    }
+    // unused lanes are empty and never read
+    std::fill(lengths + targetCount, lengths + lanes, 0);
+    std::fill(targetSeqs + targetCount, targetSeqs + lanes, querySeq);
+    kernels.diagonalRescore(profile + static_cast<size_t>(queryStart) * 2 * SimdKernels::DIAGONAL_PROFILE_SIZE,
+                            targetSeqs, lengths, maxTargetLen, scores, starts, ends);
+    for (size_t lane = 0; lane < targetCount; lane++) {
+        if (scores[lane] == SHRT_MAX) {
+            results.push_back(DistanceCalculator::computeSubstitutionStartEndDistance(
+                    querySeq + queryStart, targetSeqs[lane], lengths[lane], fastMatrix.matrix));
+        } else {
+            results.push_back(DistanceCalculator::LocalAlignment(starts[lane], ends[lane], scores[lane]));
+        }
+    }
+    targetCount = 0;
+    maxTargetLen = 0;
+}
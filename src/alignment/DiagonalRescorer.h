@@ -0,0 +1,68 @@
+#ifndef MMSEQS_DIAGONALRESCORER_H
+#define MMSEQS_DIAGONALRESCORER_H
+
+// Ungapped local scores of many targets on the same diagonal of one query, one target per 16 bit lane
+// (8, 16 or 32 depending on SimdKernels). Gives the same score, start and end position as
+// DistanceCalculator::computeSubstitutionStartEndDistance, which rescorediagonal calls for single hits.
+
+#include "SimdKernels.h"
+#include "DistanceCalculator.h"
+#include "SubstitutionMatrix.h"
+
+#include <climits>
+#include <cstddef>
+#include <vector>
+
+class DiagonalRescorer {
+public:
+    // longest diagonal the 16 bit positions can address
+    static const unsigned int MAX_DIAGONAL_LEN = SHRT_MAX - 1;
+
+    explicit DiagonalRescorer(BaseMatrix &subMat);
+    ~DiagonalRescorer();
+
+    // the query and the targets are ASCII residues as in a sequence database
+    void initQuery(const char *querySeq, unsigned int queryLen);
+
+    size_t getLanes() const {
+        return lanes;
+    }
+
+    size_t getTargetCount() const {
+        return targetCount;
+    }
+
+    // the batch holds at most getLanes() targets, targetSeq points to the first residue on the diagonal
+    // and diagonalLen is at most MAX_DIAGONAL_LEN
+    void addTarget(const char *targetSeq, unsigned int diagonalLen);
+
+    // scores all added targets against the query from queryStart on in the order they were added and empties the batch,
+    // the start and end positions are relative to the first residue on the diagonal
+    void rescore(unsigned int queryStart, std::vector<DistanceCalculator::LocalAlignment> &results);
+
+private:
+    const SimdKernels &kernels;
+    const size_t lanes;
+    // scores of a saturated lane are recomputed with the scalar version
+    SubstitutionMatrix::FastMatrix fastMatrix;
+
+    // low bytes and high bytes of the scores of each query residue against all target residues
+    char *residueRows;
+    // low bytes and high bytes of the scores of each query position against all residue types, grown on demand
+    char *profile;
+    unsigned int profileCapacity;
+    const char *querySeq;
+    unsigned int queryLen;
+
+    // the kernel reads the targets in place
+    const char **targetSeqs;
+    unsigned int maxTargetLen;
+    size_t targetCount;
+
+    short *lengths;
+    short *scores;
+    short *starts;
+    short *ends;
+};
+
+#endif //MMSEQS_DIAGONALRESCORER_H
@@ -0,0 +1,132 @@
+#include "InterSequenceAligner.h"
+#include "Debug.h"
+#include "Util.h"
+#include "simd.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+
+InterSequenceAligner::InterSequenceAligner(unsigned int maxQueryLen, int alphabetSize, int gapOpen, int gapExtend)
+        : kernels(SimdKernels::get()), lanes(kernels.vectorSize), maxQueryLen(maxQueryLen),
+          alphabetSize(alphabetSize), gapOpen(static_cast<uint8_t>(gapOpen)), gapExtend(static_cast<uint8_t>(gapExtend)),
+          queryLen(0), bias(0), targets(NULL), targetCapacity(0), maxTargetLen(0), targetCount(0) {
+    if (alphabetSize >= (int) SimdKernels::PADDING_RESIDUE) {
+        Debug(Debug::ERROR) << "Alphabet size " << alphabetSize << " is too large for the inter-sequence alignment.\n";
+        EXIT(EXIT_FAILURE);
+    }
+    workspace.vH = mem_align(MAX_ALIGN_INT, maxQueryLen * lanes);
+    workspace.vE = mem_align(MAX_ALIGN_INT, maxQueryLen * lanes);
+    workspace.vPositionBias = mem_align(MAX_ALIGN_INT, maxQueryLen * lanes);
+    workspace.vScores = mem_align(MAX_ALIGN_INT, SimdKernels::DIAGONAL_PROFILE_SIZE * lanes);
+    scoreRows = (char *) mem_align(MAX_ALIGN_INT, SimdKernels::DIAGONAL_PROFILE_SIZE * SimdKernels::DIAGONAL_PROFILE_SIZE);
+    memset(scoreRows, 0, SimdKernels::DIAGONAL_PROFILE_SIZE * SimdKernels::DIAGONAL_PROFILE_SIZE);
+    querySequence = new unsigned char[maxQueryLen];
+    positionBias = new unsigned char[maxQueryLen];
+    scores = new uint8_t[lanes];
+    dbEnds = new int32_t[lanes];
+}
+
+InterSequenceAligner::~InterSequenceAligner() {
+    free(workspace.vH);
+    free(workspace.vE);
+    free(workspace.vPositionBias);
+    free(workspace.vScores);
+    free(scoreRows);
+    free(targets);
+    delete[] querySequence;
+    delete[] positionBias;
+    delete[] scores;
+    delete[] dbEnds;
+}
+
+void InterSequenceAligner::initQuery(const int *sequence, unsigned int queryLen, const int8_t *mat,
+                                     const int8_t *compositionBias) {
+    if (queryLen > maxQueryLen) {
+        Debug(Debug::ERROR) << "Query length " << queryLen << " exceeds " << maxQueryLen << ".\n";
+        EXIT(EXIT_FAILURE);
+    }
+    this->queryLen = queryLen;
+    int matBias = 0;
+    for (int i = 0; i < alphabetSize * alphabetSize; i++) {
+        matBias = std::min(matBias, static_cast<int>(mat[i]));
+    }
+    int minCompositionBias = 0;
+    if (compositionBias != NULL) {
+        for (unsigned int j = 0; j < queryLen; j++) {
+            minCompositionBias = std::min(minCompositionBias, static_cast<int>(compositionBias[j]));
+        }
+    }
+    bias = static_cast<uint8_t>(-matBias - minCompositionBias);
+
+    for (int aa = 0; aa < alphabetSize; aa++) {
+        char *row = scoreRows + aa * SimdKernels::DIAGONAL_PROFILE_SIZE;
+        for (int target = 0; target < alphabetSize; target++) {
+            row[target] = static_cast<char>(mat[target * alphabetSize + aa] - matBias);
+        }
+    }
+    for (unsigned int j = 0; j < queryLen; j++) {
+        querySequence[j] = static_cast<unsigned char>(sequence[j]);
+        const int positionScore = (compositionBias != NULL) ? compositionBias[j] : 0;
+        positionBias[j] = static_cast<unsigned char>(positionScore - minCompositionBias);
+    }
+    targetCount = 0;
+    maxTargetLen = 0;
+}
+
+void InterSequenceAligner::addTarget(const int *sequence, unsigned int length) {
+    if (targetCount >= lanes) {
+        Debug(Debug::ERROR) << "Too many targets for the inter-sequence alignment.\n";
+        EXIT(EXIT_FAILURE);
+    }
+    if (length > maxTargetLen) {
+        const size_t required = static_cast<size_t>(length) * lanes;
+        if (required > targetCapacity) {
+            const size_t capacity = std::max(required, 2 * targetCapacity);
+            unsigned char *grown = (unsigned char *) mem_align(MAX_ALIGN_INT, capacity);
+            if (targets != NULL) {
+                memcpy(grown, targets, static_cast<size_t>(maxTargetLen) * lanes);
+                free(targets);
+            }
+            targets = grown;
+            targetCapacity = capacity;
+        }
+        // pad the columns that are new for the targets added before
+        memset(targets + static_cast<size_t>(maxTargetLen) * lanes, SimdKernels::PADDING_RESIDUE,
+               static_cast<size_t>(length - maxTargetLen) * lanes);
+        maxTargetLen = length;
+    }
+    unsigned char *lane = targets + targetCount;
+    for (unsigned int i = 0; i < length; i++) {
+        lane[i * lanes] = static_cast<unsigned char>(sequence[i]);
+    }
+    for (unsigned int i = length; i < maxTargetLen; i++) {
+        lane[i * lanes] = SimdKernels::PADDING_RESIDUE;
+    }
+    targetCount++;
+}
+
+void InterSequenceAligner::align(std::vector<Result> &results) {
+    results.clear();
+    if (targetCount == 0) {
+        return;
+    }
+    // unused lanes are padding
+    for (size_t lane = targetCount; lane < lanes; lane++) {
+        for (unsigned int i = 0; i < maxTargetLen; i++) {
+            targets[i * lanes + lane] = SimdKernels::PADDING_RESIDUE;
+        }
+    }
+    kernels.interSequence(workspace, scoreRows, alphabetSize, querySequence, positionBias, queryLen,
+                          targets, maxTargetLen, gapOpen, gapExtend, bias, scores, dbEnds);
+    for (size_t lane = 0; lane < targetCount; lane++) {
+        Result result;
+        result.score = scores[lane];
+        result.dbEndPos = dbEnds[lane];
+        // as in SmithWaterman, the byte scores are exact below 255 - bias
+        result.overflow = (scores[lane] + bias >= 255);
+        results.push_back(result);
+    }
+    targetCount = 0;
+    maxTargetLen = 0;
+}
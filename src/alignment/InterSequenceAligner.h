@@ -0,0 +1,73 @@
+#ifndef MMSEQS_INTERSEQUENCEALIGNER_H
+#define MMSEQS_INTERSEQUENCEALIGNER_H
+
+// Smith-Waterman scores of many targets against one query in a single pass, one target per byte lane
+// (16, 32 or 64 depending on SimdKernels). Meant for short queries and targets, where the striped alignment
+// of SmithWaterman leaves most lanes empty. Only score and end position on the target are computed.
+// The score is the exact affine gap score and can exceed the one of SmithWaterman::ssw_align,
+// which disallows an insertion directly after a deletion at the stripe boundaries, but it is never lower.
+
+#include "SimdKernels.h"
+
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+
+class InterSequenceAligner {
+public:
+    struct Result {
+        int score;
+        // 0-based, -1 if the score is 0
+        int dbEndPos;
+        // the score did not fit into a byte, score is a lower bound
+        bool overflow;
+    };
+
+    InterSequenceAligner(unsigned int maxQueryLen, int alphabetSize, int gapOpen, int gapExtend);
+    ~InterSequenceAligner();
+
+    // mat is the alphabetSize * alphabetSize matrix of SmithWaterman::ssw_init (row is the target residue),
+    // compositionBias is added to every score of a query position and can be NULL
+    void initQuery(const int *querySequence, unsigned int queryLen, const int8_t *mat, const int8_t *compositionBias);
+
+    size_t getLanes() const {
+        return lanes;
+    }
+
+    size_t getTargetCount() const {
+        return targetCount;
+    }
+
+    // the batch holds at most getLanes() targets
+    void addTarget(const int *sequence, unsigned int length);
+
+    // scores all added targets in the order they were added and empties the batch
+    void align(std::vector<Result> &results);
+
+private:
+    const SimdKernels &kernels;
+    const size_t lanes;
+    const unsigned int maxQueryLen;
+    const int alphabetSize;
+    const uint8_t gapOpen;
+    const uint8_t gapExtend;
+
+    SimdKernels::InterSequenceWorkspace workspace;
+    // scores of each query residue type indexed by the target residue
+    char *scoreRows;
+    unsigned char *querySequence;
+    unsigned char *positionBias;
+    unsigned int queryLen;
+    uint8_t bias;
+
+    // interleaved target residues
+    unsigned char *targets;
+    size_t targetCapacity;
+    unsigned int maxTargetLen;
+    size_t targetCount;
+
+    uint8_t *scores;
+    int32_t *dbEnds;
+};
+
+#endif //MMSEQS_INTERSEQUENCEALIGNER_H
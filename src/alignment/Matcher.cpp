@@ -1,3 +1,4 @@
+#include <cstddef>
 #include <iomanip>
 #include <itoa.h>
 #include "Matcher.h"
@@ -7,6 +8,7 @@
 
 const unsigned short Matcher::GAP_OPEN;
 const unsigned short Matcher::GAP_EXTEND;
+const unsigned int Matcher::INTER_SEQUENCE_MAX_LEN;
 
 Matcher::Matcher(int querySeqType, int maxSeqLen, BaseMatrix *m, EvalueComputation * evaluer,
                  bool aaBiasCorrection, int gapOpen, int gapExtend){
@@ -14,6 +16,7 @@ Matcher::Matcher(int querySeqType, int maxSeqLen, BaseMatrix *m, EvalueComputati
     this->tinySubMat = NULL;
     this->gapOpen = gapOpen;
     this->gapExtend = gapExtend;
+    this->lastRawScore = 0;
     if(querySeqType != Sequence::PROFILE_STATE_PROFILE ) {
         setSubstitutionMatrix(m);
     }
@@ -21,16 +24,35 @@ Matcher::Matcher(int querySeqType, int maxSeqLen, BaseMatrix *m, EvalueComputati
     this->maxSeqLen = maxSeqLen;
     nuclaligner=NULL;
     aligner=NULL;
+    interAligner=NULL;
+    interAlignerReady=false;
+    xdropBand=0;
+    xdrop=0;
     if(querySeqType==Sequence::NUCLEOTIDES){
         nuclaligner = new  BandedNucleotideAligner(m, maxSeqLen, gapOpen, gapExtend);
     }else{
         aligner = new SmithWaterman(maxSeqLen, m->alphabetSize, aaBiasCorrection);
     }
+    if(querySeqType==Sequence::AMINO_ACIDS){
+        interAligner = new InterSequenceAligner(std::min(static_cast<unsigned int>(maxSeqLen), INTER_SEQUENCE_MAX_LEN),
+                                                m->alphabetSize, gapOpen, gapExtend);
+    }
     this->evaluer = evaluer;
     //std::cout << "lambda=" << lambdaLog2 << " logKLog2=" << logKLog2 << std::endl;
 }
 
 
+void Matcher::setXdropBand(int bandWidth, float xdropBits) {
+    xdropBand = bandWidth;
+    xdrop = static_cast<int>(xdropBits * m->getBitFactor() + 0.5f);
+}
+
+void Matcher::setExtensionWindow(int window) {
+    if(nuclaligner != NULL){
+        nuclaligner->setExtensionWindow(window);
+    }
+}
+
 void Matcher::setSubstitutionMatrix(BaseMatrix *m){
     this->tinySubMat = new int8_t[m->alphabetSize*m->alphabetSize];
     for (int i = 0; i < m->alphabetSize; i++) {
@@ -47,6 +69,9 @@ Matcher::~Matcher(){
     if(nuclaligner != NULL){
         delete nuclaligner;
     }
+    if(interAligner != NULL){
+        delete interAligner;
+    }
     if(tinySubMat != NULL){
         delete [] tinySubMat;
         tinySubMat = NULL;
@@ -62,6 +87,12 @@ void Matcher::initQuery(Sequence* query){
     }else{
         aligner->ssw_init(query, this->tinySubMat, this->m, this->m->alphabetSize, 2);
     }
+    interAlignerReady = false;
+    if(interAligner != NULL && query->getSequenceType() == Sequence::AMINO_ACIDS
+       && static_cast<unsigned int>(query->L) <= INTER_SEQUENCE_MAX_LEN){
+        interAligner->initQuery(query->int_sequence, query->L, this->tinySubMat, aligner->getCompositionBias());
+        interAlignerReady = true;
+    }
 }
 
 
@@ -90,7 +121,22 @@ Matcher::result_t Matcher::getSWResult(Sequence* dbSeq, const int diagonal, cons
         alignment = nuclaligner->align(dbSeq,diagonal,evaluer);
         alignmentMode = Matcher::SCORE_COV_SEQID;
     }else if(isIdentity==false){
-        alignment = aligner->ssw_align(dbSeq->int_sequence, dbSeq->L, gapOpen, gapExtend, alignmentMode, evalThr, evaluer, covMode, covThr, maskLen);
+        // diagonals of the prefilter wrap around for longer sequences
+        bool bandHit = true;
+        if(xdropBand > 0 && diagonal != INT_MAX && currentQuery->L <= SHRT_MAX && dbSeq->L <= SHRT_MAX){
+            alignment = aligner->ssw_align_xdrop(dbSeq->int_sequence, dbSeq->L, gapOpen, gapExtend, static_cast<short>(diagonal),
+                                                 xdropBand, xdrop, evaluer, bandHit);
+            if(bandHit){
+                delete [] alignment.cigar;
+            }else if(alignmentMode == Matcher::SCORE_ONLY){
+                // like ssw_align, only the end positions are reported
+                alignment.qStartPos1 = -1;
+                alignment.dbStartPos1 = -1;
+            }
+        }
+        if(bandHit){
+            alignment = aligner->ssw_align(dbSeq->int_sequence, dbSeq->L, gapOpen, gapExtend, alignmentMode, evalThr, evaluer, covMode, covThr, maskLen);
+        }
     }else{
         alignment = aligner->scoreIdentical(dbSeq->int_sequence, dbSeq->L, evaluer, alignmentMode);
     }
@@ -180,6 +226,7 @@ Matcher::result_t Matcher::getSWResult(Sequence* dbSeq, const int diagonal, cons
     double evalue = alignment.evalue;
     int bitScore = static_cast<short>(evaluer->computeBitScore(alignment.score1)+0.5);
 
+    lastRawScore = alignment.score1;
     result_t result(dbSeq->getDbKey(), bitScore, qcov, dbcov, seqId, evalue, alnLength, qStartPos, qEndPos, currentQuery->L, dbStartPos, dbEndPos, dbSeq->L, backtrace);
     delete [] alignment.cigar;
     return result;
@@ -251,48 +298,122 @@ Matcher::result_t Matcher::parseAlignmentRecord(char *data, bool readCompressed)
         Debug(Debug::ERROR) << "Invalid alignment result record.\n";
         EXIT(EXIT_FAILURE);
     }
+    result_t result;
+    parseAlignmentColumns(entry, columns, result, readCompressed, true);
+    return result;
+}
 
-    char key[255];
-    ptrdiff_t keySize =  (entry[1] - data);
-    strncpy(key, data, keySize);
-    key[keySize] = '\0';
-
-    unsigned int targetId = Util::fast_atoi<unsigned int>(key);
-    int score = Util::fast_atoi<int>(entry[1]);
-    double seqId = strtod(entry[2],NULL);
-    double eval = strtod(entry[3],NULL);
-
-    int qStart =  Util::fast_atoi<int>(entry[4]);
-    int qEnd = Util::fast_atoi<int>(entry[5]);
-    int qLen = Util::fast_atoi<int>(entry[6]);
-    int dbStart = Util::fast_atoi<int>(entry[7]);
-    int dbEnd = Util::fast_atoi<int>(entry[8]);
-    int dbLen = Util::fast_atoi<int>(entry[9]);
-    int adjustQstart = (qStart==-1)? 0 : qStart;
-    int adjustDBstart = (dbStart==-1)? 0 : dbStart;
-    double qCov = SmithWaterman::computeCov(adjustQstart, qEnd, qLen);
-    double dbCov = SmithWaterman::computeCov(adjustDBstart, dbEnd, dbLen);
-    size_t alnLength = Matcher::computeAlnLength(adjustQstart, qEnd, adjustDBstart, dbEnd);
-
-    if (columns < ALN_RES_WITH_BT_COL_CNT) {
-        return Matcher::result_t(targetId, score, qCov, dbCov, seqId, eval,
-                                 alnLength, qStart, qEnd, qLen, dbStart, dbEnd, dbLen, "");
-
+void Matcher::parseAlignmentColumns(char **entry, size_t columns, result_t &result, bool readCompressed,
+                                    bool readBacktrace) {
+    result.dbKey = Util::fast_atoi<unsigned int>(entry[0]);
+    result.score = Util::fast_atoi<int>(entry[1]);
+    result.seqId = strtod(entry[2],NULL);
+    result.eval = strtod(entry[3],NULL);
+
+    result.qStartPos = Util::fast_atoi<int>(entry[4]);
+    result.qEndPos = Util::fast_atoi<int>(entry[5]);
+    result.qLen = Util::fast_atoi<int>(entry[6]);
+    result.dbStartPos = Util::fast_atoi<int>(entry[7]);
+    result.dbEndPos = Util::fast_atoi<int>(entry[8]);
+    result.dbLen = Util::fast_atoi<int>(entry[9]);
+    int adjustQstart = (result.qStartPos == -1) ? 0 : result.qStartPos;
+    int adjustDBstart = (result.dbStartPos == -1) ? 0 : result.dbStartPos;
+    result.qcov = SmithWaterman::computeCov(adjustQstart, result.qEndPos, result.qLen);
+    result.dbcov = SmithWaterman::computeCov(adjustDBstart, result.dbEndPos, result.dbLen);
+    result.alnLength = Matcher::computeAlnLength(adjustQstart, result.qEndPos, adjustDBstart, result.dbEndPos);
+
+    if (columns < ALN_RES_WITH_BT_COL_CNT || readBacktrace == false) {
+        result.backtrace.clear();
     } else {
         size_t len = entry[11] - entry[10];
         if (readCompressed) {
-            return Matcher::result_t(targetId, score, qCov, dbCov, seqId, eval,
-                                     alnLength, qStart, qEnd, qLen, dbStart, dbEnd,
-                                     dbLen, std::string(entry[10], len));
+            result.backtrace.assign(entry[10], len);
         } else {
-            return Matcher::result_t(targetId, score, qCov, dbCov, seqId, eval,
-                                     alnLength, qStart, qEnd, qLen, dbStart, dbEnd,
-                                     dbLen, uncompressAlignment(std::string(entry[10], len)));
+            result.backtrace = uncompressAlignment(std::string(entry[10], len));
         }
     }
 }
 
 
+size_t Matcher::resultToBinaryBuffer(char * buffer, const result_t &result, bool addBacktrace, bool compress) {
+    binary_result_t record;
+    record.eval = result.eval;
+    record.dbKey = result.dbKey;
+    record.score = result.score;
+    record.seqId = result.seqId;
+    record.qStartPos = result.qStartPos;
+    record.qEndPos = result.qEndPos;
+    record.qLen = result.qLen;
+    record.dbStartPos = result.dbStartPos;
+    record.dbEndPos = result.dbEndPos;
+    record.dbLen = result.dbLen;
+    record.backtraceLen = 0;
+    std::string compressedCigar;
+    if (addBacktrace == true) {
+        compressedCigar = compress ? Matcher::compressAlignment(result.backtrace) : result.backtrace;
+        record.backtraceLen = compressedCigar.length();
+    }
+    memcpy(buffer, &record, sizeof(binary_result_t));
+    memcpy(buffer + sizeof(binary_result_t), compressedCigar.c_str(), record.backtraceLen);
+    return sizeof(binary_result_t) + record.backtraceLen;
+}
+
+size_t Matcher::parseBinaryAlignmentRecord(const char *data, result_t &result, bool readCompressed, bool readBacktrace) {
+    // records are not aligned within the entry
+    binary_result_t record;
+    memcpy(&record, data, sizeof(binary_result_t));
+
+    int adjustQstart = (record.qStartPos == -1) ? 0 : record.qStartPos;
+    int adjustDBstart = (record.dbStartPos == -1) ? 0 : record.dbStartPos;
+    result.dbKey = record.dbKey;
+    result.score = record.score;
+    result.qcov = SmithWaterman::computeCov(adjustQstart, record.qEndPos, record.qLen);
+    result.dbcov = SmithWaterman::computeCov(adjustDBstart, record.dbEndPos, record.dbLen);
+    result.seqId = record.seqId;
+    result.eval = record.eval;
+    result.alnLength = Matcher::computeAlnLength(adjustQstart, record.qEndPos, adjustDBstart, record.dbEndPos);
+    result.qStartPos = record.qStartPos;
+    result.qEndPos = record.qEndPos;
+    result.qLen = record.qLen;
+    result.dbStartPos = record.dbStartPos;
+    result.dbEndPos = record.dbEndPos;
+    result.dbLen = record.dbLen;
+    if (readBacktrace == false) {
+        result.backtrace.clear();
+        return sizeof(binary_result_t) + record.backtraceLen;
+    }
+    result.backtrace.assign(data + sizeof(binary_result_t), record.backtraceLen);
+    if (readCompressed == false && record.backtraceLen > 0) {
+        result.backtrace = uncompressAlignment(result.backtrace);
+    }
+    return sizeof(binary_result_t) + record.backtraceLen;
+}
+
+void Matcher::readBinaryAlignmentResults(std::vector<result_t> &result, const char *data, size_t dataSize,
+                                         bool readCompressed) {
+    if (data == NULL) {
+        return;
+    }
+
+    size_t pos = 0;
+    while (pos + sizeof(binary_result_t) <= dataSize) {
+        result.emplace_back();
+        pos += parseBinaryAlignmentRecord(data + pos, result.back(), readCompressed);
+    }
+}
+
+size_t Matcher::countBinaryAlignmentResults(const char *data, size_t dataSize) {
+    size_t count = 0;
+    size_t pos = 0;
+    while (pos + sizeof(binary_result_t) <= dataSize) {
+        unsigned int backtraceLen;
+        memcpy(&backtraceLen, data + pos + offsetof(binary_result_t, backtraceLen), sizeof(unsigned int));
+        pos += sizeof(binary_result_t) + backtraceLen;
+        count++;
+    }
+    return count;
+}
+
 size_t Matcher::resultToBuffer(char * buff1, const result_t &result, bool addBacktrace, bool compress) {
     char * basePos = buff1;
     char * tmpBuff = Itoa::u32toa_sse2((uint32_t) result.dbKey, buff1);
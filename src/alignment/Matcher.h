@@ -16,6 +16,7 @@
 #include "StripedSmithWaterman.h"
 #include "EvalueComputation.h"
 #include "BandedNucleotideAligner.h"
+#include "InterSequenceAligner.h"
 
 class Matcher{
 
@@ -27,6 +28,9 @@ public:
 
     const static int ALN_RES_WITH_BT_COL_CNT = 11;
 
+    // queries up to this length are also prepared for the inter-sequence alignment
+    const static unsigned int INTER_SEQUENCE_MAX_LEN = 256;
+
     struct result_t {
         unsigned int dbKey;
         int score;
@@ -60,6 +64,22 @@ public:
         result_t(){};
     };
 
+    // fixed-width record of the binary alignment result format (Sequence::ALIGNMENT_RES_BINARY)
+    // each record is followed by backtraceLen bytes of the compressed backtrace
+    struct binary_result_t {
+        double eval;
+        unsigned int dbKey;
+        int score;
+        float seqId;
+        int qStartPos;
+        int qEndPos;
+        unsigned int qLen;
+        int dbStartPos;
+        int dbEndPos;
+        unsigned int dbLen;
+        unsigned int backtraceLen;
+    };
+
     Matcher(int querySeqType, int maxSeqLen, BaseMatrix *m,
             EvalueComputation * evaluer, bool aaBiasCorrection,
             int gapOpen, int gapExtend);
@@ -87,10 +107,42 @@ public:
     // map new query into memory (create queryProfile, ...)
     void initQuery(Sequence* query);
 
+    // aligns hits with a known diagonal in a band of bandWidth diagonals on each side and stops
+    // at the X-drop, alignments that reach the band boundary are recomputed with full SW (0: full SW)
+    void setXdropBand(int bandWidth, float xdropBits);
+
+    // nucleotide alignments of sequences longer than window are extended window by window (0: in one piece)
+    void setExtensionWindow(int window);
+
+    // raw score of the last getSWResult, the e-value of its result is computed from it
+    int getLastRawScore() const { return lastRawScore; }
+
+    // scores many targets of the current query at once, NULL if the query is not an amino acid
+    // sequence of at most INTER_SEQUENCE_MAX_LEN residues
+    InterSequenceAligner *getInterSequenceAligner() {
+        return (interAlignerReady == true) ? interAligner : NULL;
+    }
+
     static result_t parseAlignmentRecord(char *data, bool readCompressed=false);
 
+    // converts the columns of a text record split by Util::getWordsOfLine, columns has to be at least
+    // ALN_RES_WITH_OUT_BT_COL_CNT and entry needs space for ALN_RES_WITH_BT_COL_CNT + 1 pointers
+    static void parseAlignmentColumns(char **entry, size_t columns, result_t &result, bool readCompressed,
+                                      bool readBacktrace);
+
     static void readAlignmentResults(std::vector<result_t> &result, char *data, bool readCompressed = false);
 
+    // parses one binary record and returns the number of bytes it occupies
+    static size_t parseBinaryAlignmentRecord(const char *data, result_t &result, bool readCompressed = false,
+                                             bool readBacktrace = true);
+
+    // dataSize is the size of the entry without the terminating null byte
+    static void readBinaryAlignmentResults(std::vector<result_t> &result, const char *data, size_t dataSize,
+                                           bool readCompressed = false);
+
+    // counts the records of a binary entry without parsing them
+    static size_t countBinaryAlignmentResults(const char *data, size_t dataSize);
+
     static float estimateSeqIdByScorePerCol(uint16_t score, unsigned int qLen, unsigned int tLen);
 
     static std::string compressAlignment(const std::string &bt);
@@ -103,11 +155,17 @@ public:
 
     static size_t resultToBuffer(char * buffer, const result_t &result, bool addBacktrace, bool compress  = true);
 
+    // writes a binary record, the backtrace is always stored compressed
+    // pass compress = false if result.backtrace is already compressed
+    static size_t resultToBinaryBuffer(char * buffer, const result_t &result, bool addBacktrace, bool compress = true);
+
     static size_t computeAlnLength(size_t anEnd, size_t start, size_t dbEnd, size_t dbStart);
 
 
 private:
 
+    int lastRawScore;
+
     // costs to open a gap
     int gapOpen;
     // costs to extend a gap
@@ -123,6 +181,12 @@ private:
     SmithWaterman * aligner;
     // aligner for nucl
     BandedNucleotideAligner * nuclaligner;
+    // aligner for many short targets
+    InterSequenceAligner * interAligner;
+    bool interAlignerReady;
+    // band width and X-drop (raw score) of the banded alignment, full SW if xdropBand is 0
+    int xdropBand;
+    int xdrop;
     // substitution matrix
     BaseMatrix* m;
     // evalue
@@ -0,0 +1,46 @@
+#include "SimdKernels.h"
+#include "CpuInfo.h"
+#include "Debug.h"
+
+#include <cstdlib>
+
+const SimdKernels *SimdKernels::get(const std::string &name) {
+    CpuInfo info;
+#ifdef SIMD_KERNELS_AVX512
+    if (name == "avx512") {
+        return (info.HW_AVX512F && info.HW_AVX512BW) ? &getSimdKernelsAVX512() : NULL;
+    }
+#endif
+    if (name == "avx2") {
+        return info.HW_AVX2 ? &getSimdKernelsAVX2() : NULL;
+    }
+    if (name == "sse41") {
+        return info.HW_SSE41 ? &getSimdKernelsSSE41() : NULL;
+    }
+    return NULL;
+}
+
+static const SimdKernels &selectKernels() {
+    const char *forced = getenv("MMSEQS_SIMD");
+    if (forced != NULL) {
+        const SimdKernels *kernels = SimdKernels::get(forced);
+        if (kernels != NULL) {
+            return *kernels;
+        }
+        Debug(Debug::WARNING) << "MMSEQS_SIMD=" << forced << " is not supported on this machine.\n";
+    }
+    const char *names[] = {"avx512", "avx2", "sse41"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        const SimdKernels *kernels = SimdKernels::get(names[i]);
+        if (kernels != NULL) {
+            return *kernels;
+        }
+    }
+    // SSE4.1 is the minimum requirement checked in checkCpu
+    return getSimdKernelsSSE41();
+}
+
+const SimdKernels &SimdKernels::get() {
+    static const SimdKernels &kernels = selectKernels();
+    return kernels;
+}
@@ -0,0 +1,110 @@
+#ifndef MMSEQS_SIMDKERNELS_H
+#define MMSEQS_SIMDKERNELS_H
+
+// Vector kernels of the striped Smith-Waterman (SmithWaterman) and of the ungapped diagonal scoring
+// (UngappedAlignment). SimdKernelsImpl.h is compiled once per instruction set (SimdKernelsSSE41.cpp,
+// SimdKernelsAVX2.cpp, SimdKernelsAVX512.cpp) and the widest set the CPU supports is picked at runtime,
+// so a single binary uses AVX-512 on machines that have it.
+// This header must not include simd.h, each kernel translation unit defines its own simd_int.
+
+#include <cstddef>
+#include <string>
+#include <stdint.h>
+
+#if (defined(__GNUC__) && __GNUC__ >= 5) || defined(__clang__)
+#define SIMD_KERNELS_AVX512
+#endif
+
+struct SimdKernels {
+    typedef struct {
+        uint16_t score;
+        int32_t ref;	 //0-based position
+        int32_t read;    //alignment ending position on read, 0-based
+    } alignment_end;
+
+    // buffers of one SmithWaterman instance, aligned to MAX_ALIGN_INT
+    struct Workspace {
+        void *vHStore;
+        void *vHLoad;
+        void *vE;
+        void *vHmax;
+        uint8_t *maxColumn;
+    };
+
+    // buffers of one InterSequenceAligner, aligned to MAX_ALIGN_INT
+    // vH, vE and vPositionBias hold one vector per query position, vScores one vector per residue type
+    struct InterSequenceWorkspace {
+        void *vH;
+        void *vE;
+        void *vPositionBias;
+        void *vScores;
+    };
+
+    // returns the best and second best alignment end, has to be freed
+    typedef alignment_end *(*SwByte)(const Workspace &workspace, const int *db_sequence, int8_t ref_dir,
+                                     int32_t db_length, int32_t query_length, const uint8_t gap_open,
+                                     const uint8_t gap_extend, const void *query_profile_byte, uint8_t terminate,
+                                     uint8_t bias, int32_t maskLen);
+    typedef alignment_end *(*SwWord)(const Workspace &workspace, const int *db_sequence, int8_t ref_dir,
+                                     int32_t db_length, int32_t query_length, const uint8_t gap_open,
+                                     const uint8_t gap_extend, const void *query_profile_word, uint16_t terminate,
+                                     int32_t maskLen);
+    // forward SwByte that continues in 16 bit once the next target position could overflow the byte scores,
+    // instead of starting over with SwWord. maxScore is the highest score of the query profile.
+    // The result is the one of SwWord, only the second best alignment end can differ.
+    // Without query_profile_word it returns a score of 255 on overflow like SwByte.
+    typedef alignment_end *(*SwByteWord)(const Workspace &workspace, const int *db_sequence, int32_t db_length,
+                                         int32_t query_length, const uint8_t gap_open, const uint8_t gap_extend,
+                                         const void *query_profile_byte, uint8_t bias,
+                                         const void *query_profile_word, int32_t maxScore, int32_t maskLen);
+    typedef int (*Ungapped)(const Workspace &workspace, const int *db_sequence, int32_t db_length,
+                            const void *query_profile_byte, int32_t query_length, uint8_t bias);
+    // scores the diagonal of byteLanes target sequences at once, their residues are interleaved in dbSeq
+    // profile has DIAGONAL_PROFILE_SIZE scores per query position
+    typedef void (*DiagonalScores)(const char *profile, const char bias, const unsigned int seqLen,
+                                   const unsigned char *dbSeq, unsigned int *scores);
+    // exact ungapped local score, start and end position on the diagonal of vectorSize / 2 targets, one per word lane,
+    // lane l scores the first lengths[l] residues of dbSeqs[l], seqLen is the longest. The residues are looked up by
+    // their lower 5 bits, so ASCII letters work as they are.
+    // Saturates at SHRT_MAX, seqLen has to be below SHRT_MAX
+    typedef void (*DiagonalRescore)(const char *profile, const char **dbSeqs, const short *lengths,
+                                    const unsigned int seqLen, short *scores, short *starts, short *ends);
+
+    // scores vectorSize targets against one query at once, target residue i of lane l is dbSeq[i * vectorSize + l],
+    // targets shorter than db_length are filled up with PADDING_RESIDUE
+    // scoreRows holds DIAGONAL_PROFILE_SIZE scores for each query residue type indexed by the target residue,
+    // positionBias one value per query position, both are shifted up so that bias has to be subtracted
+    // writes the best score (saturated at 255) and its 0-based end position on the target (-1 for 0) of each lane
+    typedef void (*InterSequence)(const InterSequenceWorkspace &workspace, const char *scoreRows, int32_t alphabetSize,
+                                  const unsigned char *query_sequence, const unsigned char *positionBias,
+                                  int32_t query_length, const unsigned char *dbSeq, int32_t db_length,
+                                  uint8_t gap_open, uint8_t gap_extend, uint8_t bias,
+                                  uint8_t *scores, int32_t *dbEnds);
+
+    static const unsigned int DIAGONAL_PROFILE_SIZE = 32;
+    static const unsigned char PADDING_RESIDUE = DIAGONAL_PROFILE_SIZE - 1;
+
+    const char *name;
+    // bytes per vector, the byte kernels have vectorSize lanes and the word kernels vectorSize / 2
+    unsigned int vectorSize;
+    SwByte swByte;
+    SwWord swWord;
+    SwByteWord swByteWord;
+    Ungapped ungapped;
+    DiagonalScores diagonalScores;
+    DiagonalRescore diagonalRescore;
+    InterSequence interSequence;
+
+    // widest kernels supported by the CPU, the environment variable MMSEQS_SIMD=sse41|avx2|avx512 overrides the choice
+    static const SimdKernels &get();
+    // NULL if the kernels are not compiled in or not supported by the CPU
+    static const SimdKernels *get(const std::string &name);
+};
+
+const SimdKernels &getSimdKernelsSSE41();
+const SimdKernels &getSimdKernelsAVX2();
+#ifdef SIMD_KERNELS_AVX512
+const SimdKernels &getSimdKernelsAVX512();
+#endif
+
+#endif //MMSEQS_SIMDKERNELS_H
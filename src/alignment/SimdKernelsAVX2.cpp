@@ -0,0 +1,42 @@
+// SimdKernels for AVX2, 32 byte lanes
+#include "SimdKernels.h"
+#include "Util.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <iostream>
+#include <immintrin.h>
+#include <smmintrin.h>
+#include <xmmintrin.h>
+
+// the instruction set of this file is independent of the one mmseqs-framework is compiled for
+#undef SSE
+#undef AVX
+#undef AVX2
+#undef AVX512
+#define AVX2
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+namespace SimdKernelsAVX2 {
+#include "simd.h"
+#include "SimdKernelsImpl.h"
+}
+
+const SimdKernels &getSimdKernelsAVX2() {
+    static const SimdKernels kernels = SimdKernelsAVX2::createKernels("avx2");
+    return kernels;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
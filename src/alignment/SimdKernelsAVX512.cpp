@@ -0,0 +1,49 @@
+// SimdKernels for AVX-512 (F and BW), 64 byte lanes
+#include "SimdKernels.h"
+
+#ifdef SIMD_KERNELS_AVX512
+#include "Util.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <iostream>
+#include <immintrin.h>
+#include <smmintrin.h>
+#include <xmmintrin.h>
+
+// the instruction set of this file is independent of the one mmseqs-framework is compiled for
+#undef SSE
+#undef AVX
+#undef AVX2
+#undef AVX512
+#define AVX512
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f,avx512bw"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("avx512f,avx512bw")
+// the set1 intrinsics of GCC 12 start from an undefined vector and trigger false positives
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+namespace SimdKernelsAVX512 {
+#include "simd.h"
+#include "SimdKernelsImpl.h"
+}
+
+const SimdKernels &getSimdKernelsAVX512() {
+    static const SimdKernels kernels = SimdKernelsAVX512::createKernels("avx512");
+    return kernels;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC diagnostic pop
+#pragma GCC pop_options
+#endif
+#endif
@@ -0,0 +1,799 @@
+// Kernel bodies of SimdKernels. SimdKernelsSSE41.cpp, SimdKernelsAVX2.cpp and SimdKernelsAVX512.cpp include
+// simd.h and this file inside their own namespace, so every instruction set gets its own copy of the code
+// with VECSIZE_INT * 4 byte lanes. No include guard on purpose.
+// The striped Smith-Waterman was written by Michael Farrar, 2006 (alignment), Mengyao Zhao (SSW Library) and
+// Martin Steinegger (aa composition, profile and AVX2 support), see StripedSmithWaterman.cpp.
+
+typedef SimdKernels::alignment_end alignment_end;
+
+// simdi8_movemask with all lanes set
+static const uint64_t ALL_LANES = (~0ULL >> (64 - VECSIZE_INT * 4));
+
+static inline uint64_t laneMask(simd_int vector) {
+#ifdef AVX512
+    return (uint64_t) simdi8_movemask(vector);
+#else
+    return (uint64_t) (uint32_t) simdi8_movemask(vector);
+#endif
+}
+
+static alignment_end *sw_word(simd_int *pvHStore, simd_int *pvHLoad, simd_int *pvE, simd_int *pvHmax,
+                              uint16_t *maxColumn, const int *db_sequence, int8_t ref_dir, int32_t begin,
+                              int32_t db_length, int32_t query_lenght, const uint8_t gap_open,
+                              const uint8_t gap_extend, const void *query_profile, uint16_t terminate,
+                              uint16_t max, int32_t end_ref, int32_t maskLen);
+
+/* Copies a striped byte column into the striped word layout. The byte layout is padded to at least as many
+   query positions as the word layout, the positions beyond it are dropped. */
+static void byte_to_word_column(const simd_int *byteColumn, int32_t byteSegLen, simd_int *wordColumn, int32_t wordSegLen) {
+	const int32_t BYTE_SIZE = VECSIZE_INT * 4;
+	const int32_t WORD_SIZE = VECSIZE_INT * 2;
+	const uint8_t *in = (const uint8_t *) byteColumn;
+	uint16_t *out = (uint16_t *) wordColumn;
+	for (int32_t pos = 0; pos < wordSegLen * WORD_SIZE; ++pos) {
+		out[(pos % wordSegLen) * WORD_SIZE + pos / wordSegLen] = in[(pos % byteSegLen) * BYTE_SIZE + pos / byteSegLen];
+	}
+}
+
+static alignment_end *sw_byte(const SimdKernels::Workspace &workspace,
+                              const int *db_sequence,
+                              int8_t ref_dir,	// 0: forward ref; 1: reverse ref
+                              int32_t db_length,
+                              int32_t query_length,
+                              const uint8_t gap_open, /* will be used as - */
+                              const uint8_t gap_extend, /* will be used as - */
+                              const void *query_profile,
+                              uint8_t terminate,	/* the best alignment score: used to terminate
+                                                    the matrix calculation when locating the
+                                                    alignment beginning point. If this score
+                                                    is set to 0, it will not be used */
+                              uint8_t bias,  /* Shift 0 point to a positive value. */
+                              const void *query_profile_word, /* forward only: continue with the word scores
+                                                                 before the byte scores could overflow */
+                              int32_t maxScore,  /* highest score of the query profile */
+                              int32_t maskLen) {
+#define max16(m, vm) ((m) = simdi8_hmax((vm)));
+
+	const simd_int *query_profile_byte = (const simd_int *) query_profile;
+	uint8_t max = 0;		                     /* the max alignment score */
+	int32_t end_query = query_length - 1;
+	int32_t end_db = -1; /* 0_based best alignment ending point; Initialized as isn't aligned -1. */
+	const int SIMD_SIZE = VECSIZE_INT * 4;
+	int32_t segLen = (query_length + SIMD_SIZE-1) / SIMD_SIZE; /* number of segment */
+	/* array to record the largest score of each reference position */
+	memset(workspace.maxColumn, 0, db_length * sizeof(uint8_t));
+	uint8_t * maxColumn = (uint8_t *) workspace.maxColumn;
+
+	/* Define 16 byte 0 vector. */
+	simd_int vZero = simdi32_set(0);
+	simd_int* pvHStore = (simd_int *) workspace.vHStore;
+	simd_int* pvHLoad = (simd_int *) workspace.vHLoad;
+	simd_int* pvE = (simd_int *) workspace.vE;
+	simd_int* pvHmax = (simd_int *) workspace.vHmax;
+	memset(pvHStore,0,segLen*sizeof(simd_int));
+	memset(pvHLoad,0,segLen*sizeof(simd_int));
+	memset(pvE,0,segLen*sizeof(simd_int));
+	memset(pvHmax,0,segLen*sizeof(simd_int));
+
+	int32_t i, j;
+	/* 16 byte insertion begin vector */
+	simd_int vGapO = simdi8_set(gap_open);
+
+	/* 16 byte insertion extension vector */
+	simd_int vGapE = simdi8_set(gap_extend);
+
+	/* 16 byte bias vector */
+	simd_int vBias = simdi8_set(bias);
+
+	simd_int vMaxScore = vZero; /* Trace the highest score of the whole SW matrix. */
+	simd_int vMaxMark = vZero; /* Trace the highest score till the previous column. */
+	simd_int vTemp;
+	int32_t edge, begin = 0, end = db_length, step = 1;
+
+	/* A column is at most maxScore above the highest score of the previous one, so the next column cannot
+	   overflow as long as the highest score of the current one stays below wordScore. */
+	const int32_t wordScore = (query_profile_word != NULL) ? 255 - bias - maxScore : 256;
+
+	/* outer loop to process the reference sequence */
+	if (ref_dir == 1) {
+		begin = db_length - 1;
+		end = -1;
+		step = -1;
+	}
+	for (i = begin; LIKELY(i != end); i += step) {
+		simd_int e, vF = vZero, vMaxColumn = vZero; /* Initialize F value to 0.
+                                                    Any errors to vH values will be corrected in the Lazy_F loop.
+                                                    */
+		simd_int vH = pvHStore[segLen - 1];
+		vH = simdi8_shiftl (vH, 1); /* Shift the 128-bit value in vH left by 1 byte. */
+		const simd_int* vP = query_profile_byte + db_sequence[i] * segLen; /* Right part of the query_profile_byte */
+
+		/* Swap the 2 H buffers. */
+		simd_int* pv = pvHLoad;
+		pvHLoad = pvHStore;
+		pvHStore = pv;
+
+		/* inner loop to process the query sequence */
+		for (j = 0; LIKELY(j < segLen); ++j) {
+			vH = simdui8_adds(vH, simdi_load(vP + j));
+			vH = simdui8_subs(vH, vBias); /* vH will be always > 0 */
+
+			/* Get max from vH, vE and vF. */
+			e = simdi_load(pvE + j);
+			vH = simdui8_max(vH, e);
+			vH = simdui8_max(vH, vF);
+			vMaxColumn = simdui8_max(vMaxColumn, vH);
+
+			/* Save vH values. */
+			simdi_store(pvHStore + j, vH);
+
+			/* Update vE value. */
+			vH = simdui8_subs(vH, vGapO); /* saturation arithmetic, result >= 0 */
+			e = simdui8_subs(e, vGapE);
+			e = simdui8_max(e, vH);
+			simdi_store(pvE + j, e);
+
+			/* Update vF value. */
+			vF = simdui8_subs(vF, vGapE);
+			vF = simdui8_max(vF, vH);
+
+			/* Load the next vH. */
+			vH = simdi_load(pvHLoad + j);
+		}
+
+		/* Lazy_F loop: has been revised to disallow adjecent insertion and then deletion, so don't update E(i, j), learn from SWPS3 */
+		/* reset pointers to the start of the saved data */
+		j = 0;
+		vH = simdi_load (pvHStore + j);
+
+		/*  the computed vF value is for the given column.  since */
+		/*  we are at the end, we need to shift the vF value over */
+		/*  to the next column. */
+		vF = simdi8_shiftl (vF, 1);
+		vTemp = simdui8_subs (vH, vGapO);
+		vTemp = simdui8_subs (vF, vTemp);
+		vTemp = simdi8_eq (vTemp, vZero);
+		uint64_t cmp = laneMask (vTemp);
+		while (cmp != ALL_LANES)
+		{
+			vH = simdui8_max (vH, vF);
+			vMaxColumn = simdui8_max(vMaxColumn, vH);
+			simdi_store (pvHStore + j, vH);
+			vF = simdui8_subs (vF, vGapE);
+			j++;
+			if (j >= segLen)
+			{
+				j = 0;
+				vF = simdi8_shiftl (vF, 1);
+			}
+			vH = simdi_load (pvHStore + j);
+
+			vTemp = simdui8_subs (vH, vGapO);
+			vTemp = simdui8_subs (vF, vTemp);
+			vTemp = simdi8_eq (vTemp, vZero);
+			cmp  = laneMask (vTemp);
+		}
+
+		vMaxScore = simdui8_max(vMaxScore, vMaxColumn);
+		vTemp = simdi8_eq(vMaxMark, vMaxScore);
+		cmp = laneMask(vTemp);
+		if (cmp != ALL_LANES)
+		{
+			uint8_t temp;
+			vMaxMark = vMaxScore;
+			max16(temp, vMaxScore);
+			vMaxScore = vMaxMark;
+
+			if (LIKELY(temp > max)) {
+				max = temp;
+				if (max + bias >= 255) break;	//overflow
+				end_db = i;
+
+				/* Store the column with the highest alignment score in order to trace the alignment ending position on read. */
+				for (j = 0; LIKELY(j < segLen); ++j) pvHmax[j] = pvHStore[j];
+			}
+		}
+
+		/* Record the max score of current column. */
+		max16(maxColumn[i], vMaxColumn);
+		if (maxColumn[i] == terminate) break;
+
+		/* Continue with the word scores from the exact H and E of this column. Each byte column is copied
+		   into a buffer that is no longer needed, the one of the previous H column is free. */
+		if (UNLIKELY(maxColumn[i] >= wordScore) && i + 1 < db_length) {
+			const int32_t wordSegLen = (query_length + VECSIZE_INT * 2 - 1) / (VECSIZE_INT * 2);
+			byte_to_word_column(pvHStore, segLen, pvHLoad, wordSegLen);
+			byte_to_word_column(pvE, segLen, pvHStore, wordSegLen);
+			byte_to_word_column(pvHmax, segLen, pvE, wordSegLen);
+			/* widen the column maxima in place, from the back */
+			uint16_t *wordMaxColumn = (uint16_t *) workspace.maxColumn;
+			for (j = i; j >= 0; --j) wordMaxColumn[j] = maxColumn[j];
+			memset(wordMaxColumn + i + 1, 0, (db_length - i - 1) * sizeof(uint16_t));
+			return sw_word(pvHLoad, pvHmax, pvHStore, pvE, wordMaxColumn, db_sequence, 0, i + 1, db_length,
+			               query_length, gap_open, gap_extend, query_profile_word, -1, max, end_db, maskLen);
+		}
+	}
+
+	/* Trace the alignment ending position on read. */
+	uint8_t *t = (uint8_t*)pvHmax;
+	int32_t column_len = segLen * SIMD_SIZE;
+	for (i = 0; LIKELY(i < column_len); ++i, ++t) {
+		int32_t temp;
+		if (*t == max) {
+			temp = i / SIMD_SIZE + i % SIMD_SIZE * segLen;
+			if (temp < end_query) end_query = temp;
+		}
+	}
+
+	/* Find the most possible 2nd best alignment. */
+	alignment_end* bests = (alignment_end*) calloc(2, sizeof(alignment_end));
+	bests[0].score = max + bias >= 255 ? 255 : max;
+	bests[0].ref = end_db;
+	bests[0].read = end_query;
+
+	bests[1].score = 0;
+	bests[1].ref = 0;
+	bests[1].read = 0;
+
+	edge = (end_db - maskLen) > 0 ? (end_db - maskLen) : 0;
+	for (i = 0; i < edge; i ++) {
+		if (maxColumn[i] > bests[1].score) {
+			bests[1].score = maxColumn[i];
+			bests[1].ref = i;
+		}
+	}
+	edge = (end_db + maskLen) > db_length ? db_length : (end_db + maskLen);
+	for (i = edge + 1; i < db_length; i ++) {
+		if (maxColumn[i] > bests[1].score) {
+			bests[1].score = maxColumn[i];
+			bests[1].ref = i;
+		}
+	}
+
+	return bests;
+#undef max16
+}
+
+/* Word kernel from column begin on, the buffers and max, end_ref and maxColumn hold the state of the columns
+   before it. pvHStore has the H values of the previous column, pvHLoad is only written. */
+static alignment_end *sw_word(simd_int *pvHStore, simd_int *pvHLoad, simd_int *pvE, simd_int *pvHmax,
+                              uint16_t *maxColumn, const int *db_sequence,
+                              int8_t ref_dir,	// 0: forward ref; 1: reverse ref
+                              int32_t begin,
+                              int32_t db_length,
+                              int32_t query_lenght,
+                              const uint8_t gap_open, /* will be used as - */
+                              const uint8_t gap_extend, /* will be used as - */
+                              const void *query_profile,
+                              uint16_t terminate,
+                              uint16_t max,		/* the max alignment score */
+                              int32_t end_ref,	/* 1_based best alignment ending point; Initialized as isn't aligned - 0. */
+                              int32_t maskLen) {
+#define max8(m, vm) ((m) = simdi16_hmax((vm)));
+
+	const simd_int *query_profile_word = (const simd_int *) query_profile;
+	int32_t end_read = query_lenght - 1;
+	const unsigned int SIMD_SIZE = VECSIZE_INT * 2;
+	int32_t segLen = (query_lenght + SIMD_SIZE-1) / SIMD_SIZE; /* number of segment */
+
+	/* Define 16 byte 0 vector. */
+	simd_int vZero = simdi32_set(0);
+
+	int32_t i, j, k;
+	/* 16 byte insertion begin vector */
+	simd_int vGapO = simdi16_set(gap_open);
+
+	/* 16 byte insertion extension vector */
+	simd_int vGapE = simdi16_set(gap_extend);
+
+	simd_int vMaxScore = simdi16_set(max); /* Trace the highest score of the whole SW matrix. */
+	simd_int vMaxMark = vMaxScore; /* Trace the highest score till the previous column. */
+	simd_int vTemp;
+	int32_t edge, end = db_length, step = 1;
+
+	/* outer loop to process the reference sequence */
+	if (ref_dir == 1) {
+		end = -1;
+		step = -1;
+	}
+	for (i = begin; LIKELY(i != end); i += step) {
+		simd_int e, vF = vZero; /* Initialize F value to 0.
+                                Any errors to vH values will be corrected in the Lazy_F loop.
+                                */
+		simd_int vH = pvHStore[segLen - 1];
+		vH = simdi8_shiftl (vH, 2); /* Shift the 128-bit value in vH left by 2 byte. */
+
+		/* Swap the 2 H buffers. */
+		simd_int* pv = pvHLoad;
+
+		simd_int vMaxColumn = vZero; /* vMaxColumn is used to record the max values of column i. */
+
+		const simd_int* vP = query_profile_word + db_sequence[i] * segLen; /* Right part of the query_profile_byte */
+		pvHLoad = pvHStore;
+		pvHStore = pv;
+
+		/* inner loop to process the query sequence */
+		for (j = 0; LIKELY(j < segLen); j ++) {
+			vH = simdi16_adds(vH, simdi_load(vP + j));
+
+			/* Get max from vH, vE and vF. */
+			e = simdi_load(pvE + j);
+			vH = simdi16_max(vH, e);
+			vH = simdi16_max(vH, vF);
+			vMaxColumn = simdi16_max(vMaxColumn, vH);
+
+			/* Save vH values. */
+			simdi_store(pvHStore + j, vH);
+
+			/* Update vE value. */
+			vH = simdui16_subs(vH, vGapO); /* saturation arithmetic, result >= 0 */
+			e = simdui16_subs(e, vGapE);
+			e = simdi16_max(e, vH);
+			simdi_store(pvE + j, e);
+
+			/* Update vF value. */
+			vF = simdui16_subs(vF, vGapE);
+			vF = simdi16_max(vF, vH);
+
+			/* Load the next vH. */
+			vH = simdi_load(pvHLoad + j);
+		}
+
+		/* Lazy_F loop: has been revised to disallow adjecent insertion and then deletion, so don't update E(i, j), learn from SWPS3 */
+		for (k = 0; LIKELY(k < (int32_t) SIMD_SIZE); ++k) {
+			vF = simdi8_shiftl (vF, 2);
+			for (j = 0; LIKELY(j < segLen); ++j) {
+				vH = simdi_load(pvHStore + j);
+				vH = simdi16_max(vH, vF);
+				vMaxColumn = simdi16_max(vMaxColumn, vH); //newly added line
+				simdi_store(pvHStore + j, vH);
+				vH = simdui16_subs(vH, vGapO);
+				vF = simdui16_subs(vF, vGapE);
+				if (UNLIKELY(! laneMask(simdi16_gt(vF, vH)))) goto end;
+			}
+		}
+
+		end:
+		vMaxScore = simdi16_max(vMaxScore, vMaxColumn);
+		vTemp = simdi16_eq(vMaxMark, vMaxScore);
+		uint64_t cmp = laneMask(vTemp);
+		if (cmp != ALL_LANES)
+		{
+			uint16_t temp;
+			vMaxMark = vMaxScore;
+			max8(temp, vMaxScore);
+			vMaxScore = vMaxMark;
+
+			if (LIKELY(temp > max)) {
+				max = temp;
+				end_ref = i;
+				for (j = 0; LIKELY(j < segLen); ++j) pvHmax[j] = pvHStore[j];
+			}
+		}
+
+		/* Record the max score of current column. */
+		max8(maxColumn[i], vMaxColumn);
+		if (maxColumn[i] == terminate) break;
+	}
+
+	/* Trace the alignment ending position on read. */
+	uint16_t *t = (uint16_t*)pvHmax;
+	int32_t column_len = segLen * SIMD_SIZE;
+	for (i = 0; LIKELY(i < column_len); ++i, ++t) {
+		int32_t temp;
+		if (*t == max) {
+			temp = i / SIMD_SIZE + i % SIMD_SIZE * segLen;
+			if (temp < end_read) end_read = temp;
+		}
+	}
+
+	/* Find the most possible 2nd best alignment. */
+	alignment_end* bests = (alignment_end*) calloc(2, sizeof(alignment_end));
+	bests[0].score = max;
+	bests[0].ref = end_ref;
+	bests[0].read = end_read;
+
+	bests[1].score = 0;
+	bests[1].ref = 0;
+	bests[1].read = 0;
+
+	edge = (end_ref - maskLen) > 0 ? (end_ref - maskLen) : 0;
+	for (i = 0; i < edge; i ++) {
+		if (maxColumn[i] > bests[1].score) {
+			bests[1].score = maxColumn[i];
+			bests[1].ref = i;
+		}
+	}
+	edge = (end_ref + maskLen) > db_length ? db_length : (end_ref + maskLen);
+	for (i = edge; i < db_length; i ++) {
+		if (maxColumn[i] > bests[1].score) {
+			bests[1].score = maxColumn[i];
+			bests[1].ref = i;
+		}
+	}
+
+	return bests;
+#undef max8
+}
+
+static alignment_end *sw_sse2_byte(const SimdKernels::Workspace &workspace, const int *db_sequence, int8_t ref_dir,
+                                   int32_t db_length, int32_t query_length, const uint8_t gap_open,
+                                   const uint8_t gap_extend, const void *query_profile, uint8_t terminate,
+                                   uint8_t bias, int32_t maskLen) {
+	return sw_byte(workspace, db_sequence, ref_dir, db_length, query_length, gap_open, gap_extend, query_profile,
+	               terminate, bias, NULL, 0, maskLen);
+}
+
+static alignment_end *sw_sse2_word(const SimdKernels::Workspace &workspace, const int *db_sequence, int8_t ref_dir,
+                                   int32_t db_length, int32_t query_lenght, const uint8_t gap_open,
+                                   const uint8_t gap_extend, const void *query_profile, uint16_t terminate,
+                                   int32_t maskLen) {
+	const unsigned int SIMD_SIZE = VECSIZE_INT * 2;
+	int32_t segLen = (query_lenght + SIMD_SIZE-1) / SIMD_SIZE;
+	/* array to record the alignment read ending position of the largest score of each reference position */
+	memset(workspace.maxColumn, 0, db_length * sizeof(uint16_t));
+	memset(workspace.vHStore, 0, segLen * sizeof(simd_int));
+	memset(workspace.vHLoad, 0, segLen * sizeof(simd_int));
+	memset(workspace.vE, 0, segLen * sizeof(simd_int));
+	memset(workspace.vHmax, 0, segLen * sizeof(simd_int));
+	return sw_word((simd_int *) workspace.vHStore, (simd_int *) workspace.vHLoad, (simd_int *) workspace.vE,
+	               (simd_int *) workspace.vHmax, (uint16_t *) workspace.maxColumn, db_sequence, ref_dir,
+	               (ref_dir == 1) ? db_length - 1 : 0, db_length, query_lenght, gap_open, gap_extend,
+	               query_profile, terminate, 0, 0, maskLen);
+}
+
+static alignment_end *sw_sse2_byte_word(const SimdKernels::Workspace &workspace, const int *db_sequence,
+                                        int32_t db_length, int32_t query_length, const uint8_t gap_open,
+                                        const uint8_t gap_extend, const void *query_profile_byte, uint8_t bias,
+                                        const void *query_profile_word, int32_t maxScore, int32_t maskLen) {
+	maxScore = std::max(maxScore, 0);
+	if (query_profile_word != NULL && bias + maxScore >= 255) {
+		/* already the first column could overflow */
+		return sw_sse2_word(workspace, db_sequence, 0, db_length, query_length, gap_open, gap_extend,
+		                    query_profile_word, -1, maskLen);
+	}
+	return sw_byte(workspace, db_sequence, 0, db_length, query_length, gap_open, gap_extend, query_profile_byte,
+	               -1, bias, query_profile_word, maxScore, maskLen);
+}
+
+static int ungapped_alignment(const SimdKernels::Workspace &workspace, const int *db_sequence, int32_t db_length,
+                              const void *query_profile, int32_t query_length, uint8_t bias) {
+#define SWAP(tmp, arg1, arg2) tmp = arg1; arg1 = arg2; arg2 = tmp;
+
+	int i; // position in query bands (0,..,W-1)
+	int j; // position in db sequence (0,..,dbseq_length-1)
+	int element_count = (VECSIZE_INT * 4);
+	const int W = (query_length + (element_count - 1)) / element_count; // width of bands in query and score matrix = hochgerundetes LQ/16
+
+	simd_int *p;
+	simd_int S;              // 16 unsigned bytes holding S(b*W+i,j) (b=0,..,15)
+	simd_int Smax = simdi_setzero();
+	simd_int Soffset; // all scores in query profile are shifted up by Soffset to obtain pos values
+	simd_int *s_prev, *s_curr; // pointers to Score(i-1,j-1) and Score(i,j), resp.
+	const simd_int *qji;             // query profile score in row j (for residue x_j)
+	simd_int *s_prev_it, *s_curr_it;
+	const simd_int *query_profile_it = (const simd_int *) query_profile;
+
+	// Load the score offset to all 16 unsigned byte elements of Soffset
+	Soffset = simdi8_set(bias);
+	s_curr = (simd_int *) workspace.vHStore;
+	s_prev = (simd_int *) workspace.vHLoad;
+
+	memset(s_curr,0,W*sizeof(simd_int));
+	memset(s_prev,0,W*sizeof(simd_int));
+
+	for (j = 0; j < db_length; ++j) // loop over db sequence positions
+	{
+
+		// Get address of query scores for row j
+		qji = query_profile_it + db_sequence[j] * W;
+
+		// Load the next S value
+		S = simdi_load(s_curr + W - 1);
+		S = simdi8_shiftl(S, 1);
+
+		// Swap s_prev and s_curr, smax_prev and smax_curr
+		SWAP(p, s_prev, s_curr);
+
+		s_curr_it = s_curr;
+		s_prev_it = s_prev;
+
+		for (i = 0; i < W; ++i) // loop over query band positions
+		{
+			// Saturated addition and subtraction to score S(i,j)
+			S = simdui8_adds(S, *(qji++)); // S(i,j) = S(i-1,j-1) + (q(i,x_j) + Soffset)
+			S = simdui8_subs(S, Soffset);       // S(i,j) = max(0, S(i,j) - Soffset)
+			simdi_store(s_curr_it++, S);       // store S to s_curr[i]
+			Smax = simdui8_max(Smax, S);       // Smax(i,j) = max(Smax(i,j), S(i,j))
+
+			// Load the next S and Smax values
+			S = simdi_load(s_prev_it++);
+		}
+	}
+	int score = simd_hmax((unsigned char *) &Smax, element_count);
+
+	/* return largest score */
+	return score;
+#undef SWAP
+}
+
+#if defined(AVX2) && !defined(AVX512)
+static inline __m256i Shuffle(const __m256i & value, const __m256i & shuffle)
+{
+    const __m256i K0 = _mm256_setr_epi8(
+            (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70,
+            (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0);
+    const __m256i K1 = _mm256_setr_epi8(
+            (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0, (char)0xF0,
+            (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70, (char)0x70);
+    return _mm256_or_si256(_mm256_shuffle_epi8(value, _mm256_add_epi8(shuffle, K0)),
+                           _mm256_shuffle_epi8(_mm256_permute4x64_epi64(value, 0x4E), _mm256_add_epi8(shuffle, K1)));
+}
+#endif
+
+// looks up the score of each lane in a row of DIAGONAL_PROFILE_SIZE scores, residues has one index (< 32) per lane
+static inline simd_int lookupScores(const char *row, simd_int residues) {
+#ifdef AVX512
+    // the 32 scores do not fit into one 128 bit lane, look up the lower and upper 16 separately
+    const __m512i row01 = _mm512_broadcast_i32x4(_mm_load_si128((const __m128i *) row));
+    const __m512i row16 = _mm512_broadcast_i32x4(_mm_load_si128((const __m128i *) (row + 16)));
+    const __mmask64 lookupMask16 = _mm512_cmpge_epu8_mask(residues, _mm512_set1_epi8(16));
+    return _mm512_mask_blend_epi8(lookupMask16, _mm512_shuffle_epi8(row01, residues), _mm512_shuffle_epi8(row16, residues));
+#elif defined(AVX2)
+    return Shuffle(_mm256_load_si256((const __m256i *) row), residues);
+#else
+    // each row has 32 byte
+    // 20 scores and 12 zeros
+    // load score 0 - 15
+    __m128i score_matrix_vec01 = _mm_load_si128((const __m128i *) row);
+    // load score 16 - 32
+    __m128i score_matrix_vec16 = _mm_load_si128((const __m128i *) (row + 16));
+    // parallel score lookup
+    // _mm_shuffle_epi8
+    // for i ... 16
+    //   score01[i] = score_matrix_vec01[template01[i]%16]
+    __m128i score01 = _mm_shuffle_epi8(score_matrix_vec01, residues);
+    __m128i score16 = _mm_shuffle_epi8(score_matrix_vec16, residues);
+    // t[i] < 16 => 0 - 15
+    // example: template01: 02 15 12 18 < 16 16 16 16 => FF FF FF 00
+    __m128i lookup_mask01 = _mm_cmplt_epi8(residues, _mm_set1_epi8(16));
+    // 15 < t[i] => 16 - xx
+    // example: template01: 16 16 16 16 < 02 15 12 18 => 00 00 00 FF
+    __m128i lookup_mask16 = _mm_cmplt_epi8(_mm_set1_epi8(15), residues);
+    // score01 & lookup_mask01 => Score   Score   Score   NoScore
+    score01 = _mm_and_si128(lookup_mask01, score01);
+    // score16 & lookup_mask16 => NoScore NoScore NoScore Score
+    score16 = _mm_and_si128(lookup_mask16, score16);
+    //     Score   Score   Score NoScore
+    // + NoScore NoScore NoScore   Score
+    // =   Score   Score   Score   Score
+    return _mm_add_epi8(score01, score16);
+#endif
+}
+
+static void diagonalScores(const char *profile, const char bias, const unsigned int seqLen,
+                           const unsigned char *dbSeq, unsigned int *scores) {
+    const unsigned int PROFILESIZE = SimdKernels::DIAGONAL_PROFILE_SIZE;
+    simd_int vscore        = simdi_setzero();
+    simd_int vMaxScore     = simdi_setzero();
+    const simd_int vBias   = simdi8_set(bias);
+    for(unsigned int pos = 0; pos < seqLen; pos++){
+        simd_int template01 = simdi_load((simd_int *)&dbSeq[pos*VECSIZE_INT*4]);
+        simd_int score_vec_8bit = lookupScores(&profile[pos * PROFILESIZE], template01);
+        vscore    = simdui8_adds(vscore, score_vec_8bit);
+        vscore    = simdui8_subs(vscore, vBias);
+        vMaxScore = simdui8_max(vMaxScore, vscore);
+    }
+
+    unsigned char maxScores[VECSIZE_INT * 4];
+    simdi_storeu((simd_int *) maxScores, vMaxScore);
+    for (unsigned int i = 0; i < VECSIZE_INT * 4; i++) {
+        scores[i] = maxScores[i];
+    }
+}
+
+static inline simd_int blendWords(simd_int mask, simd_int a, simd_int b) {
+    return simdi_or(simdi_and(mask, a), simdi_andnot(mask, b));
+}
+
+// widens one residue byte per word lane to a word that holds the lower 5 bits of the residue in both bytes
+static inline simd_int loadResidueWords(const unsigned char *residues) {
+#ifdef AVX512
+    const simd_int words = _mm512_cvtepu8_epi16(_mm256_load_si256((const __m256i *) residues));
+#elif defined(AVX2)
+    const simd_int words = _mm256_cvtepu8_epi16(_mm_load_si128((const __m128i *) residues));
+#else
+    const simd_int words = _mm_cvtepu8_epi16(_mm_loadl_epi64((const __m128i *) residues));
+#endif
+    return simdi_and(simdi_or(words, simdi16_slli(words, 8)), simdi8_set(SimdKernels::DIAGONAL_PROFILE_SIZE - 1));
+}
+
+// transposes 16 rows of 16 bytes, columns[i] holds byte i of every row
+static inline void transposeBytes16x16(const __m128i *rows, __m128i *columns) {
+    __m128i a[16];
+    __m128i b[16];
+    // two rows and 8 columns each
+    for (int i = 0; i < 8; i++) {
+        a[i] = _mm_unpacklo_epi8(rows[2 * i], rows[2 * i + 1]);
+        a[i + 8] = _mm_unpackhi_epi8(rows[2 * i], rows[2 * i + 1]);
+    }
+    // four rows and 4 columns each
+    for (int half = 0; half < 16; half += 8) {
+        for (int k = 0; k < 4; k++) {
+            b[half + k] = _mm_unpacklo_epi16(a[half + 2 * k], a[half + 2 * k + 1]);
+            b[half + k + 4] = _mm_unpackhi_epi16(a[half + 2 * k], a[half + 2 * k + 1]);
+        }
+    }
+    // eight rows and 2 columns each
+    for (int quarter = 0; quarter < 16; quarter += 4) {
+        for (int m = 0; m < 2; m++) {
+            a[quarter + m] = _mm_unpacklo_epi32(b[quarter + 2 * m], b[quarter + 2 * m + 1]);
+            a[quarter + m + 2] = _mm_unpackhi_epi32(b[quarter + 2 * m], b[quarter + 2 * m + 1]);
+        }
+    }
+    // all rows
+    for (int quarter = 0; quarter < 16; quarter += 4) {
+        columns[quarter] = _mm_unpacklo_epi64(a[quarter], a[quarter + 1]);
+        columns[quarter + 1] = _mm_unpackhi_epi64(a[quarter], a[quarter + 1]);
+        columns[quarter + 2] = _mm_unpacklo_epi64(a[quarter + 2], a[quarter + 3]);
+        columns[quarter + 3] = _mm_unpackhi_epi64(a[quarter + 2], a[quarter + 3]);
+    }
+}
+
+// like diagonalScores with exact 16 bit scores instead of saturated bytes, one target per word lane.
+// profile holds the low bytes of the DIAGONAL_PROFILE_SIZE word scores of a query position followed by their high bytes.
+// Follows DistanceCalculator::computeSubstitutionStartEndDistance: the end is the first position of the maximum,
+// the start the position after the last score <= 0 before it
+static void diagonalRescore(const char *profile, const char **dbSeqs, const short *lengths,
+                                 const unsigned int seqLen, short *scores, short *starts, short *ends) {
+    const unsigned int PROFILESIZE = SimdKernels::DIAGONAL_PROFILE_SIZE;
+    const unsigned int BLOCKSIZE = 16;
+    const unsigned int lanes = VECSIZE_INT * 2;
+    const simd_int vZero = simdi_setzero();
+    const simd_int vOne = simdi16_set(1);
+    const simd_int vLowBytes = simdi16_set(0x00FF);
+    simd_int vScore = vZero;
+    simd_int vMaxScore = vZero;
+    simd_int vPos = vZero;
+    simd_int vMinPos = simdi16_set(-1);
+    simd_int vStart = vZero;
+    simd_int vEnd = vZero;
+    const simd_int vLength = simdi_loadu((const simd_int *) lengths);
+    // the residues of BLOCKSIZE positions, one byte per lane
+    simd_int block[BLOCKSIZE / 2];
+    unsigned char *blockResidues = (unsigned char *) block;
+    const __m128i zeroRow = _mm_setzero_si128();
+    for (unsigned int blockStart = 0; blockStart < seqLen; blockStart += BLOCKSIZE) {
+        // targets that end inside the block are copied one by one, the lanes behind their end are ignored
+        for (unsigned int group = 0; group < lanes; group += 16) {
+            __m128i rows[16];
+            for (unsigned int row = 0; row < 16; row++) {
+                const unsigned int lane = group + row;
+                rows[row] = (lane < lanes && blockStart + BLOCKSIZE <= (unsigned int) lengths[lane])
+                            ? _mm_loadu_si128((const __m128i *) (dbSeqs[lane] + blockStart)) : zeroRow;
+            }
+            __m128i columns[16];
+            transposeBytes16x16(rows, columns);
+            for (unsigned int i = 0; i < BLOCKSIZE; i++) {
+                if (lanes >= 16) {
+                    _mm_storeu_si128((__m128i *) (blockResidues + i * lanes + group), columns[i]);
+                } else {
+                    _mm_storel_epi64((__m128i *) (blockResidues + i * lanes + group), columns[i]);
+                }
+            }
+        }
+        for (unsigned int lane = 0; lane < lanes; lane++) {
+            const unsigned int length = lengths[lane];
+            for (unsigned int pos = blockStart; pos < length && pos < blockStart + BLOCKSIZE && blockStart + BLOCKSIZE > length; pos++) {
+                blockResidues[(pos - blockStart) * lanes + lane] = dbSeqs[lane][pos];
+            }
+        }
+
+        const unsigned int blockEnd = (blockStart + BLOCKSIZE < seqLen) ? blockStart + BLOCKSIZE : seqLen;
+        for (unsigned int pos = blockStart; pos < blockEnd; pos++) {
+            const simd_int residues = loadResidueWords(blockResidues + (pos - blockStart) * lanes);
+            const char *row = &profile[pos * 2 * PROFILESIZE];
+            const simd_int low = lookupScores(row, residues);
+            const simd_int high = lookupScores(row + PROFILESIZE, residues);
+            // behind the end of a shorter target the score stays and cannot give a new maximum
+            const simd_int vInside = simdi16_gt(vLength, vPos);
+            const simd_int vSubstitution = simdi_or(simdi_and(vLowBytes, low), simdi_andnot(vLowBytes, high));
+            vScore = simdi16_adds(vScore, simdi_and(vInside, vSubstitution));
+            const simd_int isMinScore = simdi16_gt(vOne, vScore);
+            vMinPos = blendWords(isMinScore, vPos, vMinPos);
+            vScore = simdi16_max(vScore, vZero);
+            const simd_int isNewMaxScore = simdi16_gt(vScore, vMaxScore);
+            vEnd = blendWords(isNewMaxScore, vPos, vEnd);
+            vStart = blendWords(isNewMaxScore, simdi16_add(vMinPos, vOne), vStart);
+            vMaxScore = simdi16_max(vMaxScore, vScore);
+            vPos = simdi16_add(vPos, vOne);
+        }
+    }
+    simdi_storeu((simd_int *) scores, vMaxScore);
+    simdi_storeu((simd_int *) starts, vStart);
+    simdi_storeu((simd_int *) ends, vEnd);
+}
+
+// inter-sequence Smith-Waterman after Rognes (SWIPE, BMC Bioinformatics 2011): every lane holds another target,
+// the matrix is filled column by column (target position) and row by row (query position) without striping.
+// The scores of all residue types against the current target column are looked up once per column.
+// Unlike the striped kernels a deletion can directly follow an insertion, so the score is never lower.
+static void interSequenceScores(const SimdKernels::InterSequenceWorkspace &workspace, const char *scoreRows,
+                                int32_t alphabetSize, const unsigned char *query_sequence,
+                                const unsigned char *positionBias, int32_t query_length,
+                                const unsigned char *dbSeq, int32_t db_length,
+                                uint8_t gap_open, uint8_t gap_extend, uint8_t bias,
+                                uint8_t *scores, int32_t *dbEnds) {
+    const int32_t lanes = VECSIZE_INT * 4;
+    simd_int *pvH = (simd_int *) workspace.vH;
+    simd_int *pvE = (simd_int *) workspace.vE;
+    simd_int *pvPositionBias = (simd_int *) workspace.vPositionBias;
+    simd_int *pvScores = (simd_int *) workspace.vScores;
+
+    const simd_int vZero = simdi_setzero();
+    for (int32_t j = 0; j < query_length; j++) {
+        simdi_store(pvH + j, vZero);
+        simdi_store(pvE + j, vZero);
+        simdi_store(pvPositionBias + j, simdi8_set(positionBias[j]));
+    }
+    for (int32_t lane = 0; lane < lanes; lane++) {
+        dbEnds[lane] = -1;
+    }
+
+    const simd_int vGapO = simdi8_set(gap_open);
+    const simd_int vGapE = simdi8_set(gap_extend);
+    const simd_int vBias = simdi8_set(bias);
+    const simd_int vPadding = simdi8_set(SimdKernels::PADDING_RESIDUE);
+    simd_int vMaxScore = vZero;
+    for (int32_t i = 0; i < db_length; i++) {
+        const simd_int residues = simdi_load((const simd_int *) (dbSeq + i * lanes));
+        for (int32_t aa = 0; aa < alphabetSize; aa++) {
+            simdi_store(pvScores + aa, lookupScores(scoreRows + aa * SimdKernels::DIAGONAL_PROFILE_SIZE, residues));
+        }
+
+        simd_int vF = vZero;
+        simd_int vHDiagonal = vZero;
+        simd_int vMaxColumn = vZero;
+        for (int32_t j = 0; LIKELY(j < query_length); j++) {
+            simd_int vH = simdui8_adds(vHDiagonal, simdi_load(pvScores + query_sequence[j]));
+            vH = simdui8_adds(vH, simdi_load(pvPositionBias + j));
+            vH = simdui8_subs(vH, vBias);
+            const simd_int e = simdi_load(pvE + j);
+            vH = simdui8_max(vH, e);
+            vH = simdui8_max(vH, vF);
+            vMaxColumn = simdui8_max(vMaxColumn, vH);
+
+            vHDiagonal = simdi_load(pvH + j);
+            simdi_store(pvH + j, vH);
+
+            vH = simdui8_subs(vH, vGapO);
+            simdi_store(pvE + j, simdui8_max(simdui8_subs(e, vGapE), vH));
+            vF = simdui8_max(simdui8_subs(vF, vGapE), vH);
+        }
+
+        // the padding behind shorter targets must not count
+        vMaxColumn = simdi_andnot(simdi8_eq(residues, vPadding), vMaxColumn);
+        const simd_int vNewMaxScore = simdui8_max(vMaxScore, vMaxColumn);
+        uint64_t improved = ~laneMask(simdi8_eq(vNewMaxScore, vMaxScore)) & ALL_LANES;
+        while (improved != 0) {
+            dbEnds[__builtin_ctzll(improved)] = i;
+            improved &= improved - 1;
+        }
+        vMaxScore = vNewMaxScore;
+    }
+    simdi_storeu((simd_int *) scores, vMaxScore);
+}
+
+static SimdKernels createKernels(const char *name) {
+    SimdKernels kernels;
+    kernels.name = name;
+    kernels.vectorSize = VECSIZE_INT * 4;
+    kernels.swByte = sw_sse2_byte;
+    kernels.swWord = sw_sse2_word;
+    kernels.swByteWord = sw_sse2_byte_word;
+    kernels.ungapped = ungapped_alignment;
+    kernels.diagonalScores = diagonalScores;
+    kernels.diagonalRescore = diagonalRescore;
+    kernels.interSequence = interSequenceScores;
+    return kernels;
+}
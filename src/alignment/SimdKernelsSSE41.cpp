@@ -0,0 +1,42 @@
+// SimdKernels for SSE4.1, 16 byte lanes
+#include "SimdKernels.h"
+#include "Util.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <algorithm>
+#include <iostream>
+#include <immintrin.h>
+#include <smmintrin.h>
+#include <xmmintrin.h>
+
+// the instruction set of this file is independent of the one mmseqs-framework is compiled for
+#undef SSE
+#undef AVX
+#undef AVX2
+#undef AVX512
+#define SSE
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse4.1"))), apply_to = function)
+#else
+#pragma GCC push_options
+#pragma GCC target("sse4.1")
+#endif
+
+namespace SimdKernelsSSE41 {
+#include "simd.h"
+#include "SimdKernelsImpl.h"
+}
+
+const SimdKernels &getSimdKernelsSSE41() {
+    static const SimdKernels kernels = SimdKernelsSSE41::createKernels("sse41");
+    return kernels;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#else
+#pragma GCC pop_options
+#endif
@@ -30,20 +30,27 @@
 #include "SubstitutionMatrix.h"
 #include "Debug.h"
 
+#include <vector>
+
 
 SmithWaterman::SmithWaterman(size_t maxSequenceLength, int aaSize, bool aaBiasCorrection) {
 	maxSequenceLength += 1;
 	this->aaBiasCorrection = aaBiasCorrection;
-	const int segSize = (maxSequenceLength+7)/8;
-	vHStore = (simd_int*) mem_align(ALIGN_INT, segSize * sizeof(simd_int));
-	vHLoad  = (simd_int*) mem_align(ALIGN_INT, segSize * sizeof(simd_int));
-	vE      = (simd_int*) mem_align(ALIGN_INT, segSize * sizeof(simd_int));
-	vHmax   = (simd_int*) mem_align(ALIGN_INT, segSize * sizeof(simd_int));
+	kernels = &SimdKernels::get();
+	// the word kernels have the fewest lanes and need the most vectors
+	const size_t wordLanes = kernels->vectorSize / 2;
+	const size_t segSize = ((maxSequenceLength + wordLanes - 1) / wordLanes) * kernels->vectorSize;
+	workspace.vHStore = mem_align(MAX_ALIGN_INT, segSize);
+	workspace.vHLoad  = mem_align(MAX_ALIGN_INT, segSize);
+	workspace.vE      = mem_align(MAX_ALIGN_INT, segSize);
+	workspace.vHmax   = mem_align(MAX_ALIGN_INT, segSize);
 	profile = new s_profile();
-	profile->profile_byte = (simd_int*)mem_align(ALIGN_INT, aaSize * segSize * sizeof(simd_int));
-	profile->profile_word = (simd_int*)mem_align(ALIGN_INT, aaSize * segSize * sizeof(simd_int));
-	profile->profile_rev_byte = (simd_int*)mem_align(ALIGN_INT, aaSize * segSize * sizeof(simd_int));
-	profile->profile_rev_word = (simd_int*)mem_align(ALIGN_INT, aaSize * segSize * sizeof(simd_int));
+	profile->profile_byte = mem_align(MAX_ALIGN_INT, aaSize * segSize);
+	profile->profile_word = mem_align(MAX_ALIGN_INT, aaSize * segSize);
+	profile->profile_rev_byte = mem_align(MAX_ALIGN_INT, aaSize * segSize);
+	profile->profile_rev_word = mem_align(MAX_ALIGN_INT, aaSize * segSize);
+	profile->wordScores = false;
+	profile->wordReady = false;
 	profile->query_rev_sequence = new int8_t[maxSequenceLength];
 	profile->query_sequence     = new int8_t[maxSequenceLength];
 	profile->composition_bias   = new int8_t[maxSequenceLength];
@@ -54,21 +61,26 @@ SmithWaterman::SmithWaterman(size_t maxSequenceLength, int aaSize, bool aaBiasCo
 	profile->mat                = new int8_t[maxSequenceLength * aaSize * 2];
 	tmp_composition_bias   = new float[maxSequenceLength];
 	/* array to record the largest score of each reference position */
-	maxColumn = new uint8_t[maxSequenceLength*sizeof(uint16_t)];
-	memset(maxColumn, 0, maxSequenceLength*sizeof(uint16_t));
+	workspace.maxColumn = new uint8_t[maxSequenceLength*sizeof(uint16_t)];
+	memset(workspace.maxColumn, 0, maxSequenceLength*sizeof(uint16_t));
 
 	memset(profile->query_sequence, 0, maxSequenceLength * sizeof(int8_t));
 	memset(profile->query_rev_sequence, 0, maxSequenceLength * sizeof(int8_t));
 	memset(profile->mat_rev, 0, maxSequenceLength * aaSize);
 	memset(profile->composition_bias, 0, maxSequenceLength * sizeof(int8_t));
 	memset(profile->composition_bias_rev, 0, maxSequenceLength * sizeof(int8_t));
+	bandH = NULL;
+	bandE = NULL;
+	bandSize = 0;
+	bandTrace = NULL;
+	bandTraceSize = 0;
 }
 
 SmithWaterman::~SmithWaterman(){
-	free(vHStore);
-	free(vHLoad);
-	free(vE);
-	free(vHmax);
+	free(workspace.vHStore);
+	free(workspace.vHLoad);
+	free(workspace.vE);
+	free(workspace.vHmax);
 	free(profile->profile_byte);
 	free(profile->profile_word);
 	free(profile->profile_rev_byte);
@@ -82,14 +94,17 @@ SmithWaterman::~SmithWaterman(){
 	delete [] profile->mat_rev;
 	delete [] profile->mat;
 	delete [] tmp_composition_bias;
-	delete [] maxColumn;
+	delete [] workspace.maxColumn;
 	delete profile;
+	free(bandH);
+	free(bandE);
+	free(bandTrace);
 }
 
 
 /* Generate query profile rearrange query sequence & calculate the weight of match/mismatch. */
-template <typename T, size_t Elements, const unsigned int type>
-void SmithWaterman::createQueryProfile(simd_int *profile, const int8_t *query_sequence, const int8_t * composition_bias, const int8_t *mat,
+template <typename T, const unsigned int type>
+void SmithWaterman::createQueryProfile(void *profile, const size_t Elements, const int8_t *query_sequence, const int8_t * composition_bias, const int8_t *mat,
 									   const int32_t query_length, const int32_t aaSize, uint8_t bias,
 									   const int32_t offset, const int32_t entryLength) {
 
@@ -125,6 +140,11 @@ void SmithWaterman::createQueryProfile(simd_int *profile, const int8_t *query_se
 
 }
 
+template void SmithWaterman::createQueryProfile<int8_t, SmithWaterman::SUBSTITUTIONMATRIX>(void *, const size_t, const int8_t *, const int8_t *, const int8_t *, const int32_t, const int32_t, uint8_t, const int32_t, const int32_t);
+template void SmithWaterman::createQueryProfile<int8_t, SmithWaterman::PROFILE>(void *, const size_t, const int8_t *, const int8_t *, const int8_t *, const int32_t, const int32_t, uint8_t, const int32_t, const int32_t);
+template void SmithWaterman::createQueryProfile<int16_t, SmithWaterman::SUBSTITUTIONMATRIX>(void *, const size_t, const int8_t *, const int8_t *, const int8_t *, const int32_t, const int32_t, uint8_t, const int32_t, const int32_t);
+template void SmithWaterman::createQueryProfile<int16_t, SmithWaterman::PROFILE>(void *, const size_t, const int8_t *, const int8_t *, const int8_t *, const int32_t, const int32_t, uint8_t, const int32_t, const int32_t);
+
 
 s_align SmithWaterman::ssw_align (
 		const int *db_sequence,
@@ -151,24 +171,21 @@ s_align SmithWaterman::ssw_align (
 	//}
 
 	// Find the alignment scores and ending positions
-	if (profile->profile_byte) {
-		bests = sw_sse2_byte(db_sequence, 0, db_length, query_length, gap_open, gap_extend, profile->profile_byte, -1, profile->bias, maskLen);
-
-		if (profile->profile_word && bests[0].score == 255) {
-			free(bests);
-			bests = sw_sse2_word(db_sequence, 0, db_length, query_length, gap_open, gap_extend, profile->profile_word, -1, maskLen);
-			word = 1;
-		} else if (bests[0].score == 255) {
+	// the byte kernel continues with the word scores where they are needed, until the first overflow of a query
+	// they are not built and the byte kernel is run again
+	bests = kernels->swByteWord(workspace, db_sequence, db_length, query_length, gap_open, gap_extend, profile->profile_byte, profile->bias,
+								profile->wordReady ? profile->profile_word : NULL, profile->maxScore, maskLen);
+	if (profile->wordReady == false && bests[0].score == 255) {
+		if (profile->wordScores == false) {
 			fprintf(stderr, "Please set 2 to the score_size parameter of the function ssw_init, otherwise the alignment results will be incorrect.\n");
 			EXIT(EXIT_FAILURE);
 		}
-	}else if (profile->profile_word) {
-		bests = sw_sse2_word(db_sequence, 0, db_length, query_length, gap_open, gap_extend, profile->profile_word, -1, maskLen);
-		word = 1;
-	}else {
-		fprintf(stderr, "Please call the function ssw_init before ssw_align.\n");
-		EXIT(EXIT_FAILURE);
+		free(bests);
+		createWordProfile();
+		bests = kernels->swByteWord(workspace, db_sequence, db_length, query_length, gap_open, gap_extend, profile->profile_byte, profile->bias,
+									profile->profile_word, profile->maxScore, maskLen);
 	}
+	word = (bests[0].score + profile->bias >= 255);
 	r.score1 = bests[0].score;
 	r.dbEndPos1 = bests[0].ref;
 	r.qEndPos1 = bests[0].read;
@@ -194,24 +211,24 @@ s_align SmithWaterman::ssw_align (
 	// Find the beginning position of the best alignment.
 	if (word == 0) {
 		if(profile->sequence_type == Sequence::HMM_PROFILE || profile->sequence_type == Sequence::PROFILE_STATE_PROFILE) {
-			createQueryProfile<int8_t, VECSIZE_INT * 4, PROFILE>(profile->profile_rev_byte, profile->query_rev_sequence, NULL, profile->mat_rev,
+			createQueryProfile<int8_t, PROFILE>(profile->profile_rev_byte, kernels->vectorSize, profile->query_rev_sequence, NULL, profile->mat_rev,
 																 r.qEndPos1 + 1, profile->alphabetSize, profile->bias, queryOffset, profile->query_length);
 		}else{
-			createQueryProfile<int8_t, VECSIZE_INT * 4, SUBSTITUTIONMATRIX>(profile->profile_rev_byte, profile->query_rev_sequence, profile->composition_bias_rev, profile->mat,
+			createQueryProfile<int8_t, SUBSTITUTIONMATRIX>(profile->profile_rev_byte, kernels->vectorSize, profile->query_rev_sequence, profile->composition_bias_rev, profile->mat,
 																			r.qEndPos1 + 1, profile->alphabetSize, profile->bias, queryOffset, 0);
 		}
-		bests_reverse = sw_sse2_byte(db_sequence, 1, r.dbEndPos1 + 1, r.qEndPos1 + 1, gap_open, gap_extend, profile->profile_rev_byte,
+		bests_reverse = kernels->swByte(workspace, db_sequence, 1, r.dbEndPos1 + 1, r.qEndPos1 + 1, gap_open, gap_extend, profile->profile_rev_byte,
 									 r.score1, profile->bias, maskLen);
 	} else {
 		if(profile->sequence_type == Sequence::HMM_PROFILE || profile->sequence_type == Sequence::PROFILE_STATE_PROFILE) {
-			createQueryProfile<int16_t, VECSIZE_INT * 2, PROFILE>(profile->profile_rev_word, profile->query_rev_sequence, NULL, profile->mat_rev,
+			createQueryProfile<int16_t, PROFILE>(profile->profile_rev_word, kernels->vectorSize / 2, profile->query_rev_sequence, NULL, profile->mat_rev,
 																  r.qEndPos1 + 1, profile->alphabetSize, 0, queryOffset, profile->query_length);
 
 		}else{
-			createQueryProfile<int16_t, VECSIZE_INT * 2, SUBSTITUTIONMATRIX>(profile->profile_rev_word, profile->query_rev_sequence, profile->composition_bias_rev, profile->mat,
+			createQueryProfile<int16_t, SUBSTITUTIONMATRIX>(profile->profile_rev_word, kernels->vectorSize / 2, profile->query_rev_sequence, profile->composition_bias_rev, profile->mat,
 																			 r.qEndPos1 + 1, profile->alphabetSize, 0, queryOffset, 0);
 		}
-		bests_reverse = sw_sse2_word(db_sequence, 1, r.dbEndPos1 + 1, r.qEndPos1 + 1, gap_open, gap_extend, profile->profile_rev_word,
+		bests_reverse = kernels->swWord(workspace, db_sequence, 1, r.dbEndPos1 + 1, r.qEndPos1 + 1, gap_open, gap_extend, profile->profile_rev_word,
 									 r.score1, maskLen);
 	}
 	if(bests_reverse->score != r.score1){
@@ -261,6 +278,193 @@ s_align SmithWaterman::ssw_align (
 
 
 
+s_align SmithWaterman::ssw_align_xdrop(const int *db_sequence,
+									   int32_t db_length,
+									   const uint8_t gap_open,
+									   const uint8_t gap_extend,
+									   const int diagonal,
+									   const int32_t bandWidth,
+									   const int32_t xdrop,
+									   EvalueComputation *evaluer,
+									   bool &bandHit) {
+	if (profile->wordReady == false) {
+		createWordProfile();
+	}
+	const int32_t query_length = profile->query_length;
+	const int32_t width = 2 * bandWidth + 1;
+	const int32_t minScore = INT_MIN / 2;
+	s_align r;
+	r.score1 = 0;
+	r.score2 = 0;
+	r.ref_end2 = -1;
+	r.qStartPos1 = 0;
+	r.qEndPos1 = 0;
+	r.dbStartPos1 = 0;
+	r.dbEndPos1 = 0;
+	r.cigar = NULL;
+	r.cigarLen = 0;
+	bandHit = false;
+
+	// cell k of query row i is target position i - diagonal - bandWidth + k, only rows that overlap the target are computed
+	const int32_t firstRow = std::max(0, diagonal - bandWidth);
+	const int32_t lastRow = std::min(query_length - 1, db_length - 1 + diagonal + bandWidth);
+	if (firstRow > lastRow) {
+		r.qCov = 0.0f;
+		r.tCov = 0.0f;
+		r.evalue = evaluer->computeEvalue(0, query_length);
+		return r;
+	}
+	// H and E of cell k are stored at k + 1, the cells 0 and width + 1 stay empty
+	if (bandSize < width + 2) {
+		bandSize = width + 2;
+		bandH = (int32_t *) realloc(bandH, bandSize * sizeof(int32_t));
+		bandE = (int32_t *) realloc(bandE, bandSize * sizeof(int32_t));
+	}
+	const size_t traceSize = static_cast<size_t>(lastRow - firstRow + 1) * width;
+	if (bandTraceSize < traceSize) {
+		bandTraceSize = traceSize;
+		bandTrace = (uint8_t *) realloc(bandTrace, bandTraceSize * sizeof(uint8_t));
+	}
+	for (int32_t k = 0; k < width + 2; k++) {
+		bandH[k] = 0;
+		bandE[k] = minScore;
+	}
+
+	// trace bits: 0-1 origin of H (0: start, 1: diagonal, 2: E, 3: F), 2: E extends E, 3: F extends F
+	int32_t best = 0;
+	int32_t bestRow = -1;
+	int32_t bestCell = -1;
+	for (int32_t i = firstRow; i <= lastRow; i++) {
+		const int32_t offset = i - diagonal - bandWidth;
+		const int32_t kBeg = std::max(0, -offset);
+		const int32_t kEnd = std::min(width - 1, db_length - 1 - offset);
+		uint8_t *trace = bandTrace + static_cast<size_t>(i - firstRow) * width;
+		for (int32_t k = 0; k < kBeg; k++) {
+			bandH[k + 1] = 0;
+			bandE[k + 1] = minScore;
+			trace[k] = 0;
+		}
+		int32_t f = minScore;
+		int32_t rowMax = 0;
+		for (int32_t k = kBeg; k <= kEnd; k++) {
+			// H of the previous row at k is the diagonal, at k + 1 the cell above, H at k is the cell to the left
+			const int32_t hUp = bandH[k + 2] - gap_open;
+			const int32_t eUp = bandE[k + 2] - gap_extend;
+			const int32_t e = std::max(hUp, eUp);
+			const int32_t hLeft = bandH[k] - gap_open;
+			const int32_t fLeft = f - gap_extend;
+			f = std::max(hLeft, fLeft);
+			int32_t h = bandH[k + 1] + profile->profile_word_linear[db_sequence[offset + k]][i];
+			uint8_t t = (h > 0) ? 1 : 0;
+			h = std::max(h, 0);
+			if (e > h) {
+				h = e;
+				t = 2;
+			}
+			if (f > h) {
+				h = f;
+				t = 3;
+			}
+			t |= (eUp > hUp) ? 4 : 0;
+			t |= (fLeft > hLeft) ? 8 : 0;
+			trace[k] = t;
+			bandH[k + 1] = h;
+			bandE[k + 1] = e;
+			rowMax = std::max(rowMax, h);
+			if (h > best) {
+				best = h;
+				bestRow = i;
+				bestCell = k;
+			}
+		}
+		// the best cell of the row is on the outermost diagonal, the alignment drifts out of the band
+		if (rowMax > xdrop && rowMax >= best - xdrop
+			&& ((kBeg == 0 && bandH[1] == rowMax) || (kEnd == width - 1 && bandH[width] == rowMax))) {
+			bandHit = true;
+		}
+		for (int32_t k = kEnd + 1; k < width; k++) {
+			bandH[k + 1] = 0;
+			bandE[k + 1] = minScore;
+			trace[k] = 0;
+		}
+		// no cell of the band can recover to the best score
+		if (rowMax < best - xdrop) {
+			break;
+		}
+	}
+
+	if (best == 0) {
+		r.qCov = 0.0f;
+		r.tCov = 0.0f;
+		r.evalue = evaluer->computeEvalue(0, query_length);
+		return r;
+	}
+
+	// trace back from the best cell, the operations are collected in reverse order
+	std::vector<uint32_t> ops;
+	int32_t i = bestRow;
+	int32_t k = bestCell;
+	int32_t qStart = i;
+	int32_t dbStart = i - diagonal - bandWidth + k;
+	char state = 'M';
+	char prevOp = 0;
+	uint32_t opLen = 0;
+	while (i >= firstRow) {
+		const uint8_t t = bandTrace[static_cast<size_t>(i - firstRow) * width + k];
+		if (k == 0 || k == width - 1) {
+			bandHit = true;
+		}
+		char op;
+		if (state == 'M') {
+			const uint8_t origin = t & 3;
+			if (origin == 0) {
+				break;
+			} else if (origin == 2) {
+				state = 'I';
+				continue;
+			} else if (origin == 3) {
+				state = 'D';
+				continue;
+			}
+			op = 'M';
+			qStart = i;
+			dbStart = i - diagonal - bandWidth + k;
+			i--;
+		} else if (state == 'I') {
+			op = 'I';
+			state = (t & 4) ? 'I' : 'M';
+			i--;
+			k++;
+		} else {
+			op = 'D';
+			state = (t & 8) ? 'D' : 'M';
+			k--;
+		}
+		if (op != prevOp && opLen > 0) {
+			ops.push_back(to_cigar_int(opLen, prevOp));
+			opLen = 0;
+		}
+		prevOp = op;
+		opLen++;
+	}
+	if (opLen > 0) {
+		ops.push_back(to_cigar_int(opLen, prevOp));
+	}
+
+	r.score1 = best;
+	r.qStartPos1 = qStart;
+	r.qEndPos1 = bestRow;
+	r.dbStartPos1 = dbStart;
+	r.dbEndPos1 = bestRow - diagonal - bandWidth + bestCell;
+	r.cigarLen = ops.size();
+	r.cigar = new uint32_t[ops.size()];
+	std::reverse_copy(ops.begin(), ops.end(), r.cigar);
+	r.qCov = computeCov(r.qStartPos1, r.qEndPos1, query_length);
+	r.tCov = computeCov(r.dbStartPos1, r.dbEndPos1, db_length);
+	r.evalue = evaluer->computeEvalue(r.score1, query_length);
+	return r;
+}
+
 char SmithWaterman::cigar_int_to_op (uint32_t cigar_int)
 {
 	uint8_t letter_code = cigar_int & 0xfU;
@@ -289,407 +493,6 @@ uint32_t SmithWaterman::cigar_int_to_len (uint32_t cigar_int)
 	return res;
 }
 
-SmithWaterman::alignment_end* SmithWaterman::sw_sse2_byte (const int* db_sequence,
-														   int8_t ref_dir,	// 0: forward ref; 1: reverse ref
-														   int32_t db_length,
-														   int32_t query_length,
-														   const uint8_t gap_open, /* will be used as - */
-														   const uint8_t gap_extend, /* will be used as - */
-														   const simd_int* query_profile_byte,
-														   uint8_t terminate,	/* the best alignment score: used to terminate
-                                                         the matrix calculation when locating the
-                                                         alignment beginning point. If this score
-                                                         is set to 0, it will not be used */
-														   uint8_t bias,  /* Shift 0 point to a positive value. */
-														   int32_t maskLen) {
-#define max16(m, vm) ((m) = simdi8_hmax((vm)));
-
-	uint8_t max = 0;		                     /* the max alignment score */
-	int32_t end_query = query_length - 1;
-	int32_t end_db = -1; /* 0_based best alignment ending point; Initialized as isn't aligned -1. */
-	const int SIMD_SIZE = VECSIZE_INT * 4;
-	int32_t segLen = (query_length + SIMD_SIZE-1) / SIMD_SIZE; /* number of segment */
-	/* array to record the largest score of each reference position */
-	memset(this->maxColumn, 0, db_length * sizeof(uint8_t));
-	uint8_t * maxColumn = (uint8_t *) this->maxColumn;
-
-	/* Define 16 byte 0 vector. */
-	simd_int vZero = simdi32_set(0);
-	simd_int* pvHStore = vHStore;
-	simd_int* pvHLoad = vHLoad;
-	simd_int* pvE = vE;
-	simd_int* pvHmax = vHmax;
-	memset(pvHStore,0,segLen*sizeof(simd_int));
-	memset(pvHLoad,0,segLen*sizeof(simd_int));
-	memset(pvE,0,segLen*sizeof(simd_int));
-	memset(pvHmax,0,segLen*sizeof(simd_int));
-
-	int32_t i, j;
-	/* 16 byte insertion begin vector */
-	simd_int vGapO = simdi8_set(gap_open);
-
-	/* 16 byte insertion extension vector */
-	simd_int vGapE = simdi8_set(gap_extend);
-
-	/* 16 byte bias vector */
-	simd_int vBias = simdi8_set(bias);
-
-	simd_int vMaxScore = vZero; /* Trace the highest score of the whole SW matrix. */
-	simd_int vMaxMark = vZero; /* Trace the highest score till the previous column. */
-	simd_int vTemp;
-	int32_t edge, begin = 0, end = db_length, step = 1;
-	//	int32_t distance = query_length * 2 / 3;
-	//	int32_t distance = query_length / 2;
-	//	int32_t distance = query_length;
-
-	/* outer loop to process the reference sequence */
-	if (ref_dir == 1) {
-		begin = db_length - 1;
-		end = -1;
-		step = -1;
-	}
-	for (i = begin; LIKELY(i != end); i += step) {
-		simd_int e, vF = vZero, vMaxColumn = vZero; /* Initialize F value to 0.
-                                                    Any errors to vH values will be corrected in the Lazy_F loop.
-                                                    */
-		//		max16(maxColumn[i], vMaxColumn);
-		//		fprintf(stderr, "middle[%d]: %d\n", i, maxColumn[i]);
-
-		simd_int vH = pvHStore[segLen - 1];
-		vH = simdi8_shiftl (vH, 1); /* Shift the 128-bit value in vH left by 1 byte. */
-		const simd_int* vP = query_profile_byte + db_sequence[i] * segLen; /* Right part of the query_profile_byte */
-		//	int8_t* t;
-		//	int32_t ti;
-		//        fprintf(stderr, "i: %d of %d:\t ", i,segLen);
-		//for (t = (int8_t*)vP, ti = 0; ti < segLen; ++ti) fprintf(stderr, "%d\t", *t++);
-		//fprintf(stderr, "\n");
-
-		/* Swap the 2 H buffers. */
-		simd_int* pv = pvHLoad;
-		pvHLoad = pvHStore;
-		pvHStore = pv;
-
-		/* inner loop to process the query sequence */
-		for (j = 0; LIKELY(j < segLen); ++j) {
-			vH = simdui8_adds(vH, simdi_load(vP + j));
-			vH = simdui8_subs(vH, vBias); /* vH will be always > 0 */
-			//	max16(maxColumn[i], vH);
-			//	fprintf(stderr, "H[%d]: %d\n", i, maxColumn[i]);
-			//	int8_t* t;
-			//	int32_t ti;
-			//for (t = (int8_t*)&vH, ti = 0; ti < 16; ++ti) fprintf(stderr, "%d\t", *t++);
-
-			/* Get max from vH, vE and vF. */
-			e = simdi_load(pvE + j);
-			vH = simdui8_max(vH, e);
-			vH = simdui8_max(vH, vF);
-			vMaxColumn = simdui8_max(vMaxColumn, vH);
-
-			//	max16(maxColumn[i], vMaxColumn);
-			//	fprintf(stderr, "middle[%d]: %d\n", i, maxColumn[i]);
-			//	for (t = (int8_t*)&vMaxColumn, ti = 0; ti < 16; ++ti) fprintf(stderr, "%d\t", *t++);
-
-			/* Save vH values. */
-			simdi_store(pvHStore + j, vH);
-
-			/* Update vE value. */
-			vH = simdui8_subs(vH, vGapO); /* saturation arithmetic, result >= 0 */
-			e = simdui8_subs(e, vGapE);
-			e = simdui8_max(e, vH);
-			simdi_store(pvE + j, e);
-
-			/* Update vF value. */
-			vF = simdui8_subs(vF, vGapE);
-			vF = simdui8_max(vF, vH);
-
-			/* Load the next vH. */
-			vH = simdi_load(pvHLoad + j);
-		}
-
-		/* Lazy_F loop: has been revised to disallow adjecent insertion and then deletion, so don't update E(i, j), learn from SWPS3 */
-		/* reset pointers to the start of the saved data */
-		j = 0;
-		vH = simdi_load (pvHStore + j);
-
-		/*  the computed vF value is for the given column.  since */
-		/*  we are at the end, we need to shift the vF value over */
-		/*  to the next column. */
-		vF = simdi8_shiftl (vF, 1);
-		vTemp = simdui8_subs (vH, vGapO);
-		vTemp = simdui8_subs (vF, vTemp);
-		vTemp = simdi8_eq (vTemp, vZero);
-		uint32_t cmp = simdi8_movemask (vTemp);
-#ifdef AVX2
-		while (cmp != 0xffffffff)
-#else
-			while (cmp != 0xffff)
-#endif
-		{
-			vH = simdui8_max (vH, vF);
-			vMaxColumn = simdui8_max(vMaxColumn, vH);
-			simdi_store (pvHStore + j, vH);
-			vF = simdui8_subs (vF, vGapE);
-			j++;
-			if (j >= segLen)
-			{
-				j = 0;
-				vF = simdi8_shiftl (vF, 1);
-			}
-			vH = simdi_load (pvHStore + j);
-
-			vTemp = simdui8_subs (vH, vGapO);
-			vTemp = simdui8_subs (vF, vTemp);
-			vTemp = simdi8_eq (vTemp, vZero);
-			cmp  = simdi8_movemask (vTemp);
-		}
-
-		vMaxScore = simdui8_max(vMaxScore, vMaxColumn);
-		vTemp = simdi8_eq(vMaxMark, vMaxScore);
-		cmp = simdi8_movemask(vTemp);
-#ifdef AVX2
-		if (cmp != 0xffffffff)
-#else
-			if (cmp != 0xffff)
-#endif
-		{
-			uint8_t temp;
-			vMaxMark = vMaxScore;
-			max16(temp, vMaxScore);
-			vMaxScore = vMaxMark;
-
-			if (LIKELY(temp > max)) {
-				max = temp;
-				if (max + bias >= 255) break;	//overflow
-				end_db = i;
-
-				/* Store the column with the highest alignment score in order to trace the alignment ending position on read. */
-				for (j = 0; LIKELY(j < segLen); ++j) pvHmax[j] = pvHStore[j];
-			}
-		}
-
-		/* Record the max score of current column. */
-		max16(maxColumn[i], vMaxColumn);
-		//		fprintf(stderr, "maxColumn[%d]: %d\n", i, maxColumn[i]);
-		if (maxColumn[i] == terminate) break;
-	}
-
-	/* Trace the alignment ending position on read. */
-	uint8_t *t = (uint8_t*)pvHmax;
-	int32_t column_len = segLen * SIMD_SIZE;
-	for (i = 0; LIKELY(i < column_len); ++i, ++t) {
-		int32_t temp;
-		if (*t == max) {
-			temp = i / SIMD_SIZE + i % SIMD_SIZE * segLen;
-			if (temp < end_query) end_query = temp;
-		}
-	}
-
-	/* Find the most possible 2nd best alignment. */
-	alignment_end* bests = (alignment_end*) calloc(2, sizeof(alignment_end));
-	bests[0].score = max + bias >= 255 ? 255 : max;
-	bests[0].ref = end_db;
-	bests[0].read = end_query;
-
-	bests[1].score = 0;
-	bests[1].ref = 0;
-	bests[1].read = 0;
-
-	edge = (end_db - maskLen) > 0 ? (end_db - maskLen) : 0;
-	for (i = 0; i < edge; i ++) {
-		//			fprintf (stderr, "maxColumn[%d]: %d\n", i, maxColumn[i]);
-		if (maxColumn[i] > bests[1].score) {
-			bests[1].score = maxColumn[i];
-			bests[1].ref = i;
-		}
-	}
-	edge = (end_db + maskLen) > db_length ? db_length : (end_db + maskLen);
-	for (i = edge + 1; i < db_length; i ++) {
-		//			fprintf (stderr, "db_length: %d\tmaxColumn[%d]: %d\n", db_length, i, maxColumn[i]);
-		if (maxColumn[i] > bests[1].score) {
-			bests[1].score = maxColumn[i];
-			bests[1].ref = i;
-		}
-	}
-
-	return bests;
-#undef max16
-}
-
-
-SmithWaterman::alignment_end* SmithWaterman::sw_sse2_word (const int* db_sequence,
-														   int8_t ref_dir,	// 0: forward ref; 1: reverse ref
-														   int32_t db_length,
-														   int32_t query_lenght,
-														   const uint8_t gap_open, /* will be used as - */
-														   const uint8_t gap_extend, /* will be used as - */
-														   const simd_int*query_profile_word,
-														   uint16_t terminate,
-														   int32_t maskLen) {
-
-#define max8(m, vm) ((m) = simdi16_hmax((vm)));
-
-	uint16_t max = 0;		                     /* the max alignment score */
-	int32_t end_read = query_lenght - 1;
-	int32_t end_ref = 0; /* 1_based best alignment ending point; Initialized as isn't aligned - 0. */
-	const unsigned int SIMD_SIZE = VECSIZE_INT * 2;
-	int32_t segLen = (query_lenght + SIMD_SIZE-1) / SIMD_SIZE; /* number of segment */
-	/* array to record the alignment read ending position of the largest score of each reference position */
-	memset(this->maxColumn, 0, db_length * sizeof(uint16_t));
-	uint16_t * maxColumn = (uint16_t *) this->maxColumn;
-
-	/* Define 16 byte 0 vector. */
-	simd_int vZero = simdi32_set(0);
-	simd_int* pvHStore = vHStore;
-	simd_int* pvHLoad = vHLoad;
-	simd_int* pvE = vE;
-	simd_int* pvHmax = vHmax;
-	memset(pvHStore,0,segLen*sizeof(simd_int));
-	memset(pvHLoad,0, segLen*sizeof(simd_int));
-	memset(pvE,0,     segLen*sizeof(simd_int));
-	memset(pvHmax,0,  segLen*sizeof(simd_int));
-
-	int32_t i, j, k;
-	/* 16 byte insertion begin vector */
-	simd_int vGapO = simdi16_set(gap_open);
-
-	/* 16 byte insertion extension vector */
-	simd_int vGapE = simdi16_set(gap_extend);
-
-	simd_int vMaxScore = vZero; /* Trace the highest score of the whole SW matrix. */
-	simd_int vMaxMark = vZero; /* Trace the highest score till the previous column. */
-	simd_int vTemp;
-	int32_t edge, begin = 0, end = db_length, step = 1;
-
-	/* outer loop to process the reference sequence */
-	if (ref_dir == 1) {
-		begin = db_length - 1;
-		end = -1;
-		step = -1;
-	}
-	for (i = begin; LIKELY(i != end); i += step) {
-		simd_int e, vF = vZero; /* Initialize F value to 0.
-                                Any errors to vH values will be corrected in the Lazy_F loop.
-                                */
-		simd_int vH = pvHStore[segLen - 1];
-		vH = simdi8_shiftl (vH, 2); /* Shift the 128-bit value in vH left by 2 byte. */
-
-		/* Swap the 2 H buffers. */
-		simd_int* pv = pvHLoad;
-
-		simd_int vMaxColumn = vZero; /* vMaxColumn is used to record the max values of column i. */
-
-		const simd_int* vP = query_profile_word + db_sequence[i] * segLen; /* Right part of the query_profile_byte */
-		pvHLoad = pvHStore;
-		pvHStore = pv;
-
-		/* inner loop to process the query sequence */
-		for (j = 0; LIKELY(j < segLen); j ++) {
-			vH = simdi16_adds(vH, simdi_load(vP + j));
-
-			/* Get max from vH, vE and vF. */
-			e = simdi_load(pvE + j);
-			vH = simdi16_max(vH, e);
-			vH = simdi16_max(vH, vF);
-			vMaxColumn = simdi16_max(vMaxColumn, vH);
-
-			/* Save vH values. */
-			simdi_store(pvHStore + j, vH);
-
-			/* Update vE value. */
-			vH = simdui16_subs(vH, vGapO); /* saturation arithmetic, result >= 0 */
-			e = simdui16_subs(e, vGapE);
-			e = simdi16_max(e, vH);
-			simdi_store(pvE + j, e);
-
-			/* Update vF value. */
-			vF = simdui16_subs(vF, vGapE);
-			vF = simdi16_max(vF, vH);
-
-			/* Load the next vH. */
-			vH = simdi_load(pvHLoad + j);
-		}
-
-		/* Lazy_F loop: has been revised to disallow adjecent insertion and then deletion, so don't update E(i, j), learn from SWPS3 */
-		for (k = 0; LIKELY(k < (int32_t) SIMD_SIZE); ++k) {
-			vF = simdi8_shiftl (vF, 2);
-			for (j = 0; LIKELY(j < segLen); ++j) {
-				vH = simdi_load(pvHStore + j);
-				vH = simdi16_max(vH, vF);
-                                vMaxColumn = simdi16_max(vMaxColumn, vH); //newly added line
-				simdi_store(pvHStore + j, vH);
-				vH = simdui16_subs(vH, vGapO);
-				vF = simdui16_subs(vF, vGapE);
-				if (UNLIKELY(! simdi8_movemask(simdi16_gt(vF, vH)))) goto end;
-			}
-		}
-
-		end:
-		vMaxScore = simdi16_max(vMaxScore, vMaxColumn);
-		vTemp = simdi16_eq(vMaxMark, vMaxScore);
-		int32_t cmp = simdi8_movemask(vTemp);
-#ifdef AVX2
-		if (cmp != (int32_t)0xffffffff)
-#else
-			if (cmp != 0xffff)
-#endif
-		{
-			uint16_t temp;
-			vMaxMark = vMaxScore;
-			max8(temp, vMaxScore);
-			vMaxScore = vMaxMark;
-
-			if (LIKELY(temp > max)) {
-				max = temp;
-				end_ref = i;
-				for (j = 0; LIKELY(j < segLen); ++j) pvHmax[j] = pvHStore[j];
-			}
-		}
-
-		/* Record the max score of current column. */
-		max8(maxColumn[i], vMaxColumn);
-		if (maxColumn[i] == terminate) break;
-	}
-
-	/* Trace the alignment ending position on read. */
-	uint16_t *t = (uint16_t*)pvHmax;
-	int32_t column_len = segLen * SIMD_SIZE;
-	for (i = 0; LIKELY(i < column_len); ++i, ++t) {
-		int32_t temp;
-		if (*t == max) {
-			temp = i / SIMD_SIZE + i % SIMD_SIZE * segLen;
-			if (temp < end_read) end_read = temp;
-		}
-	}
-
-	/* Find the most possible 2nd best alignment. */
-	SmithWaterman::alignment_end* bests = (alignment_end*) calloc(2, sizeof(alignment_end));
-	bests[0].score = max;
-	bests[0].ref = end_ref;
-	bests[0].read = end_read;
-
-	bests[1].score = 0;
-	bests[1].ref = 0;
-	bests[1].read = 0;
-
-	edge = (end_ref - maskLen) > 0 ? (end_ref - maskLen) : 0;
-	for (i = 0; i < edge; i ++) {
-		if (maxColumn[i] > bests[1].score) {
-			bests[1].score = maxColumn[i];
-			bests[1].ref = i;
-		}
-	}
-	edge = (end_ref + maskLen) > db_length ? db_length : (end_ref + maskLen);
-	for (i = edge; i < db_length; i ++) {
-		if (maxColumn[i] > bests[1].score) {
-			bests[1].score = maxColumn[i];
-			bests[1].ref = i;
-		}
-	}
-
-	return bests;
-#undef max8
-}
-
 void SmithWaterman::ssw_init (const Sequence* q,
 							  const int8_t* mat,
 							  const BaseMatrix *m,
@@ -743,33 +546,23 @@ void SmithWaterman::ssw_init (const Sequence* q,
 		bias = abs(bias) + abs(compositionBias);
 		profile->bias = bias;
 		if(q->getSequenceType() == Sequence::HMM_PROFILE || q->getSequenceType() == Sequence::PROFILE_STATE_PROFILE){
-			createQueryProfile<int8_t, VECSIZE_INT * 4, PROFILE>(profile->profile_byte, profile->query_sequence, NULL, profile->mat, q->L, alphabetSize, bias, 1, q->L);
+			createQueryProfile<int8_t, PROFILE>(profile->profile_byte, kernels->vectorSize, profile->query_sequence, NULL, profile->mat, q->L, alphabetSize, bias, 1, q->L);
 		}else{
-			createQueryProfile<int8_t, VECSIZE_INT * 4, SUBSTITUTIONMATRIX>(profile->profile_byte, profile->query_sequence, profile->composition_bias, profile->mat, q->L, alphabetSize, bias, 0, 0);
+			createQueryProfile<int8_t, SUBSTITUTIONMATRIX>(profile->profile_byte, kernels->vectorSize, profile->query_sequence, profile->composition_bias, profile->mat, q->L, alphabetSize, bias, 0, 0);
 		}
 	}
-	if (score_size == 1 || score_size == 2) {
-		if(q->getSequenceType() == Sequence::HMM_PROFILE || q->getSequenceType() == Sequence::PROFILE_STATE_PROFILE){
-			createQueryProfile<int16_t, VECSIZE_INT * 2, PROFILE>(profile->profile_word, profile->query_sequence, NULL, profile->mat, q->L, alphabetSize, 0, 1, q->L);
-			for(int32_t i = 0; i< alphabetSize; i++) {
-				profile->profile_word_linear[i] = &profile_word_linear_data[i*q->L];
-				for (int j = 0; j < q->L; j++) {
-					//TODO is this right? :O
-					profile->profile_word_linear[i][j] = mat[i * q->L + j];
-				}
-			}
-		}else{
-			createQueryProfile<int16_t, VECSIZE_INT * 2, SUBSTITUTIONMATRIX>(profile->profile_word, profile->query_sequence, profile->composition_bias, profile->mat, q->L, alphabetSize, 0, 0, 0);
-			for(int32_t i = 0; i< alphabetSize; i++) {
-				profile->profile_word_linear[i] = &profile_word_linear_data[i*q->L];
-				for (int j = 0; j < q->L; j++) {
-					profile->profile_word_linear[i][j] = mat[i * alphabetSize + q->int_sequence[j]] + profile->composition_bias[j];
-				}
-			}
+	// highest score of a query position, it limits how fast the byte scores can grow
+	int32_t maxScore = 0;
+	for (int32_t i = 0; i < q->L; i++) {
+		for (int32_t aa = 0; aa < alphabetSize; aa++) {
+			const int32_t score = isProfile ? profile->mat[aa * q->L + i]
+											: profile->mat[aa * alphabetSize + profile->query_sequence[i]] + profile->composition_bias[i];
+			maxScore = std::max(maxScore, score);
 		}
-
-
 	}
+	profile->maxScore = maxScore;
+	profile->wordScores = (score_size == 1 || score_size == 2);
+	profile->wordReady = false;
 	// create reverse structures
 	seq_reverse( profile->query_rev_sequence, profile->query_sequence, q->L);
 	seq_reverse( profile->composition_bias_rev, profile->composition_bias, q->L);
@@ -783,6 +576,32 @@ void SmithWaterman::ssw_init (const Sequence* q,
 	}
 	profile->query_length = q->L;
 	profile->alphabetSize = alphabetSize;
+	if (score_size == 1) {
+		createWordProfile();
+	}
+}
+
+void SmithWaterman::createWordProfile() {
+	const int32_t queryLength = profile->query_length;
+	const int32_t alphabetSize = profile->alphabetSize;
+	if(profile->sequence_type == Sequence::HMM_PROFILE || profile->sequence_type == Sequence::PROFILE_STATE_PROFILE){
+		createQueryProfile<int16_t, PROFILE>(profile->profile_word, kernels->vectorSize / 2, profile->query_sequence, NULL, profile->mat, queryLength, alphabetSize, 0, 1, queryLength);
+		for(int32_t i = 0; i< alphabetSize; i++) {
+			profile->profile_word_linear[i] = &profile_word_linear_data[i*queryLength];
+			for (int j = 0; j < queryLength; j++) {
+				profile->profile_word_linear[i][j] = profile->mat[i * queryLength + j];
+			}
+		}
+	}else{
+		createQueryProfile<int16_t, SUBSTITUTIONMATRIX>(profile->profile_word, kernels->vectorSize / 2, profile->query_sequence, profile->composition_bias, profile->mat, queryLength, alphabetSize, 0, 0, 0);
+		for(int32_t i = 0; i< alphabetSize; i++) {
+			profile->profile_word_linear[i] = &profile_word_linear_data[i*queryLength];
+			for (int j = 0; j < queryLength; j++) {
+				profile->profile_word_linear[i][j] = profile->mat[i * alphabetSize + profile->query_sequence[j]] + profile->composition_bias[j];
+			}
+		}
+	}
+	profile->wordReady = true;
 }
 template <const unsigned int type>
 SmithWaterman::cigar * SmithWaterman::banded_sw(const int *db_sequence, const int8_t *query_sequence, const int8_t * compositionBias,
@@ -1070,6 +889,9 @@ s_align SmithWaterman::scoreIdentical(int *dbSeq, int L, EvalueComputation * eva
 				  << "\n";
 		EXIT(1);
 	}
+	if (profile->wordReady == false) {
+		createWordProfile();
+	}
 
 	s_align r;
 	// to be compatible with --alignment-mode 1 (score only)
@@ -1100,63 +922,6 @@ s_align SmithWaterman::scoreIdentical(int *dbSeq, int L, EvalueComputation * eva
 }
 
 int SmithWaterman::ungapped_alignment(const int *db_sequence, int32_t db_length) {
-#define SWAP(tmp, arg1, arg2) tmp = arg1; arg1 = arg2; arg2 = tmp;
-
-	int i; // position in query bands (0,..,W-1)
-	int j; // position in db sequence (0,..,dbseq_length-1)
-	int element_count = (VECSIZE_INT * 4);
-	const int W = (profile->query_length + (element_count - 1)) / element_count; // width of bands in query and score matrix = hochgerundetes LQ/16
-
-	simd_int *p;
-	simd_int S;              // 16 unsigned bytes holding S(b*W+i,j) (b=0,..,15)
-	simd_int Smax = simdi_setzero();
-	simd_int Soffset; // all scores in query profile are shifted up by Soffset to obtain pos values
-	simd_int *s_prev, *s_curr; // pointers to Score(i-1,j-1) and Score(i,j), resp.
-	simd_int *qji;             // query profile score in row j (for residue x_j)
-	simd_int *s_prev_it, *s_curr_it;
-	simd_int *query_profile_it = (simd_int *) profile->profile_byte;
-	simd_int Zero = simdi_setzero();
-
-	// Load the score offset to all 16 unsigned byte elements of Soffset
-	Soffset = simdi8_set(profile->bias);
-	s_curr = vHStore;
-	s_prev = vHLoad;
-
-	memset(vHStore,0,W*sizeof(simd_int));
-	memset(vHLoad,0,W*sizeof(simd_int));
-
-	for (j = 0; j < db_length; ++j) // loop over db sequence positions
-	{
-
-		// Get address of query scores for row j
-		qji = query_profile_it + db_sequence[j] * W;
-
-		// Load the next S value
-		S = simdi_load(s_curr + W - 1);
-		S = simdi8_shiftl(S, 1);
-
-		// Swap s_prev and s_curr, smax_prev and smax_curr
-		SWAP(p, s_prev, s_curr);
-
-		s_curr_it = s_curr;
-		s_prev_it = s_prev;
-
-		for (i = 0; i < W; ++i) // loop over query band positions
-		{
-			// Saturated addition and subtraction to score S(i,j)
-			S = simdui8_adds(S, *(qji++)); // S(i,j) = S(i-1,j-1) + (q(i,x_j) + Soffset)
-			S = simdui8_subs(S, Soffset);       // S(i,j) = max(0, S(i,j) - Soffset)
-			simdi_store(s_curr_it++, S);       // store S to s_curr[i]
-			Smax = simdui8_max(Smax, S);       // Smax(i,j) = max(Smax(i,j), S(i,j))
-
-			// Load the next S and Smax values
-			S = simdi_load(s_prev_it++);
-		}
-	}
-	int score = simd_hmax((unsigned char *) &Smax, element_count);
-
-	/* return largest score */
-	return score;
-#undef SWAP
+	return kernels->ungapped(workspace, db_sequence, db_length, profile->profile_byte, profile->query_length, profile->bias);
 }
 
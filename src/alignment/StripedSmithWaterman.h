@@ -45,6 +45,7 @@
 
 #include "simd.h"
 #include "BaseMatrix.h"
+#include "SimdKernels.h"
 
 #include "Sequence.h"
 #include "EvalueComputation.h"
@@ -145,6 +146,30 @@ public:
                         const int32_t maskLen);
 
 
+    /*!	@function	Banded Smith-Waterman around a seed diagonal with X-drop termination.
+
+     @param	diagonal	query position - target position of the seed (the prefilter diagonal)
+
+     @param	bandWidth	number of diagonals on each side of the seed diagonal
+
+     @param	xdrop	stop once the best score of a query row is more than xdrop below the best score so far
+
+     @param	bandHit	set if the traceback of the best alignment touches the band boundary, the alignment might
+     continue outside of the band and should be recomputed with ssw_align
+
+     @return	alignment result with start, end positions and cigar, alignments that never reach a positive score
+     have a score of 0 and no cigar
+     */
+    s_align ssw_align_xdrop(const int *db_sequence,
+                            int32_t db_length,
+                            const uint8_t gap_open,
+                            const uint8_t gap_extend,
+                            const int diagonal,
+                            const int32_t bandWidth,
+                            const int32_t xdrop,
+                            EvalueComputation *evaluer,
+                            bool &bandHit);
+
     /*!	@function computed ungapped alignment score
 
    @param	db_sequence	pointer to the target sequence; the target sequence needs to be numbers and corresponding to the mat parameter of
@@ -187,6 +212,19 @@ public:
 
     s_align scoreIdentical(int *dbSeq, int L, EvalueComputation * evaluer, int alignmentMode);
 
+    // per position score correction of the current query (all zero without bias correction)
+    const int8_t *getCompositionBias() const {
+        return profile->composition_bias;
+    }
+
+    const static unsigned int SUBSTITUTIONMATRIX = 1;
+    const static unsigned int PROFILE = 2;
+
+    // striped scores of the query for a kernel with Elements lanes, shifted up by bias
+    // (instantiated for int8_t and int16_t)
+    template <typename T, const unsigned int type>
+    static void createQueryProfile(void *profile, const size_t Elements, const int8_t *query_sequence, const int8_t * composition_bias, const int8_t *mat, const int32_t query_length, const int32_t aaSize, uint8_t bias, const int32_t offset, const int32_t entryLength);
+
     static void seq_reverse(int8_t * reverse, const int8_t* seq, int32_t end)	/* end is 0-based alignment ending position */
     {
         int32_t start = 0;
@@ -202,10 +240,14 @@ public:
 private:
 
     struct s_profile{
-        simd_int* profile_byte;	// 0: none
-        simd_int* profile_word;	// 0: none
-        simd_int* profile_rev_byte;	// 0: none
-        simd_int* profile_rev_word;	// 0: none
+        void* profile_byte;	// 0: none
+        void* profile_word;	// 0: none
+        void* profile_rev_byte;	// 0: none
+        void* profile_rev_word;	// 0: none
+        // the word scores are only built once a byte alignment overflows (or ssw_align_xdrop needs them)
+        bool wordScores;
+        bool wordReady;
+        int32_t maxScore;
         int8_t* query_sequence;
         int8_t* query_rev_sequence;
         int8_t* composition_bias;
@@ -230,55 +272,17 @@ private:
         uint8_t bias;
         short ** profile_word_linear;
     };
-    simd_int* vHStore;
-    simd_int* vHLoad;
-    simd_int* vE;
-    simd_int* vHmax;
-    uint8_t * maxColumn;
-
-    typedef struct {
-        uint16_t score;
-        int32_t ref;	 //0-based position
-        int32_t read;    //alignment ending position on read, 0-based
-    } alignment_end;
+    // vector kernels for the widest instruction set of the CPU, the buffers are sized for its vectors
+    const SimdKernels *kernels;
+    SimdKernels::Workspace workspace;
 
+    typedef SimdKernels::alignment_end alignment_end;
 
     typedef struct {
         uint32_t* seq;
         int32_t length;
     } cigar;
 
-    /* Striped Smith-Waterman
-     Record the highest score of each reference position.
-     Return the alignment score and ending position of the best alignment, 2nd best alignment, etc.
-     Gap begin and gap extension are different.
-     wight_match > 0, all other weights < 0.
-     The returned positions are 0-based.
-     */
-    alignment_end* sw_sse2_byte (const int*db_sequence,
-                                 int8_t ref_dir,	// 0: forward ref; 1: reverse ref
-                                 int32_t db_length,
-                                 int32_t query_length,
-                                 const uint8_t gap_open, /* will be used as - */
-                                 const uint8_t gap_extend, /* will be used as - */
-                                 const simd_int* query_profile_byte,
-                                 uint8_t terminate,	/* the best alignment score: used to terminate
-                                                     the matrix calculation when locating the
-                                                     alignment beginning point. If this score
-                                                     is set to 0, it will not be used */
-                                 uint8_t bias,  /* Shift 0 point to a positive value. */
-                                 int32_t maskLen);
-
-    alignment_end* sw_sse2_word (const int* db_sequence,
-                                 int8_t ref_dir,	// 0: forward ref; 1: reverse ref
-                                 int32_t db_length,
-                                 int32_t query_lenght,
-                                 const uint8_t gap_open, /* will be used as - */
-                                 const uint8_t gap_extend, /* will be used as - */
-                                 const simd_int*query_profile_byte,
-                                 uint16_t terminate,
-                                 int32_t maskLen);
-
     template <const unsigned int type>
     SmithWaterman::cigar *banded_sw(const int *db_sequence, const int8_t *query_sequence, const int8_t * compositionBias, int32_t db_length, int32_t query_length, int32_t queryStart, int32_t score, const uint32_t gap_open, const uint32_t gap_extend, int32_t band_width, const int8_t *mat, int32_t n);
 
@@ -292,14 +296,18 @@ private:
     s_profile* profile;
 
 
-    const static unsigned int SUBSTITUTIONMATRIX = 1;
-    const static unsigned int PROFILE = 2;
-
-    template <typename T, size_t Elements, const unsigned int type>
-    void createQueryProfile(simd_int *profile, const int8_t *query_sequence, const int8_t * composition_bias, const int8_t *mat, const int32_t query_length, const int32_t aaSize, uint8_t bias, const int32_t offset, const int32_t entryLength);
+    // builds the word scores of the current query
+    void createWordProfile();
 
     float *tmp_composition_bias;
     short * profile_word_linear_data;
+
+    // rows of the band of ssw_align_xdrop and its traceback matrix, grown on demand
+    int32_t *bandH;
+    int32_t *bandE;
+    int32_t bandSize;
+    uint8_t *bandTrace;
+    size_t bandTraceSize;
     bool aaBiasCorrection;
 };
 #endif /* SMITH_WATERMAN_SSE2_H */
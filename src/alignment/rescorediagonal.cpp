@@ -1,10 +1,12 @@
 #include "DistanceCalculator.h"
+#include "DiagonalRescorer.h"
 #include "Util.h"
 #include "Parameters.h"
 #include "Matcher.h"
 #include "Debug.h"
 #include "DBReader.h"
 #include "DBWriter.h"
+#include "ResultCursor.h"
 #include "QueryMatcher.h"
 #include "CovSeqidQscPercMinDiag.out.h"
 #include "CovSeqidQscPercMinDiagTargetCov.out.h"
@@ -40,6 +42,112 @@ float parsePrecisionLib(const std::string &scoreFile, double targetSeqid, double
     return 0;
 }
 
+// a prefilter hit placed on its diagonal
+struct DiagonalHit {
+    unsigned int targetId;
+    const char *targetSeq;
+    int dbLen;
+    // false if the diagonal lies outside of query or target, the hit is then kept with a distance of 0
+    bool onDiagonal;
+    unsigned int diagonalLen;
+    // first residue on the diagonal
+    unsigned int queryStart;
+    unsigned int targetStart;
+};
+
+// looks up the target of a hit and its diagonal, returns false if the target can not fulfill the coverage threshold
+bool prepareDiagonalHit(Parameters &par, DBReader<unsigned int> *tdbr, const hit_t &hit, int queryLen,
+                        std::vector<char> &targetBuffer, DiagonalHit &diagonalHit) {
+    diagonalHit.targetId = tdbr->getId(hit.seqId);
+    diagonalHit.targetSeq = tdbr->getData(diagonalHit.targetId, targetBuffer);
+    // -2 because of \n\0 in sequenceDB
+    diagonalHit.dbLen = std::max(0, static_cast<int>(tdbr->getSeqLens(diagonalHit.targetId)) - 2);
+    if (Util::canBeCovered(par.covThr, par.covMode, static_cast<float>(queryLen), static_cast<float>(diagonalHit.dbLen)) == false) {
+        return false;
+    }
+    const short diagonal = static_cast<short>(hit.diagonal);
+    const unsigned short distanceToDiagonal = abs(diagonal);
+    diagonalHit.onDiagonal = true;
+    diagonalHit.diagonalLen = 0;
+    diagonalHit.queryStart = 0;
+    diagonalHit.targetStart = 0;
+    if (diagonal >= 0 && distanceToDiagonal < queryLen) {
+        diagonalHit.diagonalLen = std::min(diagonalHit.dbLen, queryLen - distanceToDiagonal);
+        diagonalHit.queryStart = distanceToDiagonal;
+    } else if (diagonal < 0 && distanceToDiagonal < diagonalHit.dbLen) {
+        diagonalHit.diagonalLen = std::min(diagonalHit.dbLen - distanceToDiagonal, queryLen);
+        diagonalHit.targetStart = distanceToDiagonal;
+    } else {
+        diagonalHit.onDiagonal = false;
+    }
+    return true;
+}
+
+// scores the diagonals of the hits of one query for --rescore-mode 2,
+// hits on the same diagonal are scored together by the DiagonalRescorer
+void rescoreDiagonals(DiagonalRescorer &rescorer, const char **subMat, Parameters &par,
+                      DBReader<unsigned int> *tdbr, const std::vector<hit_t> &hits,
+                      const char *querySeq, int queryLen,
+                      std::vector<std::pair<short, size_t>> &order,
+                      std::vector<std::vector<char>> &targetBuffers,
+                      std::vector<DistanceCalculator::LocalAlignment> &alignments) {
+    // a vector with only a few lanes used is slower than scoring the hits one by one
+    const size_t minBatchSize = std::max(static_cast<size_t>(2), rescorer.getLanes() / 8);
+    rescorer.initQuery(querySeq, queryLen);
+    alignments.assign(hits.size(), DistanceCalculator::LocalAlignment());
+    order.clear();
+    for (size_t entryIdx = 0; entryIdx < hits.size(); entryIdx++) {
+        order.emplace_back(static_cast<short>(hits[entryIdx].diagonal), entryIdx);
+    }
+    std::sort(order.begin(), order.end());
+
+    std::vector<size_t> batch;
+    batch.reserve(rescorer.getLanes());
+    // the rescorer reads the targets of a batch in place, so each lane needs its own buffer
+    targetBuffers.resize(rescorer.getLanes());
+    std::vector<DistanceCalculator::LocalAlignment> batchResults;
+    for (size_t runStart = 0; runStart < order.size(); ) {
+        const short diagonal = order[runStart].first;
+        size_t runEnd = runStart;
+        while (runEnd < order.size() && order[runEnd].first == diagonal) {
+            runEnd++;
+        }
+        const bool useBatch = (runEnd - runStart) >= minBatchSize;
+        const unsigned int queryStart = (diagonal >= 0) ? abs(diagonal) : 0;
+        for (size_t i = runStart; i < runEnd; i++) {
+            const size_t entryIdx = order[i].second;
+            DiagonalHit diagonalHit;
+            if (prepareDiagonalHit(par, tdbr, hits[entryIdx], queryLen, targetBuffers[batch.size()], diagonalHit) == false
+                || diagonalHit.onDiagonal == false) {
+                continue;
+            }
+            const char *targetSeq = diagonalHit.targetSeq + diagonalHit.targetStart;
+            if (useBatch && diagonalHit.diagonalLen <= DiagonalRescorer::MAX_DIAGONAL_LEN) {
+                rescorer.addTarget(targetSeq, diagonalHit.diagonalLen);
+                batch.push_back(entryIdx);
+            } else {
+                alignments[entryIdx] = DistanceCalculator::computeSubstitutionStartEndDistance(
+                        querySeq + queryStart, targetSeq, diagonalHit.diagonalLen, subMat);
+            }
+            if (batch.size() == rescorer.getLanes()) {
+                rescorer.rescore(queryStart, batchResults);
+                for (size_t j = 0; j < batch.size(); j++) {
+                    alignments[batch[j]] = batchResults[j];
+                }
+                batch.clear();
+            }
+        }
+        if (batch.empty() == false) {
+            rescorer.rescore(queryStart, batchResults);
+            for (size_t j = 0; j < batch.size(); j++) {
+                alignments[batch[j]] = batchResults[j];
+            }
+            batch.clear();
+        }
+        runStart = runEnd;
+    }
+}
+
 int doRescorediagonal(Parameters &par,
                       DBWriter &resultWriter,
                       DBReader<unsigned int> &resultReader,
@@ -123,6 +231,13 @@ int doRescorediagonal(Parameters &par,
             alnResults.reserve(300);
             std::vector<hit_t> shortResults;
             shortResults.reserve(300);
+            DiagonalRescorer rescorer(*subMat);
+            std::vector<std::pair<short, size_t>> diagonalOrder;
+            std::vector<std::vector<char>> targetBuffers;
+            std::vector<DistanceCalculator::LocalAlignment> alignments;
+            // the query stays in use while the targets are read, which can come from the same database
+            std::vector<char> queryBuffer;
+            std::vector<char> targetBuffer;
 
 #pragma omp for schedule(dynamic, 1)
             for (size_t id = start; id < (start + bucketSize); id++) {
@@ -131,7 +246,7 @@ int doRescorediagonal(Parameters &par,
                 char *data = resultReader.getData(id);
                 size_t queryKey = resultReader.getDbKey(id);
                 unsigned int queryId = qdbr.getId(queryKey);
-                char *querySeq = qdbr.getData(queryId);
+                char *querySeq = qdbr.getData(queryId, queryBuffer);
                 int queryLen = std::max(0, static_cast<int>(qdbr.getSeqLens(queryId)) - 2);
 
 //                if(par.rescoreMode != Parameters::RESCORE_MODE_HAMMING){
@@ -142,46 +257,35 @@ int doRescorediagonal(Parameters &par,
 //                }
 
                 std::vector<hit_t> results = QueryMatcher::parsePrefilterHits(data);
+                // several hits on the same diagonal are scored in one vector
+                if (par.rescoreMode == Parameters::RESCORE_MODE_ALIGNMENT) {
+                    rescoreDiagonals(rescorer, fastMatrix.matrix, par, tdbr, results, querySeq, queryLen, diagonalOrder, targetBuffers, alignments);
+                }
                 for (size_t entryIdx = 0; entryIdx < results.size(); entryIdx++) {
-                    unsigned int targetId = tdbr->getId(results[entryIdx].seqId);
-                    const bool isIdentity = (queryId == targetId && (par.includeIdentity || sameDB))? true : false;
-                    char * targetSeq = tdbr->getData(targetId);
-                    int dbLen = std::max(0, static_cast<int>(tdbr->getSeqLens(targetId)) - 2);
-
-                    float queryLength = static_cast<float>(queryLen);
-                    float targetLength = static_cast<float>(dbLen);
-                    if(Util::canBeCovered(par.covThr, par.covMode, queryLength, targetLength)==false){
+                    DiagonalHit diagonalHit;
+                    if (prepareDiagonalHit(par, tdbr, results[entryIdx], queryLen, targetBuffer, diagonalHit) == false) {
                         continue;
                     }
+                    const bool isIdentity = (queryId == diagonalHit.targetId && (par.includeIdentity || sameDB))? true : false;
+                    const char *targetSeq = diagonalHit.targetSeq;
+                    int dbLen = diagonalHit.dbLen;
                     short diagonal = results[entryIdx].diagonal;
                     unsigned short distanceToDiagonal = abs(diagonal);
-                    unsigned int diagonalLen = 0;
+                    unsigned int diagonalLen = diagonalHit.diagonalLen;
                     unsigned int distance = 0;
                     DistanceCalculator::LocalAlignment alignment;
-                    if (diagonal >= 0 && distanceToDiagonal < queryLen) {
-                        diagonalLen = std::min(dbLen, queryLen - distanceToDiagonal);
-                        if (par.rescoreMode == Parameters::RESCORE_MODE_HAMMING) {
-                            distance = DistanceCalculator::computeHammingDistance(
-                                    querySeq + distanceToDiagonal, targetSeq, diagonalLen);
-                        } else if (par.rescoreMode == Parameters::RESCORE_MODE_SUBSTITUTION) {
-                            distance = DistanceCalculator::computeSubstitutionDistance(
-                                    querySeq + distanceToDiagonal, targetSeq, diagonalLen, fastMatrix.matrix, par.globalAlignment);
-                        } else if (par.rescoreMode == Parameters::RESCORE_MODE_ALIGNMENT) {
-                            alignment = DistanceCalculator::computeSubstitutionStartEndDistance(
-                                    querySeq + distanceToDiagonal, targetSeq, diagonalLen, fastMatrix.matrix);
-                            distance = alignment.score;
-                        }
-                    } else if (diagonal < 0 && distanceToDiagonal < dbLen) {
-                        diagonalLen = std::min(dbLen - distanceToDiagonal, queryLen);
+                    if (diagonalHit.onDiagonal) {
+                        const char *queryDiagonal = querySeq + diagonalHit.queryStart;
+                        const char *targetDiagonal = targetSeq + diagonalHit.targetStart;
+                        // the hamming distance compares whole vectors along the diagonal, the score only substitution
+                        // distance is cheaper per hit than batching hits into the DiagonalRescorer
                         if (par.rescoreMode == Parameters::RESCORE_MODE_HAMMING) {
-                            distance = DistanceCalculator::computeHammingDistance(
-                                    querySeq, targetSeq + distanceToDiagonal, diagonalLen);
+                            distance = DistanceCalculator::computeHammingDistance(queryDiagonal, targetDiagonal, diagonalLen);
                         } else if (par.rescoreMode == Parameters::RESCORE_MODE_SUBSTITUTION) {
                             distance = DistanceCalculator::computeSubstitutionDistance(
-                                    querySeq, targetSeq + distanceToDiagonal, diagonalLen, fastMatrix.matrix, par.globalAlignment);
+                                    queryDiagonal, targetDiagonal, diagonalLen, fastMatrix.matrix, par.globalAlignment);
                         } else if (par.rescoreMode == Parameters::RESCORE_MODE_ALIGNMENT) {
-                            alignment = DistanceCalculator::computeSubstitutionStartEndDistance(
-                                    querySeq, targetSeq + distanceToDiagonal, diagonalLen, fastMatrix.matrix);
+                            alignment = alignments[entryIdx];
                             distance = alignment.score;
                         }
                     }
@@ -323,6 +427,7 @@ int rescorediagonal(int argc, const char **argv, const Command &command) {
 
 
     Debug(Debug::INFO) << "Prefilter database: " << par.db3 << "\n";
+    ResultCursor::requireText(par.db3);
     DBReader<unsigned int> resultReader(par.db3.c_str(), par.db3Index.c_str());
     resultReader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
 #ifdef HAVE_MPI
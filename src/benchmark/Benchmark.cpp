@@ -0,0 +1,799 @@
+// mmseqs-bench: timings of the compute kernels on deterministic data, to catch performance regressions
+// before a release. Every benchmark runs several times and reports its fastest run in ns per operation
+// (and GCUPS for the alignment kernels) together with a checksum of its results.
+//
+// mmseqs-bench [options]
+//   --fasta FILE       benchmark on the sequences of a FASTA file (e.g. examples/QUERY.fasta) instead of
+//                      the synthetic protein families
+//   --scale FLOAT      size of the synthetic data set [1.0]
+//   --repeat INT       runs of every benchmark, the fastest counts [3]
+//   --filter NAME      only run the benchmarks whose name contains NAME
+//   --json FILE        write the results as JSON, - writes them to stdout
+//   --baseline FILE    compare with the JSON of an earlier run
+//   --tolerance FLOAT  allowed slowdown against the baseline [0.2]
+//   --tmp PREFIX       prefix of the temporary sequence database [/tmp/mmseqs-bench]
+//
+// Exits with 1 if a benchmark is slower than the baseline by more than the tolerance or if its checksum
+// differs from the baseline on the same data set.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <map>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "kseq.h"
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "Debug.h"
+#include "Util.h"
+#include "FileUtil.h"
+#include "Sequence.h"
+#include "SubstitutionMatrix.h"
+#include "ExtendedSubstitutionMatrix.h"
+#include "EvalueComputation.h"
+#include "StripedSmithWaterman.h"
+#include "Matcher.h"
+#include "SimdKernels.h"
+#include "IndexTable.h"
+#include "IndexBuilder.h"
+#include "SequenceLookup.h"
+#include "UngappedAlignment.h"
+#include "QueryMatcher.h"
+#include "KmerGenerator.h"
+#include "CacheFriendlyOperations.h"
+#include "MathUtil.h"
+
+const char* binary_name = "mmseqs-bench";
+
+KSEQ_INIT(int, read)
+
+const char RESIDUES[] = "ACDEFGHIKLMNPQRSTVWY";
+
+// xorshift64, the same sequence on every platform unlike rand()
+class Random {
+public:
+    explicit Random(uint64_t seed) : state(seed) {}
+
+    uint64_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+
+    size_t uniform(size_t n) {
+        return static_cast<size_t>(next() % n);
+    }
+
+private:
+    uint64_t state;
+};
+
+struct DataSet {
+    std::string name;
+    std::vector<std::string> queries;
+    std::vector<std::string> targets;
+    // the targets homologous to each query, their alignments overflow the byte scores
+    std::vector<std::vector<size_t> > related;
+    // unrelated to the queries, their alignments stay within the byte scores
+    std::vector<std::string> decoys;
+};
+
+struct Measurement {
+    Measurement() : ops(0), cells(0.0), checksum(0), seconds(0.0) {}
+    size_t ops;
+    double cells;
+    uint64_t checksum;
+    double seconds;
+};
+
+struct BenchResult {
+    std::string name;
+    size_t ops;
+    double nsPerOp;
+    double gcups;
+    uint64_t checksum;
+};
+
+double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + 1e-6 * t.tv_usec;
+}
+
+std::string randomSequence(Random &random, size_t length) {
+    std::string seq(length, 'A');
+    for (size_t i = 0; i < length; i++) {
+        seq[i] = RESIDUES[random.uniform(20)];
+    }
+    return seq;
+}
+
+// 25% substitutions and 2% insertions or deletions
+std::string mutate(Random &random, const std::string &seq) {
+    std::string result;
+    for (size_t i = 0; i < seq.size(); i++) {
+        const size_t r = random.uniform(100);
+        if (r < 1) {
+            continue;
+        } else if (r < 2) {
+            result.push_back(RESIDUES[random.uniform(20)]);
+        }
+        result.push_back(r < 27 ? RESIDUES[random.uniform(20)] : seq[i]);
+    }
+    return result;
+}
+
+// families of a random ancestor with six mutated copies as targets and one as query
+DataSet syntheticDataSet(double scale) {
+    Random random(42);
+    DataSet data;
+    std::ostringstream name;
+    name << "synthetic-" << std::fixed << std::setprecision(2) << scale;
+    data.name = name.str();
+    const size_t families = std::max(static_cast<size_t>(250 * scale), (size_t) 1);
+    for (size_t i = 0; i < families; i++) {
+        const std::string ancestor = randomSequence(random, 80 + random.uniform(500));
+        data.related.push_back(std::vector<size_t>());
+        for (size_t t = 0; t < 6; t++) {
+            data.related.back().push_back(data.targets.size());
+            data.targets.push_back(mutate(random, ancestor));
+        }
+        data.queries.push_back(mutate(random, ancestor));
+    }
+    for (size_t i = 0; i < 100; i++) {
+        data.decoys.push_back(randomSequence(random, 80 + random.uniform(500)));
+    }
+    return data;
+}
+
+// all sequences are targets, the first 100 are also queries related to themselves and their shuffled residues are the decoys
+DataSet fastaDataSet(const std::string &fastaFile) {
+    FILE *file = FileUtil::openFileOrDie(fastaFile.c_str(), "r", true);
+    kseq_t *seq = kseq_init(fileno(file));
+    DataSet data;
+    data.name = FileUtil::baseName(fastaFile);
+    while (kseq_read(seq) >= 0) {
+        if (seq->seq.l > 0) {
+            data.targets.push_back(seq->seq.s);
+        }
+    }
+    kseq_destroy(seq);
+    fclose(file);
+    if (data.targets.empty()) {
+        Debug(Debug::ERROR) << "No sequences in " << fastaFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+
+    Random random(42);
+    for (size_t i = 0; i < std::min(data.targets.size(), (size_t) 100); i++) {
+        data.queries.push_back(data.targets[i]);
+        data.related.push_back(std::vector<size_t>(1, i));
+        std::string decoy = data.targets[i];
+        for (size_t pos = decoy.size(); pos > 1; pos--) {
+            std::swap(decoy[pos - 1], decoy[random.uniform(pos)]);
+        }
+        data.decoys.push_back(decoy);
+    }
+    return data;
+}
+
+// everything the benchmarks share, built once and not timed
+struct Context {
+    Context(const DataSet &data, const std::string &dbPrefix);
+    ~Context();
+
+    const DataSet &data;
+    std::string dbData;
+    std::string dbIndex;
+    unsigned int maxSeqLen;
+
+    // alignment scores in half bits as in align, prefilter scores in eighth bits as in prefilter
+    SubstitutionMatrix alnMat;
+    SubstitutionMatrix prefMat;
+    int8_t *tinySubMat;
+    EvalueComputation *alnEvaluer;
+    EvalueComputation *prefEvaluer;
+
+    DBReader<unsigned int> *dbr;
+    IndexTable *indexTable;
+    SequenceLookup *sequenceLookup;
+    ScoreMatrix *twoMer;
+    ScoreMatrix *threeMer;
+    short kmerThr;
+
+    // mapped once, ssw_align reads them in place
+    std::vector<std::vector<int> > targetInts;
+    std::vector<std::vector<int> > decoyInts;
+};
+
+Context::Context(const DataSet &data, const std::string &dbPrefix)
+        : data(data), dbData(dbPrefix), dbIndex(dbPrefix + ".index"), maxSeqLen(0),
+          alnMat("blosum62.out", 2.0, 0.0), prefMat("blosum62.out", 8.0, -0.2f),
+          sequenceLookup(NULL) {
+    DBWriter writer(dbData.c_str(), dbIndex.c_str(), 1, DBWriter::ASCII_MODE);
+    writer.open();
+    for (size_t i = 0; i < data.targets.size(); i++) {
+        const std::string entry = data.targets[i] + "\n";
+        writer.writeData(entry.c_str(), entry.size(), static_cast<unsigned int>(i), 0);
+        maxSeqLen = std::max(maxSeqLen, static_cast<unsigned int>(data.targets[i].size()));
+    }
+    writer.close(Sequence::AMINO_ACIDS);
+    for (size_t i = 0; i < data.queries.size(); i++) {
+        maxSeqLen = std::max(maxSeqLen, static_cast<unsigned int>(data.queries[i].size()));
+    }
+    for (size_t i = 0; i < data.decoys.size(); i++) {
+        maxSeqLen = std::max(maxSeqLen, static_cast<unsigned int>(data.decoys[i].size()));
+    }
+    maxSeqLen += 1;
+
+    dbr = new DBReader<unsigned int>(dbData.c_str(), dbIndex.c_str());
+    dbr->open(DBReader<unsigned int>::NOSORT);
+
+    const int alphabetSize = alnMat.alphabetSize;
+    tinySubMat = new int8_t[alphabetSize * alphabetSize];
+    for (int i = 0; i < alphabetSize; i++) {
+        for (int j = 0; j < alphabetSize; j++) {
+            tinySubMat[i * alphabetSize + j] = alnMat.subMatrix[i][j];
+        }
+    }
+    alnEvaluer = new EvalueComputation(dbr->getAminoAcidDBSize(), &alnMat, Matcher::GAP_OPEN, Matcher::GAP_EXTEND, true);
+    prefEvaluer = new EvalueComputation(dbr->getAminoAcidDBSize(), &prefMat, 0, 0, false);
+
+    // k-mer size 6 at sensitivity 4 without X
+    kmerThr = 104;
+    Sequence seq(maxSeqLen, Sequence::AMINO_ACIDS, &prefMat, 6, true, false);
+    indexTable = new IndexTable(prefMat.alphabetSize - 1, 6, false);
+    IndexBuilder::fillDatabase(indexTable, NULL, &sequenceLookup, prefMat, &seq, dbr, 0, dbr->getSize(), kmerThr);
+    prefMat.alphabetSize = prefMat.alphabetSize - 1;
+    twoMer = ExtendedSubstitutionMatrix::calcScoreMatrix(prefMat, 2);
+    threeMer = ExtendedSubstitutionMatrix::calcScoreMatrix(prefMat, 3);
+    prefMat.alphabetSize = prefMat.alphabetSize + 1;
+
+    Sequence target(maxSeqLen, Sequence::AMINO_ACIDS, &alnMat, 0, false, false);
+    for (size_t i = 0; i < data.targets.size(); i++) {
+        target.mapSequence(i, i, data.targets[i].c_str());
+        targetInts.push_back(std::vector<int>(target.int_sequence, target.int_sequence + target.L));
+    }
+    for (size_t i = 0; i < data.decoys.size(); i++) {
+        target.mapSequence(i, i, data.decoys[i].c_str());
+        decoyInts.push_back(std::vector<int>(target.int_sequence, target.int_sequence + target.L));
+    }
+}
+
+Context::~Context() {
+    ScoreMatrix::cleanup(twoMer);
+    ScoreMatrix::cleanup(threeMer);
+    delete sequenceLookup;
+    delete indexTable;
+    delete prefEvaluer;
+    delete alnEvaluer;
+    delete[] tinySubMat;
+    dbr->close();
+    delete dbr;
+    const std::string files[] = {dbData, dbIndex, dbData + ".dbtype", dbIndex + ".bin"};
+    for (size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        if (FileUtil::fileExists(files[i].c_str())) {
+            FileUtil::deleteFile(files[i]);
+        }
+    }
+}
+
+// ssw_align always starts with the byte scores and only switches to the word scores when they overflow,
+// as in align, so the word benchmark aligns homologs and includes the overflowing byte pass
+void smithWaterman(Context &ctx, Measurement &m, bool homologs) {
+    SmithWaterman aligner(ctx.maxSeqLen, ctx.alnMat.alphabetSize, false);
+    Sequence query(ctx.maxSeqLen, Sequence::AMINO_ACIDS, &ctx.alnMat, 0, false, false);
+    const size_t queryCount = std::min(ctx.data.queries.size(), (size_t) (homologs ? 250 : 50));
+    const double start = now();
+    for (size_t i = 0; i < queryCount; i++) {
+        query.mapSequence(i, i, ctx.data.queries[i].c_str());
+        aligner.ssw_init(&query, ctx.tinySubMat, &ctx.alnMat, ctx.alnMat.alphabetSize, 2);
+        const size_t targetCount = homologs ? ctx.data.related[i].size() : ctx.decoyInts.size();
+        for (size_t t = 0; t < targetCount; t++) {
+            const std::vector<int> &targetSeq = homologs ? ctx.targetInts[ctx.data.related[i][t]] : ctx.decoyInts[t];
+            const int32_t targetLen = static_cast<int32_t>(targetSeq.size());
+            s_align result = aligner.ssw_align(&targetSeq[0], targetLen, Matcher::GAP_OPEN, Matcher::GAP_EXTEND,
+                                               Matcher::SCORE_ONLY, 0.0, ctx.alnEvaluer, 0, 0.0, query.L / 2);
+            m.checksum += result.score1;
+            m.cells += static_cast<double>(query.L) * targetLen;
+            m.ops++;
+            delete[] result.cigar;
+        }
+    }
+    m.seconds = now() - start;
+}
+
+void swByte(Context &ctx, Measurement &m) {
+    smithWaterman(ctx, m, false);
+}
+
+void swWord(Context &ctx, Measurement &m) {
+    smithWaterman(ctx, m, true);
+}
+
+// profile of the query as msa2profile writes it, every position has half of its residue and half of the
+// substitution probabilities of the residue
+std::string queryProfile(const SubstitutionMatrix &mat, const std::string &query) {
+    std::string profile;
+    for (size_t i = 0; i < query.size(); i++) {
+        const int aa = mat.aa2int[(int) query[i]];
+        for (int b = 0; b < static_cast<int>(Sequence::PROFILE_AA_SIZE); b++) {
+            float prob = static_cast<float>(mat.pBack[b]);
+            if (aa < static_cast<int>(Sequence::PROFILE_AA_SIZE)) {
+                prob = 0.5f * static_cast<float>(mat.probMatrix[aa][b] / mat.pBack[aa]) + ((aa == b) ? 0.5f : 0.0f);
+            }
+            profile.push_back(static_cast<char>(Sequence::scoreMask(prob)));
+        }
+        profile.push_back(static_cast<char>(aa));
+        profile.push_back(static_cast<char>(aa));
+        profile.push_back(MathUtil::convertNeffToChar(3.0f));
+    }
+    return profile;
+}
+
+// profile queries against their homologs and 10 decoys, either with the word scores built up front and every
+// overflowing byte alignment started over on the word kernel (the path before SimdKernels::swByteWord) or as
+// SmithWaterman::ssw_align does it: the word scores are built on the first overflow and the byte kernel continues
+// with them. About a third of the alignments overflow the byte scores.
+void profileSmithWaterman(Context &ctx, Measurement &m, bool resume) {
+    const SimdKernels &kernels = SimdKernels::get();
+    const size_t lanes = kernels.vectorSize;
+    const size_t segSize = ((ctx.maxSeqLen + lanes / 2 - 1) / (lanes / 2)) * lanes;
+    const int alphabetSize = ctx.alnMat.alphabetSize;
+    SimdKernels::Workspace workspace;
+    workspace.vHStore = mem_align(MAX_ALIGN_INT, segSize);
+    workspace.vHLoad = mem_align(MAX_ALIGN_INT, segSize);
+    workspace.vE = mem_align(MAX_ALIGN_INT, segSize);
+    workspace.vHmax = mem_align(MAX_ALIGN_INT, segSize);
+    workspace.maxColumn = new uint8_t[ctx.maxSeqLen * sizeof(uint16_t)];
+    void *byteProfile = mem_align(MAX_ALIGN_INT, alphabetSize * segSize);
+    void *wordProfile = mem_align(MAX_ALIGN_INT, alphabetSize * segSize);
+
+    Sequence query(ctx.maxSeqLen, Sequence::HMM_PROFILE, &ctx.alnMat, 0, false, false);
+    std::vector<int8_t> mat;
+    const size_t queryCount = std::min(ctx.data.queries.size(), (size_t) 250);
+    double seconds = 0.0;
+    for (size_t i = 0; i < queryCount; i++) {
+        const std::string profile = queryProfile(ctx.alnMat, ctx.data.queries[i]);
+        query.mapSequence(i, i, profile.c_str());
+        const int32_t queryLen = query.L;
+        // as ssw_init copies it, with a neutral X
+        mat.assign(query.getAlignmentProfile(), query.getAlignmentProfile() + alphabetSize * queryLen);
+        std::fill(mat.begin() + (alphabetSize - 1) * queryLen, mat.end(), 0);
+
+        const double start = now();
+        int bias = 0;
+        int maxScore = 0;
+        for (int32_t k = 0; k < queryLen * static_cast<int32_t>(Sequence::PROFILE_AA_SIZE); k++) {
+            bias = std::min(bias, static_cast<int>(mat[k]));
+            maxScore = std::max(maxScore, static_cast<int>(mat[k]));
+        }
+        bias = -bias;
+        SmithWaterman::createQueryProfile<int8_t, SmithWaterman::PROFILE>(byteProfile, lanes, NULL, NULL, &mat[0], queryLen,
+                                                                          alphabetSize, bias, 1, queryLen);
+        bool wordReady = false;
+        if (resume == false) {
+            SmithWaterman::createQueryProfile<int16_t, SmithWaterman::PROFILE>(wordProfile, lanes / 2, NULL, NULL, &mat[0], queryLen,
+                                                                               alphabetSize, 0, 1, queryLen);
+            wordReady = true;
+        }
+        const size_t targetCount = ctx.data.related[i].size() + std::min(ctx.decoyInts.size(), (size_t) 10);
+        for (size_t t = 0; t < targetCount; t++) {
+            const bool homolog = (t < ctx.data.related[i].size());
+            const std::vector<int> &targetSeq = homolog ? ctx.targetInts[ctx.data.related[i][t]]
+                                                        : ctx.decoyInts[t - ctx.data.related[i].size()];
+            const int32_t targetLen = static_cast<int32_t>(targetSeq.size());
+            SimdKernels::alignment_end *bests = resume
+                    ? kernels.swByteWord(workspace, &targetSeq[0], targetLen, queryLen, Matcher::GAP_OPEN, Matcher::GAP_EXTEND,
+                                         byteProfile, bias, wordReady ? wordProfile : NULL, maxScore, queryLen / 2)
+                    : kernels.swByte(workspace, &targetSeq[0], 0, targetLen, queryLen, Matcher::GAP_OPEN,
+                                     Matcher::GAP_EXTEND, byteProfile, -1, bias, queryLen / 2);
+            if (bests[0].score == 255 && (resume == false || wordReady == false)) {
+                free(bests);
+                if (wordReady == false) {
+                    SmithWaterman::createQueryProfile<int16_t, SmithWaterman::PROFILE>(wordProfile, lanes / 2, NULL, NULL, &mat[0], queryLen,
+                                                                                       alphabetSize, 0, 1, queryLen);
+                    wordReady = true;
+                }
+                bests = resume
+                        ? kernels.swByteWord(workspace, &targetSeq[0], targetLen, queryLen, Matcher::GAP_OPEN, Matcher::GAP_EXTEND,
+                                             byteProfile, bias, wordProfile, maxScore, queryLen / 2)
+                        : kernels.swWord(workspace, &targetSeq[0], 0, targetLen, queryLen, Matcher::GAP_OPEN,
+                                         Matcher::GAP_EXTEND, wordProfile, -1, queryLen / 2);
+            }
+            m.checksum += bests[0].score + bests[0].ref;
+            m.cells += static_cast<double>(queryLen) * targetLen;
+            m.ops++;
+            free(bests);
+        }
+        seconds += now() - start;
+    }
+    m.seconds = seconds;
+
+    free(wordProfile);
+    free(byteProfile);
+    delete[] workspace.maxColumn;
+    free(workspace.vHmax);
+    free(workspace.vE);
+    free(workspace.vHLoad);
+    free(workspace.vHStore);
+}
+
+void swProfileRestart(Context &ctx, Measurement &m) {
+    profileSmithWaterman(ctx, m, false);
+}
+
+void swProfileResume(Context &ctx, Measurement &m) {
+    profileSmithWaterman(ctx, m, true);
+}
+
+// every query against every target on a diagonal between -8 and 7
+void ungapped(Context &ctx, Measurement &m) {
+    UngappedAlignment aligner(ctx.maxSeqLen, &ctx.prefMat, ctx.sequenceLookup);
+    Sequence query(ctx.maxSeqLen, Sequence::AMINO_ACIDS, &ctx.prefMat, 0, false, false);
+    std::vector<float> bias(ctx.maxSeqLen, 0.0f);
+    std::vector<CounterResult> hits(ctx.data.targets.size());
+    const size_t queryCount = std::min(ctx.data.queries.size(), (size_t) 100);
+    double seconds = 0.0;
+    for (size_t i = 0; i < queryCount; i++) {
+        query.mapSequence(i, i, ctx.data.queries[i].c_str());
+        for (size_t t = 0; t < hits.size(); t++) {
+            const int diagonal = static_cast<int>((i * 7 + t * 13) % 16) - 8;
+            hits[t].id = static_cast<unsigned int>(t);
+            hits[t].diagonal = static_cast<unsigned short>(diagonal);
+            hits[t].count = 0;
+            const int targetLen = static_cast<int>(ctx.data.targets[t].size());
+            const int cells = (diagonal >= 0) ? std::min(targetLen, query.L - diagonal) : std::min(targetLen + diagonal, query.L);
+            m.cells += std::max(cells, 0);
+        }
+        const double start = now();
+        aligner.processQuery(&query, &bias[0], &hits[0], hits.size());
+        seconds += now() - start;
+        for (size_t t = 0; t < hits.size(); t++) {
+            m.checksum += hits[t].count;
+        }
+        m.ops += hits.size();
+    }
+    m.seconds = seconds;
+}
+
+void queryMatcher(Context &ctx, Measurement &m) {
+    Sequence query(ctx.maxSeqLen, Sequence::AMINO_ACIDS, &ctx.prefMat, 6, true, false);
+    QueryMatcher matcher(ctx.indexTable, ctx.sequenceLookup, &ctx.prefMat, *ctx.prefEvaluer, ctx.dbr->getSeqLens(),
+                         ctx.kmerThr, 0.0, 6, ctx.dbr->getSize(), ctx.maxSeqLen, query.getEffectiveKmerSize(),
+                         300, false, true, 15, false);
+    matcher.setSubstitutionMatrix(ctx.threeMer, ctx.twoMer);
+    const size_t queryCount = std::min(ctx.data.queries.size(), (size_t) 100);
+    const double start = now();
+    for (size_t i = 0; i < queryCount; i++) {
+        query.mapSequence(i, i, ctx.data.queries[i].c_str());
+        std::pair<hit_t *, size_t> hits = matcher.matchQuery(&query, UINT_MAX);
+        for (size_t h = 0; h < hits.second; h++) {
+            m.checksum += hits.first[h].seqId + hits.first[h].prefScore;
+        }
+        m.ops++;
+    }
+    m.seconds = now() - start;
+}
+
+void kmerGenerator(Context &ctx, Measurement &m) {
+    Sequence query(ctx.maxSeqLen, Sequence::AMINO_ACIDS, &ctx.prefMat, 6, true, false);
+    KmerGenerator generator(6, ctx.prefMat.alphabetSize - 1, ctx.kmerThr);
+    generator.setDivideStrategy(ctx.threeMer, ctx.twoMer);
+    const double start = now();
+    for (size_t i = 0; i < ctx.data.queries.size(); i++) {
+        query.mapSequence(i, i, ctx.data.queries[i].c_str());
+        while (query.hasNextKmer()) {
+            const ScoreMatrix kmers = generator.generateKmerList(query.nextKmer());
+            m.checksum += kmers.elementSize;
+            m.ops++;
+        }
+    }
+    m.seconds = now() - start;
+}
+
+// hit lists as the prefilter counts them: most ids once, some twice on the same or on different diagonals
+std::vector<CounterResult> counterResults(size_t dbSize, size_t count) {
+    Random random(7);
+    std::vector<CounterResult> hits(count);
+    bool repeat = false;
+    for (size_t i = 0; i < count; i++) {
+        repeat = (i > 0 && repeat == false && random.uniform(4) == 0);
+        hits[i].id = repeat ? hits[i - 1].id : static_cast<unsigned int>(random.uniform(dbSize));
+        hits[i].diagonal = (repeat && random.uniform(2) == 0) ? hits[i - 1].diagonal : static_cast<unsigned short>(random.uniform(512));
+        hits[i].count = static_cast<unsigned char>(1 + random.uniform(3));
+    }
+    return hits;
+}
+
+void cacheFriendlyMerge(Context &ctx, Measurement &m, bool byDiagonal) {
+    const size_t dbSize = std::max(ctx.data.targets.size(), (size_t) 100000);
+    const size_t hitCount = 50000;
+    const std::vector<CounterResult> input = counterResults(dbSize, hitCount);
+    std::vector<CounterResult> hits(hitCount);
+    CacheFriendlyOperations<256> merger(dbSize, hitCount / 256);
+    double seconds = 0.0;
+    for (size_t round = 0; round < 20; round++) {
+        std::copy(input.begin(), input.end(), hits.begin());
+        const double start = now();
+        const size_t merged = byDiagonal ? merger.mergeElementsByDiagonal(&hits[0], hitCount)
+                                         : merger.mergeElementsByScore(&hits[0], hitCount);
+        seconds += now() - start;
+        m.checksum += merged;
+        for (size_t i = 0; i < merged; i++) {
+            m.checksum += hits[i].id + hits[i].count;
+        }
+        m.ops += hitCount;
+    }
+    m.seconds = seconds;
+}
+
+void mergeByScore(Context &ctx, Measurement &m) {
+    cacheFriendlyMerge(ctx, m, false);
+}
+
+void mergeByDiagonal(Context &ctx, Measurement &m) {
+    cacheFriendlyMerge(ctx, m, true);
+}
+
+void dbReaderOpen(Context &ctx, Measurement &m) {
+    const double start = now();
+    for (size_t i = 0; i < 20; i++) {
+        DBReader<unsigned int> reader(ctx.dbData.c_str(), ctx.dbIndex.c_str());
+        reader.open(DBReader<unsigned int>::NOSORT);
+        m.checksum += reader.getSize() + reader.getAminoAcidDBSize();
+        reader.close();
+        m.ops++;
+    }
+    m.seconds = now() - start;
+}
+
+// random access as the alignment reads its targets
+void dbReaderGetData(Context &ctx, Measurement &m) {
+    Random random(11);
+    const size_t size = ctx.dbr->getSize();
+    std::vector<size_t> order(size);
+    for (size_t i = 0; i < size; i++) {
+        order[i] = i;
+    }
+    for (size_t i = size; i > 1; i--) {
+        std::swap(order[i - 1], order[random.uniform(i)]);
+    }
+    const double start = now();
+    for (size_t round = 0; round < 50; round++) {
+        for (size_t i = 0; i < size; i++) {
+            const char *data = ctx.dbr->getData(order[i]);
+            m.checksum += static_cast<unsigned char>(data[0]) + ctx.dbr->getSeqLens(order[i]);
+        }
+        m.ops += size;
+    }
+    m.seconds = now() - start;
+}
+
+typedef void (*BenchFunction)(Context &ctx, Measurement &m);
+
+struct Benchmark {
+    const char *name;
+    BenchFunction function;
+    // reports GCUPS
+    bool alignment;
+};
+
+const Benchmark BENCHMARKS[] = {
+        {"sw_byte", swByte, true},
+        {"sw_word", swWord, true},
+        {"sw_profile_restart", swProfileRestart, true},
+        {"sw_profile_resume", swProfileResume, true},
+        {"ungapped", ungapped, true},
+        {"query_matcher", queryMatcher, false},
+        {"kmer_generator", kmerGenerator, false},
+        {"merge_by_score", mergeByScore, false},
+        {"merge_by_diagonal", mergeByDiagonal, false},
+        {"dbreader_open", dbReaderOpen, false},
+        {"dbreader_getdata", dbReaderGetData, false}
+};
+
+void writeJson(std::ostream &out, const std::string &dataSet, const std::vector<BenchResult> &results) {
+    out << "{\n"
+        << "  \"dataset\": \"" << dataSet << "\",\n"
+        << "  \"simd\": \"" << SimdKernels::get().name << "\",\n"
+        << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        out << "    {\"name\": \"" << results[i].name << "\", \"ops\": " << results[i].ops
+            << ", \"ns_per_op\": " << std::fixed << std::setprecision(3) << results[i].nsPerOp
+            << ", \"gcups\": " << std::setprecision(4) << results[i].gcups
+            << ", \"checksum\": " << results[i].checksum << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n}\n";
+}
+
+// value of "key" in a line written by writeJson, without quotes
+std::string jsonValue(const std::string &line, const std::string &key) {
+    const std::string pattern = "\"" + key + "\": ";
+    size_t pos = line.find(pattern);
+    if (pos == std::string::npos) {
+        return "";
+    }
+    pos += pattern.size();
+    const size_t end = line.find_first_of(",}", pos);
+    std::string value = line.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    if (value.size() >= 2 && value[0] == '"') {
+        value = value.substr(1, value.find('"', 1) - 1);
+    }
+    return value;
+}
+
+// reads the JSON written by writeJson, returns the data set and simd name
+std::pair<std::string, std::string> readBaseline(const std::string &file, std::map<std::string, BenchResult> &baseline) {
+    std::ifstream in(file.c_str());
+    if (in.fail()) {
+        Debug(Debug::ERROR) << "Could not open baseline " << file << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    std::pair<std::string, std::string> info;
+    std::string line;
+    while (std::getline(in, line)) {
+        const std::string name = jsonValue(line, "name");
+        if (name.empty() == false) {
+            BenchResult result;
+            result.name = name;
+            result.ops = strtoull(jsonValue(line, "ops").c_str(), NULL, 10);
+            result.nsPerOp = strtod(jsonValue(line, "ns_per_op").c_str(), NULL);
+            result.gcups = strtod(jsonValue(line, "gcups").c_str(), NULL);
+            result.checksum = strtoull(jsonValue(line, "checksum").c_str(), NULL, 10);
+            baseline[name] = result;
+        } else if (jsonValue(line, "dataset").empty() == false) {
+            info.first = jsonValue(line, "dataset");
+        } else if (jsonValue(line, "simd").empty() == false) {
+            info.second = jsonValue(line, "simd");
+        }
+    }
+    return info;
+}
+
+void usage() {
+    Debug(Debug::INFO) << "Usage: mmseqs-bench [--fasta FILE] [--scale FLOAT] [--repeat INT] [--filter NAME] [--json FILE]\n"
+                          "                    [--baseline FILE] [--tolerance FLOAT] [--tmp PREFIX]\n";
+}
+
+int main(int argc, const char **argv) {
+    std::string fastaFile;
+    std::string filter;
+    std::string jsonFile;
+    std::string baselineFile;
+    std::string tmpPrefix = "/tmp/mmseqs-bench";
+    double scale = 1.0;
+    double tolerance = 0.2;
+    int repeat = 3;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            usage();
+            return EXIT_SUCCESS;
+        }
+        if (i + 1 >= argc) {
+            usage();
+            Debug(Debug::ERROR) << "Missing value of " << arg << "\n";
+            return EXIT_FAILURE;
+        }
+        const std::string value = argv[++i];
+        if (arg == "--fasta") {
+            fastaFile = value;
+        } else if (arg == "--scale") {
+            scale = strtod(value.c_str(), NULL);
+        } else if (arg == "--repeat") {
+            repeat = std::max(atoi(value.c_str()), 1);
+        } else if (arg == "--filter") {
+            filter = value;
+        } else if (arg == "--json") {
+            jsonFile = value;
+        } else if (arg == "--baseline") {
+            baselineFile = value;
+        } else if (arg == "--tolerance") {
+            tolerance = strtod(value.c_str(), NULL);
+        } else if (arg == "--tmp") {
+            tmpPrefix = value;
+        } else {
+            usage();
+            Debug(Debug::ERROR) << "Unknown option " << arg << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    // the JSON can go to stdout, the table and the library messages stay out of it
+    std::ostream &log = (jsonFile == "-") ? std::cerr : std::cout;
+    Debug::setDebugLevel(Debug::ERROR);
+    const DataSet data = fastaFile.empty() ? syntheticDataSet(scale) : fastaDataSet(fastaFile);
+    Context ctx(data, tmpPrefix + "_" + SSTR(getpid()));
+
+    std::map<std::string, BenchResult> baseline;
+    std::pair<std::string, std::string> baselineInfo;
+    if (baselineFile.empty() == false) {
+        baselineInfo = readBaseline(baselineFile, baseline);
+        if (baselineInfo.second != SimdKernels::get().name) {
+            log << "Baseline was measured with " << baselineInfo.second << " instead of "
+                << SimdKernels::get().name << " kernels\n";
+        }
+    }
+    const bool sameData = (baselineInfo.first == data.name);
+
+    log << "Data set " << data.name << ": " << data.queries.size() << " queries, "
+        << data.targets.size() << " targets, " << data.decoys.size() << " decoys, "
+        << SimdKernels::get().name << " kernels\n";
+    log << std::left << std::setw(20) << "benchmark" << std::right << std::setw(14) << "ns/op"
+        << std::setw(10) << "GCUPS" << std::setw(12) << "baseline" << "\n";
+
+    std::vector<BenchResult> results;
+    size_t regressions = 0;
+    for (size_t b = 0; b < sizeof(BENCHMARKS) / sizeof(BENCHMARKS[0]); b++) {
+        const Benchmark &benchmark = BENCHMARKS[b];
+        if (filter.empty() == false && std::string(benchmark.name).find(filter) == std::string::npos) {
+            continue;
+        }
+        BenchResult result;
+        result.name = benchmark.name;
+        result.nsPerOp = 0.0;
+        result.gcups = 0.0;
+        for (int run = 0; run < repeat; run++) {
+            Measurement m;
+            benchmark.function(ctx, m);
+            const double nsPerOp = 1e9 * m.seconds / std::max(m.ops, (size_t) 1);
+            if (run > 0 && m.checksum != result.checksum) {
+                Debug(Debug::ERROR) << benchmark.name << " gives a different checksum in run " << run << "\n";
+                return EXIT_FAILURE;
+            }
+            if (run == 0 || nsPerOp < result.nsPerOp) {
+                result.nsPerOp = nsPerOp;
+                result.gcups = (benchmark.alignment && m.seconds > 0.0) ? m.cells / m.seconds / 1e9 : 0.0;
+            }
+            result.ops = m.ops;
+            result.checksum = m.checksum;
+        }
+        results.push_back(result);
+
+        std::ostringstream line;
+        line << std::left << std::setw(20) << result.name << std::right << std::fixed << std::setprecision(1)
+             << std::setw(14) << result.nsPerOp << std::setprecision(3) << std::setw(10) << result.gcups;
+        std::map<std::string, BenchResult>::const_iterator base = baseline.find(result.name);
+        if (base != baseline.end()) {
+            const double ratio = result.nsPerOp / std::max(base->second.nsPerOp, 1e-9);
+            line << std::setprecision(2) << std::setw(11) << ratio << "x";
+            if (ratio > 1.0 + tolerance) {
+                line << "  SLOWER";
+                regressions++;
+            }
+            if (sameData && result.checksum != base->second.checksum) {
+                line << "  CHECKSUM " << base->second.checksum;
+                regressions++;
+            }
+        }
+        log << line.str() << std::endl;
+    }
+
+    if (jsonFile == "-") {
+        writeJson(std::cout, data.name, results);
+    } else if (jsonFile.empty() == false) {
+        std::ofstream out(jsonFile.c_str());
+        if (out.fail()) {
+            Debug(Debug::ERROR) << "Could not write " << jsonFile << "\n";
+            return EXIT_FAILURE;
+        }
+        writeJson(out, data.name, results);
+    }
+
+    if (regressions > 0) {
+        Debug(Debug::ERROR) << regressions << " regressions against the baseline " << baselineFile << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
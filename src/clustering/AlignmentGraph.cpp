@@ -0,0 +1,355 @@
+#include "AlignmentGraph.h"
+#include "AlignmentSymmetry.h"
+#include "FileUtil.h"
+#include "Matcher.h"
+#include "Parameters.h"
+#include "Timer.h"
+#include "Util.h"
+#include "Debug.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+AlignmentGraph::AlignmentGraph(DBReader<unsigned int> *seqDbr, DBReader<unsigned int> *alnDbr, int threads,
+                               bool withScores, int scoretype, const std::string &graphDir)
+        : seqDbr(seqDbr), alnDbr(alnDbr), dbSize(seqDbr->getSize()), threads(threads), scoretype(scoretype),
+          graphDir(graphDir), scoreBytes(withScores ? sizeof(unsigned short) : 0), maxDegree(0) {
+    Timer timer;
+    if (graphDir != "") {
+        if (FileUtil::directoryExists(graphDir.c_str()) == false) {
+            Debug(Debug::ERROR) << "Graph directory " << graphDir << " does not exist.\n";
+            EXIT(EXIT_FAILURE);
+        }
+        Debug(Debug::INFO) << "Keep the alignment graph in " << graphDir << ".\n";
+    }
+    allocate(offsets, "offsets", (dbSize + 1) * sizeof(size_t));
+    countResults();
+    const size_t elementCount = getElementCount();
+    allocate(elements, "elements", elementCount * sizeof(unsigned int));
+    if (scoreBytes != 0) {
+        allocate(scores, "scores", elementCount * sizeof(unsigned short));
+        usedScores.assign((USHRT_MAX + 1) / 64, 0);
+    }
+    readResults();
+    Debug(Debug::INFO) << "\nFind missing connections.\n";
+    addMissingLinks();
+    if (scoreBytes != 0) {
+        compressScores();
+    }
+    const size_t *offset = getOffsets();
+    for (size_t i = 0; i < dbSize; i++) {
+        maxDegree = std::max(maxDegree, static_cast<unsigned int>(offset[i + 1] - offset[i]));
+    }
+    Debug(Debug::INFO) << "\nTime for read in: " << timer.lap() << "\n";
+}
+
+AlignmentGraph::~AlignmentGraph() {
+    release(offsets);
+    release(elements);
+    release(scores);
+}
+
+void AlignmentGraph::allocate(Storage &storage, const std::string &name, size_t size) {
+    // neither malloc nor mmap hand out empty arrays reliably
+    const size_t allocSize = std::max(size, static_cast<size_t>(1));
+    storage.size = size;
+    if (graphDir == "") {
+        storage.data = malloc(allocSize);
+        Util::checkAllocation(storage.data, "Could not allocate " + name + " memory in AlignmentGraph");
+        return;
+    }
+    const std::string file = graphDir + "/clustgraph_" + SSTR(getpid()) + "_" + name;
+    storage.fd = open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+    if (storage.fd < 0) {
+        Debug(Debug::ERROR) << "Could not create graph file " << file << ".\n";
+        EXIT(EXIT_FAILURE);
+    }
+    // the file stays accessible through the descriptor and disappears with it, even if clust is killed
+    unlink(file.c_str());
+    if (ftruncate(storage.fd, allocSize) != 0) {
+        Debug(Debug::ERROR) << "Could not resize graph file " << file << " to " << allocSize << " bytes.\n";
+        EXIT(EXIT_FAILURE);
+    }
+    storage.data = mmap(NULL, allocSize, PROT_READ | PROT_WRITE, MAP_SHARED, storage.fd, 0);
+    if (storage.data == MAP_FAILED) {
+        Debug(Debug::ERROR) << "Could not map graph file " << file << ".\n";
+        EXIT(EXIT_FAILURE);
+    }
+}
+
+void AlignmentGraph::resize(Storage &storage, size_t size) {
+    const size_t allocSize = std::max(size, static_cast<size_t>(1));
+    if (storage.fd < 0) {
+        storage.data = realloc(storage.data, allocSize);
+        Util::checkAllocation(storage.data, "Could not resize memory in AlignmentGraph");
+        storage.size = size;
+        return;
+    }
+    munmap(storage.data, std::max(storage.size, static_cast<size_t>(1)));
+    if (ftruncate(storage.fd, allocSize) != 0) {
+        Debug(Debug::ERROR) << "Could not resize graph file to " << allocSize << " bytes.\n";
+        EXIT(EXIT_FAILURE);
+    }
+    storage.data = mmap(NULL, allocSize, PROT_READ | PROT_WRITE, MAP_SHARED, storage.fd, 0);
+    if (storage.data == MAP_FAILED) {
+        Debug(Debug::ERROR) << "Could not map graph file.\n";
+        EXIT(EXIT_FAILURE);
+    }
+    storage.size = size;
+}
+
+void AlignmentGraph::release(Storage &storage) {
+    if (storage.data == NULL) {
+        return;
+    }
+    if (storage.fd < 0) {
+        free(storage.data);
+    } else {
+        munmap(storage.data, std::max(storage.size, static_cast<size_t>(1)));
+        close(storage.fd);
+        storage.fd = -1;
+    }
+    storage.data = NULL;
+    storage.size = 0;
+}
+
+void AlignmentGraph::countResults() {
+    size_t *offset = static_cast<size_t *>(offsets.data);
+    const bool binaryInput = (alnDbr->getDbtype() == Sequence::ALIGNMENT_RES_BINARY);
+#pragma omp parallel for schedule(dynamic, 1000)
+    for (size_t i = 0; i < dbSize; i++) {
+        const unsigned int clusterId = seqDbr->getDbKey(i);
+        const size_t alnId = alnDbr->getId(clusterId);
+        const char *data = alnDbr->getData(alnId);
+        const size_t dataSize = alnDbr->getSeqLens(alnId);
+        if (binaryInput) {
+            offset[i] = Matcher::countBinaryAlignmentResults(data, dataSize - 1);
+        } else {
+            offset[i] = Util::countLines(data, dataSize);
+        }
+    }
+    offset[dbSize] = 0;
+    AlignmentSymmetry::computeOffsetFromCounts(offset, dbSize);
+    alnDbr->remapData(); // need to free memory
+}
+
+void AlignmentGraph::readResults() {
+    const size_t *offset = getOffsets();
+    unsigned int *element = static_cast<unsigned int *>(elements.data);
+    unsigned short *score = static_cast<unsigned short *>(scores.data);
+    const bool binaryInput = (alnDbr->getDbtype() == Sequence::ALIGNMENT_RES_BINARY);
+    std::vector<std::vector<uint64_t> > threadUsedScores(threads, std::vector<uint64_t>(usedScores.size(), 0));
+    // read the database in blocks so that the pages of the finished ones can be dropped
+    const size_t flushSize = 1000000;
+    for (size_t start = 0; start < dbSize; start += flushSize) {
+        const size_t end = std::min(dbSize, start + flushSize);
+#pragma omp parallel
+        {
+            int thread_idx = 0;
+#ifdef OPENMP
+            thread_idx = omp_get_thread_num();
+#endif
+            std::vector<uint64_t> &used = threadUsedScores[thread_idx];
+#pragma omp for schedule(dynamic, 100)
+            for (size_t i = start; i < end; i++) {
+                Debug::printProgress(i);
+                // seqDbr is descending sorted by length
+                // the assumption is that clustering is B -> B (not A -> B)
+                const unsigned int clusterId = seqDbr->getDbKey(i);
+                const size_t alnId = alnDbr->getId(clusterId);
+                char *data = alnDbr->getData(alnId);
+                const char *dataEnd = data + alnDbr->getSeqLens(alnId) - 1;
+
+                if (binaryInput ? data >= dataEnd : *data == '\0') { // check if file contains entry
+                    Debug(Debug::ERROR) << "ERROR: Sequence " << i
+                                        << " does not contain any sequence for key " << clusterId
+                                        << "!\n";
+                    continue;
+                }
+                size_t writePos = offset[i];
+                while (binaryInput ? data < dataEnd : *data != '\0') {
+                    if (writePos >= offset[i + 1]) {
+                        Debug(Debug::ERROR) << "ERROR: Set " << i
+                                            << " has more elements than allocated (" << offset[i + 1] - offset[i]
+                                            << ")!\n";
+                        EXIT(EXIT_FAILURE);
+                    }
+                    unsigned int key;
+                    if (binaryInput) {
+                        Matcher::binary_result_t record;
+                        memcpy(&record, data, sizeof(Matcher::binary_result_t));
+                        key = record.dbKey;
+                        if (score != NULL) {
+                            if (scoretype == Parameters::APC_ALIGNMENTSCORE) {
+                                score[writePos] = (unsigned short) record.score;
+                            } else {
+                                score[writePos] = (unsigned short) (record.seqId * 1000.0f);
+                            }
+                        }
+                        data += sizeof(Matcher::binary_result_t) + record.backtraceLen;
+                    } else {
+                        char similarity[255 + 1];
+                        char dbKey[255 + 1];
+                        Util::parseKey(data, dbKey);
+                        key = (unsigned int) strtoul(dbKey, NULL, 10);
+                        if (score != NULL) {
+                            if (scoretype == Parameters::APC_ALIGNMENTSCORE) {
+                                //column 1 = alignment score
+                                Util::parseByColumnNumber(data, similarity, 1);
+                                score[writePos] = (unsigned short) (atof(similarity));
+                            } else {
+                                //column 2 = sequence identity
+                                Util::parseByColumnNumber(data, similarity, 2);
+                                score[writePos] = (unsigned short) (atof(similarity) * 1000.0f);
+                            }
+                        }
+                        data = Util::skipLine(data);
+                    }
+                    const size_t currElement = seqDbr->getId(key);
+                    if (currElement == UINT_MAX || currElement > seqDbr->getSize()) {
+                        Debug(Debug::ERROR) << "ERROR: Element " << key
+                                            << " contained in some alignment list, but not contained in the sequence database!\n";
+                        EXIT(EXIT_FAILURE);
+                    }
+                    if (score != NULL) {
+                        used[score[writePos] / 64] |= static_cast<uint64_t>(1) << (score[writePos] % 64);
+                    }
+                    element[writePos] = currElement;
+                    writePos++;
+                }
+            }
+        }
+        alnDbr->remapData(); // need to free memory
+    }
+    for (size_t thread = 0; thread < threadUsedScores.size(); thread++) {
+        for (size_t i = 0; i < usedScores.size(); i++) {
+            usedScores[i] |= threadUsedScores[thread][i];
+        }
+    }
+}
+
+void AlignmentGraph::addMissingLinks() {
+    const size_t *offset = getOffsets();
+    const size_t elementCount = getElementCount();
+
+    // sorted copy of the results to look up whether a link exists in both directions
+    Storage sorted;
+    allocate(sorted, "sorted", elementCount * sizeof(unsigned int));
+    unsigned int *sortedElement = static_cast<unsigned int *>(sorted.data);
+    memcpy(sortedElement, elements.data, elementCount * sizeof(unsigned int));
+#pragma omp parallel for schedule(dynamic, 1000)
+    for (size_t i = 0; i < dbSize; i++) {
+        std::sort(sortedElement + offset[i], sortedElement + offset[i + 1]);
+    }
+
+    // count the links that are missing in each set and mark the results they come from
+    unsigned int *missing = new(std::nothrow) unsigned int[dbSize];
+    Util::checkAllocation(missing, "Could not allocate missing memory in AlignmentGraph::addMissingLinks");
+    std::fill_n(missing, dbSize, 0);
+    Storage links;
+    allocate(links, "links", ((elementCount + 63) / 64) * sizeof(uint64_t));
+    uint64_t *missingLink = static_cast<uint64_t *>(links.data);
+    memset(missingLink, 0, links.size);
+    const unsigned int *element = getElements();
+#pragma omp parallel for schedule(dynamic, 1000)
+    for (size_t setId = 0; setId < dbSize; setId++) {
+        for (size_t pos = offset[setId]; pos < offset[setId + 1]; pos++) {
+            const unsigned int currElm = element[pos];
+            // this is a new connection since setId is not contained in the set of currElm
+            if (std::binary_search(sortedElement + offset[currElm], sortedElement + offset[currElm + 1],
+                                   static_cast<unsigned int>(setId)) == false) {
+                __atomic_fetch_add(&missing[currElm], 1, __ATOMIC_RELAXED);
+                __atomic_fetch_or(&missingLink[pos / 64], static_cast<uint64_t>(1) << (pos % 64), __ATOMIC_RELAXED);
+            }
+        }
+    }
+    release(sorted);
+
+    Storage symmetricOffsets;
+    allocate(symmetricOffsets, "symmetric_offsets", (dbSize + 1) * sizeof(size_t));
+    size_t *newOffset = static_cast<size_t *>(symmetricOffsets.data);
+    newOffset[0] = 0;
+    for (size_t i = 0; i < dbSize; i++) {
+        newOffset[i + 1] = newOffset[i] + (offset[i + 1] - offset[i]) + missing[i];
+    }
+    const size_t symmetricElementCount = newOffset[dbSize];
+    Debug(Debug::INFO) << "\nFound " << symmetricElementCount - elementCount << " new connections.\n";
+
+    // move every set to its new start, beginning with the last one so that no set is overwritten before it moved
+    resize(elements, symmetricElementCount * sizeof(unsigned int));
+    unsigned int *newElement = static_cast<unsigned int *>(elements.data);
+    unsigned short *score = NULL;
+    if (scoreBytes != 0) {
+        resize(scores, symmetricElementCount * sizeof(unsigned short));
+        score = static_cast<unsigned short *>(scores.data);
+    }
+    for (size_t i = dbSize; i > 0; i--) {
+        const size_t setId = i - 1;
+        const size_t length = offset[setId + 1] - offset[setId];
+        memmove(newElement + newOffset[setId], newElement + offset[setId], length * sizeof(unsigned int));
+        if (score != NULL) {
+            memmove(score + newOffset[setId], score + offset[setId], length * sizeof(unsigned short));
+        }
+    }
+
+    // append the missing links behind the results of each set in the order of the sets they come from
+    for (size_t setId = 0; setId < dbSize; setId++) {
+        Debug::printProgress(setId);
+        const size_t length = offset[setId + 1] - offset[setId];
+        for (size_t elementId = 0; elementId < length; elementId++) {
+            const size_t pos = offset[setId] + elementId;
+            if ((missingLink[pos / 64] & (static_cast<uint64_t>(1) << (pos % 64))) == 0) {
+                continue;
+            }
+            const unsigned int currElm = newElement[newOffset[setId] + elementId];
+            const size_t writePos = newOffset[currElm + 1] - missing[currElm];
+            missing[currElm]--;
+            newElement[writePos] = static_cast<unsigned int>(setId);
+            if (score != NULL) {
+                score[writePos] = score[newOffset[setId] + elementId];
+            }
+        }
+    }
+    release(links);
+    delete[] missing;
+    release(offsets);
+    offsets = symmetricOffsets;
+}
+
+void AlignmentGraph::compressScores() {
+    size_t distinct = 0;
+    for (size_t i = 0; i < usedScores.size(); i++) {
+        distinct += __builtin_popcountll(usedScores[i]);
+    }
+    if (distinct > UCHAR_MAX + 1) {
+        return;
+    }
+    // ranks in the order of the scores as short, the type they are compared in
+    std::vector<unsigned char> rank(USHRT_MAX + 1, 0);
+    unsigned char nextRank = 0;
+    for (int value = SHRT_MIN; value <= SHRT_MAX; value++) {
+        const unsigned short score = static_cast<unsigned short>(value);
+        if (usedScores[score / 64] & (static_cast<uint64_t>(1) << (score % 64))) {
+            rank[score] = nextRank++;
+        }
+    }
+    // in place, byte i is written after the score at bytes 2i and 2i+1 was read
+    const size_t elementCount = getElementCount();
+    const unsigned short *score = static_cast<const unsigned short *>(scores.data);
+    unsigned char *scoreRank = static_cast<unsigned char *>(scores.data);
+    for (size_t i = 0; i < elementCount; i++) {
+        scoreRank[i] = rank[score[i]];
+    }
+    resize(scores, elementCount * sizeof(unsigned char));
+    scoreBytes = sizeof(unsigned char);
+}
@@ -0,0 +1,95 @@
+#ifndef MMSEQS_ALIGNMENTGRAPH_H
+#define MMSEQS_ALIGNMENTGRAPH_H
+
+// Symmetric alignment graph of the clustering in compressed sparse row form.
+// The neighbors of sequence i are elements[offsets[i]] to elements[offsets[i + 1] - 1]: first the results of i
+// in the order of the alignment database, then the sequences that contain i in their results but are not
+// contained in the results of i, ordered by id. Ids are positions in the length sorted sequence database.
+//
+// The alignment database is streamed twice, once to count the results of each entry and once to parse them.
+// Scores are only read if they are requested. They are stored as their rank in 8 bits if there are at most 256
+// different values and in 16 bits otherwise, both keep the order of the scores as short.
+// If a directory is given, the arrays are kept in files there that are mapped into memory, so that graphs
+// that do not fit into the main memory are paged in and out by the kernel.
+
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <stdint.h>
+
+#include "DBReader.h"
+
+class AlignmentGraph {
+public:
+    AlignmentGraph(DBReader<unsigned int> *seqDbr, DBReader<unsigned int> *alnDbr, int threads,
+                   bool withScores, int scoretype, const std::string &graphDir);
+
+    ~AlignmentGraph();
+
+    size_t getSize() const {
+        return dbSize;
+    }
+
+    size_t getElementCount() const {
+        return getOffsets()[dbSize];
+    }
+
+    const size_t *getOffsets() const {
+        return static_cast<const size_t *>(offsets.data);
+    }
+
+    const unsigned int *getElements() const {
+        return static_cast<const unsigned int *>(elements.data);
+    }
+
+    // NULL unless scores were requested and stored in this width
+    const unsigned char *getScores8() const {
+        return scoreBytes == 1 ? static_cast<const unsigned char *>(scores.data) : NULL;
+    }
+
+    const unsigned short *getScores16() const {
+        return scoreBytes == 2 ? static_cast<const unsigned short *>(scores.data) : NULL;
+    }
+
+    unsigned int getMaxDegree() const {
+        return maxDegree;
+    }
+
+private:
+    // an array in memory or in a mapped file
+    struct Storage {
+        void *data;
+        size_t size;
+        int fd;
+
+        Storage() : data(NULL), size(0), fd(-1) {}
+    };
+
+    DBReader<unsigned int> *seqDbr;
+    DBReader<unsigned int> *alnDbr;
+    const size_t dbSize;
+    const int threads;
+    const int scoretype;
+    const std::string graphDir;
+
+    Storage offsets;
+    Storage elements;
+    Storage scores;
+    // 0 without scores
+    size_t scoreBytes;
+    unsigned int maxDegree;
+
+    // scores that occur in the alignments, one bit per unsigned short value
+    std::vector<uint64_t> usedScores;
+
+    void allocate(Storage &storage, const std::string &name, size_t size);
+    void resize(Storage &storage, size_t size);
+    void release(Storage &storage);
+
+    void countResults();
+    void readResults();
+    void addMissingLinks();
+    void compressScores();
+};
+
+#endif //MMSEQS_ALIGNMENTGRAPH_H
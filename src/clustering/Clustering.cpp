@@ -9,9 +9,11 @@
 Clustering::Clustering(const std::string &seqDB, const std::string &seqDBIndex,
                        const std::string &alnDB, const std::string &alnDBIndex,
                        const std::string &outDB, const std::string &outDBIndex,
-                       unsigned int maxIteration, int similarityScoreType, int threads) : maxIteration(maxIteration),
+                       unsigned int maxIteration, int similarityScoreType, int threads,
+                       const std::string &graphDir) : maxIteration(maxIteration),
                                                                similarityScoreType(similarityScoreType),
                                                                threads(threads),
+                                                               graphDir(graphDir),
                                                                outDB(outDB),
                                                                outDBIndex(outDBIndex) {
     Debug(Debug::INFO) << "Init...\n";
@@ -41,7 +43,7 @@ void Clustering::run(int mode) {
     std::unordered_map<unsigned int, std::vector<unsigned int>> ret;
     ClusteringAlgorithms *algorithm = new ClusteringAlgorithms(seqDbr, alnDbr,
                                                                threads, similarityScoreType,
-                                                               maxIteration);
+                                                               maxIteration, graphDir);
 
     if (mode == Parameters::GREEDY) {
         Debug(Debug::INFO) << "Clustering mode: Greedy\n";
@@ -1,16 +1,18 @@
 #include "ClusteringAlgorithms.h"
 #include "Util.h"
 #include "Debug.h"
-#include "AlignmentSymmetry.h"
+#include "AlignmentGraph.h"
+#include "ResultCursor.h"
 #include "Timer.h"
 
 #include <queue>
 #include <algorithm>
 #include <climits>
+#include <stdint.h>
 #include <unordered_map>
 
 ClusteringAlgorithms::ClusteringAlgorithms(DBReader<unsigned int>* seqDbr, DBReader<unsigned int>* alnDbr,
-                                           int threads, int scoretype, int maxiterations){
+                                           int threads, int scoretype, int maxiterations, const std::string &graphDir){
     this->seqDbr=seqDbr;
     if(seqDbr->getSize() != alnDbr->getSize()){
         Debug(Debug::ERROR) << "Sequence db size != result db size\n";
@@ -21,6 +23,7 @@ ClusteringAlgorithms::ClusteringAlgorithms(DBReader<unsigned int>* seqDbr, DBRea
     this->threads=threads;
     this->scoretype=scoretype;
     this->maxiterations=maxiterations;
+    this->graphDir=graphDir;
     ///time
     this->clustersizes=new int[dbSize];
     std::fill_n(clustersizes, dbSize, 0);
@@ -31,10 +34,6 @@ ClusteringAlgorithms::~ClusteringAlgorithms(){
 }
 
 std::unordered_map<unsigned int, std::vector<unsigned int>>  ClusteringAlgorithms::execute(int mode) {
-    const char * data = alnDbr->getData();
-    const size_t dataSize = alnDbr->getDataSize();
-    // init data
-
     unsigned int *assignedcluster = new(std::nothrow) unsigned int[dbSize];
     Util::checkAllocation(assignedcluster, "Could not allocate assignedcluster memory in ClusteringAlgorithms::execute");
     std::fill_n(assignedcluster, dbSize, UINT_MAX);
@@ -43,74 +42,41 @@ std::unordered_map<unsigned int, std::vector<unsigned int>>  ClusteringAlgorithm
     if (mode==4) {
         greedyIncrementalLowMem(assignedcluster);
     }else {
-        const size_t elementCount = Util::countLines(data, dataSize);
-        unsigned int * elements = new(std::nothrow) unsigned int[elementCount];
-        Util::checkAllocation(elements, "Could not allocate elements memory in ClusteringAlgorithms::execute");
-        unsigned int ** elementLookupTable = new(std::nothrow) unsigned int*[dbSize];
-        Util::checkAllocation(elementLookupTable, "Could not allocate elementLookupTable memory in ClusteringAlgorithms::execute");
-        unsigned short **scoreLookupTable = new(std::nothrow) unsigned short *[dbSize];
-        Util::checkAllocation(scoreLookupTable, "Could not allocate scoreLookupTable memory in ClusteringAlgorithms::execute");
-        unsigned short *score = NULL;
-        size_t *elementOffsets = new(std::nothrow) size_t[dbSize + 1];
-        Util::checkAllocation(elementOffsets, "Could not allocate elementOffsets memory in ClusteringAlgorithms::execute");
-        elementOffsets[dbSize] = 0;
-        short *bestscore = new(std::nothrow) short[dbSize];
-        Util::checkAllocation(bestscore, "Could not allocate bestscore memory in ClusteringAlgorithms::execute");
-        std::fill_n(bestscore, dbSize, SHRT_MIN);
-
-        readInClusterData(elementLookupTable, elements, scoreLookupTable, score, elementOffsets, elementCount);
-
+        // only set cover compares the scores of the links
+        AlignmentGraph graph(seqDbr, alnDbr, threads, mode == 1, scoretype, graphDir);
+        const unsigned int *elements = graph.getElements();
+        const size_t *elementOffsets = graph.getOffsets();
+        maxClustersize = graph.getMaxDegree();
+        for (size_t i = 0; i < dbSize; i++) {
+            clustersizes[i] = elementOffsets[i + 1] - elementOffsets[i];
+        }
 
         if (mode==2){
-            greedyIncremental(elementLookupTable, elementOffsets,
+            greedyIncremental(elements, elementOffsets,
                               dbSize, assignedcluster);
         }else {
             ClusteringAlgorithms::initClustersizes();
             if (mode == 1) {
-                setCover(elementLookupTable, scoreLookupTable, assignedcluster, bestscore, elementOffsets);
+                short *bestscore = new(std::nothrow) short[dbSize];
+                Util::checkAllocation(bestscore, "Could not allocate bestscore memory in ClusteringAlgorithms::execute");
+                std::fill_n(bestscore, dbSize, SHRT_MIN);
+                Timer timer;
+                if (graph.getScores8() != NULL) {
+                    setCover(elements, graph.getScores8(), assignedcluster, bestscore, elementOffsets);
+                } else {
+                    setCover(elements, graph.getScores16(), assignedcluster, bestscore, elementOffsets);
+                }
+                Debug(Debug::INFO) << "Time for set cover: " << timer.lap() << "\n";
+                delete [] bestscore;
             } else if (mode == 3) {
                 Debug(Debug::INFO) << "connected component mode" << "\n";
-                for (int cl_size = dbSize - 1; cl_size >= 0; cl_size--) {
-                    unsigned int representative = sorted_clustersizes[cl_size];
-                    if (assignedcluster[representative] == UINT_MAX) {
-                        assignedcluster[representative] = representative;
-                        std::queue<int> myqueue;
-                        myqueue.push(representative);
-                        std::queue<int> iterationcutoffs;
-                        iterationcutoffs.push(0);
-                        //delete clusters of members;
-                        while (!myqueue.empty()) {
-                            int currentid = myqueue.front();
-                            int iterationcutoff = iterationcutoffs.front();
-                            assignedcluster[currentid] = representative;
-                            myqueue.pop();
-                            iterationcutoffs.pop();
-                            size_t elementSize = (elementOffsets[currentid + 1] - elementOffsets[currentid]);
-                            for (size_t elementId = 0; elementId < elementSize; elementId++) {
-                                unsigned int elementtodelete = elementLookupTable[currentid][elementId];
-                                if (assignedcluster[elementtodelete] == UINT_MAX && iterationcutoff < maxiterations) {
-                                    myqueue.push(elementtodelete);
-                                    iterationcutoffs.push((iterationcutoff + 1));
-                                }
-                                assignedcluster[elementtodelete] = representative;
-                            }
-                        }
-
-                    }
-                }
+                connectedComponents(elements, elementOffsets, assignedcluster);
             }
             //delete unnecessary datastructures
             delete [] sorted_clustersizes;
             delete [] clusterid_to_arrayposition;
             delete [] borders_of_set;
         }
-
-        delete [] elementLookupTable;
-        delete [] elements;
-        delete [] elementOffsets;
-        delete [] scoreLookupTable;
-        delete [] score;
-        delete [] bestscore;
     }
 
 
@@ -193,8 +159,16 @@ void ClusteringAlgorithms::decreaseClustersize(int clusterid){
     clustersizes[clusterid]--;
 }
 
-void ClusteringAlgorithms::setCover(unsigned int **elementLookupTable, unsigned short ** elementScoreLookupTable,
-                                    unsigned int *assignedcluster, short *bestscore, size_t *newElementOffsets) {
+template <typename T>
+void ClusteringAlgorithms::setCover(const unsigned int *elements, const T *scores,
+                                    unsigned int *assignedcluster, short *bestscore, const size_t *newElementOffsets) {
+    // members of the current cluster whose neighbors are scanned, the start of their neighbors in decreaseIds
+    std::vector<unsigned int> scanMembers;
+    std::vector<size_t> scanOffsets;
+    // the sets each member leaves, decreaseCounts of them from its offset on
+    std::vector<unsigned int> decreaseIds;
+    std::vector<size_t> decreaseCounts;
+    std::vector<char> representativeFound;
     for (int cl_size = dbSize - 1; cl_size >= 0; cl_size--) {
         const unsigned int representative = sorted_clustersizes[cl_size];
         if (representative == UINT_MAX) {
@@ -207,9 +181,9 @@ void ClusteringAlgorithms::setCover(unsigned int **elementLookupTable, unsigned
         //delete clusters of members;
         size_t elementSize = (newElementOffsets[representative + 1] - newElementOffsets[representative]);
         for (size_t elementId = 0; elementId < elementSize; elementId++) {
-            const unsigned int elementtodelete = elementLookupTable[representative][elementId];
+            const unsigned int elementtodelete = elements[newElementOffsets[representative] + elementId];
             // float seqId = elementScoreTable[representative][elementId];
-            const short seqId = elementScoreLookupTable[representative][elementId];
+            const short seqId = scores[newElementOffsets[representative] + elementId];
             //  Debug(Debug::INFO)<<seqId<<"\t"<<bestscore[elementtodelete]<<"\n";
             // becareful of this criteria
             if (seqId > bestscore[elementtodelete]) {
@@ -226,11 +200,16 @@ void ClusteringAlgorithms::setCover(unsigned int **elementLookupTable, unsigned
             removeClustersize(elementtodelete);
         }
 
+        // The members leave the sets that contain them. Which sets shrink does not depend on the order the
+        // members are handled in, only the positions in sorted_clustersizes do. So the neighbors of the members
+        // are scanned in parallel for large clusters and the sizes are decreased in the sequential order,
+        // which picks the same representatives as handling one member after the other.
+        // The selection and the size updates stay sequential and bound the speedup of the set cover.
+        scanMembers.clear();
+        scanOffsets.clear();
+        size_t scanSize = 0;
         for (size_t elementId = 0; elementId < elementSize; elementId++) {
-            bool representativefound = false;
-            const unsigned int elementtodelete = elementLookupTable[representative][elementId];
-            const unsigned int currElementSize = (newElementOffsets[elementtodelete + 1] -
-                                                  newElementOffsets[elementtodelete]);
+            const unsigned int elementtodelete = elements[newElementOffsets[representative] + elementId];
             if (elementtodelete == representative) {
                 clustersizes[elementtodelete] = -1;
                 continue;
@@ -239,21 +218,53 @@ void ClusteringAlgorithms::setCover(unsigned int **elementLookupTable, unsigned
                 continue;
             }
             clustersizes[elementtodelete] = -1;
-            //decrease clustersize of sets that contain the element
+            scanMembers.push_back(elementtodelete);
+            scanOffsets.push_back(scanSize);
+            scanSize += newElementOffsets[elementtodelete + 1] - newElementOffsets[elementtodelete];
+        }
+        scanOffsets.push_back(scanSize);
+        if (decreaseIds.size() < scanSize) {
+            decreaseIds.resize(scanSize);
+        }
+        decreaseCounts.resize(scanMembers.size());
+        representativeFound.resize(scanMembers.size());
+
+        //decrease clustersize of sets that contain the element
+#pragma omp parallel for schedule(dynamic, 16) if (scanSize >= PARALLEL_SCAN_SIZE)
+        for (size_t i = 0; i < scanMembers.size(); i++) {
+            const unsigned int elementtodelete = scanMembers[i];
+            const size_t currElementSize = newElementOffsets[elementtodelete + 1] - newElementOffsets[elementtodelete];
+            unsigned int *decrease = &decreaseIds[scanOffsets[i]];
+            size_t count = 0;
+            bool representativefound = false;
             for (size_t elementId2 = 0; elementId2 < currElementSize; elementId2++) {
-                const unsigned int elementtodecrease = elementLookupTable[elementtodelete][elementId2];
+                const unsigned int elementtodecrease = elements[newElementOffsets[elementtodelete] + elementId2];
                 if (representative == elementtodecrease) {
                     representativefound = true;
                 }
+                // only the members of this cluster change their size during the scan, they stay below 1
+                if (clustersizes[elementtodecrease] > 0) {
+                    decrease[count++] = elementtodecrease;
+                }
+            }
+            decreaseCounts[i] = count;
+            representativeFound[i] = representativefound;
+        }
+
+        for (size_t i = 0; i < scanMembers.size(); i++) {
+            const unsigned int elementtodelete = scanMembers[i];
+            const unsigned int *decrease = &decreaseIds[scanOffsets[i]];
+            for (size_t j = 0; j < decreaseCounts[i]; j++) {
+                const unsigned int elementtodecrease = decrease[j];
                 if (clustersizes[elementtodecrease] == 1) {
                     Debug(Debug::ERROR) << "there must be an error: " << seqDbr->getDbKey(elementtodelete) <<
                                         " deleted from " << seqDbr->getDbKey(elementtodecrease) <<
                                         " that now is empty, but not assigned to a cluster\n";
-                } else if (clustersizes[elementtodecrease] > 0) {
+                } else {
                     decreaseClustersize(elementtodecrease);
                 }
             }
-            if (!representativefound) {
+            if (!representativeFound[i]) {
                 Debug(Debug::ERROR) << "error with cluster:\t" << seqDbr->getDbKey(representative) <<
                                     "\tis not contained in set:\t" << seqDbr->getDbKey(elementtodelete) << ".\n";
             }
@@ -261,6 +272,128 @@ void ClusteringAlgorithms::setCover(unsigned int **elementLookupTable, unsigned
     }
 }
 
+static unsigned int findRoot(unsigned int *parent, unsigned int id) {
+    unsigned int next = __atomic_load_n(&parent[id], __ATOMIC_RELAXED);
+    while (next != id) {
+        // path halving, a lost race only leaves a longer path since parents only move towards the root
+        unsigned int grandparent = __atomic_load_n(&parent[next], __ATOMIC_RELAXED);
+        if (grandparent != next) {
+            __atomic_compare_exchange_n(&parent[id], &next, grandparent, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+        }
+        id = grandparent;
+        next = __atomic_load_n(&parent[id], __ATOMIC_RELAXED);
+    }
+    return id;
+}
+
+static void unite(unsigned int *parent, unsigned int first, unsigned int second) {
+    while (true) {
+        first = findRoot(parent, first);
+        second = findRoot(parent, second);
+        if (first == second) {
+            return;
+        }
+        // the larger root is linked below the smaller one, so parents are never larger than their children
+        unsigned int root = std::max(first, second);
+        if (__atomic_compare_exchange_n(&parent[root], &root, std::min(first, second), false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+            return;
+        }
+    }
+}
+
+void ClusteringAlgorithms::connectedComponents(const unsigned int *elements, const size_t *elementOffsets,
+                                               unsigned int *assignedcluster) {
+    // The breadth first search below starts a cluster at each unassigned sequence in the order of sorted_clustersizes,
+    // the sequence with the most links first and the one with the larger id first among equals, and assigns the
+    // sequences up to maxiterations links away. If a component has at most maxiterations + 1 sequences, this is
+    // the whole component with its first sequence in this order as representative. These components are found in
+    // parallel with a lock-free union-find, only the larger ones are searched.
+    unsigned int *parent = new(std::nothrow) unsigned int[dbSize];
+    Util::checkAllocation(parent, "Could not allocate parent memory in ClusteringAlgorithms::connectedComponents");
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < dbSize; i++) {
+        parent[i] = i;
+    }
+#pragma omp parallel for schedule(dynamic, 1000)
+    for (size_t i = 0; i < dbSize; i++) {
+        for (size_t pos = elementOffsets[i]; pos < elementOffsets[i + 1]; pos++) {
+            // the graph is symmetric, each link is united from its smaller end
+            if (elements[pos] > i) {
+                unite(parent, i, elements[pos]);
+            }
+        }
+    }
+
+    // size and first sequence in the search order of each component, keyed by (number of links, id)
+    unsigned int *componentSize = new(std::nothrow) unsigned int[dbSize];
+    Util::checkAllocation(componentSize, "Could not allocate componentSize memory in ClusteringAlgorithms::connectedComponents");
+    uint64_t *componentFirst = new(std::nothrow) uint64_t[dbSize];
+    Util::checkAllocation(componentFirst, "Could not allocate componentFirst memory in ClusteringAlgorithms::connectedComponents");
+#pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < dbSize; i++) {
+        componentSize[i] = 0;
+        componentFirst[i] = 0;
+    }
+#pragma omp parallel for schedule(dynamic, 1000)
+    for (size_t i = 0; i < dbSize; i++) {
+        const unsigned int root = findRoot(parent, i);
+        parent[i] = root;
+        __atomic_fetch_add(&componentSize[root], 1, __ATOMIC_RELAXED);
+        const uint64_t key = (static_cast<uint64_t>(clustersizes[i]) << 32) | i;
+        uint64_t first = __atomic_load_n(&componentFirst[root], __ATOMIC_RELAXED);
+        while (key > first && !__atomic_compare_exchange_n(&componentFirst[root], &first, key, false,
+                                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+    }
+    size_t searchedSize = 0;
+#pragma omp parallel for schedule(static) reduction(+:searchedSize)
+    for (size_t i = 0; i < dbSize; i++) {
+        const unsigned int root = parent[i];
+        if (static_cast<size_t>(componentSize[root]) <= static_cast<size_t>(maxiterations) + 1) {
+            assignedcluster[i] = static_cast<unsigned int>(componentFirst[root]);
+        } else {
+            searchedSize++;
+        }
+    }
+    delete [] componentFirst;
+    delete [] componentSize;
+    delete [] parent;
+    if (searchedSize == 0) {
+        return;
+    }
+
+    Debug(Debug::INFO) << "Search " << searchedSize << " sequences in components with more than " << maxiterations + 1
+                       << " sequences\n";
+    for (int cl_size = dbSize - 1; cl_size >= 0; cl_size--) {
+        unsigned int representative = sorted_clustersizes[cl_size];
+        if (assignedcluster[representative] == UINT_MAX) {
+            assignedcluster[representative] = representative;
+            std::queue<int> myqueue;
+            myqueue.push(representative);
+            std::queue<int> iterationcutoffs;
+            iterationcutoffs.push(0);
+            //delete clusters of members;
+            while (!myqueue.empty()) {
+                int currentid = myqueue.front();
+                int iterationcutoff = iterationcutoffs.front();
+                assignedcluster[currentid] = representative;
+                myqueue.pop();
+                iterationcutoffs.pop();
+                size_t elementSize = (elementOffsets[currentid + 1] - elementOffsets[currentid]);
+                for (size_t elementId = 0; elementId < elementSize; elementId++) {
+                    unsigned int elementtodelete = elements[elementOffsets[currentid] + elementId];
+                    if (assignedcluster[elementtodelete] == UINT_MAX && iterationcutoff < maxiterations) {
+                        myqueue.push(elementtodelete);
+                        iterationcutoffs.push((iterationcutoff + 1));
+                    }
+                    assignedcluster[elementtodelete] = representative;
+                }
+            }
+
+        }
+    }
+}
+
 void ClusteringAlgorithms::greedyIncrementalLowMem( unsigned int *assignedcluster) {
     // two step clustering
     // 1.) we define the rep. sequences by minimizing the ids (smaller ID = longer sequence)
@@ -280,13 +413,10 @@ void ClusteringAlgorithms::greedyIncrementalLowMem( unsigned int *assignedcluste
         } while (!__atomic_compare_exchange(&assignedcluster[clusterId],  &targetId,  &clusterId , false,  __ATOMIC_RELAXED, __ATOMIC_RELAXED));
 
 
-        const size_t alnId = alnDbr->getId(clusterKey);
-        char *data = alnDbr->getData(alnId);
-
-        while (*data != '\0') {
-            char dbKey[255 + 1];
-            Util::parseKey(data, dbKey);
-            const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
+        ResultCursor cursor(alnDbr);
+        cursor.reset(alnDbr->getId(clusterKey));
+        unsigned int key;
+        while (cursor.nextKey(key)) {
             unsigned int currElement = seqDbr->getId(key);
             unsigned int targetId;
 
@@ -296,11 +426,10 @@ void ClusteringAlgorithms::greedyIncrementalLowMem( unsigned int *assignedcluste
             } while (!__atomic_compare_exchange(&assignedcluster[currElement],  &targetId,  &clusterId , false,  __ATOMIC_RELAXED, __ATOMIC_RELAXED));
 
             if (currElement == UINT_MAX || currElement > seqDbr->getSize()) {
-                Debug(Debug::ERROR) << "ERROR: Element " << dbKey
+                Debug(Debug::ERROR) << "ERROR: Element " << key
                                     << " contained in some alignment list, but not contained in the sequence database!\n";
                 EXIT(EXIT_FAILURE);
             }
-            data = Util::skipLine(data);
         }
     }
 
@@ -309,13 +438,10 @@ void ClusteringAlgorithms::greedyIncrementalLowMem( unsigned int *assignedcluste
         unsigned int clusterKey = seqDbr->getDbKey(id);
         unsigned int clusterId = id;
 
-        const size_t alnId = alnDbr->getId(clusterKey);
-        char *data = alnDbr->getData(alnId);
-
-        while (*data != '\0') {
-            char dbKey[255 + 1];
-            Util::parseKey(data, dbKey);
-            const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
+        ResultCursor cursor(alnDbr);
+        cursor.reset(alnDbr->getId(clusterKey));
+        unsigned int key;
+        while (cursor.nextKey(key)) {
             unsigned int currElement = seqDbr->getId(key);
             unsigned int targetId;
 
@@ -325,11 +451,10 @@ void ClusteringAlgorithms::greedyIncrementalLowMem( unsigned int *assignedcluste
             } while (!__atomic_compare_exchange(&assignedcluster[currElement],  &targetId,  &clusterId , false,  __ATOMIC_RELAXED, __ATOMIC_RELAXED));
 
             if (currElement == UINT_MAX || currElement > seqDbr->getSize()) {
-                Debug(Debug::ERROR) << "ERROR: Element " << dbKey
+                Debug(Debug::ERROR) << "ERROR: Element " << key
                                     << " contained in some alignment list, but not contained in the sequence database!\n";
                 EXIT(EXIT_FAILURE);
             }
-            data = Util::skipLine(data);
         }
     }
 
@@ -342,7 +467,7 @@ void ClusteringAlgorithms::greedyIncrementalLowMem( unsigned int *assignedcluste
     }
 }
 
-void ClusteringAlgorithms::greedyIncremental(unsigned int **elementLookupTable, size_t *elementOffsets,
+void ClusteringAlgorithms::greedyIncremental(const unsigned int *elements, const size_t *elementOffsets,
                                              size_t n, unsigned int *assignedcluster) {
     for(size_t i = 0; i < n; i++) {
         // seqDbr is descending sorted by length
@@ -351,7 +476,7 @@ void ClusteringAlgorithms::greedyIncremental(unsigned int **elementLookupTable,
         if(assignedcluster[i] == UINT_MAX){
             size_t elementSize = (elementOffsets[i + 1] - elementOffsets[i]);
             for (size_t elementId = 0; elementId < elementSize; elementId++) {
-                const unsigned int currElm = elementLookupTable[i][elementId];
+                const unsigned int currElm = elements[elementOffsets[i] + elementId];
                 if(assignedcluster[currElm] == currElm){
                     assignedcluster[i] = currElm;
                     break;
@@ -363,65 +488,3 @@ void ClusteringAlgorithms::greedyIncremental(unsigned int **elementLookupTable,
         }
     }
 }
-
-void ClusteringAlgorithms::readInClusterData(unsigned int **elementLookupTable, unsigned int *&elements,
-                                             unsigned short **scoreLookupTable, unsigned short *&scores,
-                                             size_t *elementOffsets, size_t totalElementCount) {
-    Timer timer;
-#pragma omp parallel for schedule(dynamic, 1000)
-    for(size_t i = 0; i < dbSize; i++) {
-        const unsigned int clusterId = seqDbr->getDbKey(i);
-        const size_t alnId = alnDbr->getId(clusterId);
-        const char *data = alnDbr->getData(alnId);
-        const size_t dataSize = alnDbr->getSeqLens(alnId);
-        elementOffsets[i] = Util::countLines(data, dataSize);
-    }
-
-    // make offset table
-    AlignmentSymmetry::computeOffsetFromCounts(elementOffsets, dbSize);
-    // set element edge pointers by using the offset table
-    AlignmentSymmetry::setupPointers<unsigned int>(elements, elementLookupTable, elementOffsets, dbSize,
-                                                   totalElementCount);
-    // fill elements
-    AlignmentSymmetry::readInData(alnDbr, seqDbr, elementLookupTable, NULL, 0, elementOffsets);
-    Debug(Debug::INFO) << "\nSort entries.\n";
-    AlignmentSymmetry::sortElements(elementLookupTable, elementOffsets, dbSize);
-    Debug(Debug::INFO) << "\nFind missing connections.\n";
-
-    size_t *newElementOffsets = new size_t[dbSize + 1];
-    memcpy(newElementOffsets, elementOffsets, sizeof(size_t) * (dbSize + 1));
-
-    // findMissingLinks detects new possible connections and updates the elementOffsets with new sizes
-    const size_t symmetricElementCount = AlignmentSymmetry::findMissingLinks(elementLookupTable,
-                                                                             newElementOffsets, dbSize,
-                                                                             threads);
-    // resize elements
-    delete[] elements;
-    elements = new(std::nothrow) unsigned int[symmetricElementCount];
-    Util::checkAllocation(elements, "Could not allocate elements memory in readInClusterData");
-    std::fill_n(elements, symmetricElementCount, UINT_MAX);
-    // init score vector
-    scores = new(std::nothrow) unsigned short[symmetricElementCount];
-    Util::checkAllocation(scores, "Could not allocate scores memory in readInClusterData");
-    std::fill_n(scores, symmetricElementCount, 0);
-    Debug(Debug::INFO) << "\nFound " << symmetricElementCount - totalElementCount << " new connections.\n";
-    AlignmentSymmetry::setupPointers<unsigned int>  (elements, elementLookupTable, newElementOffsets, dbSize, symmetricElementCount);
-    AlignmentSymmetry::setupPointers<unsigned short>(scores, scoreLookupTable, newElementOffsets, dbSize, symmetricElementCount);
-    //time
-    Debug(Debug::INFO) << "\nReconstruct initial order.\n";
-    alnDbr->remapData(); // need to free memory
-    AlignmentSymmetry::readInData(alnDbr, seqDbr, elementLookupTable, scoreLookupTable, scoretype, elementOffsets);
-    alnDbr->remapData(); // need to free memory
-    Debug(Debug::INFO) << "\nAdd missing connections.\n";
-    AlignmentSymmetry::addMissingLinks(elementLookupTable, elementOffsets, newElementOffsets, dbSize, scoreLookupTable);
-    maxClustersize = 0;
-    for (size_t i = 0; i < dbSize; i++) {
-        size_t elementCount = newElementOffsets[i + 1] - newElementOffsets[i];
-        maxClustersize = std::max((unsigned int) elementCount, maxClustersize);
-        clustersizes[i] = elementCount;
-    }
-
-    memcpy(elementOffsets, newElementOffsets, sizeof(size_t) * (dbSize + 1));
-    delete[] newElementOffsets;
-    Debug(Debug::INFO) << "\nTime for read in: " << timer.lap() << "\n";
-}
@@ -7,6 +7,7 @@
 
 #include <set>
 #include <list>
+#include <string>
 #include <vector>
 #include <unordered_map>
 
@@ -15,7 +16,9 @@
 
 class ClusteringAlgorithms {
 public:
-    ClusteringAlgorithms(DBReader<unsigned int>* seqDbr, DBReader<unsigned int>* alnDbr, int threads,int scoretype, int maxiterations);
+    // graphDir keeps the alignment graph in mapped files there instead of in memory if it is not empty
+    ClusteringAlgorithms(DBReader<unsigned int>* seqDbr, DBReader<unsigned int>* alnDbr, int threads,int scoretype, int maxiterations,
+                         const std::string &graphDir);
     ~ClusteringAlgorithms();
     std::unordered_map<unsigned int, std::vector<unsigned int>> execute(int mode);
 private:
@@ -26,6 +29,7 @@ private:
 
     int threads;
     int scoretype;
+    std::string graphDir;
 //datastructures
     unsigned int maxClustersize;
     unsigned int dbSize;
@@ -45,19 +49,23 @@ private:
     int maxiterations;
 
 
-    void setCover(unsigned int **elementLookup, unsigned short ** elementScoreLookupTable,
-                  unsigned int *assignedcluster, short *bestscore, size_t *offsets);
+    // clusters whose members have at least this many neighbors are scanned in parallel by setCover,
+    // only this scan is parallel, the greedy selection is sequential
+    static const size_t PARALLEL_SCAN_SIZE = 65536;
 
-    void greedyIncremental(unsigned int **elementLookupTable, size_t *elementOffsets,
-                           size_t n, unsigned int *assignedcluster) ;
+    // scores are unsigned char or unsigned short, see AlignmentGraph
+    template <typename T>
+    void setCover(const unsigned int *elements, const T *scores,
+                  unsigned int *assignedcluster, short *bestscore, const size_t *offsets);
 
+    void connectedComponents(const unsigned int *elements, const size_t *elementOffsets,
+                             unsigned int *assignedcluster);
 
-    void greedyIncrementalLowMem(unsigned int *assignedcluster) ;
+    void greedyIncremental(const unsigned int *elements, const size_t *elementOffsets,
+                           size_t n, unsigned int *assignedcluster) ;
 
 
-    void readInClusterData(unsigned int **elementLookupTable, unsigned int *&elements,
-                           unsigned short **scoreLookupTable, unsigned short *&scores,
-                           size_t *elementOffsets, size_t totalElementCount)  ;
+    void greedyIncrementalLowMem(unsigned int *assignedcluster) ;
 
 };
 
@@ -0,0 +1,348 @@
+#include "Bgzf.h"
+
+#ifdef HAVE_ZLIB
+#include "Debug.h"
+#include "Util.h"
+#include "FileUtil.h"
+
+#include <algorithm>
+#include <cstring>
+#include <climits>
+#include <unistd.h>
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+// gzip header with a single extra subfield "BC" that stores the total block size - 1
+static const size_t BGZF_HEADER_SIZE = 18;
+static const size_t BGZF_FOOTER_SIZE = 8;
+static const size_t BGZF_MAX_BLOCK_SIZE = 64 * 1024;
+
+static const unsigned char BGZF_EOF[28] = {
+        0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43,
+        0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+static inline uint16_t readUInt16(const unsigned char *p) {
+    return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+static inline uint32_t readUInt32(const unsigned char *p) {
+    return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static inline void writeUInt16(unsigned char *p, uint16_t value) {
+    p[0] = (unsigned char) (value & 0xff);
+    p[1] = (unsigned char) (value >> 8);
+}
+
+static inline void writeUInt32(unsigned char *p, uint32_t value) {
+    p[0] = (unsigned char) (value & 0xff);
+    p[1] = (unsigned char) ((value >> 8) & 0xff);
+    p[2] = (unsigned char) ((value >> 16) & 0xff);
+    p[3] = (unsigned char) (value >> 24);
+}
+
+// returns the BSIZE value of the BC subfield or -1 if the extra field does not contain one
+static int findBlockSize(const unsigned char *extra, size_t extraLen) {
+    size_t pos = 0;
+    while (pos + 4 <= extraLen) {
+        uint16_t subfieldLen = readUInt16(extra + pos + 2);
+        if (extra[pos] == 'B' && extra[pos + 1] == 'C' && subfieldLen == 2 && pos + 6 <= extraLen) {
+            return readUInt16(extra + pos + 4);
+        }
+        pos += 4 + subfieldLen;
+    }
+    return -1;
+}
+
+bool BgzfReader::isBgzf(const char *fileName) {
+    FILE *file = FileUtil::openFileOrDie(fileName, "rb", true);
+    unsigned char header[BGZF_HEADER_SIZE];
+    size_t read = fread(header, sizeof(char), BGZF_HEADER_SIZE, file);
+    fclose(file);
+    if (read != BGZF_HEADER_SIZE) {
+        return false;
+    }
+    return header[0] == 31 && header[1] == 139 && header[2] == 8 && (header[3] & 4) != 0
+           && findBlockSize(header + 12, readUInt16(header + 10)) >= 0;
+}
+
+BgzfReader::BgzfReader(FILE *file, unsigned int threads)
+        : file(file), threads(threads), fileOffset(0), fallback(NULL), decompressedSize(0), decompressedPos(0), eof(false) {
+    if (this->threads == 0) {
+        this->threads = 1;
+    }
+}
+
+BgzfReader::~BgzfReader() {
+    if (fallback != NULL) {
+        gzclose(fallback);
+    }
+}
+
+void BgzfReader::startFallback(size_t offset) {
+    // zlib reads from its own descriptor, which shares the file position with the FILE that we stop using here
+    int fd = dup(fileno(file));
+    if (fd == -1 || lseek(fd, (off_t) offset, SEEK_SET) == (off_t) -1) {
+        Debug(Debug::ERROR) << "Could not seek to gzip member at offset " << offset << ".\n";
+        EXIT(EXIT_FAILURE);
+    }
+    fallback = gzdopen(fd, "rb");
+    if (fallback == NULL) {
+        Debug(Debug::ERROR) << "Could not open gzip member at offset " << offset << ".\n";
+        EXIT(EXIT_FAILURE);
+    }
+    eof = true;
+}
+
+void BgzfReader::inflateBlock(const Block &block) {
+    if (block.isize == 0) {
+        return;
+    }
+    z_stream stream;
+    memset(&stream, 0, sizeof(z_stream));
+    // negative window bits: raw deflate data without zlib or gzip wrapper
+    if (inflateInit2(&stream, -15) != Z_OK) {
+        Debug(Debug::ERROR) << "Could not initialize inflate.\n";
+        EXIT(EXIT_FAILURE);
+    }
+    stream.next_in = (Bytef *) compressed.data() + block.dataOffset;
+    stream.avail_in = block.dataSize;
+    stream.next_out = (Bytef *) decompressed.data() + block.outOffset;
+    stream.avail_out = block.isize;
+    int status = inflate(&stream, Z_FINISH);
+    inflateEnd(&stream);
+    if (status != Z_STREAM_END || stream.total_out != block.isize) {
+        Debug(Debug::ERROR) << "Could not inflate BGZF block.\n";
+        EXIT(EXIT_FAILURE);
+    }
+    if (crc32(0, (const Bytef *) decompressed.data() + block.outOffset, block.isize) != block.crc) {
+        Debug(Debug::ERROR) << "CRC mismatch in BGZF block.\n";
+        EXIT(EXIT_FAILURE);
+    }
+}
+
+bool BgzfReader::fillBuffer() {
+    // read a few blocks per thread so that each batch keeps all threads busy
+    const size_t maxBlocks = threads * 16;
+    compressed.resize(maxBlocks * BGZF_MAX_BLOCK_SIZE);
+    blocks.clear();
+
+    size_t compressedPos = 0;
+    size_t outOffset = 0;
+    while (blocks.size() < maxBlocks) {
+        const size_t memberOffset = fileOffset;
+        unsigned char header[12];
+        size_t read = fread(header, sizeof(char), 12, file);
+        if (read == 0) {
+            eof = true;
+            break;
+        }
+        if (read < 2 || header[0] != 31 || header[1] != 139) {
+            Debug(Debug::WARNING) << "Ignoring trailing data after the last gzip member.\n";
+            eof = true;
+            break;
+        }
+        // a concatenated plain gzip member ends the BGZF part of the file, zlib inflates the rest sequentially
+        if (read != 12 || header[2] != 8 || (header[3] & 4) == 0) {
+            startFallback(memberOffset);
+            break;
+        }
+
+        size_t extraLen = readUInt16(header + 10);
+        unsigned char extra[BGZF_MAX_BLOCK_SIZE];
+        if (fread(extra, sizeof(char), extraLen, file) != extraLen) {
+            startFallback(memberOffset);
+            break;
+        }
+        int blockSize = findBlockSize(extra, extraLen);
+        if (blockSize < 0) {
+            startFallback(memberOffset);
+            break;
+        }
+        if ((size_t) blockSize + 1 < 12 + extraLen + BGZF_FOOTER_SIZE) {
+            Debug(Debug::ERROR) << "Gzip member is not a valid BGZF block.\n";
+            EXIT(EXIT_FAILURE);
+        }
+
+        size_t remaining = (size_t) blockSize + 1 - 12 - extraLen;
+        if (fread(compressed.data() + compressedPos, sizeof(char), remaining, file) != remaining) {
+            Debug(Debug::ERROR) << "Truncated BGZF block.\n";
+            EXIT(EXIT_FAILURE);
+        }
+
+        const unsigned char *footer = (const unsigned char *) compressed.data() + compressedPos + remaining - BGZF_FOOTER_SIZE;
+        Block block;
+        block.dataOffset = compressedPos;
+        block.dataSize = remaining - BGZF_FOOTER_SIZE;
+        block.outOffset = outOffset;
+        block.crc = readUInt32(footer);
+        block.isize = readUInt32(footer + 4);
+        if (block.isize > BGZF_MAX_BLOCK_SIZE) {
+            Debug(Debug::ERROR) << "BGZF block is larger than 64kb.\n";
+            EXIT(EXIT_FAILURE);
+        }
+        blocks.push_back(block);
+
+        compressedPos += remaining;
+        outOffset += block.isize;
+        fileOffset += (size_t) blockSize + 1;
+    }
+
+    decompressed.resize(outOffset);
+    decompressedSize = outOffset;
+    decompressedPos = 0;
+
+#ifdef OPENMP
+    if (omp_in_parallel()) {
+        // we are called from a thread of an enclosing team (e.g. the reader of createdb), instead of starting
+        // a nested team the blocks are handed to that team, whose threads run them once they wait at a barrier
+        for (size_t i = 0; i < blocks.size(); i++) {
+#pragma omp task firstprivate(i)
+            inflateBlock(blocks[i]);
+        }
+#pragma omp taskwait
+    } else
+#endif
+    {
+#pragma omp parallel for schedule(dynamic, 1) num_threads(threads)
+        for (size_t i = 0; i < blocks.size(); i++) {
+            inflateBlock(blocks[i]);
+        }
+    }
+
+    return decompressedSize > 0;
+}
+
+size_t BgzfReader::read(char *buffer, size_t len) {
+    size_t copied = 0;
+    while (copied < len) {
+        if (decompressedPos == decompressedSize) {
+            if (eof == true && fallback != NULL) {
+                int inflated = gzread(fallback, buffer + copied, (unsigned int) std::min(len - copied, (size_t) INT_MAX));
+                if (inflated < 0) {
+                    Debug(Debug::ERROR) << "Could not inflate gzip member.\n";
+                    EXIT(EXIT_FAILURE);
+                }
+                if (inflated == 0) {
+                    break;
+                }
+                copied += inflated;
+                continue;
+            }
+            if (eof == true || fillBuffer() == false) {
+                // empty blocks can be followed by more data, only stop at the end of the file
+                if (eof == true) {
+                    break;
+                }
+                continue;
+            }
+        }
+        size_t toCopy = std::min(len - copied, decompressedSize - decompressedPos);
+        memcpy(buffer + copied, decompressed.data() + decompressedPos, toCopy);
+        copied += toCopy;
+        decompressedPos += toCopy;
+    }
+    return copied;
+}
+
+const size_t BgzfWriter::BLOCK_DATA_SIZE;
+
+BgzfWriter::BgzfWriter(FILE *file, unsigned int threads, int level)
+        : file(file), threads(threads), level(level), uncompressedSize(0) {
+    if (this->threads == 0) {
+        this->threads = 1;
+    }
+    const size_t maxBlocks = this->threads * 16;
+    uncompressed.resize(maxBlocks * BLOCK_DATA_SIZE);
+    compressed.resize(maxBlocks * BGZF_MAX_BLOCK_SIZE);
+    compressedSizes.resize(maxBlocks);
+}
+
+BgzfWriter::~BgzfWriter() {}
+
+void BgzfWriter::write(const char *data, size_t len) {
+    while (len > 0) {
+        size_t toCopy = std::min(len, uncompressed.size() - uncompressedSize);
+        memcpy(uncompressed.data() + uncompressedSize, data, toCopy);
+        uncompressedSize += toCopy;
+        data += toCopy;
+        len -= toCopy;
+        if (uncompressedSize == uncompressed.size()) {
+            flushBlocks();
+        }
+    }
+}
+
+void BgzfWriter::flushBlocks() {
+    const size_t blockCount = (uncompressedSize + BLOCK_DATA_SIZE - 1) / BLOCK_DATA_SIZE;
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(threads)
+    for (size_t i = 0; i < blockCount; i++) {
+        const size_t inOffset = i * BLOCK_DATA_SIZE;
+        const size_t inSize = std::min(BLOCK_DATA_SIZE, uncompressedSize - inOffset);
+        unsigned char *out = (unsigned char *) compressed.data() + i * BGZF_MAX_BLOCK_SIZE;
+
+        z_stream stream;
+        memset(&stream, 0, sizeof(z_stream));
+        if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            Debug(Debug::ERROR) << "Could not initialize deflate.\n";
+            EXIT(EXIT_FAILURE);
+        }
+        stream.next_in = (Bytef *) uncompressed.data() + inOffset;
+        stream.avail_in = inSize;
+        stream.next_out = out + BGZF_HEADER_SIZE;
+        stream.avail_out = BGZF_MAX_BLOCK_SIZE - BGZF_HEADER_SIZE - BGZF_FOOTER_SIZE;
+        int status = deflate(&stream, Z_FINISH);
+        deflateEnd(&stream);
+        if (status != Z_STREAM_END) {
+            Debug(Debug::ERROR) << "Could not deflate BGZF block.\n";
+            EXIT(EXIT_FAILURE);
+        }
+
+        const size_t blockSize = BGZF_HEADER_SIZE + stream.total_out + BGZF_FOOTER_SIZE;
+        memcpy(out, BGZF_EOF, BGZF_HEADER_SIZE);
+        writeUInt16(out + 16, (uint16_t) (blockSize - 1));
+        unsigned char *footer = out + BGZF_HEADER_SIZE + stream.total_out;
+        writeUInt32(footer, (uint32_t) crc32(0, (const Bytef *) uncompressed.data() + inOffset, inSize));
+        writeUInt32(footer + 4, (uint32_t) inSize);
+        compressedSizes[i] = blockSize;
+    }
+
+    for (size_t i = 0; i < blockCount; i++) {
+        size_t written = fwrite(compressed.data() + i * BGZF_MAX_BLOCK_SIZE, sizeof(char), compressedSizes[i], file);
+        if (written != compressedSizes[i]) {
+            Debug(Debug::ERROR) << "Could not write BGZF block.\n";
+            EXIT(EXIT_FAILURE);
+        }
+    }
+    uncompressedSize = 0;
+}
+
+void BgzfWriter::close() {
+    if (uncompressedSize > 0) {
+        flushBlocks();
+    }
+    if (fwrite(BGZF_EOF, sizeof(char), sizeof(BGZF_EOF), file) != sizeof(BGZF_EOF)) {
+        Debug(Debug::ERROR) << "Could not write BGZF end-of-file marker.\n";
+        EXIT(EXIT_FAILURE);
+    }
+}
+
+void BgzfWriter::compressFile(const char *inFileName, const char *outFileName, unsigned int threads) {
+    FILE *in = FileUtil::openFileOrDie(inFileName, "rb", true);
+    FILE *out = FileUtil::openFileOrDie(outFileName, "wb", false);
+    BgzfWriter writer(out, threads);
+    char *buffer = new char[BLOCK_DATA_SIZE * 16];
+    size_t read;
+    while ((read = fread(buffer, sizeof(char), BLOCK_DATA_SIZE * 16, in)) > 0) {
+        writer.write(buffer, read);
+    }
+    writer.close();
+    delete[] buffer;
+    fclose(out);
+    fclose(in);
+}
+#endif
@@ -0,0 +1,88 @@
+#ifndef MMSEQS_BGZF_H
+#define MMSEQS_BGZF_H
+
+// Reads and writes BGZF (blocked gzip, as used by samtools/tabix) files.
+// BGZF is a series of independent gzip members of at most 64kb each, whose
+// compressed size is stored in the gzip header. This allows us to inflate or
+// deflate many blocks in parallel while still producing a valid gzip stream.
+
+#ifdef HAVE_ZLIB
+#include <cstdio>
+#include <cstddef>
+#include <vector>
+#include <stdint.h>
+#include <zlib.h>
+
+class BgzfReader {
+public:
+    BgzfReader(FILE *file, unsigned int threads);
+    ~BgzfReader();
+
+    // copies up to len decompressed bytes into buffer, returns 0 at the end of the file
+    size_t read(char *buffer, size_t len);
+
+    // checks if the first member of the file carries the BGZF "BC" extra field
+    static bool isBgzf(const char *fileName);
+
+private:
+    struct Block;
+
+    bool fillBuffer();
+    void inflateBlock(const Block &block);
+    void startFallback(size_t offset);
+
+    FILE *file;
+    unsigned int threads;
+    // bytes of the file consumed so far
+    size_t fileOffset;
+    // inflates the rest of the file sequentially once a member without the BC field is found
+    gzFile fallback;
+
+    struct Block {
+        size_t dataOffset;
+        size_t dataSize;
+        size_t outOffset;
+        uint32_t crc;
+        uint32_t isize;
+    };
+
+    std::vector<char> compressed;
+    std::vector<Block> blocks;
+    std::vector<char> decompressed;
+    size_t decompressedSize;
+    size_t decompressedPos;
+    bool eof;
+};
+
+class BgzfWriter {
+public:
+    BgzfWriter(FILE *file, unsigned int threads, int level = 6);
+    ~BgzfWriter();
+
+    void write(const char *data, size_t len);
+
+    // flushes all pending blocks and appends the BGZF end-of-file marker, does not close the file
+    void close();
+
+    // compresses a whole file into a new BGZF file
+    static void compressFile(const char *inFileName, const char *outFileName, unsigned int threads);
+
+    // payload per block, leaves room for incompressible data to still fit into a 64kb block
+    static const size_t BLOCK_DATA_SIZE = 0xff00;
+
+private:
+    void flushBlocks();
+
+    FILE *file;
+    unsigned int threads;
+    int level;
+
+    std::vector<char> uncompressed;
+    size_t uncompressedSize;
+    std::vector<char> compressed;
+    std::vector<size_t> compressedSizes;
+};
+
+#endif
+
+#endif //MMSEQS_BGZF_H
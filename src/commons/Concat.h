@@ -14,6 +14,9 @@
 #include <algorithm>
 #include <fcntl.h>
 #include <limits.h>
+#ifdef HAVE_SENDFILE
+#include <sys/sendfile.h>
+#endif
 
 #include "Debug.h"
 #include "Util.h"
@@ -109,6 +112,40 @@ public:
     }
 
 
+    /* Copy up to SIZE bytes from the current offset of INPUT_DESC to OUT_DESC inside
+       the kernel. copy_file_range can share the extents on copy-on-write file systems,
+       so nothing is read or written at all. Returns the number of bytes copied, the
+       caller falls back to read/write for the remainder.  */
+    static size_t kernelCopy(int input_desc, int out_desc, size_t size) {
+        size_t copied = 0;
+        const size_t maxChunk = INT_MAX & ~8191;
+#ifdef HAVE_COPY_FILE_RANGE
+        while (copied < size) {
+            ssize_t result = copy_file_range(input_desc, NULL, out_desc, NULL, std::min(size - copied, maxChunk), 0);
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result <= 0) {
+                break;
+            }
+            copied += result;
+        }
+#endif
+#ifdef HAVE_SENDFILE
+        while (copied < size) {
+            ssize_t result = sendfile(out_desc, input_desc, NULL, std::min(size - copied, maxChunk));
+            if (result < 0 && errno == EINTR) {
+                continue;
+            }
+            if (result <= 0) {
+                break;
+            }
+            copied += result;
+        }
+#endif
+        return copied;
+    }
+
     static void concatFiles(FILE * files[], size_t n, FILE *outFile) {
         int output_desc = fileno(outFile);
         struct stat stat_buf;
@@ -125,6 +162,10 @@ public:
                 EXIT(EXIT_FAILURE);
             }
 
+            if (kernelCopy(input_desc, output_desc, stat_buf.st_size) == (size_t) stat_buf.st_size) {
+                continue;
+            }
+
             size_t insize = io_blksize(stat_buf);
             insize = std::max(insize, outsize);
 
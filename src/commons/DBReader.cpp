@@ -5,8 +5,10 @@
 #include <algorithm>
 #include <climits>
 #include <cstring>
+#include <cstdlib>
 #include <cstddef>
 #include <random>
+#include <vector>
 
 #include <sys/mman.h>
 #include <sys/stat.h>
@@ -17,20 +19,30 @@
 #include "Util.h"
 #include "FileUtil.h"
 
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
 template <typename T>
 DBReader<T>::DBReader(const char* dataFileName_, const char* indexFileName_, int dataMode) :
         data(NULL), dataMode(dataMode), dataFileName(strdup(dataFileName_)),
         indexFileName(strdup(indexFileName_)), size(0), dataSize(0), aaDbSize(0), lastKey(T()), closed(1), dbtype(-1),
-        index(NULL), seqLens(NULL), id2local(NULL), local2id(NULL),
-        dataMapped(false), accessType(0), externalData(false), didMlock(false)
+        index(NULL), seqLens(NULL), indexMapping(NULL), indexMappingSize(0), id2local(NULL), local2id(NULL),
+        dataMapped(false), accessType(0), externalData(false), didMlock(false), compressed(false),
+        dictId(0), threadBuffers(NULL), threadBufferCount(0)
 {}
 
 template <typename T>
 DBReader<T>::DBReader(DBReader<T>::Index *index, unsigned int *seqLens, size_t size, size_t aaDbSize, T lastKey) :
         data(NULL), dataMode(USE_INDEX), dataFileName(NULL), indexFileName(NULL),
         size(size), dataSize(0), aaDbSize(aaDbSize), lastKey(lastKey), closed(1), dbtype(-1),
-        index(index), seqLens(seqLens), id2local(NULL), local2id(NULL),
-        dataMapped(false), accessType(NOSORT), externalData(true), didMlock(false)
+        index(index), seqLens(seqLens), indexMapping(NULL), indexMappingSize(0), id2local(NULL), local2id(NULL),
+        dataMapped(false), accessType(NOSORT), externalData(true), didMlock(false), compressed(false),
+        dictId(0), threadBuffers(NULL), threadBufferCount(0)
 {}
 
 template <typename T>
@@ -92,6 +104,7 @@ template <typename T> bool DBReader<T>::open(int accessType){
         data = mmapData(dataFile, &dataSize);
         fclose(dataFile);
         dataMapped = true;
+        readCompressionDict();
     }
 
     if (externalData == false) {
@@ -99,21 +112,31 @@ template <typename T> bool DBReader<T>::open(int accessType){
             Debug(Debug::ERROR) << "Could not open index file " << indexFileName << "!\n";
             EXIT(EXIT_FAILURE);
         }
-        size = FileUtil::countLines(indexFileName);
-        index = new Index[this->size];
-        seqLens = new unsigned int[size];
+        if (openIndexSidecar(&isSortedById) == false) {
+            size = FileUtil::countLines(indexFileName);
+            index = new Index[this->size];
+            seqLens = new unsigned int[size];
+
+            isSortedById = readIndex(indexFileName, index, seqLens);
 
-        isSortedById = readIndex(indexFileName, index, seqLens);
+            // init seq lens array and dbKey mapping
+            aaDbSize = 0;
+            for (size_t i = 0; i < size; i++){
+                unsigned int size = seqLens[i];
+                aaDbSize += size;
+            }
+        }
         if (accessType != HARDNOSORT) {
             sortIndex(isSortedById);
         }
+    }
 
-        // init seq lens array and dbKey mapping
-        aaDbSize = 0;
-        for (size_t i = 0; i < size; i++){
-            unsigned int size = seqLens[i];
-            aaDbSize += size;
-        }
+    if (compressed == true) {
+        threadBufferCount = 1;
+#ifdef OPENMP
+        threadBufferCount = (unsigned int) std::max(omp_get_max_threads(), 1);
+#endif
+        threadBuffers = new std::vector<char>[threadBufferCount];
     }
 
     closed = 0;
@@ -336,6 +359,11 @@ template <typename T> void DBReader<T>::remapData(){
 }
 
 template <typename T> void DBReader<T>::close(){
+    if (threadBuffers != NULL) {
+        delete[] threadBuffers;
+        threadBuffers = NULL;
+        threadBufferCount = 0;
+    }
     if(dataMode & USE_DATA){
         unmapData();
     }
@@ -345,8 +373,13 @@ template <typename T> void DBReader<T>::close(){
     }
 
     if(externalData == false) {
-        delete[] index;
-        delete[] seqLens;
+        if (indexMapping != NULL) {
+            munmap(indexMapping, indexMappingSize);
+            indexMapping = NULL;
+        } else {
+            delete[] index;
+            delete[] seqLens;
+        }
     }
     closed = 1;
 }
@@ -377,16 +410,51 @@ template <typename T> char* DBReader<T>::getData(size_t id){
         Debug(Debug::ERROR) << "Requested offset: " << index[id].offset << "\n";
         EXIT(EXIT_FAILURE);
     }
+    if (compressed == true) {
+        return getData(id, threadBuffer());
+    }
+    return data + index[indexPosition(id)].offset;
+}
+
+template <typename T> char* DBReader<T>::getData(size_t id, std::vector<char> &buffer) {
+    if (compressed == false) {
+        return getData(id);
+    }
+    checkClosed();
+    if (id >= size){
+        Debug(Debug::ERROR) << "Invalid database read for database data file=" << dataFileName << ", database index=" << indexFileName << "\n";
+        Debug(Debug::ERROR) << "getData: local id (" << id << ") >= db size (" << size << ")\n";
+        EXIT(EXIT_FAILURE);
+    }
+    return decompressEntry(indexPosition(id), buffer);
+}
+
+template <typename T> size_t DBReader<T>::indexPosition(size_t id) {
     if(accessType == SORT_BY_LENGTH || accessType == LINEAR_ACCCESS || accessType == SORT_BY_LINE || accessType == SHUFFLE){
-        return data + index[local2id[id]].offset;
-    }else{
-        return data + index[id].offset;
+        return local2id[id];
+    }
+    return id;
+}
+
+template <typename T> const char* DBReader<T>::getData() {
+    if (compressed == true) {
+        Debug(Debug::ERROR) << "Raw data of the compressed database " << dataFileName << " can not be accessed!\n";
+        EXIT(EXIT_FAILURE);
     }
+    return data;
 }
 
 template <typename T>
 void DBReader<T>::touchData(size_t id) {
     if((dataMode & USE_DATA) && (dataMode & USE_FREAD) == 0) {
+        if (compressed == true) {
+            // only bring the deflated entry into memory
+            const char *entry = data + index[indexPosition(id)].offset;
+            CompressedEntryHeader header;
+            memcpy(&header, entry, sizeof(CompressedEntryHeader));
+            magicBytes = Util::touchMemory((char *) entry, sizeof(CompressedEntryHeader) + header.compressedSize);
+            return;
+        }
         char *data = getData(id);
         size_t size = getSeqLens(id);
         magicBytes = Util::touchMemory(data, size);
@@ -395,7 +463,10 @@ void DBReader<T>::touchData(size_t id) {
 
 template <typename T> char* DBReader<T>::getDataByDBKey(T dbKey) {
     size_t id = getId(dbKey);
-    return (id != UINT_MAX) ? data + index[id].offset : NULL;
+    if (id == UINT_MAX) {
+        return NULL;
+    }
+    return (compressed == true) ? decompressEntry(id, threadBuffer()) : data + index[id].offset;
 }
 
 template <typename T> size_t DBReader<T>::getSize (){
@@ -442,6 +513,15 @@ template <typename T> size_t DBReader<T>::maxCount(char c) {
 
     size_t max = 0;
     size_t count = 0;
+    if (compressed == true) {
+        std::vector<char> buffer;
+        for (size_t id = 0; id < size; ++id) {
+            const char *entry = getData(id, buffer);
+            count = std::count(entry, entry + seqLens[id], c);
+            max = std::max(max, count);
+        }
+        return max;
+    }
     for (size_t i = 0; i < dataSize; ++i) {
         if (data[i] == c) {
             count++;
@@ -500,6 +580,240 @@ bool DBReader<T>::readIndex(char *indexFileName, Index *index, unsigned int *ent
     return isSorted;
 }
 
+template <typename T>
+std::string DBReader<T>::indexSidecarFileName(const char *indexFileName) {
+    return std::string(indexFileName) + ".bin";
+}
+
+template <typename T>
+bool DBReader<T>::getIndexFileStamp(const char *indexFileName, IndexSidecarHeader &header) {
+    FILE *file = fopen(indexFileName, "r");
+    if (file == NULL) {
+        return false;
+    }
+    struct stat sb;
+    if (fstat(fileno(file), &sb) < 0) {
+        fclose(file);
+        return false;
+    }
+    header.indexFileSize = sb.st_size;
+#ifdef __APPLE__
+    header.indexMtimeSec = sb.st_mtimespec.tv_sec;
+    header.indexMtimeNsec = sb.st_mtimespec.tv_nsec;
+#else
+    header.indexMtimeSec = sb.st_mtim.tv_sec;
+    header.indexMtimeNsec = sb.st_mtim.tv_nsec;
+#endif
+    // the first and last lines of the index hold the smallest and largest keys with their offsets
+    unsigned char block[2 * INDEX_STAMP_BLOCK];
+    const size_t fileSize = sb.st_size;
+    const size_t headSize = std::min(fileSize, INDEX_STAMP_BLOCK);
+    const size_t tailSize = std::min(fileSize - headSize, INDEX_STAMP_BLOCK);
+    bool success = fread(block, sizeof(char), headSize, file) == headSize;
+    if (tailSize > 0) {
+        success = success && fseek(file, fileSize - tailSize, SEEK_SET) == 0
+                  && fread(block + headSize, sizeof(char), tailSize, file) == tailSize;
+    }
+    fclose(file);
+    header.indexChecksum = Util::hash(block, headSize + tailSize);
+    return success;
+}
+
+template <typename T>
+bool DBReader<T>::openIndexSidecar(bool *) {
+    // only fixed size keys can be mapped directly
+    return false;
+}
+
+template <>
+bool DBReader<unsigned int>::openIndexSidecar(bool *isSortedById) {
+    std::string sidecarFileName = indexSidecarFileName(indexFileName);
+    if (FileUtil::fileExists(sidecarFileName.c_str()) == false) {
+        return false;
+    }
+
+    IndexSidecarHeader stamp;
+    if (getIndexFileStamp(indexFileName, stamp) == false) {
+        return false;
+    }
+
+    FILE *file = fopen(sidecarFileName.c_str(), "r");
+    if (file == NULL) {
+        return false;
+    }
+    struct stat sb;
+    if (fstat(fileno(file), &sb) < 0 || (size_t) sb.st_size < sizeof(IndexSidecarHeader)) {
+        fclose(file);
+        return false;
+    }
+    // private writable mapping, sortIndex permutes seqLens in place for some access types
+    char *mapping = static_cast<char *>(mmap(NULL, sb.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno(file), 0));
+    fclose(file);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+
+    const IndexSidecarHeader *header = (const IndexSidecarHeader *) mapping;
+    const size_t expectedSize = sizeof(IndexSidecarHeader) + header->size * (sizeof(Index) + sizeof(unsigned int));
+    if (header->magic != INDEX_SIDECAR_MAGIC
+        || header->indexFileSize != stamp.indexFileSize
+        || header->indexMtimeSec != stamp.indexMtimeSec
+        || header->indexMtimeNsec != stamp.indexMtimeNsec
+        || header->indexChecksum != stamp.indexChecksum
+        || expectedSize != (size_t) sb.st_size) {
+        munmap(mapping, sb.st_size);
+        return false;
+    }
+
+    size = header->size;
+    aaDbSize = header->aaDbSize;
+    lastKey = header->lastKey;
+    *isSortedById = header->isSortedById != 0;
+    index = (Index *) (mapping + sizeof(IndexSidecarHeader));
+    seqLens = (unsigned int *) (mapping + sizeof(IndexSidecarHeader) + size * sizeof(Index));
+    indexMapping = mapping;
+    indexMappingSize = sb.st_size;
+    return true;
+}
+
+template <typename T>
+std::string DBReader<T>::compressionDictFileName(const char *dataFileName) {
+    return std::string(dataFileName) + ".zdict";
+}
+
+template <typename T>
+uint32_t DBReader<T>::compressionDictId(const std::string &dictionary, size_t size, size_t dataSize) {
+#ifdef HAVE_ZLIB
+    uLong crc = crc32(0L, Z_NULL, 0);
+    crc = crc32(crc, (const Bytef *) dictionary.data(), dictionary.size());
+    const uint64_t sizes[2] = { size, dataSize };
+    crc = crc32(crc, (const Bytef *) sizes, sizeof(sizes));
+    return (uint32_t) crc;
+#else
+    return 0;
+#endif
+}
+
+template <typename T>
+void DBReader<T>::readCompressionDict() {
+    compressed = false;
+    compressionDict.clear();
+    std::string dictFileName = compressionDictFileName(dataFileName);
+    if (FileUtil::fileExists(dictFileName.c_str()) == false) {
+        return;
+    }
+    FILE *file = FileUtil::openFileOrDie(dictFileName.c_str(), "r", true);
+    CompressionDictHeader header;
+    if (fread(&header, sizeof(CompressionDictHeader), 1, file) != 1
+        || header.magic != COMPRESSION_DICT_MAGIC || header.dataFileSize != dataSize) {
+        // left over from an older database with the same name
+        fclose(file);
+        return;
+    }
+    if (dataSize >= sizeof(CompressedEntryHeader)) {
+        // the first entry is written at offset 0
+        CompressedEntryHeader entryHeader;
+        memcpy(&entryHeader, data, sizeof(CompressedEntryHeader));
+        if (entryHeader.dictId != header.dictId) {
+            fclose(file);
+            return;
+        }
+    }
+    compressionDict.resize(header.dictSize);
+    if (header.dictSize > 0 && fread(&compressionDict[0], sizeof(char), header.dictSize, file) != header.dictSize) {
+        Debug(Debug::ERROR) << "Could not read compression dictionary " << dictFileName << "!\n";
+        EXIT(EXIT_FAILURE);
+    }
+    fclose(file);
+#ifndef HAVE_ZLIB
+    Debug(Debug::ERROR) << "Database " << dataFileName << " is compressed, but MMseqs was not compiled with zlib support!\n";
+    EXIT(EXIT_FAILURE);
+#endif
+    dictId = header.dictId;
+    compressed = true;
+}
+
+#ifdef HAVE_ZLIB
+struct InflateState {
+    z_stream stream;
+    bool initialized;
+
+    InflateState() : initialized(false) {}
+    ~InflateState() {
+        if (initialized) {
+            inflateEnd(&stream);
+        }
+    }
+};
+static thread_local InflateState inflateState;
+#endif
+
+template <typename T>
+std::vector<char> &DBReader<T>::threadBuffer() {
+    unsigned int thread_idx = 0;
+#ifdef OPENMP
+    thread_idx = (unsigned int) omp_get_thread_num();
+#endif
+    if (thread_idx >= threadBufferCount) {
+        Debug(Debug::ERROR) << "Compressed database " << dataFileName << " was opened for " << threadBufferCount
+                            << " threads, but is read by thread " << thread_idx << "!\n";
+        EXIT(EXIT_FAILURE);
+    }
+    return threadBuffers[thread_idx];
+}
+
+template <typename T>
+char *DBReader<T>::decompressEntry(size_t position, std::vector<char> &buffer) {
+    const char *entry = data + index[position].offset;
+    CompressedEntryHeader header;
+    memcpy(&header, entry, sizeof(CompressedEntryHeader));
+    buffer.resize(std::max(header.rawSize, (uint32_t) 1));
+    decompressEntry(entry, buffer.data());
+    return buffer.data();
+}
+
+template <typename T>
+void DBReader<T>::decompressEntry(const char *entry, char *buffer) {
+#ifdef HAVE_ZLIB
+    CompressedEntryHeader header;
+    memcpy(&header, entry, sizeof(CompressedEntryHeader));
+    if (header.dictId != dictId) {
+        Debug(Debug::ERROR) << "Entry of compressed database " << dataFileName << " does not belong to dictionary "
+                            << compressionDictFileName(dataFileName) << "!\n";
+        EXIT(EXIT_FAILURE);
+    }
+
+    InflateState &state = inflateState;
+    if (state.initialized == false) {
+        memset(&state.stream, 0, sizeof(z_stream));
+        // raw deflate data without zlib header
+        if (inflateInit2(&state.stream, -15) != Z_OK) {
+            Debug(Debug::ERROR) << "Could not initialize inflate.\n";
+            EXIT(EXIT_FAILURE);
+        }
+        state.initialized = true;
+    } else {
+        inflateReset(&state.stream);
+    }
+
+    if (compressionDict.empty() == false) {
+        inflateSetDictionary(&state.stream, (const Bytef *) compressionDict.data(), compressionDict.size());
+    }
+    state.stream.next_in = (Bytef *) entry + sizeof(CompressedEntryHeader);
+    state.stream.avail_in = header.compressedSize;
+    state.stream.next_out = (Bytef *) buffer;
+    state.stream.avail_out = header.rawSize;
+    int status = inflate(&state.stream, Z_FINISH);
+    if (status != Z_STREAM_END || state.stream.total_out != header.rawSize) {
+        Debug(Debug::ERROR) << "Could not inflate entry of compressed database " << dataFileName << "!\n";
+        EXIT(EXIT_FAILURE);
+    }
+#else
+    (void) entry;
+    (void) buffer;
+#endif
+}
+
 template<typename T> T DBReader<T>::getLastKey() {
     return lastKey;
 }
@@ -534,6 +848,10 @@ template <typename T> void DBReader<T>::unmapData() {
 }
 
 template <typename T>  size_t DBReader<T>::getDataOffset(T i) {
+    if (compressed == true) {
+        Debug(Debug::ERROR) << "Data offsets of the compressed database " << dataFileName << " can not be accessed!\n";
+        EXIT(EXIT_FAILURE);
+    }
     size_t id = bsearch(index, size, i);
     return index[id].offset;
 }
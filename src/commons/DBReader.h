@@ -9,6 +9,8 @@
 #include <cstddef>
 #include <utility>
 #include <string>
+#include <vector>
+#include <stdint.h>
 #include "Sequence.h"
 
 template <typename T>
@@ -22,6 +24,45 @@ public:
             return (x.id <= y.id);
         }
     };
+    // header of the binary index sidecar (<index>.bin), followed by size Index entries and size seqLens
+    // the sidecar is only used if size, mtime and the checksum of the first and last
+    // INDEX_STAMP_BLOCK bytes of the text index match the ones stored here
+    struct IndexSidecarHeader {
+        uint64_t magic;
+        uint64_t size;
+        uint64_t aaDbSize;
+        uint64_t indexFileSize;
+        int64_t indexMtimeSec;
+        int64_t indexMtimeNsec;
+        uint32_t lastKey;
+        uint32_t isSortedById;
+        uint64_t indexChecksum;
+    };
+    // "MMSIDX2\0" in little endian
+    static const uint64_t INDEX_SIDECAR_MAGIC = 0x0032584449534d4dULL;
+    static const size_t INDEX_STAMP_BLOCK = 4096;
+
+    // entries of compressed databases start with this header, followed by compressedSize bytes of raw deflate data
+    // the index still stores the uncompressed length, so getSeqLens keeps its meaning
+    // dictId names the dictionary the entry was deflated with
+    struct CompressedEntryHeader {
+        uint32_t compressedSize;
+        uint32_t rawSize;
+        uint32_t dictId;
+    };
+
+    // header of <data>.zdict, followed by dictSize bytes of the deflate dictionary
+    // a database counts as compressed only if dataFileSize matches its data file
+    // and its first entry carries dictId
+    struct CompressionDictHeader {
+        uint64_t magic;
+        uint64_t dataFileSize;
+        uint64_t dictSize;
+        uint64_t dictId;
+    };
+    // "MMZDIC2\0" in little endian
+    static const uint64_t COMPRESSION_DICT_MAGIC = 0x00324349445a4d4dULL;
+
     DBReader(const char* dataFileName, const char* indexFileName, int mode = USE_DATA|USE_INDEX);
 
     DBReader(Index* index, unsigned int *seqLens, size_t size, size_t aaDbSize, T lastKey);
@@ -40,8 +81,14 @@ public:
 
     size_t getAminoAcidDBSize(){ return aaDbSize; }
 
+    // entries of compressed databases are inflated into a buffer of the calling thread,
+    // that stays valid until the same thread calls getData or getDataByDBKey of this reader again
     char* getData(size_t id);
 
+    // same as getData, but compressed entries are inflated into buffer instead,
+    // the result stays valid until buffer is changed. Needed to hold several entries of one reader at once.
+    char* getData(size_t id, std::vector<char> &buffer);
+
     void touchData(size_t id);
 
     char* getDataByDBKey(T key);
@@ -79,9 +126,8 @@ public:
     static const int USE_WRITABLE = 2;
     static const int USE_FREAD    = 4;
 
-    const char * getData(){
-        return data;
-    }
+    // raw data file, not available for compressed databases
+    const char * getData();
 
     size_t getDataSize(){
         return dataSize;
@@ -101,6 +147,7 @@ public:
 
     void unmapData();
 
+    // not available for compressed databases
     size_t getDataOffset(T i);
 
 
@@ -125,6 +172,20 @@ public:
 
     static int parseDbType(const char *name);
 
+    static std::string indexSidecarFileName(const char *indexFileName);
+
+    static std::string compressionDictFileName(const char *dataFileName);
+
+    bool isCompressed() {
+        return compressed;
+    }
+
+    // dictionary id of a deflate dictionary for a database of size entries and dataSize bytes
+    static uint32_t compressionDictId(const std::string &dictionary, size_t size, size_t dataSize);
+
+    // fills in size, mtime and checksum of the text index, returns false if it can not be read
+    static bool getIndexFileStamp(const char *indexFileName, IndexSidecarHeader &header);
+
     int getDbtype(){
         return dbtype;
     }
@@ -140,6 +201,7 @@ public:
             case Sequence::HMM_PROFILE: return "Profile";
             case Sequence::PROFILE_STATE_SEQ: return "Profile state";
             case Sequence::PROFILE_STATE_PROFILE: return "Profile profile";
+            case Sequence::ALIGNMENT_RES_BINARY: return "Binary alignment result";
             default: return "Unknown";
         }
     }
@@ -195,6 +257,21 @@ private:
 
     void checkClosed();
 
+    bool openIndexSidecar(bool *isSortedById);
+
+    void readCompressionDict();
+
+    // position of local id in index
+    size_t indexPosition(size_t id);
+
+    // inflate buffer of the calling thread
+    std::vector<char> &threadBuffer();
+
+    // inflates the entry at an index position into buffer
+    char *decompressEntry(size_t position, std::vector<char> &buffer);
+
+    void decompressEntry(const char *entry, char *buffer);
+
     char* data;
 
     int dataMode;
@@ -218,6 +295,9 @@ private:
     Index * index;
 
     unsigned int * seqLens;
+    // index and seqLens point into this mapping if they were read from the sidecar
+    char * indexMapping;
+    size_t indexMappingSize;
     unsigned int * id2local;
     unsigned int * local2id;
 
@@ -231,6 +311,13 @@ private:
     // needed to prevent the compiler from optimizing away the loop
     char magicBytes;
 
+    bool compressed;
+    std::string compressionDict;
+    uint32_t dictId;
+    // one inflate buffer per thread
+    std::vector<char> *threadBuffers;
+    unsigned int threadBufferCount;
+
 };
 
 #endif
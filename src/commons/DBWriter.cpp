@@ -7,10 +7,18 @@
 #include "itoa.h"
 #include "Timer.h"
 
+#include <climits>
 #include <cstdlib>
 #include <cstdio>
 #include <sstream>
 #include <unistd.h>
+#include <algorithm>
+#include <functional>
+#include <omptl/omptl_algorithm>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 #ifdef OPENMP
 #include <omp.h>
@@ -91,20 +99,21 @@ void DBWriter::mergeFiles(DBReader<unsigned int> &qdbr,
 
     for (size_t id = 0; id < qdbr.getSize(); id++) {
         unsigned int key = qdbr.getDbKey(id);
-        std::ostringstream ss;
+        writeStart(0);
         // get all data for the id from all files
         for (size_t i = 0; i < fileCount; i++) {
-            const char *data = filesToMerge[i]->getDataByDBKey(key);
-            if (data != NULL) {
-                if(i < prefixes.size()) {
-                    ss << prefixes[i];
-                }
-                ss << data;
+            const size_t fileId = filesToMerge[i]->getId(key);
+            if (fileId == UINT_MAX) {
+                continue;
+            }
+            if (i < prefixes.size()) {
+                writeAdd(prefixes[i].c_str(), prefixes[i].length(), 0);
             }
+            // entries are appended by length, binary records may contain null bytes
+            const char *data = filesToMerge[i]->getData(fileId);
+            writeAdd(data, std::max(filesToMerge[i]->getSeqLens(fileId), (size_t) 1) - 1, 0);
         }
-        // write result
-        std::string result = ss.str();
-        writeData(result.c_str(), result.length(), key, 0);
+        writeEnd(key, 0);
     }
 
     // close all reader
@@ -189,24 +198,22 @@ void DBWriter::close(int dbType) {
     }
 
     if (dbType > -1){
-        std::string dataFile = dataFileName;
-        std::string dbTypeFile = (dataFile+".dbtype").c_str();
-        FILE * dbtypeDataFile = fopen(dbTypeFile.c_str(), "wb");
-        if (dbtypeDataFile == NULL) {
-            Debug(Debug::ERROR) << "Could not open data file " << dbTypeFile << "!\n";
-            EXIT(EXIT_FAILURE);
-        }
-        size_t written = fwrite(&dbType, sizeof(int), 1, dbtypeDataFile);
-        if (written != 1) {
-            Debug(Debug::ERROR) << "Could not write to data file " << dbTypeFile << "\n";
-            EXIT(EXIT_FAILURE);
-        }
-        fclose(dbtypeDataFile);
+        writeDbtypeFile(dataFileName, dbType);
     }
 
     mergeResults(dataFileName, indexFileName,
                  (const char **) dataFileNames, (const char **) indexFileNames, threads, ((mode & LEXICOGRAPHIC_MODE) != 0));
 
+    if ((mode & COMPRESSED_MODE) != 0) {
+        compressDatabase(dataFileName, indexFileName, threads);
+    } else {
+        // do not let an older compressed database with the same name claim the new data
+        std::string dictFileName = DBReader<unsigned int>::compressionDictFileName(dataFileName);
+        if (FileUtil::fileExists(dictFileName.c_str())) {
+            std::remove(dictFileName.c_str());
+        }
+    }
+
     for (unsigned int i = 0; i < threads; i++) {
         delete [] dataFilesBuffer[i];
         free(dataFileNames[i]);
@@ -215,6 +222,21 @@ void DBWriter::close(int dbType) {
     closed = true;
 }
 
+void DBWriter::writeDbtypeFile(const char *dataFileName, int dbType) {
+    std::string dbTypeFile = std::string(dataFileName) + ".dbtype";
+    FILE * dbtypeDataFile = fopen(dbTypeFile.c_str(), "wb");
+    if (dbtypeDataFile == NULL) {
+        Debug(Debug::ERROR) << "Could not open data file " << dbTypeFile << "!\n";
+        EXIT(EXIT_FAILURE);
+    }
+    size_t written = fwrite(&dbType, sizeof(int), 1, dbtypeDataFile);
+    if (written != 1) {
+        Debug(Debug::ERROR) << "Could not write to data file " << dbTypeFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    fclose(dbtypeDataFile);
+}
+
 void DBWriter::writeStart(unsigned int thrIdx) {
     checkClosed();
     if (thrIdx >= threads) {
@@ -366,12 +388,13 @@ void DBWriter::mergeResults(const char *outFileName, const char *outFileNameInde
                             const char **dataFileNames, const char **indexFileNames,
                             const unsigned long fileCount, const bool lexicographicOrder) {
     Timer timer;
+    // offset of each shard in the merged data file
+    std::vector<size_t> shardOffsets(fileCount, 0);
     // merge results from each thread into one result file
     if (fileCount > 1) {
         FILE *outFile = fopen(outFileName, "w");
         FILE **infiles = new FILE *[fileCount];
-        std::vector<size_t> threadDataFileSizes;
-
+        size_t globalOffset = 0;
         for (unsigned int i = 0; i < fileCount; i++) {
             infiles[i] = fopen(dataFileNames[i], "r");
             if (infiles[i] == NULL) {
@@ -385,7 +408,8 @@ void DBWriter::mergeResults(const char *outFileName, const char *outFileNameInde
                 Debug(Debug::ERROR) << "Failed to fstat file " << dataFileNames[i] << ". Error " << errsv << ".\n";
                 EXIT(EXIT_FAILURE);
             }
-            threadDataFileSizes.push_back(sb.st_size);
+            shardOffsets[i] = globalOffset;
+            globalOffset += sb.st_size;
         }
         Concat::concatFiles(infiles, fileCount, outFile);
         for (unsigned int i = 0; i < fileCount; i++) {
@@ -396,53 +420,91 @@ void DBWriter::mergeResults(const char *outFileName, const char *outFileNameInde
         }
         delete[] infiles;
         fclose(outFile);
-
-        // merge index
-        FILE *index_file = fopen(indexFileNames[0], "a");
-        if (index_file == NULL) {
-            perror(outFileNameIndex);
+    } else {
+        if (std::rename(dataFileNames[0], outFileName) != 0) {
+            Debug(Debug::ERROR) << "Could not move result " << dataFileNames[0] << " to final location " << outFileName << "!\n";
             EXIT(EXIT_FAILURE);
         }
-        size_t globalOffset = threadDataFileSizes[0];
-        for (unsigned int fileIdx = 1; fileIdx < fileCount; fileIdx++) {
-            DBReader<unsigned int> reader(dataFileNames[fileIdx], indexFileNames[fileIdx], DBReader<unsigned int>::USE_INDEX);
+    }
+
+    if (lexicographicOrder == false) {
+        // read every shard index exactly once and write the final sorted index directly
+        std::vector<std::pair<DBReader<unsigned int>::Index, unsigned int>> entries;
+        bool isSortedById = true;
+        for (unsigned int fileIdx = 0; fileIdx < fileCount; fileIdx++) {
+            DBReader<unsigned int> reader(indexFileNames[fileIdx], indexFileNames[fileIdx], DBReader<unsigned int>::USE_INDEX);
             reader.open(DBReader<unsigned int>::HARDNOSORT);
-            if (reader.getSize() > 0) {
-                DBReader<unsigned int>::Index * index = reader.getIndex();
-                for (size_t i = 0; i < reader.getSize()-1; i++) {
-                    size_t currOffset = index[i].offset;
-                    index[i].offset = globalOffset + currOffset;
+            DBReader<unsigned int>::Index *index = reader.getIndex();
+            unsigned int *seqLens = reader.getSeqLens();
+            entries.reserve(entries.size() + reader.getSize());
+            for (size_t i = 0; i < reader.getSize(); i++) {
+                DBReader<unsigned int>::Index entry = index[i];
+                entry.offset += shardOffsets[fileIdx];
+                if (entries.empty() == false && entry.id < entries.back().first.id) {
+                    isSortedById = false;
                 }
-                size_t currOffset = index[reader.getSize()-1].offset;
-                index[reader.getSize()-1].offset = globalOffset + currOffset;
-                writeIndex(index_file, reader.getSize(), index, reader.getSeqLens());
+                entries.push_back(std::make_pair(entry, seqLens[i]));
             }
             reader.close();
             if (std::remove(indexFileNames[fileIdx]) != 0) {
                 Debug(Debug::WARNING) << "Could not remove file " << indexFileNames[fileIdx] << "\n";
             }
-
-            globalOffset += threadDataFileSizes[fileIdx];
+            removeIndexSidecar(indexFileNames[fileIdx]);
         }
-        fclose(index_file);
-    } else {
-        if (std::rename(dataFileNames[0], outFileName) != 0) {
-            Debug(Debug::ERROR) << "Could not move result " << dataFileNames[0] << " to final location " << outFileName << "!\n";
-            EXIT(EXIT_FAILURE);
+        if (isSortedById == false) {
+            omptl::sort(entries.begin(), entries.end(), DBReader<unsigned int>::compareIndexLengthPairById());
         }
-    }
 
-    if (lexicographicOrder == false) {
-        // sort the index
-        DBReader<unsigned int> indexReader(indexFileNames[0], indexFileNames[0], DBReader<unsigned int>::USE_INDEX);
-        indexReader.open(DBReader<unsigned int>::NOSORT);
-        DBReader<unsigned int>::Index *index = indexReader.getIndex();
+        const size_t size = entries.size();
+        DBReader<unsigned int>::Index *index = new DBReader<unsigned int>::Index[size];
+        unsigned int *seqLens = new unsigned int[size];
+        size_t aaDbSize = 0;
+        unsigned int lastKey = 0;
+        for (size_t i = 0; i < size; i++) {
+            index[i] = entries[i].first;
+            seqLens[i] = entries[i].second;
+            aaDbSize += seqLens[i];
+            lastKey = std::max(lastKey, index[i].id);
+        }
+        std::vector<std::pair<DBReader<unsigned int>::Index, unsigned int>>().swap(entries);
+
         FILE *index_file  = fopen(outFileNameIndex, "w");
-        writeIndex(index_file, indexReader.getSize(), index, indexReader.getSeqLens());
+        if (index_file == NULL) {
+            perror(outFileNameIndex);
+            EXIT(EXIT_FAILURE);
+        }
+        writeIndex(index_file, size, index, seqLens);
         fclose(index_file);
-        indexReader.close();
-
+        writeIndexSidecar(outFileNameIndex, size, index, seqLens, aaDbSize, lastKey);
+        delete[] index;
+        delete[] seqLens;
     } else {
+        // merge index
+        if (fileCount > 1) {
+            FILE *index_file = fopen(indexFileNames[0], "a");
+            if (index_file == NULL) {
+                perror(outFileNameIndex);
+                EXIT(EXIT_FAILURE);
+            }
+            for (unsigned int fileIdx = 1; fileIdx < fileCount; fileIdx++) {
+                DBReader<std::string> reader(dataFileNames[fileIdx], indexFileNames[fileIdx], DBReader<std::string>::USE_INDEX);
+                reader.open(DBReader<std::string>::HARDNOSORT);
+                if (reader.getSize() > 0) {
+                    DBReader<std::string>::Index * index = reader.getIndex();
+                    for (size_t i = 0; i < reader.getSize(); i++) {
+                        index[i].offset += shardOffsets[fileIdx];
+                    }
+                    writeIndex(index_file, reader.getSize(), index, reader.getSeqLens());
+                }
+                reader.close();
+                if (std::remove(indexFileNames[fileIdx]) != 0) {
+                    Debug(Debug::WARNING) << "Could not remove file " << indexFileNames[fileIdx] << "\n";
+                }
+                removeIndexSidecar(indexFileNames[fileIdx]);
+            }
+            fclose(index_file);
+        }
+
         DBReader<std::string> indexReader(indexFileNames[0], indexFileNames[0], DBReader<std::string>::USE_INDEX);
         indexReader.open(DBReader<std::string>::SORT_BY_ID);
         DBReader<std::string>::Index *index = indexReader.getIndex();
@@ -450,14 +512,273 @@ void DBWriter::mergeResults(const char *outFileName, const char *outFileNameInde
         writeIndex(index_file, indexReader.getSize(), index, indexReader.getSeqLens());
         fclose(index_file);
         indexReader.close();
-    }
 
-    if (std::remove(indexFileNames[0]) != 0) {
-        Debug(Debug::WARNING) << "Could not remove file " << indexFileNames[0] << "\n";
+        if (std::remove(indexFileNames[0]) != 0) {
+            Debug(Debug::WARNING) << "Could not remove file " << indexFileNames[0] << "\n";
+        }
+        removeIndexSidecar(indexFileNames[0]);
+        // string keys have no sidecar, do not leave one of an older database behind
+        removeIndexSidecar(outFileNameIndex);
     }
     Debug(Debug::INFO) << "Time for merging files: " << timer.lap() << "\n";
 }
 
+#ifdef HAVE_ZLIB
+static inline size_t dictKmerHash(const char *kmer, size_t kmerSize, unsigned int hashBits) {
+    uint64_t value = 0;
+    memcpy(&value, kmer, kmerSize);
+    return (size_t) ((value * 0x9E3779B97F4A7C15ULL) >> (64 - hashBits));
+}
+
+// Selects the most frequent segments of a sample of the entries, similar to the COVER dictionary builder of zstd.
+// Deflate prefers close matches and only looks back 32kb, so the best segments are placed at the end.
+static std::string trainDictionary(DBReader<unsigned int> &reader) {
+    const size_t maxDictSize = 32 * 1024;
+    const size_t maxSampleSize = 4 * 1024 * 1024;
+    const size_t segmentSize = 64;
+    const size_t kmerSize = 6;
+    const unsigned int hashBits = 20;
+
+    std::string sample;
+    if (reader.getSize() == 0) {
+        return sample;
+    }
+    const size_t avgEntrySize = std::max(reader.getAminoAcidDBSize() / reader.getSize(), (size_t) 1);
+    const size_t step = std::max(reader.getSize() / std::max(maxSampleSize / avgEntrySize, (size_t) 1), (size_t) 1);
+    for (size_t id = 0; id < reader.getSize() && sample.size() < maxSampleSize; id += step) {
+        sample.append(reader.getData(id), reader.getSeqLens(id));
+    }
+    if (sample.size() < 4 * segmentSize) {
+        return std::string();
+    }
+
+    std::vector<uint16_t> counts(1u << hashBits, 0);
+    for (size_t pos = 0; pos + kmerSize <= sample.size(); pos++) {
+        uint16_t &count = counts[dictKmerHash(sample.data() + pos, kmerSize, hashBits)];
+        if (count < UINT16_MAX) {
+            count++;
+        }
+    }
+
+    const size_t segmentCount = sample.size() / segmentSize;
+    std::vector<std::pair<size_t, size_t>> segmentScores(segmentCount);
+    for (size_t segment = 0; segment < segmentCount; segment++) {
+        const char *start = sample.data() + segment * segmentSize;
+        size_t score = 0;
+        for (size_t pos = 0; pos + kmerSize <= segmentSize; pos++) {
+            score += counts[dictKmerHash(start + pos, kmerSize, hashBits)];
+        }
+        segmentScores[segment] = std::make_pair(score, segment);
+    }
+    std::sort(segmentScores.begin(), segmentScores.end(), std::greater<std::pair<size_t, size_t>>());
+
+    // greedily take segments, k-mers that are already covered do not count again
+    std::vector<size_t> selected;
+    for (size_t i = 0; i < segmentCount && selected.size() * segmentSize < maxDictSize; i++) {
+        const char *start = sample.data() + segmentScores[i].second * segmentSize;
+        size_t score = 0;
+        for (size_t pos = 0; pos + kmerSize <= segmentSize; pos++) {
+            score += counts[dictKmerHash(start + pos, kmerSize, hashBits)];
+        }
+        // only k-mers that occur more than once on average are worth storing
+        if (score <= (segmentSize - kmerSize + 1) || 2 * score < segmentScores[i].first) {
+            continue;
+        }
+        for (size_t pos = 0; pos + kmerSize <= segmentSize; pos++) {
+            counts[dictKmerHash(start + pos, kmerSize, hashBits)] = 0;
+        }
+        selected.push_back(segmentScores[i].second);
+    }
+
+    std::string dictionary;
+    for (size_t i = selected.size(); i > 0; i--) {
+        dictionary.append(sample.data() + selected[i - 1] * segmentSize, segmentSize);
+    }
+    return dictionary;
+}
+#endif
+
+void DBWriter::compressDatabase(const char *dataFileName, const char *indexFileName, unsigned int threads) {
+#ifdef HAVE_ZLIB
+    Timer timer;
+    std::string dictFileName = DBReader<unsigned int>::compressionDictFileName(dataFileName);
+    if (FileUtil::fileExists(dictFileName.c_str())) {
+        std::remove(dictFileName.c_str());
+    }
+
+    DBReader<unsigned int> reader(dataFileName, indexFileName);
+    reader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
+    const std::string dictionary = trainDictionary(reader);
+    const uint32_t dictId = DBReader<unsigned int>::compressionDictId(dictionary, reader.getSize(), reader.getDataSize());
+
+    std::string compressedFileName = std::string(dataFileName) + ".compressed";
+    if (FileUtil::fileExists(compressedFileName.c_str())) {
+        std::remove(compressedFileName.c_str());
+    }
+    FILE *compressedFile = FileUtil::openFileOrDie(compressedFileName.c_str(), "w", false);
+
+    const size_t size = reader.getSize();
+    const size_t batchSize = 16 * 1024;
+    std::vector<std::string> compressed(batchSize);
+    std::vector<std::pair<DBReader<unsigned int>::Index, unsigned int>> entries(size);
+    size_t offset = 0;
+#pragma omp parallel num_threads(threads)
+    {
+        z_stream stream;
+        memset(&stream, 0, sizeof(z_stream));
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+            Debug(Debug::ERROR) << "Could not initialize deflate.\n";
+            EXIT(EXIT_FAILURE);
+        }
+        std::vector<char> buffer;
+
+        for (size_t batchStart = 0; batchStart < size; batchStart += batchSize) {
+            const size_t batchEnd = std::min(batchStart + batchSize, size);
+#pragma omp for schedule(dynamic, 64)
+            for (size_t id = batchStart; id < batchEnd; id++) {
+                const char *data = reader.getData(id);
+                const unsigned int length = reader.getSeqLens(id);
+
+                deflateReset(&stream);
+                if (dictionary.empty() == false) {
+                    deflateSetDictionary(&stream, (const Bytef *) dictionary.data(), dictionary.size());
+                }
+                buffer.resize(sizeof(DBReader<unsigned int>::CompressedEntryHeader) + deflateBound(&stream, length));
+                stream.next_in = (Bytef *) data;
+                stream.avail_in = length;
+                stream.next_out = (Bytef *) buffer.data() + sizeof(DBReader<unsigned int>::CompressedEntryHeader);
+                stream.avail_out = buffer.size() - sizeof(DBReader<unsigned int>::CompressedEntryHeader);
+                if (deflate(&stream, Z_FINISH) != Z_STREAM_END) {
+                    Debug(Debug::ERROR) << "Could not deflate entry " << reader.getDbKey(id) << "!\n";
+                    EXIT(EXIT_FAILURE);
+                }
+                DBReader<unsigned int>::CompressedEntryHeader header;
+                header.compressedSize = stream.total_out;
+                header.rawSize = length;
+                header.dictId = dictId;
+                memcpy(buffer.data(), &header, sizeof(DBReader<unsigned int>::CompressedEntryHeader));
+                compressed[id - batchStart].assign(buffer.data(), sizeof(DBReader<unsigned int>::CompressedEntryHeader) + stream.total_out);
+            }
+
+#pragma omp single
+            {
+                for (size_t id = batchStart; id < batchEnd; id++) {
+                    const std::string &entry = compressed[id - batchStart];
+                    if (fwrite(entry.data(), sizeof(char), entry.size(), compressedFile) != entry.size()) {
+                        Debug(Debug::ERROR) << "Could not write to data file " << compressedFileName << "\n";
+                        EXIT(EXIT_FAILURE);
+                    }
+                    entries[id].first.id = reader.getDbKey(id);
+                    entries[id].first.offset = offset;
+                    entries[id].second = reader.getSeqLens(id);
+                    offset += entry.size();
+                }
+            }
+        }
+        deflateEnd(&stream);
+    }
+    fclose(compressedFile);
+    const size_t aaDbSize = reader.getAminoAcidDBSize();
+    const unsigned int lastKey = reader.getLastKey();
+    reader.close();
+
+    if (std::rename(compressedFileName.c_str(), dataFileName) != 0) {
+        Debug(Debug::ERROR) << "Could not move " << compressedFileName << " to " << dataFileName << "!\n";
+        EXIT(EXIT_FAILURE);
+    }
+
+    omptl::sort(entries.begin(), entries.end(), DBReader<unsigned int>::compareIndexLengthPairById());
+    DBReader<unsigned int>::Index *index = new DBReader<unsigned int>::Index[size];
+    unsigned int *seqLens = new unsigned int[size];
+    for (size_t i = 0; i < size; i++) {
+        index[i] = entries[i].first;
+        seqLens[i] = entries[i].second;
+    }
+    std::vector<std::pair<DBReader<unsigned int>::Index, unsigned int>>().swap(entries);
+    FILE *indexFile = FileUtil::openFileOrDie(indexFileName, "w", true);
+    writeIndex(indexFile, size, index, seqLens);
+    fclose(indexFile);
+    writeIndexSidecar(indexFileName, size, index, seqLens, aaDbSize, lastKey);
+    delete[] index;
+    delete[] seqLens;
+
+    DBReader<unsigned int>::CompressionDictHeader header;
+    header.magic = DBReader<unsigned int>::COMPRESSION_DICT_MAGIC;
+    header.dataFileSize = offset;
+    header.dictSize = dictionary.size();
+    header.dictId = dictId;
+    FILE *dictFile = FileUtil::openFileOrDie(dictFileName.c_str(), "w", false);
+    if (fwrite(&header, sizeof(DBReader<unsigned int>::CompressionDictHeader), 1, dictFile) != 1
+        || fwrite(dictionary.data(), sizeof(char), dictionary.size(), dictFile) != dictionary.size()) {
+        Debug(Debug::ERROR) << "Could not write " << dictFileName << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    fclose(dictFile);
+    Debug(Debug::INFO) << "Time for compressing database: " << timer.lap() << "\n";
+#else
+    Debug(Debug::ERROR) << "MMseqs was not compiled with zlib support. Can not write compressed database " << dataFileName << "!\n";
+    EXIT(EXIT_FAILURE);
+#endif
+}
+
+void DBWriter::writeIndexSidecar(const char *indexFileName, size_t size, DBReader<unsigned int>::Index *index,
+                                 unsigned int *seqLens, size_t aaDbSize, unsigned int lastKey) {
+    if (size < INDEX_SIDECAR_MIN_ENTRIES) {
+        removeIndexSidecar(indexFileName);
+        return;
+    }
+    DBReader<unsigned int>::IndexSidecarHeader header;
+    memset(&header, 0, sizeof(DBReader<unsigned int>::IndexSidecarHeader));
+    if (DBReader<unsigned int>::getIndexFileStamp(indexFileName, header) == false) {
+        Debug(Debug::WARNING) << "Could not stat " << indexFileName << ", skipping binary index\n";
+        return;
+    }
+    header.magic = DBReader<unsigned int>::INDEX_SIDECAR_MAGIC;
+    header.size = size;
+    header.aaDbSize = aaDbSize;
+    header.lastKey = lastKey;
+    header.isSortedById = 1;
+
+    std::string sidecarFileName = DBReader<unsigned int>::indexSidecarFileName(indexFileName);
+    FILE *sidecarFile = fopen(sidecarFileName.c_str(), "w");
+    if (sidecarFile == NULL) {
+        Debug(Debug::WARNING) << "Could not open " << sidecarFileName << " for writing, skipping binary index\n";
+        return;
+    }
+    bool success = fwrite(&header, sizeof(DBReader<unsigned int>::IndexSidecarHeader), 1, sidecarFile) == 1;
+    if (header.size > 0) {
+        success = success && fwrite(index, sizeof(DBReader<unsigned int>::Index), header.size, sidecarFile) == header.size;
+        success = success && fwrite(seqLens, sizeof(unsigned int), header.size, sidecarFile) == header.size;
+    }
+    fclose(sidecarFile);
+    if (success == false) {
+        // a truncated sidecar would be rejected by DBReader anyway, but do not leave it around
+        Debug(Debug::WARNING) << "Could not write " << sidecarFileName << "\n";
+        std::remove(sidecarFileName.c_str());
+    }
+}
+
+void DBWriter::removeIndexSidecar(const std::string &indexFileName) {
+    const std::string sidecarFileName = DBReader<unsigned int>::indexSidecarFileName(indexFileName.c_str());
+    if (FileUtil::fileExists(sidecarFileName.c_str())) {
+        FileUtil::deleteFile(sidecarFileName);
+    }
+}
+
+void DBWriter::moveIndexSidecar(const std::string &fromIndexFileName, const std::string &toIndexFileName) {
+    const std::string fromSidecar = DBReader<unsigned int>::indexSidecarFileName(fromIndexFileName.c_str());
+    if (FileUtil::fileExists(fromSidecar.c_str()) == false) {
+        removeIndexSidecar(toIndexFileName);
+        return;
+    }
+    const std::string toSidecar = DBReader<unsigned int>::indexSidecarFileName(toIndexFileName.c_str());
+    if (std::rename(fromSidecar.c_str(), toSidecar.c_str()) != 0) {
+        Debug(Debug::WARNING) << "Could not move " << fromSidecar << " to " << toSidecar << "\n";
+        FileUtil::deleteFile(fromSidecar);
+        removeIndexSidecar(toIndexFileName);
+    }
+}
+
 void DBWriter::mergeFilePair(const std::vector<std::pair<std::string, std::string>> fileNames) {
     FILE ** files = new FILE*[fileNames.size()];
     for (size_t i = 0; i < fileNames.size();i++) {
@@ -19,6 +19,8 @@ class DBWriter {
         static const size_t ASCII_MODE = 0;
         static const size_t BINARY_MODE = 1;
         static const size_t LEXICOGRAPHIC_MODE = 2;
+        // compress the database after merging, see compressDatabase
+        static const size_t COMPRESSED_MODE = 4;
 
 
         DBWriter(const char* dataFileName, const char* indexFileName, unsigned int threads = 1, size_t mode = ASCII_MODE);
@@ -28,6 +30,8 @@ class DBWriter {
         void open(size_t bufferSize = 64 * 1024 * 1024);
 
         void close(int dbType = -1);
+
+        static void writeDbtypeFile(const char* dataFileName, int dbType);
     
         char* getDataFileName() { return dataFileName; }
     
@@ -59,6 +63,21 @@ class DBWriter {
 
         void mergeFilePair(const std::vector<std::pair<std::string, std::string>> fileNames);
 
+        // rewrites a database so that every entry is deflated with a dictionary trained on a sample of the entries
+        // DBReader inflates entries transparently, the index keeps the uncompressed lengths
+        static void compressDatabase(const char *dataFileName, const char *indexFileName, unsigned int threads);
+
+        // writes the binary index sidecar for an already written text index, index has to be sorted by id
+        // smaller indices are parsed quickly enough and get no sidecar
+        static void writeIndexSidecar(const char *indexFileName, size_t size, DBReader<unsigned int>::Index *index,
+                                      unsigned int *seqLens, size_t aaDbSize, unsigned int lastKey);
+        static const size_t INDEX_SIDECAR_MIN_ENTRIES = 1000000;
+
+        // has to be called wherever a text index is removed or renamed
+        static void removeIndexSidecar(const std::string &indexFileName);
+        // a sidecar of the destination is removed if the source has none
+        static void moveIndexSidecar(const std::string &fromIndexFileName, const std::string &toIndexFileName);
+
 
 private:
     template <typename T>
@@ -71,6 +71,40 @@ KSeqGzip::~KSeqGzip() {
     kseq_destroy((KSEQGZIP::kseq_t*)seq);
     gzclose(file);
 }
+
+static int bgzfRead(BgzfReader* reader, void* buffer, int len) {
+    return (int) reader->read((char*) buffer, (size_t) len);
+}
+
+namespace KSEQBGZF {
+    KSEQ_INIT(BgzfReader*, bgzfRead)
+}
+
+KSeqBgzf::KSeqBgzf(const char* fileName, unsigned int threads) {
+    file = FileUtil::openFileOrDie(fileName, "rb", true);
+    reader = new BgzfReader(file, threads);
+    seq = (void*) KSEQBGZF::kseq_init(reader);
+}
+
+bool KSeqBgzf::ReadEntry() {
+    KSEQBGZF::kseq_t* s = (KSEQBGZF::kseq_t*) seq;
+    int result = KSEQBGZF::kseq_read(s);
+    if (result < 0)
+        return false;
+
+    entry.name = s->name;
+    entry.comment = s->comment;
+    entry.sequence = s->seq;
+    entry.qual = s->qual;
+
+    return true;
+}
+
+KSeqBgzf::~KSeqBgzf() {
+    kseq_destroy((KSEQBGZF::kseq_t*)seq);
+    delete reader;
+    fclose(file);
+}
 #endif
 
 
@@ -116,14 +150,19 @@ KSeqBzip::~KSeqBzip() {
 }
 #endif
 
-KSeqWrapper* KSeqFactory(const char* file) {
+KSeqWrapper* KSeqFactory(const char* file, unsigned int threads) {
     KSeqWrapper* kseq = NULL;
     if(Util::endsWith(".gz", file) == false && Util::endsWith(".bz2", file) == false ) {
         kseq = new KSeqFile(file);
     }
 #ifdef HAVE_ZLIB
     else if(Util::endsWith(".gz", file) == true) {
-        kseq = new KSeqGzip(file);
+        // plain or multi-member gzip can only be inflated sequentially
+        if (threads > 1 && BgzfReader::isBgzf(file)) {
+            kseq = new KSeqBgzf(file, threads);
+        } else {
+            kseq = new KSeqGzip(file);
+        }
     }
 #else
     else if(Util::endsWith(".gz", file) == true) {
@@ -31,6 +31,7 @@ private:
 
 #ifdef HAVE_ZLIB
 #include <zlib.h>
+#include "Bgzf.h"
 
 class KSeqGzip : public KSeqWrapper {
 public:
@@ -40,6 +41,16 @@ public:
 private:
     gzFile file;
 };
+
+class KSeqBgzf : public KSeqWrapper {
+public:
+    KSeqBgzf(const char* file, unsigned int threads);
+    bool ReadEntry();
+    ~KSeqBgzf();
+private:
+    FILE* file;
+    BgzfReader* reader;
+};
 #endif
 
 #ifdef HAVE_BZLIB
@@ -56,6 +67,7 @@ private:
 #endif
 
 
-KSeqWrapper* KSeqFactory(const char* file);
+// BGZF input is inflated with the given number of threads, all other inputs are read by a single thread
+KSeqWrapper* KSeqFactory(const char* file, unsigned int threads = 1);
 
 #endif //MMSEQS_KSEQWRAPPER_H
@@ -0,0 +1,203 @@
+#include "MemoryPlacement.h"
+#include "Debug.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <dirent.h>
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#endif
+
+#ifndef MAP_ANONYMOUS
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+
+// memory policies and flags from linux/mempolicy.h
+#define MMSEQS_MPOL_PREFERRED 1
+#define MMSEQS_MPOL_INTERLEAVE 3
+#define MMSEQS_MPOL_MF_MOVE (1 << 1)
+
+static const size_t HUGE_PAGE_2M = 2 * 1024 * 1024;
+static const size_t HUGE_PAGE_1G = 1024 * 1024 * 1024;
+
+static size_t roundUp(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+static void *mapAnonymous(size_t size, int extraFlags) {
+    void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extraFlags, -1, 0);
+    return (ptr == MAP_FAILED) ? NULL : ptr;
+}
+
+// maps more than needed and trims both ends so that the mapping starts at a huge page boundary
+static void *mapAligned(size_t size, size_t alignment) {
+    char *ptr = (char *) mapAnonymous(size + alignment, 0);
+    if (ptr == NULL) {
+        return NULL;
+    }
+    char *aligned = (char *) roundUp((size_t) ptr, alignment);
+    if (aligned > ptr) {
+        munmap(ptr, aligned - ptr);
+    }
+    size_t tail = (ptr + size + alignment) - (aligned + size);
+    if (tail > 0) {
+        munmap(aligned + size, tail);
+    }
+    return aligned;
+}
+
+void *MemoryPlacement::allocate(size_t size, int hugePages, size_t *mappedSize) {
+    if (size == 0) {
+        size = 1;
+    }
+#if defined(MAP_HUGETLB) && defined(MAP_HUGE_SHIFT)
+    if (hugePages == HUGE_PAGES_2M || hugePages == HUGE_PAGES_1G) {
+        const size_t pageSize = (hugePages == HUGE_PAGES_2M) ? HUGE_PAGE_2M : HUGE_PAGE_1G;
+        const int pageShift = (hugePages == HUGE_PAGES_2M) ? 21 : 30;
+        *mappedSize = roundUp(size, pageSize);
+        void *ptr = mapAnonymous(*mappedSize, MAP_HUGETLB | (pageShift << MAP_HUGE_SHIFT));
+        if (ptr != NULL) {
+            return ptr;
+        }
+        Debug(Debug::WARNING) << "Could not allocate " << *mappedSize << " bytes from the huge page pool. "
+                              << "Falling back to transparent huge pages.\n";
+        hugePages = HUGE_PAGES_TRANSPARENT;
+    }
+#endif
+    if (hugePages != HUGE_PAGES_OFF) {
+        *mappedSize = roundUp(size, HUGE_PAGE_2M);
+        void *ptr = mapAligned(*mappedSize, HUGE_PAGE_2M);
+#ifdef MADV_HUGEPAGE
+        if (ptr != NULL && madvise(ptr, *mappedSize, MADV_HUGEPAGE) != 0) {
+            Debug(Debug::WARNING) << "Transparent huge pages are not available.\n";
+        }
+#endif
+        return ptr;
+    }
+
+    *mappedSize = roundUp(size, (size_t) sysconf(_SC_PAGESIZE));
+    return mapAnonymous(*mappedSize, 0);
+}
+
+void MemoryPlacement::free(void *ptr, size_t mappedSize) {
+    if (ptr != NULL) {
+        munmap(ptr, mappedSize);
+    }
+}
+
+void MemoryPlacement::release(void *ptr, size_t size) {
+    const size_t pageSize = (size_t) sysconf(_SC_PAGESIZE);
+    size = size / pageSize * pageSize;
+    if (ptr != NULL && size > 0) {
+        madvise(ptr, size, MADV_DONTNEED);
+    }
+}
+
+static std::vector<int> readNodes() {
+    std::vector<int> nodes;
+    DIR *dir = opendir("/sys/devices/system/node");
+    if (dir != NULL) {
+        struct dirent *entry;
+        while ((entry = readdir(dir)) != NULL) {
+            if (strncmp(entry->d_name, "node", 4) == 0 && entry->d_name[4] >= '0' && entry->d_name[4] <= '9') {
+                nodes.push_back(atoi(entry->d_name + 4));
+            }
+        }
+        closedir(dir);
+    }
+    if (nodes.empty()) {
+        nodes.push_back(0);
+    }
+    std::sort(nodes.begin(), nodes.end());
+    return nodes;
+}
+
+const std::vector<int> &MemoryPlacement::getNodes() {
+    static const std::vector<int> nodes = readNodes();
+    return nodes;
+}
+
+#ifdef __linux__
+static bool setPolicy(void *ptr, size_t mappedSize, int mode, const std::vector<int> &nodes) {
+    const size_t bitsPerWord = sizeof(unsigned long) * CHAR_BIT;
+    const int maxNode = nodes.back() + 1;
+    std::vector<unsigned long> mask(maxNode / bitsPerWord + 1, 0);
+    for (size_t i = 0; i < nodes.size(); i++) {
+        mask[nodes[i] / bitsPerWord] |= 1UL << (nodes[i] % bitsPerWord);
+    }
+    // the kernel expects the number of bits in the mask plus one
+    long status = syscall(SYS_mbind, ptr, mappedSize, mode, mask.data(), mask.size() * bitsPerWord + 1, MMSEQS_MPOL_MF_MOVE);
+    return status == 0;
+}
+#endif
+
+bool MemoryPlacement::interleave(void *ptr, size_t mappedSize) {
+#ifdef __linux__
+    if (getNodes().size() > 1) {
+        return setPolicy(ptr, mappedSize, MMSEQS_MPOL_INTERLEAVE, getNodes());
+    }
+#endif
+    return false;
+}
+
+bool MemoryPlacement::bindToNode(void *ptr, size_t mappedSize, int node) {
+#ifdef __linux__
+    if (getNodes().size() > 1) {
+        return setPolicy(ptr, mappedSize, MMSEQS_MPOL_PREFERRED, std::vector<int>(1, node));
+    }
+#endif
+    return false;
+}
+
+size_t MemoryPlacement::nodeIndexForThread(unsigned int thread, unsigned int threads) {
+    if (threads == 0) {
+        return 0;
+    }
+    return ((size_t) thread * getNodes().size()) / threads;
+}
+
+bool MemoryPlacement::pinThreadToNode(int node) {
+#ifdef __linux__
+    char fileName[64];
+    snprintf(fileName, sizeof(fileName), "/sys/devices/system/node/node%d/cpulist", node);
+    FILE *file = fopen(fileName, "r");
+    if (file == NULL) {
+        return false;
+    }
+    // cpulist has the form 0-3,8-11
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    int from, to;
+    while (fscanf(file, "%d", &from) == 1) {
+        to = from;
+        int next = fgetc(file);
+        if (next == '-') {
+            if (fscanf(file, "%d", &to) != 1) {
+                break;
+            }
+            next = fgetc(file);
+        }
+        for (int cpu = from; cpu <= to && cpu < CPU_SETSIZE; cpu++) {
+            CPU_SET(cpu, &cpus);
+        }
+        if (next != ',') {
+            break;
+        }
+    }
+    fclose(file);
+    if (CPU_COUNT(&cpus) == 0) {
+        return false;
+    }
+    return sched_setaffinity(0, sizeof(cpu_set_t), &cpus) == 0;
+#else
+    (void) node;
+    return false;
+#endif
+}
@@ -0,0 +1,49 @@
+#ifndef MMSEQS_MEMORYPLACEMENT_H
+#define MMSEQS_MEMORYPLACEMENT_H
+
+// Allocates large lookup tables (e.g. the prefilter k-mer index) with huge pages
+// and controls on which NUMA nodes their pages are placed.
+// NUMA placement uses the mbind syscall directly, so we do not depend on libnuma.
+// Everything falls back to regular pages on the first node on systems without support.
+
+#include <cstddef>
+#include <vector>
+
+class MemoryPlacement {
+public:
+    static const int HUGE_PAGES_OFF = 0;
+    // madvise(MADV_HUGEPAGE) on a 2MB aligned mapping
+    static const int HUGE_PAGES_TRANSPARENT = 1;
+    // MAP_HUGETLB from the reserved huge page pool, needs vm.nr_hugepages
+    static const int HUGE_PAGES_2M = 2;
+    static const int HUGE_PAGES_1G = 3;
+
+    static const int NUMA_OFF = 0;
+    // spread the pages round robin over all nodes
+    static const int NUMA_INTERLEAVE = 1;
+    // keep one copy per node and pin the threads to the node of their copy
+    static const int NUMA_REPLICATE = 2;
+
+    // returns an anonymous zero initialized mapping of at least size bytes or NULL
+    // mappedSize receives the size that has to be passed to free
+    static void *allocate(size_t size, int hugePages, size_t *mappedSize);
+    static void free(void *ptr, size_t mappedSize);
+    // gives the pages that lie completely within the first size bytes of a mapping back to the system
+    // they read as zero afterwards
+    static void release(void *ptr, size_t size);
+
+    // ids of the online NUMA nodes, contains only node 0 if NUMA is not available
+    static const std::vector<int> &getNodes();
+
+    // interleaves the pages of an anonymous mapping over all nodes, already touched pages are migrated
+    static bool interleave(void *ptr, size_t mappedSize);
+    // prefers the given node for the pages of an anonymous mapping, already touched pages are migrated
+    static bool bindToNode(void *ptr, size_t mappedSize, int node);
+
+    // index into getNodes() that the thread should work on, threads are split into contiguous blocks
+    static size_t nodeIndexForThread(unsigned int thread, unsigned int threads);
+    // restricts the calling thread to the cpus of the given node
+    static bool pinThreadToNode(int node);
+};
+
+#endif //MMSEQS_MEMORYPLACEMENT_H
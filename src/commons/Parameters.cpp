@@ -47,6 +47,11 @@ Parameters::Parameters():
         PARAM_INCLUDE_IDENTITY(PARAM_INCLUDE_IDENTITY_ID,"--add-self-matches", "Include identical Seq. Id.","artificially add entries of queries with themselves (for clustering)",typeid(bool), (void *) &includeIdentity, "", MMseqsParameter::COMMAND_PREFILTER|MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
         PARAM_RES_LIST_OFFSET(PARAM_RES_LIST_OFFSET_ID,"--offset-result", "Offset result","Offset result list",typeid(int), (void *) &resListOffset, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_PREFILTER|MMseqsParameter::COMMAND_EXPERT),
         PARAM_NO_PRELOAD(PARAM_NO_PRELOAD_ID, "--no-preload", "No preload", "Do not preload database", typeid(bool), (void*) &noPreload, "", MMseqsParameter::COMMAND_MISC|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_COMPRESSED(PARAM_COMPRESSED_ID, "--compressed", "Compressed", "write compressed output, each entry is deflated with a dictionary trained on the database [0,1]", typeid(int), (void*) &compressed, "^[0-1]{1}$", MMseqsParameter::COMMAND_MISC|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_HUGE_PAGES(PARAM_HUGE_PAGES_ID, "--huge-pages", "Huge pages", "huge pages for the k-mer index table: 0: off, 1: transparent, 2: explicit 2MB, 3: explicit 1GB [0-3]", typeid(int), (void*) &hugePages, "^[0-3]{1}$", MMseqsParameter::COMMAND_PREFILTER|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_NUMA_MODE(PARAM_NUMA_MODE_ID, "--numa-mode", "NUMA mode", "placement of the k-mer index table: 0: off, 1: interleave over all nodes, 2: one copy per node with pinned threads [0-2]", typeid(int), (void*) &numaMode, "^[0-2]{1}$", MMseqsParameter::COMMAND_PREFILTER|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_COMPRESS_INDEX(PARAM_COMPRESS_INDEX_ID, "--compress-index", "Compress index", "delta encode the sequence lists of the k-mer index table, needs less memory and fewer splits [0,1]", typeid(int), (void*) &compressIndex, "^[0-1]{1}$", MMseqsParameter::COMMAND_PREFILTER|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_QUERY_BATCH_SIZE(PARAM_QUERY_BATCH_SIZE_ID, "--query-batch-size", "Query batch size", "number of queries whose k-mer lists are read from the index table together, 1 matches each query separately [1,inf]", typeid(int), (void*) &queryBatchSize, "^[1-9]{1}[0-9]*$", MMseqsParameter::COMMAND_PREFILTER|MMseqsParameter::COMMAND_EXPERT),
         // alignment
         PARAM_ALIGNMENT_MODE(PARAM_ALIGNMENT_MODE_ID,"--alignment-mode", "Alignment mode", "How to compute the alignment: 0: automatic; 1: only score and end_pos; 2: also start_pos and cov; 3: also seq.id; 4: only ungapped alignment",typeid(int), (void *) &alignmentMode, "^[0-4]{1}$", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
         PARAM_E(PARAM_E_ID,"-e", "E-value threshold", "list matches below this E-value [0.0, inf]",typeid(float), (void *) &evalThr, "^([-+]?[0-9]*\\.?[0-9]+([eE][-+]?[0-9]+)?)|[0-9]*(\\.[0-9]+)?$", MMseqsParameter::COMMAND_ALIGN),
@@ -61,6 +66,14 @@ Parameters::Parameters():
         PARAM_MIN_SEQ_ID(PARAM_MIN_SEQ_ID_ID,"--min-seq-id", "Seq. Id Threshold","list matches above this sequence identity (for clustering) [0.0,1.0]",typeid(float), (void *) &seqIdThr, "^0(\\.[0-9]+)?|1(\\.0+)?$", MMseqsParameter::COMMAND_ALIGN),
 	    PARAM_SCORE_BIAS(PARAM_SCORE_BIAS_ID,"--score-bias", "Score bias", "Score bias when computing the SW alignment (in bits)",typeid(float), (void *) &scoreBias, "^-?[0-9]*(\\.[0-9]+)?$", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
         PARAM_ALT_ALIGNMENT(PARAM_ALT_ALIGNMENT_ID,"--alt-ali", "Alternative alignments","Show up to this many alternative alignments",typeid(int), (void *) &altAlignment, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN),
+        PARAM_BINARY_RESULT(PARAM_BINARY_RESULT_ID, "--binary-result", "Binary result", "write alignment results as binary records (convert to text with mmseqs convertalis or createtsv)", typeid(bool), (void *) &binaryResult, "", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_ALIGN_TILE_SIZE(PARAM_ALIGN_TILE_SIZE_ID, "--align-tile-size", "Alignment tile size", "align blocks of this many queries together, their hits are aligned in target order so that each target is read once per block (0: align query by query)", typeid(int), (void *) &alignTileSize, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_XDROP_BAND(PARAM_XDROP_BAND_ID, "--xdrop-band", "X-drop band width", "align prefilter hits in a band of this many diagonals on each side of the prefilter diagonal and stop at the X-drop, hits whose alignment reaches the band boundary are realigned with full Smith-Waterman. Needs prefilter diagonals (--diag-score 1) (0: full Smith-Waterman)", typeid(int), (void *) &xdropBand, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_XDROP(PARAM_XDROP_ID, "--xdrop", "X-drop", "stop the banded alignment when the best score of a query position drops this far below the best score (in bits)", typeid(float), (void *) &xdrop, "^[0-9]*(\\.[0-9]+)?$", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_EXTENSION_WINDOW(PARAM_EXTENSION_WINDOW_ID, "--extension-window", "Extension window", "extend nucleotide alignments in windows of this many residues with a moving band, so that the memory per thread is bounded by the window instead of the sequence length. Only used for sequences longer than the window (0: extend in one piece)", typeid(int), (void *) &extensionWindow, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_ALIGNMENT_CACHE(PARAM_ALIGNMENT_CACHE_ID, "--alignment-cache", "Alignment cache", "database of alignment results that is read and updated by each run, pairs of unchanged sequences that were aligned with the same parameters before are not aligned again (only for sequence queries and targets)", typeid(std::string), (void *) &alignmentCache, "", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_ALIGNMENT_CACHE_AGE(PARAM_ALIGNMENT_CACHE_AGE_ID, "--alignment-cache-age", "Alignment cache age", "number of runs after which results of the alignment cache that were not used are dropped (0: keep only the results of the last run)", typeid(int), (void *) &alignmentCacheAge, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_SEQ_CACHE_LIMIT(PARAM_SEQ_CACHE_LIMIT_ID, "--seq-cache-limit", "Sequence cache limit", "maximum memory in megabyte for target sequences that are kept encoded between their hits, targets beyond the limit are encoded again for every hit (0: no cache)", typeid(int), (void *) &seqCacheLimit, "^[0-9]{1}[0-9]*$", MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_EXPERT),
 
         // clustering
         PARAM_CLUSTER_MODE(PARAM_CLUSTER_MODE_ID,"--cluster-mode", "Cluster mode", "0: Setcover, 1: connected component, 2: Greedy clustering by sequence length  3: Greedy clustering by sequence length (low mem)",typeid(int), (void *) &clusteringMode, "[0-3]{1}$", MMseqsParameter::COMMAND_CLUST),
@@ -69,6 +82,7 @@ Parameters::Parameters():
         // affinity clustering
         PARAM_MAXITERATIONS(PARAM_MAXITERATIONS_ID,"--max-iterations", "Max depth connected component", "maximum depth of breadth first search in connected component",typeid(int), (void *) &maxIteration,  "^[1-9]{1}[0-9]*$", MMseqsParameter::COMMAND_CLUST|MMseqsParameter::COMMAND_EXPERT),
         PARAM_SIMILARITYSCORE(PARAM_SIMILARITYSCORE_ID,"--similarity-type", "Similarity type", "type of score used for clustering [1:2]. 1=alignment score. 2=sequence identity ",typeid(int),(void *) &similarityScoreType,  "^[1-2]{1}$", MMseqsParameter::COMMAND_CLUST|MMseqsParameter::COMMAND_EXPERT),
+        PARAM_CLUSTER_GRAPH_DIR(PARAM_CLUSTER_GRAPH_DIR_ID,"--cluster-graph-dir", "Cluster graph directory", "keep the alignment graph in files in this directory that are mapped into memory, so that graphs larger than the main memory can be clustered (empty: keep the graph in memory)",typeid(std::string), (void *) &clusterGraphDir, "", MMseqsParameter::COMMAND_CLUST|MMseqsParameter::COMMAND_EXPERT),
         // logging
         PARAM_V(PARAM_V_ID,"-v", "Verbosity","verbosity level: 0=nothing, 1: +errors, 2: +warnings, 3: +info",typeid(int), (void *) &verbosity, "^[0-3]{1}$", MMseqsParameter::COMMAND_COMMON),
         // create profile (HMM)
@@ -216,6 +230,14 @@ Parameters::Parameters():
     align.push_back(PARAM_MIN_SEQ_ID);
     align.push_back(PARAM_SEQ_ID_MODE);
     align.push_back(PARAM_ALT_ALIGNMENT);
+    align.push_back(PARAM_BINARY_RESULT);
+    align.push_back(PARAM_ALIGN_TILE_SIZE);
+    align.push_back(PARAM_XDROP_BAND);
+    align.push_back(PARAM_XDROP);
+    align.push_back(PARAM_EXTENSION_WINDOW);
+    align.push_back(PARAM_ALIGNMENT_CACHE);
+    align.push_back(PARAM_ALIGNMENT_CACHE_AGE);
+    align.push_back(PARAM_SEQ_CACHE_LIMIT);
     align.push_back(PARAM_C);
     align.push_back(PARAM_COV_MODE);
     align.push_back(PARAM_MAX_SEQ_LEN);
@@ -226,6 +248,7 @@ Parameters::Parameters():
     align.push_back(PARAM_MAX_ACCEPT);
     align.push_back(PARAM_INCLUDE_IDENTITY);
     align.push_back(PARAM_NO_PRELOAD);
+    align.push_back(PARAM_COMPRESSED);
     align.push_back(PARAM_PCA);
     align.push_back(PARAM_PCB);
     align.push_back(PARAM_SCORE_BIAS);
@@ -254,6 +277,10 @@ Parameters::Parameters():
     prefilter.push_back(PARAM_INCLUDE_IDENTITY);
     prefilter.push_back(PARAM_SPACED_KMER_MODE);
     prefilter.push_back(PARAM_NO_PRELOAD);
+    prefilter.push_back(PARAM_HUGE_PAGES);
+    prefilter.push_back(PARAM_NUMA_MODE);
+    prefilter.push_back(PARAM_COMPRESS_INDEX);
+    prefilter.push_back(PARAM_QUERY_BATCH_SIZE);
     prefilter.push_back(PARAM_PCA);
     prefilter.push_back(PARAM_PCB);
     prefilter.push_back(PARAM_THREADS);
@@ -273,6 +300,7 @@ Parameters::Parameters():
     clust.push_back(PARAM_CLUSTER_MODE);
     clust.push_back(PARAM_MAXITERATIONS);
     clust.push_back(PARAM_SIMILARITYSCORE);
+    clust.push_back(PARAM_CLUSTER_GRAPH_DIR);
     clust.push_back(PARAM_THREADS);
     clust.push_back(PARAM_V);
 
@@ -305,6 +333,7 @@ Parameters::Parameters():
     alignbykmer.push_back(PARAM_COV_MODE);
     alignbykmer.push_back(PARAM_MIN_SEQ_ID);
     alignbykmer.push_back(PARAM_INCLUDE_IDENTITY);
+    alignbykmer.push_back(PARAM_SEQ_CACHE_LIMIT);
     alignbykmer.push_back(PARAM_THREADS);
     alignbykmer.push_back(PARAM_V);
 
@@ -404,6 +433,7 @@ Parameters::Parameters():
     result2msa.push_back(PARAM_SUMMARY_PREFIX);
     result2msa.push_back(PARAM_OMIT_CONSENSUS);
     result2msa.push_back(PARAM_SKIP_QUERY);
+    result2msa.push_back(PARAM_SEQ_CACHE_LIMIT);
     //result2msa.push_back(PARAM_FIRST_SEQ_REP_SEQ);
     result2msa.push_back(PARAM_V);
 
@@ -491,10 +521,13 @@ Parameters::Parameters():
     createdb.push_back(PARAM_DONT_SPLIT_SEQ_BY_LEN);
     createdb.push_back(PARAM_DONT_SHUFFLE);
     createdb.push_back(PARAM_ID_OFFSET);
+    createdb.push_back(PARAM_COMPRESSED);
+    createdb.push_back(PARAM_THREADS);
     createdb.push_back(PARAM_V);
 
     // convert2fasta
     convert2fasta.push_back(PARAM_USE_HEADER_FILE);
+    convert2fasta.push_back(PARAM_THREADS);
     convert2fasta.push_back(PARAM_V);
 
     // result2flat
@@ -684,6 +717,8 @@ Parameters::Parameters():
     searchworkflow.push_back(PARAM_SLICE_SEARCH);
     searchworkflow.push_back(PARAM_RUNNER);
     searchworkflow.push_back(PARAM_REMOVE_TMP_FILES);
+    // the workflow scripts move result databases without their .zdict files
+    searchworkflow = removeParameter(searchworkflow, PARAM_COMPRESSED);
 
     // easysearch
     easysearchworkflow = combineList(searchworkflow, convertalignments);
@@ -701,6 +736,7 @@ Parameters::Parameters():
     linclustworkflow = combineList(linclustworkflow, rescorediagonal);
     linclustworkflow.push_back(PARAM_REMOVE_TMP_FILES);
     linclustworkflow.push_back(PARAM_RUNNER);
+    linclustworkflow = removeParameter(linclustworkflow, PARAM_COMPRESSED);
 
 
     // assembler workflow
@@ -718,27 +754,33 @@ Parameters::Parameters():
     clusteringWorkflow.push_back(PARAM_REMOVE_TMP_FILES);
     clusteringWorkflow.push_back(PARAM_RUNNER);
     clusteringWorkflow = combineList(clusteringWorkflow, linclustworkflow);
+    clusteringWorkflow = removeParameter(clusteringWorkflow, PARAM_COMPRESSED);
 
     // taxonomy
     taxonomy = combineList(searchworkflow, lca);
     taxonomy.push_back(PARAM_LCA_MODE);
     taxonomy.push_back(PARAM_REMOVE_TMP_FILES);
     taxonomy.push_back(PARAM_RUNNER);
+    // filterdb and lca only read text results
+    taxonomy = removeParameter(taxonomy, PARAM_BINARY_RESULT);
 
     // multi hit db
     multihitdb = combineList(createdb, extractorfs);
     multihitdb = combineList(multihitdb, extractorfs);
     multihitdb = combineList(multihitdb, translatenucs);
     multihitdb = combineList(multihitdb, result2stats);
+    multihitdb = removeParameter(multihitdb, PARAM_COMPRESSED);
 
     // multi hit search
     multihitsearch = combineList(searchworkflow, besthitbyset);
+    multihitsearch = removeParameter(multihitsearch, PARAM_BINARY_RESULT);
 
     clusterUpdateSearch = removeParameter(searchworkflow, PARAM_MAX_SEQS);
     clusterUpdateClust = removeParameter(clusteringWorkflow,PARAM_MAX_SEQS);
     clusterUpdate = combineList(clusterUpdateSearch, clusterUpdateClust);
     clusterUpdate.push_back(PARAM_USESEQID);
     clusterUpdate.push_back(PARAM_RECOVER_DELETED);
+    clusterUpdate = removeParameter(clusterUpdate, PARAM_BINARY_RESULT);
 
     mapworkflow = combineList(prefilter, rescorediagonal);
     mapworkflow = combineList(mapworkflow, extractorfs);
@@ -1217,16 +1259,30 @@ void Parameters::setDefaults() {
     altAlignment = 0;
     addBacktrace = false;
     realign = false;
+    binaryResult = false;
+    alignTileSize = 0;
+    xdropBand = 0;
+    xdrop = 25.0;
+    extensionWindow = 0;
+    alignmentCache = "";
+    alignmentCacheAge = 3;
+    seqCacheLimit = 1024;
     clusteringMode = SET_COVER;
     cascaded = true;
     clusterSteps = 3;
     resListOffset = 0;
     noPreload = false;
+    compressed = 0;
+    hugePages = 0;
+    numaMode = 0;
+    compressIndex = 0;
+    queryBatchSize = 16;
     scoreBias = 0.0;
 
     // affinity clustering
     maxIteration=1000;
     similarityScoreType=APC_SEQID;
+    clusterGraphDir = "";
 
     // workflow
     const char *runnerEnv = getenv("RUNNER");
@@ -203,6 +203,11 @@ public:
     bool   splitAA;                      // Split database by amino acid count instead
     size_t resListOffset;                // Offsets result list
     bool   noPreload;                    // Do not preload database into memory
+    int    compressed;                   // Write compressed databases
+    int    hugePages;                    // Huge page mode for the k-mer index table
+    int    numaMode;                     // NUMA placement of the k-mer index table
+    int    compressIndex;                // Delta encode the sequence lists of the k-mer index table
+    int    queryBatchSize;               // Queries that share one pass over the k-mer index table
     float  scoreBias;			 // Add this bias to the score when computing the alignements
 
     // ALIGNMENT
@@ -219,6 +224,14 @@ public:
     float  seqIdThr;                     // sequence identity threshold for acceptance
     bool   addBacktrace;                 // store backtrace string (M=Match, D=deletion, I=insertion)
     bool   realign;                      // realign hit with more conservative score
+    bool   binaryResult;                 // write alignment results as fixed-width binary records
+    int    alignTileSize;                // align blocks of this many queries with their hits sorted by target
+    int    xdropBand;                    // band width around the prefilter diagonal for the X-drop alignment
+    float  xdrop;                        // X-drop of the banded alignment (in bits)
+    int    extensionWindow;              // window of the bounded-memory nucleotide extension
+    std::string alignmentCache;          // database of alignment results reused across runs
+    int    alignmentCacheAge;            // runs after which unused alignment cache results are dropped
+    int    seqCacheLimit;                // megabytes of encoded target sequences kept between hits
 	
     // workflow
     std::string runner;
@@ -240,6 +253,7 @@ public:
     //CLUSTERING
     int maxIteration;                   // Maximum depth of breadth first search in connected component
     int similarityScoreType;            // Type of score to use for reassignment 1=alignment score. 2=coverage 3=sequence identity 4=E-value 5= Score per Column
+    std::string clusterGraphDir;        // directory for the mapped alignment graph of the clustering
 
     //extractorfs
     int orfMinLength;
@@ -447,6 +461,11 @@ public:
     PARAMETER(PARAM_INCLUDE_IDENTITY)
     PARAMETER(PARAM_RES_LIST_OFFSET)
     PARAMETER(PARAM_NO_PRELOAD)
+    PARAMETER(PARAM_COMPRESSED)
+    PARAMETER(PARAM_HUGE_PAGES)
+    PARAMETER(PARAM_NUMA_MODE)
+    PARAMETER(PARAM_COMPRESS_INDEX)
+    PARAMETER(PARAM_QUERY_BATCH_SIZE)
     std::vector<MMseqsParameter> prefilter;
     std::vector<MMseqsParameter> ungappedprefilter;
 
@@ -463,6 +482,14 @@ public:
     PARAMETER(PARAM_MIN_SEQ_ID)
     PARAMETER(PARAM_SCORE_BIAS)
     PARAMETER(PARAM_ALT_ALIGNMENT)
+    PARAMETER(PARAM_BINARY_RESULT)
+    PARAMETER(PARAM_ALIGN_TILE_SIZE)
+    PARAMETER(PARAM_XDROP_BAND)
+    PARAMETER(PARAM_XDROP)
+    PARAMETER(PARAM_EXTENSION_WINDOW)
+    PARAMETER(PARAM_ALIGNMENT_CACHE)
+    PARAMETER(PARAM_ALIGNMENT_CACHE_AGE)
+    PARAMETER(PARAM_SEQ_CACHE_LIMIT)
     std::vector<MMseqsParameter> align;
 
     // clustering
@@ -473,6 +500,7 @@ public:
     // affinity clustering
     PARAMETER(PARAM_MAXITERATIONS)
     PARAMETER(PARAM_SIMILARITYSCORE)
+    PARAMETER(PARAM_CLUSTER_GRAPH_DIR)
 
     // logging
     PARAMETER(PARAM_V)
@@ -0,0 +1,123 @@
+#include "ResultCursor.h"
+#include "Util.h"
+#include "Debug.h"
+
+#include <cstring>
+#include <algorithm>
+
+ResultCursor::ResultCursor(DBReader<unsigned int> *reader)
+        : reader(reader), binary(reader->getDbtype() == Sequence::ALIGNMENT_RES_BINARY),
+          pos(NULL), end(NULL), lastHasDiagonal(false) {}
+
+ResultCursor::ResultCursor(bool binary)
+        : reader(NULL), binary(binary), pos(NULL), end(NULL), lastHasDiagonal(false) {}
+
+void ResultCursor::requireText(const std::string &dataFileName) {
+    if (DBReader<unsigned int>::parseDbType(dataFileName.c_str()) == Sequence::ALIGNMENT_RES_BINARY) {
+        Debug(Debug::ERROR) << dataFileName << " contains binary alignment results, which this module cannot read.\n";
+        Debug(Debug::ERROR) << "Compute the alignment without --binary-result to get text results.\n";
+        EXIT(EXIT_FAILURE);
+    }
+}
+
+size_t ResultCursor::maxRecordCount() {
+    if (binary == false) {
+        return reader->maxCount('\n');
+    }
+    size_t max = 0;
+    for (size_t id = 0; id < reader->getSize(); id++) {
+        char *data = reader->getData(id, buffer);
+        if (data != NULL) {
+            max = std::max(max, Matcher::countBinaryAlignmentResults(data, std::max(reader->getSeqLens(id), (size_t) 1) - 1));
+        }
+    }
+    return max;
+}
+
+void ResultCursor::reset(size_t id) {
+    char *data = reader->getData(id, buffer);
+    // the entry length includes the terminating null byte
+    reset(data, (data == NULL) ? 0 : std::max(reader->getSeqLens(id), (size_t) 1) - 1);
+}
+
+void ResultCursor::reset(char *data, size_t dataSize) {
+    pos = data;
+    end = data + dataSize;
+    lastHasDiagonal = false;
+}
+
+void ResultCursor::skipLine(char *position) {
+    // memchr scans for the line end with vector instructions
+    char *lineEnd = (position < end) ? (char *) memchr(position, '\n', end - position) : NULL;
+    pos = (lineEnd == NULL) ? end : lineEnd + 1;
+}
+
+bool ResultCursor::next(hit_t &hit) {
+    if (hasNext() == false) {
+        return false;
+    }
+    if (binary) {
+        Matcher::binary_result_t record;
+        memcpy(&record, pos, sizeof(Matcher::binary_result_t));
+        hit.seqId = record.dbKey;
+        hit.pScore = static_cast<float>(record.score);
+        hit.diagonal = 0;
+        hit.prefScore = 0;
+        lastHasDiagonal = false;
+        pos += sizeof(Matcher::binary_result_t) + record.backtraceLen;
+        return true;
+    }
+
+    // a prefilter line has three columns, only the first columns of longer lines are split
+    char *words[4];
+    const size_t columns = Util::getWordsOfLine(pos, words, 4);
+    hit.seqId = Util::fast_atoi<unsigned int>(pos);
+    hit.pScore = (columns > 1) ? static_cast<float>(Util::fast_atoi<int>(words[1])) : 0.0f;
+    lastHasDiagonal = (columns == 3);
+    hit.diagonal = lastHasDiagonal ? static_cast<unsigned short>(Util::fast_atoi<short>(words[2])) : 0;
+    hit.prefScore = 0;
+    skipLine((columns < 4) ? words[columns] : words[3]);
+    return true;
+}
+
+bool ResultCursor::next(Matcher::result_t &result, bool readCompressed, bool readBacktrace) {
+    if (hasNext() == false) {
+        return false;
+    }
+    if (binary) {
+        pos += Matcher::parseBinaryAlignmentRecord(pos, result, readCompressed, readBacktrace);
+        return true;
+    }
+
+    char *entry[Matcher::ALN_RES_WITH_BT_COL_CNT + 1];
+    const size_t columns = Util::getWordsOfLine(pos, entry, Matcher::ALN_RES_WITH_BT_COL_CNT + 1);
+    if (columns >= (size_t) Matcher::ALN_RES_WITH_OUT_BT_COL_CNT) {
+        Matcher::parseAlignmentColumns(entry, columns, result, readCompressed, readBacktrace);
+    } else {
+        result = Matcher::result_t(Util::fast_atoi<unsigned int>(pos),
+                                   (columns > 1) ? Util::fast_atoi<int>(entry[1]) : 0,
+                                   0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, "");
+    }
+    skipLine((columns <= Matcher::ALN_RES_WITH_BT_COL_CNT) ? entry[columns] : entry[Matcher::ALN_RES_WITH_BT_COL_CNT]);
+    return true;
+}
+
+bool ResultCursor::nextKey(unsigned int &key) {
+    if (hasNext() == false) {
+        return false;
+    }
+    if (binary) {
+        Matcher::binary_result_t record;
+        memcpy(&record, pos, sizeof(Matcher::binary_result_t));
+        key = record.dbKey;
+        pos += sizeof(Matcher::binary_result_t) + record.backtraceLen;
+        return true;
+    }
+    char *keyEnd = pos;
+    key = Util::fast_atoi<unsigned int>(pos);
+    while (*keyEnd >= '0' && *keyEnd <= '9') {
+        keyEnd++;
+    }
+    skipLine(keyEnd);
+    return true;
+}
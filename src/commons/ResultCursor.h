@@ -0,0 +1,88 @@
+#ifndef MMSEQS_RESULTCURSOR_H
+#define MMSEQS_RESULTCURSOR_H
+
+// Typed reading of the records of a prefilter or alignment result entry.
+// Binary alignment results (Sequence::ALIGNMENT_RES_BINARY) are copied out of their fixed-width records,
+// text entries are split into columns in a single pass over each line.
+//
+// DBReader<unsigned int> reader(...);
+// ResultCursor cursor(&reader);
+// cursor.reset(id);
+// hit_t hit;
+// while (cursor.next(hit)) { ... }
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "DBReader.h"
+#include "Matcher.h"
+#include "QueryMatcher.h"
+
+class ResultCursor {
+public:
+    // the record layout is taken from the database type
+    explicit ResultCursor(DBReader<unsigned int> *reader);
+    // for entries that do not come from a reader
+    explicit ResultCursor(bool binary);
+
+    // exits with an error if the database holds binary alignment results,
+    // for modules that only parse text records
+    static void requireText(const std::string &dataFileName);
+
+    // largest number of records in an entry of the reader
+    size_t maxRecordCount();
+
+    // positions the cursor at the first record of entry id of the reader
+    // entries of compressed databases are inflated into a buffer of the cursor, that is reused by the next reset
+    void reset(size_t id);
+
+    // dataSize is the size without a terminating null byte
+    void reset(char *data, size_t dataSize);
+
+    bool isBinary() const {
+        return binary;
+    }
+
+    bool hasNext() const {
+        return binary ? (end - pos) >= (ptrdiff_t) sizeof(Matcher::binary_result_t) : (pos < end && *pos != '\0');
+    }
+
+    // start of the next record, records between two positions can be copied verbatim
+    char *getPosition() const {
+        return pos;
+    }
+
+    void setPosition(char *position) {
+        pos = position;
+    }
+
+    // reads the next record as prefilter hit, returns false if there is none
+    // alignment records only fill seqId and pScore (with the alignment score), hasDiagonal() tells them apart
+    bool next(hit_t &hit);
+
+    // reads the next record as alignment result, returns false if there is none
+    // text lines without the alignment columns (prefilter hits) only fill dbKey and score
+    bool next(Matcher::result_t &result, bool readCompressed = false, bool readBacktrace = true);
+
+    // skips the next record and returns only its key
+    bool nextKey(unsigned int &key);
+
+    // the last record read by next(hit_t &) was a prefilter hit with a diagonal
+    bool hasDiagonal() const {
+        return lastHasDiagonal;
+    }
+
+private:
+    DBReader<unsigned int> *reader;
+    const bool binary;
+    std::vector<char> buffer;
+    char *pos;
+    char *end;
+    bool lastHasDiagonal;
+
+    // moves pos behind the line that contains position
+    void skipLine(char *position);
+};
+
+#endif //MMSEQS_RESULTCURSOR_H
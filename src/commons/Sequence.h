@@ -176,6 +176,8 @@ public:
     static const int HMM_PROFILE = 2;
     static const int PROFILE_STATE_SEQ = 3;
     static const int PROFILE_STATE_PROFILE = 4;
+    // alignment result database of Matcher::binary_result_t records
+    static const int ALIGNMENT_RES_BINARY = 5;
 
     // submat
     BaseMatrix * subMat;
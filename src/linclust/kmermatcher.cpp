@@ -7,7 +7,6 @@
 #include "Matcher.h"
 #include "Debug.h"
 #include "DBReader.h"
-#include "omptl/omptl_algorithm"
 #include "MathUtil.h"
 #include "FileUtil.h"
 #include "NucleotideMatrix.h"
@@ -15,14 +14,14 @@
 #include "FileUtil.h"
 #include "Timer.h"
 #include "tantan.h"
+#include "kmermatcher.h"
+#include "simd.h"
 
 #include <limits>
 #include <string>
 #include <vector>
 #include <iomanip>
 #include <algorithm>
-#include <queue>
-#include <sys/mman.h>
 #ifdef OPENMP
 #include <omp.h>
 #endif
@@ -30,76 +29,20 @@
 #ifndef SIZE_T_MAX
 #define SIZE_T_MAX ((size_t) -1)
 #endif
-struct KmerPosition {
-    size_t kmer;
-    unsigned int id;
-    unsigned short seqLen;
-    short pos;
-    KmerPosition(){}
-    KmerPosition(size_t kmer, unsigned int id, unsigned short seqLen, short pos):
-            kmer(kmer), id(id), seqLen(seqLen), pos(pos) {}
-    static bool compareRepSequenceAndIdAndPos(const KmerPosition &first, const KmerPosition &second){
-        if(first.kmer < second.kmer )
-            return true;
-        if(second.kmer < first.kmer )
-            return false;
-        if(first.seqLen > second.seqLen )
-            return true;
-        if(second.seqLen > first.seqLen )
-            return false;
-        if(first.id < second.id )
-            return true;
-        if(second.id < first.id )
-            return false;
-        if(first.pos < second.pos )
-            return true;
-        if(second.pos < first.pos )
-            return false;
-        return false;
-    }
-
-    static bool compareRepSequenceAndIdAndDiag(const KmerPosition &first, const KmerPosition &second){
-        if(first.kmer < second.kmer)
-            return true;
-        if(second.kmer < first.kmer)
-            return false;
-        if(first.id < second.id)
-            return true;
-        if(second.id < first.id)
-            return false;
-
-        //        const short firstDiag  = (first.pos < 0)  ? -first.pos : first.pos;
-        //        const short secondDiag = (second.pos  < 0) ? -second.pos : second.pos;
-        if(first.pos < second.pos)
-            return true;
-        if(second.pos < first.pos)
-            return false;
-        return false;
-    }
-};
-
-struct __attribute__((__packed__)) KmerEntry {
-    unsigned int seqId;
-    short diagonal;
-};
-
-void mergeKmerFilesAndOutput(DBReader<unsigned int> & seqDbr, DBWriter & dbw,
-                             std::vector<std::string> tmpFiles, std::vector<char> &repSequence,
-                             int covMode, float covThr) ;
 
 void setKmerLengthAndAlphabet(Parameters &parameters, size_t aaDbSize, int seqType);
 
-void writeKmersToDisk(std::string tmpFile, KmerPosition *kmers, size_t totalKmers);
-
 void writeKmerMatcherResult(DBReader<unsigned int> & seqDbr, DBWriter & dbw,
                             KmerPosition *hashSeqPair, size_t totalKmers,
                             std::vector<char> &repSequence, int covMode, float covThr,
                             size_t threads);
 
 
+static const short unsigned CIRC_HASH_RAND[21] = {0x4567, 0x23c6, 0x9869, 0x4873, 0xdc51, 0x5cff, 0x944a, 0x58ec, 0x1f29, 0x7ccd, 0x58ba, 0xd7ab, 0x41f2, 0x1efb, 0xa9e3, 0xe146, 0x007c, 0x62c2, 0x0854, 0x27f8, 0x231b};
+
 #define RoL(val, numbits) (val << numbits) ^ (val >> (32 - numbits))
 unsigned circ_hash(const int * x, unsigned length, const unsigned rol){
-    short unsigned RAND[21] = {0x4567, 0x23c6, 0x9869, 0x4873, 0xdc51, 0x5cff, 0x944a, 0x58ec, 0x1f29, 0x7ccd, 0x58ba, 0xd7ab, 0x41f2, 0x1efb, 0xa9e3, 0xe146, 0x007c, 0x62c2, 0x0854, 0x27f8, 0x231b};
+    const short unsigned *RAND = CIRC_HASH_RAND;
     short unsigned h = 0x0;
     h = h^ RAND[x[0]];                  // XOR h and ki
     for (unsigned int i = 1; i < length; ++i){
@@ -111,7 +54,7 @@ unsigned circ_hash(const int * x, unsigned length, const unsigned rol){
 
 // Rolling hash for CRC variant: compute hash value for next key x[0:length-1] from previous hash value hash( x[-1:length-2] ) and x_first = x[-1]
 unsigned circ_hash_next(const int * x, unsigned length, int x_first, short unsigned h, const unsigned rol){
-    short unsigned RAND[21] = {0x4567, 0x23c6, 0x9869, 0x4873, 0xdc51, 0x5cff, 0x944a, 0x58ec, 0x1f29, 0x7ccd, 0x58ba, 0xd7ab, 0x41f2, 0x1efb, 0xa9e3, 0xe146, 0x007c, 0x62c2, 0x0854, 0x27f8, 0x231b};
+    const short unsigned *RAND = CIRC_HASH_RAND;
     h ^= RoL(RAND[x_first], (5*(length-1)) % 16); // undo INITIAL_VALUE and first letter x[0] of old key
     h =  RoL(h, rol); // circularly permute all letters x[1:length-1] to 5 positions to left
     h ^= RAND[x[length-1]]; // add new, last letter of new key x[1:length]
@@ -119,12 +62,177 @@ unsigned circ_hash_next(const int * x, unsigned length, int x_first, short unsig
 }
 #undef RoL
 
+// Computes kmerHash[j] = circ_hash_next(...) of the k-mers starting at the positions 1 to L - k of x, as if rolled from
+// circ_hash of the k-mer at position 0. Since the 16 bit hash is shifted rol bits to the left per position, a
+// residue does not contribute anymore after 16 / rol positions. Beyond that the hashes are independent of each other
+// and are computed for VECSIZE_INT * 2 positions at once.
+// residueHash and kmerHash need space for L + VECSIZE_INT * 2 elements.
+void computeKmerHashes(const int *x, int L, int kmerSize, unsigned int rol,
+                       unsigned short *residueHash, unsigned short *kmerHash) {
+    const int lastPos = L - kmerSize;
+    if (lastPos < 1) {
+        return;
+    }
+    unsigned short h = circ_hash(x, kmerSize, rol);
+    const unsigned int firstShift = (5 * (kmerSize - 1)) % 16;
+    // the shifts of circ_hash_next are rotations of 32 bit integers outside of this range
+    const bool independent = rol >= 1 && rol <= 16 && firstShift >= 1;
+    // first position that does not depend on the hash of position 0
+    const int firstIndependent = independent ? static_cast<int>((16 + rol - 1) / rol) : lastPos + 1;
+    for (int j = 1; j <= lastPos && j < firstIndependent; j++) {
+        h = circ_hash_next(x + j, kmerSize, x[j - 1], h, rol);
+        kmerHash[j] = h;
+    }
+    if (firstIndependent > lastPos) {
+        return;
+    }
+    for (int i = 0; i < L; i++) {
+        residueHash[i] = CIRC_HASH_RAND[x[i]];
+    }
+    // hash(j) = XOR_t RAND[x[j+k-1-t]] << t*rol ^ XOR_t RAND[x[j-1-t]] << firstShift+(t+1)*rol, shifts >= 16 drop out
+    const int terms = firstIndependent;
+    for (int j = firstIndependent; j <= lastPos; j += VECSIZE_INT * 2) {
+        simd_int hash = simdi_loadu((simd_int *) (residueHash + j + kmerSize - 1));
+        for (int t = 1; t < terms; t++) {
+            const simd_int last = simdi_loadu((simd_int *) (residueHash + j + kmerSize - 1 - t));
+            hash = simdi_xor(hash, simdi16_slli(last, t * rol));
+        }
+        for (int t = 0; t < terms - 1; t++) {
+            const simd_int first = simdi_loadu((simd_int *) (residueHash + j - 1 - t));
+            hash = simdi_xor(hash, simdi16_slli(first, firstShift + (t + 1) * rol));
+        }
+        simdi_storeu((simd_int *) (kmerHash + j), hash);
+    }
+}
+
+// collects the k-mers of fillKmerPositionArray in one array
+class KmerPositionArray {
+public:
+    static const size_t BUFFER_SIZE = 1024;
+
+    KmerPositionArray(KmerPosition *hashSeqPair) : hashSeqPair(hashSeqPair), offset(0) {}
+
+    bool keep(size_t) const {
+        return true;
+    }
+
+    void write(const KmerPosition *kmers, size_t count) {
+        size_t writeOffset = __sync_fetch_and_add(&offset, count);
+        memcpy(hashSeqPair + writeOffset, kmers, sizeof(KmerPosition) * count);
+    }
+
+    size_t getCount() const {
+        return offset;
+    }
+
+private:
+    KmerPosition *hashSeqPair;
+    size_t offset;
+};
+
+// partitions k-mer positions by kmer % buckets into the files <prefix>_<bucket>
+// only the buckets of this process (bucket % procs == rank) are kept, files are created on the first write
+class KmerPositionFiles {
+public:
+    static const size_t BUFFER_SIZE = 65536;
+
+    KmerPositionFiles(const std::string &prefix, size_t buckets, size_t rank, size_t procs)
+            : prefix(prefix), buckets(buckets), rank(rank), procs(procs), files(buckets, NULL) {}
+
+    ~KmerPositionFiles() {
+        for (size_t bucket = 0; bucket < buckets; bucket++) {
+            if (files[bucket] != NULL && fclose(files[bucket]) != 0) {
+                Debug(Debug::ERROR) << "Could not close " << getFileName(bucket) << "\n";
+                EXIT(EXIT_FAILURE);
+            }
+        }
+    }
+
+    bool keep(size_t kmer) const {
+        return (kmer % buckets) % procs == rank;
+    }
+
+    std::string getFileName(size_t bucket) const {
+        return prefix + "_" + SSTR(bucket);
+    }
+
+    void write(const KmerPosition *kmers, size_t count) {
+        std::vector<size_t> offsets(buckets + 1);
+        std::vector<KmerPosition> partitioned(std::min(count, BUFFER_SIZE));
+        for (size_t start = 0; start < count; start += BUFFER_SIZE) {
+            const size_t end = std::min(count, start + BUFFER_SIZE);
+            std::fill(offsets.begin(), offsets.end(), 0);
+            for (size_t i = start; i < end; i++) {
+                offsets[kmers[i].kmer % buckets + 1]++;
+            }
+            for (size_t bucket = 0; bucket < buckets; bucket++) {
+                offsets[bucket + 1] += offsets[bucket];
+            }
+            for (size_t i = start; i < end; i++) {
+                partitioned[offsets[kmers[i].kmer % buckets]++] = kmers[i];
+            }
+            // offsets[bucket] is now the end of the bucket
+#pragma omp critical
+            {
+                size_t bucketStart = 0;
+                for (size_t bucket = 0; bucket < buckets; bucket++) {
+                    const size_t bucketSize = offsets[bucket] - bucketStart;
+                    if (bucketSize > 0) {
+                        if (files[bucket] == NULL) {
+                            files[bucket] = FileUtil::openFileOrDie(getFileName(bucket).c_str(), "wb", false);
+                        }
+                        if (fwrite(&partitioned[bucketStart], sizeof(KmerPosition), bucketSize, files[bucket]) != bucketSize) {
+                            Debug(Debug::ERROR) << "Could not write to " << getFileName(bucket) << "\n";
+                            EXIT(EXIT_FAILURE);
+                        }
+                    }
+                    bucketStart = offsets[bucket];
+                }
+            }
+        }
+    }
+
+private:
+    const std::string prefix;
+    const size_t buckets;
+    const size_t rank;
+    const size_t procs;
+    std::vector<FILE *> files;
+};
 
-size_t fillKmerPositionArray(KmerPosition * hashSeqPair, DBReader<unsigned int> &seqDbr,
-                             Parameters & par, BaseMatrix * subMat,
-                             size_t KMER_SIZE, size_t chooseTopKmer,
-                             size_t splits, size_t split){
+// reads and deletes the given files of k-mer positions, the array is terminated by an entry with kmer SIZE_T_MAX
+KmerPosition *readKmerPositions(const std::vector<std::string> &files, size_t &count) {
+    count = 0;
+    for (size_t i = 0; i < files.size(); i++) {
+        if (FileUtil::fileExists(files[i].c_str())) {
+            count += FileUtil::getFileSize(files[i]) / sizeof(KmerPosition);
+        }
+    }
+    KmerPosition *hashSeqPair = new(std::nothrow) KmerPosition[count + 1];
+    Util::checkAllocation(hashSeqPair, "Could not allocate memory");
     size_t offset = 0;
+    for (size_t i = 0; i < files.size(); i++) {
+        if (FileUtil::fileExists(files[i].c_str()) == false) {
+            continue;
+        }
+        const size_t fileCount = FileUtil::getFileSize(files[i]) / sizeof(KmerPosition);
+        FILE *file = FileUtil::openFileOrDie(files[i].c_str(), "rb", true);
+        if (fread(hashSeqPair + offset, sizeof(KmerPosition), fileCount, file) != fileCount) {
+            Debug(Debug::ERROR) << "Could not read " << files[i] << "\n";
+            EXIT(EXIT_FAILURE);
+        }
+        fclose(file);
+        FileUtil::deleteFile(files[i]);
+        offset += fileCount;
+    }
+    hashSeqPair[count].kmer = SIZE_T_MAX;
+    return hashSeqPair;
+}
+
+template <typename KmerOutput>
+void fillKmerPositionArray(KmerOutput &output, DBReader<unsigned int> &seqDbr,
+                           Parameters & par, BaseMatrix * subMat,
+                           size_t KMER_SIZE, size_t chooseTopKmer){
     int querySeqType  =  seqDbr.getDbtype();
     ProbabilityMatrix *probMatrix = NULL;
     if (par.maskMode == 1) {
@@ -136,6 +244,10 @@ size_t fillKmerPositionArray(KmerPosition * hashSeqPair, DBReader<unsigned int>
         size_t kmer;
         unsigned int pos;
         static bool compareByScore(const SequencePosition &first, const SequencePosition &second){
+            return first.score < second.score;
+        }
+        // the k-mers are collected in the order of their positions, so this is the order of a stable sort by score and kmer
+        static bool compareByScoreAndKmer(const SequencePosition &first, const SequencePosition &second){
             if(first.score < second.score)
                 return true;
             if(second.score < first.score)
@@ -144,19 +256,31 @@ size_t fillKmerPositionArray(KmerPosition * hashSeqPair, DBReader<unsigned int>
                 return true;
             if(second.kmer < first.kmer)
                 return false;
-
+            if(first.pos < second.pos)
+                return true;
             return false;
         }
     };
+    struct ScoreAtMost {
+        short threshold;
+        ScoreAtMost(short threshold) : threshold(threshold) {}
+        bool operator()(const SequencePosition &kmer) const {
+            return kmer.score <= threshold;
+        }
+    };
 #pragma omp parallel
     {
         Sequence seq(par.maxSeqLen, querySeqType, subMat, KMER_SIZE, false, false);
         Indexer idxer(subMat->alphabetSize, KMER_SIZE);
         char * charSequence = new char[par.maxSeqLen];
-        const unsigned int BUFFER_SIZE = 1024;
+        std::vector<char> entryBuffer;
+        const size_t BUFFER_SIZE = KmerOutput::BUFFER_SIZE;
         size_t bufferPos = 0;
         KmerPosition * threadKmerBuffer = new KmerPosition[BUFFER_SIZE];
         SequencePosition * kmers = new SequencePosition[par.maxSeqLen+1];
+        unsigned short * residueHash = new unsigned short[par.maxSeqLen + VECSIZE_INT * 2]();
+        unsigned short * kmerHash = new unsigned short[par.maxSeqLen + VECSIZE_INT * 2];
+        const int xCode = subMat->aa2int[(int) 'X'];
         int highestSeq[32];
         for(size_t i = 0; i<KMER_SIZE;i++){
             highestSeq[i]=subMat->alphabetSize-1;
@@ -171,7 +295,7 @@ size_t fillKmerPositionArray(KmerPosition * hashSeqPair, DBReader<unsigned int>
 #pragma omp for schedule(dynamic, 100)
             for (size_t id = start; id < (start + bucketSize); id++) {
                 Debug::printProgress(id);
-                seq.mapSequence(id, id, seqDbr.getData(id));
+                seq.mapSequence(id, id, seqDbr.getData(id, entryBuffer));
                 size_t seqHash = highestPossibleIndex + static_cast<unsigned int>(Util::hash(seq.int_sequence, seq.L));
 
                 // mask using tantan
@@ -195,35 +319,42 @@ size_t fillKmerPositionArray(KmerPosition * hashSeqPair, DBReader<unsigned int>
 
                 int seqKmerCount = 0;
                 unsigned int seqId = seq.getId();
-                unsigned short prevHash = 0;
-                unsigned int prevFirstRes = 0;
-                if (seq.hasNextKmer()) {
-                    const int *kmer = seq.nextKmer();
-                    prevHash = circ_hash(kmer, KMER_SIZE, par.hashShift);
-                    prevFirstRes = kmer[0];
+                const int *intSequence = seq.int_sequence;
+                computeKmerHashes(intSequence, seq.L, KMER_SIZE, par.hashShift, residueHash, kmerHash);
+                // skip k-mers containing an X, lastX is the last X up to the end of the current k-mer
+                int lastX = -1;
+                for (int pos = 0; pos < std::min(seq.L, static_cast<int>(KMER_SIZE)); pos++) {
+                    if (intSequence[pos] == xCode) {
+                        lastX = pos;
+                    }
                 }
-                while (seq.hasNextKmer()) {
-                    const int *kmer = seq.nextKmer();
-                    //float kmerScore = 1.0;
-                    prevHash = circ_hash_next(kmer, KMER_SIZE, prevFirstRes, prevHash, par.hashShift);
-                    prevFirstRes = kmer[0];
-                    size_t xCount = 0;
-                    for (size_t kpos = 0; kpos < KMER_SIZE; kpos++) {
-                        xCount += (kmer[kpos] == subMat->aa2int[(int) 'X']);
+                // the k-mer at position 0 only initializes the rolling hash
+                for (int pos = 1; pos + static_cast<int>(KMER_SIZE) <= seq.L; pos++) {
+                    if (intSequence[pos + KMER_SIZE - 1] == xCode) {
+                        lastX = pos + KMER_SIZE - 1;
                     }
-                    if (xCount > 0) {
+                    if (lastX >= pos) {
                         continue;
                     }
-                    (kmers + seqKmerCount)->score = prevHash;
-                    size_t kmerIdx = idxer.int2index(kmer, 0, KMER_SIZE);
-                    (kmers + seqKmerCount)->kmer = kmerIdx;
-                    (kmers + seqKmerCount)->pos = seq.getCurrentPosition();
+                    (kmers + seqKmerCount)->score = kmerHash[pos];
+                    (kmers + seqKmerCount)->pos = pos;
                     seqKmerCount++;
                 }
-                if (seqKmerCount > 1) {
-                    std::stable_sort(kmers, kmers + seqKmerCount, SequencePosition::compareByScore);
-                }
                 size_t kmerConsidered = std::min(static_cast<int>(chooseTopKmer - 1), seqKmerCount);
+                // select the kmerConsidered k-mers with the lowest score, the k-mer index is only needed for
+                // the candidates with a score up to the one of the last selected k-mer
+                size_t candidates = seqKmerCount;
+                if (par.skipNRepeatKmer == 0 && kmerConsidered > 0 && kmerConsidered < candidates) {
+                    std::nth_element(kmers, kmers + kmerConsidered - 1, kmers + seqKmerCount, SequencePosition::compareByScore);
+                    candidates = std::partition(kmers + kmerConsidered, kmers + seqKmerCount,
+                                                ScoreAtMost((kmers + kmerConsidered - 1)->score)) - kmers;
+                }
+                for (size_t i = 0; i < candidates; i++) {
+                    (kmers + i)->kmer = idxer.int2index(intSequence + (kmers + i)->pos, 0, KMER_SIZE);
+                }
+                if (candidates > 1) {
+                    std::sort(kmers, kmers + candidates, SequencePosition::compareByScoreAndKmer);
+                }
                 if(par.skipNRepeatKmer > 0 ){
                     size_t prevKmer = SIZE_T_MAX;
                     kmers[seqKmerCount].kmer=SIZE_T_MAX;
@@ -240,21 +371,19 @@ size_t fillKmerPositionArray(KmerPosition * hashSeqPair, DBReader<unsigned int>
                 }
 
                 // add k-mer to represent the identity
-                if (seqHash%splits == split) {
+                if (output.keep(seqHash)) {
                     threadKmerBuffer[bufferPos].kmer = seqHash;
                     threadKmerBuffer[bufferPos].id = seqId;
                     threadKmerBuffer[bufferPos].pos = 0;
                     threadKmerBuffer[bufferPos].seqLen = seq.L;
                     bufferPos++;
                     if (bufferPos >= BUFFER_SIZE) {
-                        size_t writeOffset = __sync_fetch_and_add(&offset, bufferPos);
-                        memcpy(hashSeqPair + writeOffset, threadKmerBuffer, sizeof(KmerPosition) * bufferPos);
+                        output.write(threadKmerBuffer, bufferPos);
                         bufferPos = 0;
                     }
                 }
                 for (size_t topKmer = 0; topKmer < kmerConsidered; topKmer++) {
-                    size_t splitIdx = (kmers + topKmer)->kmer % splits;
-                    if (splitIdx != split) {
+                    if (output.keep((kmers + topKmer)->kmer) == false) {
                         continue;
                     }
 
@@ -264,8 +393,7 @@ size_t fillKmerPositionArray(KmerPosition * hashSeqPair, DBReader<unsigned int>
                     threadKmerBuffer[bufferPos].seqLen = seq.L;
                     bufferPos++;
                     if (bufferPos >= BUFFER_SIZE) {
-                        size_t writeOffset = __sync_fetch_and_add(&offset, bufferPos);
-                        memcpy(hashSeqPair + writeOffset, threadKmerBuffer, sizeof(KmerPosition) * bufferPos);
+                        output.write(threadKmerBuffer, bufferPos);
                         bufferPos = 0;
                     }
                 }
@@ -282,10 +410,11 @@ size_t fillKmerPositionArray(KmerPosition * hashSeqPair, DBReader<unsigned int>
         }
 
         if(bufferPos > 0){
-            size_t writeOffset = __sync_fetch_and_add(&offset, bufferPos);
-            memcpy(hashSeqPair+writeOffset, threadKmerBuffer, sizeof(KmerPosition) * bufferPos);
+            output.write(threadKmerBuffer, bufferPos);
         }
         delete [] kmers;
+        delete [] residueHash;
+        delete [] kmerHash;
         delete [] charSequence;
         delete [] threadKmerBuffer;
     }
@@ -293,94 +422,137 @@ size_t fillKmerPositionArray(KmerPosition * hashSeqPair, DBReader<unsigned int>
     if (probMatrix != NULL) {
         delete probMatrix;
     }
-    return offset;
 }
 
-KmerPosition * doComputation(size_t totalKmers, size_t split, size_t splits, std::string splitFile,
-                             DBReader<unsigned int> & seqDbr, Parameters & par, BaseMatrix  * subMat,
-                             size_t KMER_SIZE, size_t chooseTopKmer) {
+// assign rep. sequence to same kmer members
+// hashSeqPair has to be sorted by kmer, seq.Len and id and terminated by an entry with kmer SIZE_T_MAX.
+// The pairs of rep. sequence (stored in kmer), member and diagonal are written to the front of the array
+// followed by entries with kmer SIZE_T_MAX; returns the number of pairs
+size_t assignRepSequence(KmerPosition *hashSeqPair, size_t arraySize, Parameters & par) {
+    // The longest sequence is the first since we sorted by kmer, seq.Len and id
+    size_t writePos = 0;
+    size_t prevHash = hashSeqPair[0].kmer;
+    size_t repSeqId = hashSeqPair[0].id;
+    size_t prevHashStart = 0;
+    size_t prevSetSize = 0;
+    size_t queryLen = hashSeqPair[0].seqLen;
+    unsigned int repSeq_i_pos = hashSeqPair[0].pos;
+    for (size_t elementIdx = 0; elementIdx < arraySize; elementIdx++) {
+        if (prevHash != hashSeqPair[elementIdx].kmer) {
+            for (size_t i = prevHashStart; i < elementIdx; i++) {
+                size_t rId =  (hashSeqPair[i].kmer != SIZE_T_MAX) ? ((prevSetSize == 1) ? SIZE_T_MAX
+                                                                                        : repSeqId) : SIZE_T_MAX;
+
+                hashSeqPair[i].kmer = SIZE_T_MAX;
+                // remove singletones from set
+                if(rId != SIZE_T_MAX){
+                    short diagonal = repSeq_i_pos - hashSeqPair[i].pos;
+                    bool canBeExtended = diagonal < 0 || (static_cast<size_t>(diagonal) > (queryLen - hashSeqPair[i].seqLen));
+                    if(par.includeOnlyExtendable == false || (canBeExtended && par.includeOnlyExtendable ==true )){
+                        hashSeqPair[writePos].kmer = rId;
+                        hashSeqPair[writePos].pos = diagonal;
+                        hashSeqPair[writePos].seqLen = hashSeqPair[i].seqLen;
+                        hashSeqPair[writePos].id = hashSeqPair[i].id;
+                        writePos++;
+                    }
+                }
+            }
+            prevSetSize = 0;
+            prevHashStart = elementIdx;
+            repSeqId = hashSeqPair[elementIdx].id;
+            queryLen = hashSeqPair[elementIdx].seqLen;
+            repSeq_i_pos = hashSeqPair[elementIdx].pos;
+        }
+        if (hashSeqPair[elementIdx].kmer == SIZE_T_MAX) {
+            break;
+        }
+        prevSetSize++;
+        prevHash = hashSeqPair[elementIdx].kmer;
+    }
+    return writePos;
+}
 
-    Debug(Debug::INFO) << "Generate k-mers list " << split <<"\n";
+KmerPosition * doComputation(size_t totalKmers, DBReader<unsigned int> & seqDbr, Parameters & par, BaseMatrix  * subMat,
+                             size_t KMER_SIZE, size_t chooseTopKmer) {
 
-    size_t splitKmerCount = (splits > 1) ? static_cast<size_t >(static_cast<double>(totalKmers/splits) * 1.2) : totalKmers;
+    Debug(Debug::INFO) << "Generate k-mers list\n";
 
-    KmerPosition * hashSeqPair = new(std::nothrow) KmerPosition[splitKmerCount + 1];
+    KmerPosition * hashSeqPair = new(std::nothrow) KmerPosition[totalKmers + 1];
     Util::checkAllocation(hashSeqPair, "Could not allocate memory");
 #pragma omp parallel for
-    for (size_t i = 0; i < splitKmerCount + 1; i++) {
+    for (size_t i = 0; i < totalKmers + 1; i++) {
         hashSeqPair[i].kmer = SIZE_T_MAX;
     }
 
     Timer timer;
-    size_t elementsToSort = fillKmerPositionArray(hashSeqPair, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer, splits, split);
+    KmerPositionArray kmers(hashSeqPair);
+    fillKmerPositionArray(kmers, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer);
+    size_t elementsToSort = kmers.getCount();
     Debug(Debug::INFO) << "\nTime for fill: " << timer.lap() << "\n";
-    if(splits == 1){
-        seqDbr.unmapData();
-    }
+    seqDbr.unmapData();
     Debug(Debug::INFO) << "Done." << "\n";
     Debug(Debug::INFO) << "Sort kmer ... ";
     timer.reset();
-    omptl::sort(hashSeqPair, hashSeqPair + elementsToSort, KmerPosition::compareRepSequenceAndIdAndPos);
-    //kx::radix_sort(hashSeqPair, hashSeqPair + elementsToSort, KmerComparision());
+    sortKmerPositions(hashSeqPair, elementsToSort, KmerPosition::compareRepSequenceAndIdAndPos);
     Debug(Debug::INFO) << "Done." << "\n";
     Debug(Debug::INFO) << "Time for sort: " << timer.lap() << "\n";
-    // assign rep. sequence to same kmer members
-    // The longest sequence is the first since we sorted by kmer, seq.Len and id
-    size_t writePos = 0;
-    {
-        size_t prevHash = hashSeqPair[0].kmer;
-        size_t repSeqId = hashSeqPair[0].id;
-        size_t prevHashStart = 0;
-        size_t prevSetSize = 0;
-        size_t queryLen;
-        unsigned int repSeq_i_pos = hashSeqPair[0].pos;
-        for (size_t elementIdx = 0; elementIdx < splitKmerCount+1; elementIdx++) {
-            if (prevHash != hashSeqPair[elementIdx].kmer) {
-                for (size_t i = prevHashStart; i < elementIdx; i++) {
-                    size_t rId =  (hashSeqPair[i].kmer != SIZE_T_MAX) ? ((prevSetSize == 1) ? SIZE_T_MAX
-                                                                                            : repSeqId) : SIZE_T_MAX;
-
-                    hashSeqPair[i].kmer = SIZE_T_MAX;
-                    // remove singletones from set
-                    if(rId != SIZE_T_MAX){
-                        short diagonal = repSeq_i_pos - hashSeqPair[i].pos;
-                        bool canBeExtended = diagonal < 0 || (diagonal > (queryLen - hashSeqPair[i].seqLen));
-                        if(par.includeOnlyExtendable == false || (canBeExtended && par.includeOnlyExtendable ==true )){
-                            hashSeqPair[writePos].kmer = rId;
-                            hashSeqPair[writePos].pos = diagonal;
-                            hashSeqPair[writePos].seqLen = hashSeqPair[i].seqLen;
-                            hashSeqPair[writePos].id = hashSeqPair[i].id;
-                            writePos++;
-                        }
-                    }
-                }
-                prevSetSize = 0;
-                prevHashStart = elementIdx;
-                repSeqId = hashSeqPair[elementIdx].id;
-                queryLen = hashSeqPair[elementIdx].seqLen;
-                repSeq_i_pos = hashSeqPair[elementIdx].pos;
-            }
-            if (hashSeqPair[elementIdx].kmer == SIZE_T_MAX) {
-                break;
-            }
-            prevSetSize++;
-            prevHash = hashSeqPair[elementIdx].kmer;
-        }
-    }
+    size_t writePos = assignRepSequence(hashSeqPair, totalKmers + 1, par);
     // sort by rep. sequence (stored in kmer) and sequence id
     Debug(Debug::INFO) << "Sort by rep. sequence ... ";
     timer.reset();
-    omptl::sort(hashSeqPair, hashSeqPair + writePos, KmerPosition::compareRepSequenceAndIdAndDiag);
-    //kx::radix_sort(hashSeqPair, hashSeqPair + elementsToSort, SequenceComparision());
+    sortKmerPositions(hashSeqPair, writePos, KmerPosition::compareRepSequenceAndIdAndDiag);
     Debug(Debug::INFO) << "Done\n";
     Debug(Debug::INFO) << "Time for sort: " << timer.lap() << "\n";
+    return hashSeqPair;
+}
 
-    if(splits > 1){
-        writeKmersToDisk(splitFile, hashSeqPair, writePos + 1);
+// External memory version of doComputation for the buckets (kmer % buckets) of this process:
+// the k-mers are generated in one pass over the sequences into a file per bucket. Each bucket is then sorted
+// in memory and its pairs of rep. sequence and member are partitioned by rep. sequence % buckets into the files
+// <db2>_reps_<rank>_<bucket>, which are sorted and written by writeRepSequenceBuckets.
+void doComputationInBuckets(size_t buckets, size_t rank, size_t procs, DBReader<unsigned int> & seqDbr,
+                            Parameters & par, BaseMatrix  * subMat, size_t KMER_SIZE, size_t chooseTopKmer) {
+    Debug(Debug::INFO) << "Generate k-mers list into " << buckets << " buckets\n";
+    Timer timer;
+    std::vector<std::string> kmerFiles;
+    {
+        KmerPositionFiles kmers(par.db2 + "_kmers_" + SSTR(rank), buckets, rank, procs);
+        fillKmerPositionArray(kmers, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer);
+        for (size_t bucket = rank; bucket < buckets; bucket += procs) {
+            kmerFiles.push_back(kmers.getFileName(bucket));
+        }
+    }
+    Debug(Debug::INFO) << "\nTime for fill: " << timer.lap() << "\n";
+    seqDbr.unmapData();
+
+    KmerPositionFiles repSequences(par.db2 + "_reps_" + SSTR(rank), buckets, 0, 1);
+    for (size_t i = 0; i < kmerFiles.size(); i++) {
+        Debug(Debug::INFO) << "Process bucket " << (rank + i * procs) << " ... ";
+        size_t elementsToSort;
+        KmerPosition *hashSeqPair = readKmerPositions(std::vector<std::string>(1, kmerFiles[i]), elementsToSort);
+        sortKmerPositions(hashSeqPair, elementsToSort, KmerPosition::compareRepSequenceAndIdAndPos);
+        size_t writePos = assignRepSequence(hashSeqPair, elementsToSort + 1, par);
+        repSequences.write(hashSeqPair, writePos);
+        delete [] hashSeqPair;
+        Debug(Debug::INFO) << "Done\n";
+    }
+    Debug(Debug::INFO) << "Time for buckets: " << timer.lap() << "\n";
+}
+
+// sorts the rep. sequence buckets of all processes by rep. sequence and sequence id and writes the result
+void writeRepSequenceBuckets(DBReader<unsigned int> & seqDbr, DBWriter & dbw, size_t buckets, size_t procs,
+                             std::vector<char> &repSequence, Parameters & par) {
+    for (size_t bucket = 0; bucket < buckets; bucket++) {
+        std::vector<std::string> files;
+        for (size_t rank = 0; rank < procs; rank++) {
+            files.push_back(par.db2 + "_reps_" + SSTR(rank) + "_" + SSTR(bucket));
+        }
+        size_t elementsToSort;
+        KmerPosition *hashSeqPair = readKmerPositions(files, elementsToSort);
+        sortKmerPositions(hashSeqPair, elementsToSort, KmerPosition::compareRepSequenceAndIdAndDiag);
+        writeKmerMatcherResult(seqDbr, dbw, hashSeqPair, elementsToSort + 1, repSequence, par.covMode, par.cov, par.threads);
         delete [] hashSeqPair;
-        hashSeqPair = NULL;
     }
-    return hashSeqPair;
 }
 
 void setLinearFilterDefault(Parameters *p) {
@@ -456,46 +628,22 @@ int kmermatcher(int argc, const char **argv, const Command &command) {
         splits += 1;
     }
 
-    Debug(Debug::INFO) << "Process file into " << splits << " parts\n";
-    std::vector<std::string> splitFiles;
-    KmerPosition *hashSeqPair = NULL;
-
     size_t mpiRank = 0;
+    size_t mpiProcs = 1;
 #ifdef HAVE_MPI
     splits = std::max(static_cast<size_t>(MMseqsMPI::numProc), splits);
-    size_t fromSplit = 0;
-    size_t splitCount = 1;
     mpiRank = MMseqsMPI::rank;
-    // if split size is great than nodes than we have to
-    // distribute all splits equally over all nodes
-    unsigned int * splitCntPerProc = new unsigned int[MMseqsMPI::numProc];
-    memset(splitCntPerProc, 0, sizeof(unsigned int) * MMseqsMPI::numProc);
-    for(size_t i = 0; i < splits; i++){
-        splitCntPerProc[i % MMseqsMPI::numProc] += 1;
-    }
-    for(int i = 0; i < MMseqsMPI::rank; i++){
-        fromSplit += splitCntPerProc[i];
-    }
-    splitCount = splitCntPerProc[MMseqsMPI::rank];
-    delete[] splitCntPerProc;
-
-    for(size_t split = fromSplit; split < fromSplit+splitCount; split++) {
-        std::string splitFileName = par.db2 + "_split_" +SSTR(split);
-        hashSeqPair = doComputation(totalKmers, split, splits, splitFileName, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer);
+    mpiProcs = MMseqsMPI::numProc;
+#endif
+    Debug(Debug::INFO) << "Process file into " << splits << " parts\n";
+    KmerPosition *hashSeqPair = NULL;
+    if (splits > 1) {
+        doComputationInBuckets(splits, mpiRank, mpiProcs, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer);
+    } else {
+        hashSeqPair = doComputation(totalKmers, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer);
     }
+#ifdef HAVE_MPI
     MPI_Barrier(MPI_COMM_WORLD);
-    if(mpiRank == 0){
-        for(size_t split = 0; split < splits; split++) {
-            std::string splitFileName = par.db2 + "_split_" +SSTR(split);
-            splitFiles.push_back(splitFileName);
-        }
-    }
-#else
-    for(size_t split = 0; split < splits; split++) {
-        std::string splitFileName = par.db2 + "_split_" +SSTR(split);
-        hashSeqPair = doComputation(totalKmers, split, splits, splitFileName, seqDbr, par, subMat, KMER_SIZE, chooseTopKmer);
-        splitFiles.push_back(splitFileName);
-    }
 #endif
     if(mpiRank == 0){
         std::vector<char> repSequence(seqDbr.getSize());
@@ -506,9 +654,7 @@ int kmermatcher(int argc, const char **argv, const Command &command) {
 
         Timer timer;
         if(splits > 1) {
-            std::cout << "How many splits: " << splits<<std::endl;
-            seqDbr.unmapData();
-            mergeKmerFilesAndOutput(seqDbr, dbw, splitFiles, repSequence, par.covMode, par.cov);
+            writeRepSequenceBuckets(seqDbr, dbw, splits, mpiProcs, repSequence, par);
         } else {
             writeKmerMatcherResult(seqDbr, dbw, hashSeqPair, totalKmers, repSequence, par.covMode, par.cov, par.threads);
         }
@@ -630,211 +776,6 @@ void writeKmerMatcherResult(DBReader<unsigned int> & seqDbr, DBWriter & dbw,
     }
 }
 
-struct FileKmerPosition {
-    size_t repSeq;
-    unsigned int id;
-    short pos;
-    unsigned int file;
-    FileKmerPosition(){}
-    FileKmerPosition(size_t repSeq, unsigned int id,short pos, unsigned int file):
-            repSeq(repSeq), id(id), pos(pos), file(file) {}
-};
-
-class CompareResultBySeqId {
-public:
-    bool operator() (FileKmerPosition & first, FileKmerPosition & second) {
-        //return (first.eval < second.eval);
-        if(first.repSeq > second.repSeq )
-            return true;
-        if(second.repSeq > first.repSeq )
-            return false;
-        if(first.id > second.id )
-            return true;
-        if(second.id > first.id )
-            return false;
-        if(first.pos > second.pos )
-            return true;
-        if(second.pos > first.pos )
-            return false;
-        return false;
-    }
-};
-
-typedef std::priority_queue<FileKmerPosition, std::vector<FileKmerPosition>, CompareResultBySeqId> KmerPositionQueue;
-
-size_t queueNextEntry(KmerPositionQueue &queue, int file, size_t offsetPos, KmerEntry *entries, size_t entrySize) {
-    if(offsetPos + 1 >= entrySize){
-        return offsetPos;
-    }
-    unsigned int repSeqId = entries[offsetPos].seqId;
-    size_t pos = 0;
-    while(entries[offsetPos + pos].seqId != UINT_MAX){
-        queue.push(FileKmerPosition(repSeqId, entries[offsetPos+pos].seqId,  entries[offsetPos+pos].diagonal, file));
-        pos++;
-    }
-    queue.push(FileKmerPosition(repSeqId, UINT_MAX, 0, file));
-    pos++;
-    return offsetPos+pos;
-}
-
-void mergeKmerFilesAndOutput(DBReader<unsigned int> & seqDbr, DBWriter & dbw,
-                             std::vector<std::string> tmpFiles, std::vector<char> &repSequence,
-                             int covMode, float covThr) {
-    Debug(Debug::INFO) << "Merge splits ... ";
-
-    const int fileCnt = tmpFiles.size();
-    FILE ** files       = new FILE*[fileCnt];
-    KmerEntry **entries = new KmerEntry*[fileCnt];
-    size_t * entrySizes = new size_t[fileCnt];
-    size_t * offsetPos  = new size_t[fileCnt];
-    size_t * dataSizes  = new size_t[fileCnt];
-    // init structures
-    for(size_t file = 0; file < tmpFiles.size(); file++){
-        files[file] = FileUtil::openFileOrDie(tmpFiles[file].c_str(),"r",true);
-        size_t dataSize;
-        entries[file]    = (KmerEntry*)FileUtil::mmapFile(files[file], &dataSize);
-        dataSizes[file]  = dataSize;
-        entrySizes[file] = dataSize/sizeof(KmerEntry);
-    }
-    KmerPositionQueue queue;
-    // read one entry for each file
-    for(int file = 0; file < fileCnt; file++ ){
-        offsetPos[file]=queueNextEntry(queue, file, 0, entries[file], entrySizes[file]);
-    }
-    std::string prefResultsOutString;
-    prefResultsOutString.reserve(100000000);
-    char buffer[100];
-    FileKmerPosition filePrevsKmerPos;
-    filePrevsKmerPos.id = UINT_MAX;
-    FileKmerPosition res;
-    size_t queryLength;
-    if(queue.empty() == false){
-        res = queue.top();
-        hit_t h;
-        h.seqId = seqDbr.getDbKey(res.repSeq);
-        h.pScore = 0;
-        h.diagonal = 0;
-        int len = QueryMatcher::prefilterHitToBuffer(buffer, h);
-        prefResultsOutString.append(buffer, len);
-        queryLength = seqDbr.getSeqLens(res.repSeq);
-    }
-    while(queue.empty() == false) {
-        res = queue.top();
-        queue.pop();
-        if(res.id==UINT_MAX){
-            offsetPos[res.file] = queueNextEntry(queue, res.file, offsetPos[res.file],
-                                                 entries[res.file], entrySizes[res.file]);
-            dbw.writeData(prefResultsOutString.c_str(), prefResultsOutString.length(), seqDbr.getDbKey(res.repSeq), 0);
-            repSequence[res.repSeq]=true;
-            prefResultsOutString.clear();
-            // skipe UINT MAX entries
-            while(queue.empty() == false && queue.top().id==UINT_MAX){
-                res = queue.top();
-                queue.pop();
-                offsetPos[res.file] = queueNextEntry(queue, res.file, offsetPos[res.file],
-                                                     entries[res.file], entrySizes[res.file]);
-            }
-            if(queue.empty() == false){
-                res = queue.top();
-                hit_t h;
-                h.seqId = seqDbr.getDbKey(res.repSeq);
-                h.pScore = 0;
-                h.diagonal = 0;
-                int len = QueryMatcher::prefilterHitToBuffer(buffer, h);
-                prefResultsOutString.append(buffer, len);
-                queryLength = seqDbr.getSeqLens(res.repSeq);
-            }
-        }
-        // if its not a duplicate
-        if(filePrevsKmerPos.id != res.id && res.repSeq != res.id && res.id!=UINT_MAX){
-            unsigned int targetLength = seqDbr.getSeqLens(res.id);
-            if(Util::canBeCovered(covThr, covMode,
-                                  static_cast<float>(queryLength),
-                                  static_cast<float>(targetLength)) == true){
-                hit_t h;
-                h.seqId = seqDbr.getDbKey(res.id);
-                h.pScore = 0;
-                h.diagonal = res.pos;
-                int len = QueryMatcher::prefilterHitToBuffer(buffer, h);
-                prefResultsOutString.append(buffer, len);
-            }
-        }
-        filePrevsKmerPos = res;
-    }
-    for(size_t file = 0; file < tmpFiles.size(); file++) {
-        fclose(files[file]);
-        if(munmap((void*)entries[file], dataSizes[file]) < 0){
-            Debug(Debug::ERROR) << "Failed to munmap memory dataSize=" << dataSizes[file] <<"\n";
-            EXIT(EXIT_FAILURE);
-        }
-    }
-    Debug(Debug::INFO) << "Done\n";
-
-    delete [] dataSizes;
-    delete [] offsetPos;
-    delete [] entries;
-    delete [] entrySizes;
-    delete [] files;
-}
-
-
-
-void writeKmersToDisk(std::string tmpFile, KmerPosition *hashSeqPair, size_t totalKmers) {
-    size_t repSeqId = SIZE_T_MAX;
-    size_t lastTargetId = SIZE_T_MAX;
-    FILE* filePtr = fopen(tmpFile.c_str(), "wb");
-    if(filePtr == NULL) { perror(tmpFile.c_str()); EXIT(EXIT_FAILURE); }
-    unsigned int writeSets = 0;
-    const size_t BUFFER_SIZE = 2048;
-    size_t bufferPos = 0;
-    size_t elemenetCnt = 0;
-    KmerEntry writeBuffer[BUFFER_SIZE];
-    KmerEntry nullEntry;
-    nullEntry.seqId=UINT_MAX;
-    nullEntry.diagonal=0;
-    for(size_t kmerPos = 0; kmerPos < totalKmers && hashSeqPair[kmerPos].kmer != SIZE_T_MAX; kmerPos++){
-        if(repSeqId != hashSeqPair[kmerPos].kmer) {
-            if (writeSets > 0 && elemenetCnt > 0) {
-                if(bufferPos > 0){
-                    fwrite(writeBuffer, sizeof(KmerEntry), bufferPos, filePtr);
-                }
-                fwrite(&nullEntry, sizeof(KmerEntry), 1, filePtr);
-            }
-            lastTargetId = SIZE_T_MAX;
-            bufferPos=0;
-            elemenetCnt=0;
-            repSeqId = hashSeqPair[kmerPos].kmer;
-            writeBuffer[bufferPos].seqId = repSeqId;
-            writeBuffer[bufferPos].diagonal = 0;
-            bufferPos++;
-        }
-        unsigned int targetId = hashSeqPair[kmerPos].id;
-        unsigned short diagonal = hashSeqPair[kmerPos].pos;
-        // remove similar double sequence hit
-        if(targetId != repSeqId && lastTargetId != targetId ){
-            ;
-        }else{
-            lastTargetId = targetId;
-            continue;
-        }
-        elemenetCnt++;
-        writeBuffer[bufferPos].seqId = targetId;
-        writeBuffer[bufferPos].diagonal = diagonal;
-        bufferPos++;
-        if(bufferPos >= BUFFER_SIZE){
-            fwrite(writeBuffer, sizeof(KmerEntry), bufferPos, filePtr);
-            bufferPos=0;
-        }
-        lastTargetId = targetId;
-        writeSets++;
-    }
-    if (writeSets > 0 && elemenetCnt > 0 && bufferPos > 0) {
-        fwrite(writeBuffer, sizeof(KmerEntry), bufferPos, filePtr);
-        fwrite(&nullEntry,  sizeof(KmerEntry), 1, filePtr);
-    }
-    fclose(filePtr);
-}
-
 void setKmerLengthAndAlphabet(Parameters &parameters, size_t aaDbSize, int seqTyp) {
     if(seqTyp == Sequence::NUCLEOTIDES){
         if(parameters.kmerSize == 0) {
@@ -0,0 +1,180 @@
+#ifndef MMSEQS_KMERMATCHER_H
+#define MMSEQS_KMERMATCHER_H
+
+#include <cstddef>
+#include <algorithm>
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+struct KmerPosition {
+    size_t kmer;
+    unsigned int id;
+    unsigned short seqLen;
+    short pos;
+    KmerPosition(){}
+    KmerPosition(size_t kmer, unsigned int id, unsigned short seqLen, short pos):
+            kmer(kmer), id(id), seqLen(seqLen), pos(pos) {}
+    static bool compareRepSequenceAndIdAndPos(const KmerPosition &first, const KmerPosition &second){
+        if(first.kmer < second.kmer )
+            return true;
+        if(second.kmer < first.kmer )
+            return false;
+        if(first.seqLen > second.seqLen )
+            return true;
+        if(second.seqLen > first.seqLen )
+            return false;
+        if(first.id < second.id )
+            return true;
+        if(second.id < first.id )
+            return false;
+        if(first.pos < second.pos )
+            return true;
+        if(second.pos < first.pos )
+            return false;
+        return false;
+    }
+
+    static bool compareRepSequenceAndIdAndDiag(const KmerPosition &first, const KmerPosition &second){
+        if(first.kmer < second.kmer)
+            return true;
+        if(second.kmer < first.kmer)
+            return false;
+        if(first.id < second.id)
+            return true;
+        if(second.id < first.id)
+            return false;
+
+        //        const short firstDiag  = (first.pos < 0)  ? -first.pos : first.pos;
+        //        const short secondDiag = (second.pos  < 0) ? -second.pos : second.pos;
+        if(first.pos < second.pos)
+            return true;
+        if(second.pos < first.pos)
+            return false;
+        return false;
+    }
+};
+
+unsigned circ_hash(const int * x, unsigned length, const unsigned rol);
+
+unsigned circ_hash_next(const int * x, unsigned length, int x_first, short unsigned h, const unsigned rol);
+
+void computeKmerHashes(const int *x, int L, int kmerSize, unsigned int rol,
+                       unsigned short *residueHash, unsigned short *kmerHash);
+
+// Sorts k-mer positions in the order of one of the comparators above, which all order by kmer first.
+// The kmer is sorted by an in-place most significant digit radix sort (American flag sort) with 8 bit digits,
+// starting at the highest bit in which the kmers differ. Runs of equal kmers and small buckets are finished
+// with the comparator, so the result is the same as sorting with the comparator alone.
+// The first digit is counted in parallel and its buckets are sorted in parallel.
+namespace KmerPositionSort {
+    // buckets up to this size are sorted with the comparator
+    const size_t SMALL_BUCKET = 64;
+
+    inline unsigned int digit(const KmerPosition &kmerPos, int shift) {
+        return static_cast<unsigned int>((kmerPos.kmer >> shift) & 0xFF);
+    }
+
+    // the digit after the one at shift, -1 if all bits are used
+    inline int nextShift(int shift) {
+        return (shift >= 8) ? shift - 8 : ((shift > 0) ? 0 : -1);
+    }
+
+    // moves each element into the bucket of its digit
+    inline void permute(KmerPosition *data, const size_t *counts, int shift) {
+        size_t heads[256];
+        size_t ends[256];
+        size_t offset = 0;
+        for (unsigned int bucket = 0; bucket < 256; bucket++) {
+            heads[bucket] = offset;
+            offset += counts[bucket];
+            ends[bucket] = offset;
+        }
+        for (unsigned int bucket = 0; bucket < 256; bucket++) {
+            while (heads[bucket] < ends[bucket]) {
+                KmerPosition value = data[heads[bucket]];
+                unsigned int valueDigit = digit(value, shift);
+                while (valueDigit != bucket) {
+                    std::swap(value, data[heads[valueDigit]++]);
+                    valueDigit = digit(value, shift);
+                }
+                data[heads[bucket]++] = value;
+            }
+        }
+    }
+
+    template <typename Compare>
+    void sortBucket(KmerPosition *data, size_t size, int shift, Compare comp) {
+        while (size > SMALL_BUCKET && shift >= 0) {
+            size_t counts[256] = {};
+            for (size_t i = 0; i < size; i++) {
+                counts[digit(data[i], shift)]++;
+            }
+            // all elements have the same digit
+            if (counts[digit(data[0], shift)] == size) {
+                shift = nextShift(shift);
+                continue;
+            }
+            permute(data, counts, shift);
+            size_t offset = 0;
+            for (unsigned int bucket = 0; bucket < 256; bucket++) {
+                if (counts[bucket] > 1) {
+                    sortBucket(data + offset, counts[bucket], nextShift(shift), comp);
+                }
+                offset += counts[bucket];
+            }
+            return;
+        }
+        std::sort(data, data + size, comp);
+    }
+}
+
+template <typename Compare>
+void sortKmerPositions(KmerPosition *data, size_t size, Compare comp) {
+    if (size < 2) {
+        return;
+    }
+    const size_t firstKmer = data[0].kmer;
+    size_t differentBits = 0;
+#pragma omp parallel for reduction(|:differentBits)
+    for (size_t i = 1; i < size; i++) {
+        differentBits |= data[i].kmer ^ firstKmer;
+    }
+    if (differentBits == 0) {
+        std::sort(data, data + size, comp);
+        return;
+    }
+    // the first digit consists of the 8 highest bits in which the kmers differ
+    const int highestBit = 63 - __builtin_clzll(static_cast<unsigned long long>(differentBits));
+    const int shift = std::max(0, highestBit - 7);
+
+    size_t counts[256] = {};
+#pragma omp parallel
+    {
+        size_t threadCounts[256] = {};
+#pragma omp for schedule(static)
+        for (size_t i = 0; i < size; i++) {
+            threadCounts[KmerPositionSort::digit(data[i], shift)]++;
+        }
+#pragma omp critical
+        {
+            for (unsigned int bucket = 0; bucket < 256; bucket++) {
+                counts[bucket] += threadCounts[bucket];
+            }
+        }
+    }
+    KmerPositionSort::permute(data, counts, shift);
+
+    size_t offsets[257];
+    offsets[0] = 0;
+    for (unsigned int bucket = 0; bucket < 256; bucket++) {
+        offsets[bucket + 1] = offsets[bucket] + counts[bucket];
+    }
+    const int next = KmerPositionSort::nextShift(shift);
+#pragma omp parallel for schedule(dynamic, 1)
+    for (unsigned int bucket = 0; bucket < 256; bucket++) {
+        KmerPositionSort::sortBucket(data + offsets[bucket], counts[bucket], next, comp);
+    }
+}
+
+#endif //MMSEQS_KMERMATCHER_H
@@ -17,6 +17,7 @@ template<unsigned int BINSIZE> CacheFriendlyOperations<BINSIZE>::CacheFriendlyOp
     binSize = initBinSize;
     tmpElementBuffer = new(std::nothrow) TmpResult[binSize];
     Util::checkAllocation(tmpElementBuffer, "Could not allocate tmpElementBuffer memory in CacheFriendlyOperations");
+    memset(tmpElementBuffer, 0, sizeof(TmpResult) * binSize);
 
     bins = new CounterResult*[BINCOUNT];
     binDataFrame = new(std::nothrow) CounterResult[BINCOUNT * binSize];
@@ -55,7 +55,8 @@ public:
 
 void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedLookup, SequenceLookup **unmaskedLookup,
                                 BaseMatrix &subMat, Sequence *seq,
-                                DBReader<unsigned int> *dbr, size_t dbFrom, size_t dbTo, int kmerThr) {
+                                DBReader<unsigned int> *dbr, size_t dbFrom, size_t dbTo, int kmerThr,
+                                bool compress) {
     Debug(Debug::INFO) << "Index table: counting k-mers...\n";
 
     const bool isProfile = seq->getSeqType() == Sequence::HMM_PROFILE;
@@ -104,13 +105,14 @@ void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedL
 
         unsigned int *buffer = new unsigned int[seq->getMaxLen()];
         char *charSequence = new char[seq->getMaxLen()];
+        std::vector<char> entryBuffer;
 
         #pragma omp for schedule(dynamic, 100) reduction(+:totalKmerCount, maskedResidues)
         for (size_t id = dbFrom; id < dbTo; id++) {
             Debug::printProgress(id - dbFrom);
 
             s.resetCurrPos();
-            char *seqData = dbr->getData(id);
+            char *seqData = dbr->getData(id, entryBuffer);
             unsigned int qKey = dbr->getDbKey(id);
             s.mapSequence(id - dbFrom, qKey, seqData);
 
@@ -189,52 +191,90 @@ void IndexBuilder::fillDatabase(IndexTable *indexTable, SequenceLookup **maskedL
 //    Debug(Debug::INFO) << "Index table: Remove "<< lowSelectiveResidues <<" none selective residues\n";
 //    Debug(Debug::INFO) << "Index table: init... from "<< dbFrom << " to "<< dbTo << "\n";
 
-    indexTable->initMemory(info->tableSize);
+    size_t tableEntries = 0;
+    for (size_t i = 0; i < indexTable->getTableSize(); i++) {
+        tableEntries += indexTable->getOffset(i);
+    }
+    // a table that needs several passes is encoded range by range and never completely in memory uncompressed,
+    // smaller tables are filled at once and compressed by the caller
+    const size_t passEntries = IndexBuilder::getCompressedPassEntries(tableEntries);
+    const bool ranged = compress && passEntries < tableEntries;
+    indexTable->initMemory(info->tableSize, ranged == false);
     indexTable->init();
 
     delete info;
     info = NULL;
 
-    Debug(Debug::INFO) << "Index table: fill...\n";
-    #pragma omp parallel
-    {
-        Sequence s(seq->getMaxLen(), seq->getSeqType(), &subMat, seq->getKmerSize(), seq->isSpaced(), false);
-        Indexer idxer(static_cast<unsigned int>(indexTable->getAlphabetSize()), seq->getKmerSize());
-        IndexEntryLocalTmp *buffer = new IndexEntryLocalTmp[seq->getMaxLen()];
+    std::vector<size_t> rangeStarts(1, 0);
+    if (ranged) {
+        size_t *offsets = indexTable->getOffsets();
+        const size_t tableSize = indexTable->getTableSize();
+        while (rangeStarts.back() < tableSize) {
+            // first k-mer whose list starts at or after the pass limit, at least one k-mer per pass
+            const size_t limit = offsets[rangeStarts.back()] + passEntries;
+            size_t next = std::lower_bound(offsets + rangeStarts.back() + 1, offsets + tableSize, limit) - offsets;
+            rangeStarts.push_back(next);
+        }
+    } else {
+        rangeStarts.push_back(indexTable->getTableSize());
+    }
 
-        KmerGenerator *generator = NULL;
-        if (isProfile) {
-            generator = new KmerGenerator(seq->getKmerSize(), indexTable->getAlphabetSize(), kmerThr);
-            generator->setDivideStrategy(s.profile_matrix);
+    for (size_t range = 0; range + 1 < rangeStarts.size(); range++) {
+        if (ranged) {
+            Debug(Debug::INFO) << "Index table: fill pass " << (range + 1) << " of " << (rangeStarts.size() - 1) << "...\n";
+            indexTable->beginRange(rangeStarts[range], rangeStarts[range + 1]);
+        } else {
+            Debug(Debug::INFO) << "Index table: fill...\n";
         }
+        #pragma omp parallel
+        {
+            Sequence s(seq->getMaxLen(), seq->getSeqType(), &subMat, seq->getKmerSize(), seq->isSpaced(), false);
+            Indexer idxer(static_cast<unsigned int>(indexTable->getAlphabetSize()), seq->getKmerSize());
+            IndexEntryLocalTmp *buffer = new IndexEntryLocalTmp[seq->getMaxLen()];
+            std::vector<char> entryBuffer;
+
+            KmerGenerator *generator = NULL;
+            if (isProfile) {
+                generator = new KmerGenerator(seq->getKmerSize(), indexTable->getAlphabetSize(), kmerThr);
+                generator->setDivideStrategy(s.profile_matrix);
+            }
 
-        #pragma omp for schedule(dynamic, 100)
-        for (size_t id = dbFrom; id < dbTo; id++) {
-            s.resetCurrPos();
-            Debug::printProgress(id - dbFrom);
+            #pragma omp for schedule(dynamic, 100)
+            for (size_t id = dbFrom; id < dbTo; id++) {
+                s.resetCurrPos();
+                Debug::printProgress(id - dbFrom);
+
+                unsigned int qKey = dbr->getDbKey(id);
+                if (isProfile) {
+                    s.mapSequence(id - dbFrom, qKey, dbr->getData(id, entryBuffer));
+                    indexTable->addSimilarSequence(&s, generator, &idxer);
+                } else {
+                    s.mapSequence(id - dbFrom, qKey, sequenceLookup->getSequence(id - dbFrom));
+                    indexTable->addSequence(&s, &idxer, buffer, kmerThr, idScoreLookup);
+                }
+            }
 
-            unsigned int qKey = dbr->getDbKey(id);
-            if (isProfile) {
-                s.mapSequence(id - dbFrom, qKey, dbr->getData(id));
-                indexTable->addSimilarSequence(&s, generator, &idxer);
-            } else {
-                s.mapSequence(id - dbFrom, qKey, sequenceLookup->getSequence(id - dbFrom));
-                indexTable->addSequence(&s, &idxer, buffer, kmerThr, idScoreLookup);
+            if (generator != NULL) {
+                delete generator;
             }
-        }
 
-        if (generator != NULL) {
-            delete generator;
+            delete [] buffer;
+        }
+        if (ranged) {
+            indexTable->compressRange();
+            Debug(Debug::INFO) << "\n";
         }
-
-        delete [] buffer;
     }
     if(idScoreLookup!=NULL){
         delete[] idScoreLookup;
     }
 
-    indexTable->sortDBSeqLists();
-    Debug(Debug::INFO) << "\nIndex table: removing duplicate entries...\n";
-    indexTable->revertPointer();
+    if (ranged) {
+        indexTable->finishRanges();
+    } else {
+        indexTable->sortDBSeqLists();
+        Debug(Debug::INFO) << "\nIndex table: removing duplicate entries...\n";
+        indexTable->revertPointer();
+    }
     Debug(Debug::INFO) << "Index table init done.\n\n";
 }
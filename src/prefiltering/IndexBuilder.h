@@ -3,11 +3,25 @@
 
 #include "IndexTable.h"
 
+#include <algorithm>
+
 class IndexBuilder {
 public:
+    // with compress the lists are PostingListCodec encoded while filling (see IndexTable::beginRange),
+    // a table with more than COMPRESSED_PASS_ENTRIES entries is then filled in up to MAX_COMPRESSED_PASSES passes
     static void fillDatabase(IndexTable *indexTable, SequenceLookup **maskedLookup, SequenceLookup **unmaskedLookup,
                              BaseMatrix &subMat, Sequence *seq,
-                             DBReader<unsigned int> *dbr, size_t dbFrom, size_t dbTo, int kmerThr);
+                             DBReader<unsigned int> *dbr, size_t dbFrom, size_t dbTo, int kmerThr,
+                             bool compress = false);
+
+    // number of entries filled per pass if the table is built compressed
+    static size_t getCompressedPassEntries(size_t entries) {
+        const size_t passEntries = std::max((entries + MAX_COMPRESSED_PASSES - 1) / MAX_COMPRESSED_PASSES, COMPRESSED_PASS_ENTRIES);
+        return std::min(passEntries, entries);
+    }
+
+    static const size_t COMPRESSED_PASS_ENTRIES = 16 * 1024 * 1024;
+    static const size_t MAX_COMPRESSED_PASSES = 8;
 };
 
 #endif
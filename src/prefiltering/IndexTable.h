@@ -15,9 +15,13 @@
 #include "SequenceLookup.h"
 #include "MathUtil.h"
 #include "KmerGenerator.h"
+#include "MemoryPlacement.h"
+#include "PostingListCodec.h"
 
 #include <algorithm>
+#include <cstring>
 #include <new>
+#include <vector>
 
 // IndexEntryLocal is an entry with position and seqId for a kmer
 // structure needs to be packed or it will need 8 bytes instead of 6
@@ -63,13 +67,16 @@ struct __attribute__((__packed__)) IndexEntryLocalTmp {
 
 class IndexTable {
 public:
-    IndexTable(int alphabetSize, int kmerSize, bool externalData)
+    IndexTable(int alphabetSize, int kmerSize, bool externalData, int hugePages = MemoryPlacement::HUGE_PAGES_OFF)
             : tableSize(MathUtil::ipow<size_t>(alphabetSize, kmerSize)), alphabetSize(alphabetSize),
-              kmerSize(kmerSize), externalData(externalData), tableEntriesNum(0), size(0),
-              indexer(new Indexer(alphabetSize, kmerSize)), entries(NULL), offsets(NULL) {
+              kmerSize(kmerSize), externalData(externalData), hugePages(hugePages), tableEntriesNum(0), size(0),
+              indexer(new Indexer(alphabetSize, kmerSize)), entries(NULL), offsets(NULL),
+              entriesMappedSize(0), offsetsMappedSize(0),
+              compressedEntries(NULL), compressedEntriesSize(0), compressedEntriesMappedSize(0),
+              rangeFrom(0), rangeTo(tableSize), rangeBase(0), rangeBytes(0) {
         if (externalData == false) {
-            offsets = new(std::nothrow) size_t[tableSize + 1];
-            memset(offsets, 0, (tableSize + 1) * sizeof(size_t));
+            // anonymous mappings are zero initialized
+            offsets = (size_t *) MemoryPlacement::allocate((tableSize + 1) * sizeof(size_t), hugePages, &offsetsMappedSize);
             Util::checkAllocation(offsets, "Could not allocate entries memory in IndexTable");
         }
     }
@@ -81,16 +88,28 @@ public:
     }
 
     void deleteEntries() {
+        for (size_t i = 0; i < replicas.size(); i++) {
+            delete replicas[i];
+        }
+        replicas.clear();
         if (externalData == false) {
             if (entries != NULL) {
-                delete[] entries;
+                MemoryPlacement::free(entries, entriesMappedSize);
                 entries = NULL;
             }
             if (offsets != NULL) {
-                delete[] offsets;
+                MemoryPlacement::free(offsets, offsetsMappedSize);
                 offsets = NULL;
             }
+            if (compressedEntries != NULL) {
+                MemoryPlacement::free(compressedEntries, compressedEntriesMappedSize);
+                compressedEntries = NULL;
+            }
+        }
+        for (size_t i = 0; i < rangeBuffers.size(); i++) {
+            MemoryPlacement::free(rangeBuffers[i].data, rangeBuffers[i].mappedSize);
         }
+        rangeBuffers.clear();
     }
 
     // count k-mers in the sequence, so enough memory for the sequence lists can be allocated in the end
@@ -184,6 +203,184 @@ public:
         return (entries + offsets[kmer]);
     }
 
+    // get the encoded list of DB sequences containing this k-mer, only after compressPostingLists
+    // PostingListCodec::decode writes the entries of the list
+    inline const unsigned char *getCompressedDBSeqList(size_t kmer, size_t *matchedListSize) {
+        const unsigned char *list = compressedEntries + offsets[kmer];
+        if (offsets[kmer + 1] == offsets[kmer]) {
+            *matchedListSize = 0;
+            return list;
+        }
+        *matchedListSize = PostingListCodec::readCount(list);
+        return list;
+    }
+
+    bool hasCompressedPostingLists() {
+        return compressedEntries != NULL;
+    }
+
+    // Replaces the sorted sequence lists by their PostingListCodec encoding, offsets then point to bytes
+    // in compressedEntries. The offsets are rewritten in place and the pages of already encoded entries
+    // are released on the way, so this needs little more memory than the uncompressed table.
+    void compressPostingLists() {
+        if (externalData == true) {
+            // mmapped offsets can not be rewritten
+            offsets = copyArray(offsets, tableSize + 1, -1, &offsetsMappedSize);
+        }
+        const size_t chunkSize = 64 * 1024;
+        const size_t chunkCount = (tableSize + chunkSize - 1) / chunkSize;
+        // old offset at the start of each chunk and the encoded size of each chunk
+        std::vector<size_t> chunkStarts(chunkCount + 1);
+        std::vector<size_t> chunkBytes(chunkCount + 1, 0);
+        for (size_t chunk = 0; chunk <= chunkCount; chunk++) {
+            chunkStarts[chunk] = offsets[std::min(chunk * chunkSize, tableSize)];
+        }
+#pragma omp parallel for schedule(dynamic, 1)
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            size_t bytes = 0;
+            for (size_t i = chunk * chunkSize; i < std::min((chunk + 1) * chunkSize, tableSize); i++) {
+                const size_t listSize = offsets[i + 1] - offsets[i];
+                if (listSize > 0) {
+                    bytes += PostingListCodec::encodedSize(entries + offsets[i], listSize);
+                }
+            }
+            chunkBytes[chunk] = bytes;
+        }
+        size_t bytes = 0;
+        for (size_t chunk = 0; chunk <= chunkCount; chunk++) {
+            const size_t currentBytes = chunkBytes[chunk];
+            chunkBytes[chunk] = bytes;
+            bytes += currentBytes;
+        }
+
+        compressedEntriesSize = bytes + PostingListCodec::PADDING;
+        compressedEntries = (unsigned char *) MemoryPlacement::allocate(compressedEntriesSize, hugePages, &compressedEntriesMappedSize);
+        Util::checkAllocation(compressedEntries, "Could not allocate memory in IndexTable::compressPostingLists");
+
+        const size_t batchSize = 256;
+        for (size_t batchStart = 0; batchStart < chunkCount; batchStart += batchSize) {
+            const size_t batchEnd = std::min(batchStart + batchSize, chunkCount);
+#pragma omp parallel for schedule(dynamic, 1)
+            for (size_t chunk = batchStart; chunk < batchEnd; chunk++) {
+                const size_t chunkEnd = std::min((chunk + 1) * chunkSize, tableSize);
+                unsigned char *out = compressedEntries + chunkBytes[chunk];
+                size_t start = chunkStarts[chunk];
+                for (size_t i = chunk * chunkSize; i < chunkEnd; i++) {
+                    // the next offset of the last k-mer belongs to the next chunk and might already be rewritten
+                    const size_t end = (i + 1 == chunkEnd) ? chunkStarts[chunk + 1] : offsets[i + 1];
+                    offsets[i] = out - compressedEntries;
+                    if (end > start) {
+                        out = PostingListCodec::encode(entries + start, end - start, out);
+                    }
+                    start = end;
+                }
+            }
+            if (externalData == false) {
+                MemoryPlacement::release(entries, chunkStarts[batchEnd] * sizeof(IndexEntryLocal));
+            }
+        }
+        offsets[tableSize] = bytes;
+
+        if (externalData == false) {
+            MemoryPlacement::free(entries, entriesMappedSize);
+        }
+        entries = NULL;
+        entriesMappedSize = 0;
+        externalData = false;
+    }
+
+    // The compressed lists can also be built range by range, so only the uncompressed lists of the
+    // k-mers in [kmerFrom, kmerTo) are in memory at a time: after initMemory(dbSize, false) and init()
+    // call beginRange, add all sequences, call compressRange and repeat for the next range in order.
+    // finishRanges copies the encoded ranges into compressedEntries.
+    void beginRange(size_t kmerFrom, size_t kmerTo) {
+        rangeFrom = kmerFrom;
+        rangeTo = kmerTo;
+        rangeBase = offsets[kmerFrom];
+        const size_t rangeEntries = offsets[kmerTo] - rangeBase;
+        entries = (IndexEntryLocal *) MemoryPlacement::allocate(rangeEntries * sizeof(IndexEntryLocal), MemoryPlacement::HUGE_PAGES_OFF, &entriesMappedSize);
+        Util::checkAllocation(entries, "Could not allocate entries memory in IndexTable::beginRange");
+    }
+
+    void compressRange() {
+        // after adding the sequences offsets[i] points to the end of the list of k-mer i
+        const size_t chunkSize = 64 * 1024;
+        const size_t kmerCount = rangeTo - rangeFrom;
+        const size_t chunkCount = (kmerCount + chunkSize - 1) / chunkSize;
+        std::vector<size_t> chunkStarts(chunkCount);
+        std::vector<size_t> chunkBytes(chunkCount + 1, 0);
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            const size_t kmer = rangeFrom + chunk * chunkSize;
+            chunkStarts[chunk] = (kmer == rangeFrom) ? rangeBase : offsets[kmer - 1];
+        }
+#pragma omp parallel for schedule(dynamic, 1)
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            const size_t chunkEnd = std::min(rangeFrom + (chunk + 1) * chunkSize, rangeTo);
+            size_t start = chunkStarts[chunk];
+            size_t bytes = 0;
+            for (size_t i = rangeFrom + chunk * chunkSize; i < chunkEnd; i++) {
+                const size_t end = offsets[i];
+                if (end > start) {
+                    IndexEntryLocal *list = entries + (start - rangeBase);
+                    std::sort(list, list + (end - start), IndexEntryLocal::comapreByIdAndPos);
+                    bytes += PostingListCodec::encodedSize(list, end - start);
+                }
+                start = end;
+            }
+            chunkBytes[chunk] = bytes;
+        }
+        size_t bytes = 0;
+        for (size_t chunk = 0; chunk <= chunkCount; chunk++) {
+            const size_t currentBytes = chunkBytes[chunk];
+            chunkBytes[chunk] = bytes;
+            bytes += currentBytes;
+        }
+
+        RangeBuffer buffer;
+        buffer.size = bytes;
+        buffer.data = (unsigned char *) MemoryPlacement::allocate(std::max(bytes, (size_t) 1), MemoryPlacement::HUGE_PAGES_OFF, &buffer.mappedSize);
+        Util::checkAllocation(buffer.data, "Could not allocate memory in IndexTable::compressRange");
+#pragma omp parallel for schedule(dynamic, 1)
+        for (size_t chunk = 0; chunk < chunkCount; chunk++) {
+            const size_t chunkEnd = std::min(rangeFrom + (chunk + 1) * chunkSize, rangeTo);
+            unsigned char *out = buffer.data + chunkBytes[chunk];
+            size_t start = chunkStarts[chunk];
+            for (size_t i = rangeFrom + chunk * chunkSize; i < chunkEnd; i++) {
+                const size_t end = offsets[i];
+                offsets[i] = rangeBytes + (out - buffer.data);
+                if (end > start) {
+                    out = PostingListCodec::encode(entries + (start - rangeBase), end - start, out);
+                }
+                start = end;
+            }
+        }
+        rangeBuffers.push_back(buffer);
+        rangeBytes += bytes;
+
+        MemoryPlacement::free(entries, entriesMappedSize);
+        entries = NULL;
+        entriesMappedSize = 0;
+    }
+
+    void finishRanges() {
+        compressedEntriesSize = rangeBytes + PostingListCodec::PADDING;
+        compressedEntries = (unsigned char *) MemoryPlacement::allocate(compressedEntriesSize, hugePages, &compressedEntriesMappedSize);
+        Util::checkAllocation(compressedEntries, "Could not allocate memory in IndexTable::finishRanges");
+        size_t offset = 0;
+        for (size_t i = 0; i < rangeBuffers.size(); i++) {
+            memcpy(compressedEntries + offset, rangeBuffers[i].data, rangeBuffers[i].size);
+            offset += rangeBuffers[i].size;
+            MemoryPlacement::free(rangeBuffers[i].data, rangeBuffers[i].mappedSize);
+        }
+        rangeBuffers.clear();
+        offsets[tableSize] = rangeBytes;
+
+        rangeFrom = 0;
+        rangeTo = tableSize;
+        rangeBase = 0;
+        rangeBytes = 0;
+    }
+
     void sortDBSeqLists() {
         #pragma omp parallel for
         for (size_t i = 0; i < getTableSize(); i++) {
@@ -206,8 +403,8 @@ public:
         return offsets;
     }
 
-    // init the arrays for the sequence lists
-    void initMemory(size_t dbSize) {
+    // init the arrays for the sequence lists, without allocateEntries they are allocated by beginRange
+    void initMemory(size_t dbSize, bool allocateEntries = true) {
         size_t tableEntriesNum = 0;
         for (size_t i = 0; i < getTableSize(); i++) {
             tableEntriesNum += getOffset(i);
@@ -215,9 +412,12 @@ public:
 
         this->tableEntriesNum = tableEntriesNum;
         this->size = dbSize; // amount of sequences added
+        if (allocateEntries == false) {
+            return;
+        }
 
         // allocate memory for the sequence id lists
-        entries = new(std::nothrow) IndexEntryLocal[tableEntriesNum];
+        entries = (IndexEntryLocal *) MemoryPlacement::allocate(tableEntriesNum * sizeof(IndexEntryLocal), hugePages, &entriesMappedSize);
         Util::checkAllocation(entries, "Could not allocate entries memory in IndexTable::initMemory");
     }
 
@@ -243,6 +443,45 @@ public:
         this->offsets = entryOffsets;
     }
 
+    // Places the finished table according to the huge page mode and numaMode (see MemoryPlacement).
+    // External data (e.g. a mmapped precomputed index) is copied first, since only anonymous memory can be placed.
+    void setMemoryPlacement(int numaMode) {
+        if (externalData == true && (hugePages != MemoryPlacement::HUGE_PAGES_OFF || numaMode != MemoryPlacement::NUMA_OFF)) {
+            copyStorage(this, -1);
+            externalData = false;
+        }
+
+        const std::vector<int> &nodes = MemoryPlacement::getNodes();
+        if (numaMode == MemoryPlacement::NUMA_INTERLEAVE && nodes.size() > 1) {
+            bool interleaved = MemoryPlacement::interleave(offsets, offsetsMappedSize);
+            if (compressedEntries != NULL) {
+                interleaved &= MemoryPlacement::interleave(compressedEntries, compressedEntriesMappedSize);
+            } else {
+                interleaved &= MemoryPlacement::interleave(entries, entriesMappedSize);
+            }
+            if (interleaved == false) {
+                Debug(Debug::WARNING) << "Could not interleave index table over " << nodes.size() << " NUMA nodes.\n";
+            }
+        } else if (numaMode == MemoryPlacement::NUMA_REPLICATE && nodes.size() > 1) {
+            for (size_t i = 0; i < nodes.size(); i++) {
+                IndexTable *replica = new IndexTable(alphabetSize, kmerSize, true, hugePages);
+                replica->tableEntriesNum = tableEntriesNum;
+                replica->size = size;
+                copyStorage(replica, nodes[i]);
+                replica->externalData = false;
+                replicas.push_back(replica);
+            }
+        }
+    }
+
+    // copy of the table on the node with the given index in MemoryPlacement::getNodes(), if the table was replicated
+    IndexTable *getReplica(size_t nodeIndex) {
+        if (nodeIndex < replicas.size()) {
+            return replicas[nodeIndex];
+        }
+        return this;
+    }
+
     void revertPointer() {
         for (size_t i = tableSize; i > 0; i--) {
             offsets[i] = offsets[i - 1];
@@ -307,6 +546,8 @@ public:
             ScoreMatrix scoreMatrix = kmerGenerator->generateKmerList(kmer);
             for(size_t i = 0; i < scoreMatrix.elementSize; i++) {
                 unsigned int kmerIdx = scoreMatrix.index[i];
+                if (kmerIdx < rangeFrom || kmerIdx >= rangeTo)
+                    continue;
 
                 // if region got masked do not add kmer
                 if (offsets[kmerIdx + 1] - offsets[kmerIdx] == 0)
@@ -324,7 +565,7 @@ public:
             unsigned int kmerIdx = buffer[pos].kmer;
             if(kmerIdx != prevKmer){
                 size_t offset = __sync_fetch_and_add(&(offsets[kmerIdx]), 1);
-                IndexEntryLocal *entry = &entries[offset];
+                IndexEntryLocal *entry = &entries[offset - rangeBase];
                 entry->seqId      = buffer[pos].seqId;
                 entry->position_j = buffer[pos].position_j;
             }
@@ -364,6 +605,8 @@ public:
                 }
             }
             unsigned int kmerIdx = idxer->int2index(kmer, 0, kmerSize);
+            if (kmerIdx < rangeFrom || kmerIdx >= rangeTo)
+                continue;
             // if region got masked do not add kmer
             if (offsets[kmerIdx + 1] - offsets[kmerIdx] == 0)
                 continue;
@@ -383,7 +626,7 @@ public:
             unsigned int kmerIdx = buffer[pos].kmer;
             if(kmerIdx != prevKmer){
                 size_t offset = __sync_fetch_and_add(&(offsets[kmerIdx]), 1);
-                IndexEntryLocal *entry = &entries[offset];
+                IndexEntryLocal *entry = &entries[offset - rangeBase];
                 entry->seqId      = buffer[pos].seqId;
                 entry->position_j = buffer[pos].position_j;
             }
@@ -452,7 +695,10 @@ protected:
     const int kmerSize;
 
     // external data from mmap
-    const bool externalData;
+    bool externalData;
+
+    // MemoryPlacement::HUGE_PAGES_* mode for entries and offsets
+    const int hugePages;
 
     // number of entries in all sequence lists - must be 64bit
     uint64_t tableEntriesNum;
@@ -464,6 +710,60 @@ protected:
     // Index table entries: ids of sequences containing a certain k-mer, stored sequentially in the memory
     IndexEntryLocal *entries;
     size_t *offsets;
+    size_t entriesMappedSize;
+    size_t offsetsMappedSize;
+
+    // PostingListCodec encoded sequence lists, replaces entries after compressPostingLists
+    unsigned char *compressedEntries;
+    size_t compressedEntriesSize;
+    size_t compressedEntriesMappedSize;
+
+    // k-mers that addSequence fills, entries holds the lists of this range starting at entry rangeBase
+    size_t rangeFrom;
+    size_t rangeTo;
+    size_t rangeBase;
+    // encoded ranges waiting for finishRanges and their total size
+    struct RangeBuffer {
+        unsigned char *data;
+        size_t size;
+        size_t mappedSize;
+    };
+    std::vector<RangeBuffer> rangeBuffers;
+    size_t rangeBytes;
+
+    // per NUMA node copies for MemoryPlacement::NUMA_REPLICATE
+    std::vector<IndexTable *> replicas;
+
+    // copies offsets and entries (or their compressed form) to target, which may be this table
+    void copyStorage(IndexTable *target, int node) {
+        target->offsets = copyArray(offsets, tableSize + 1, node, &target->offsetsMappedSize);
+        if (compressedEntries != NULL) {
+            target->compressedEntriesSize = compressedEntriesSize;
+            target->compressedEntries = copyArray(compressedEntries, compressedEntriesSize, node, &target->compressedEntriesMappedSize);
+        } else {
+            target->entries = copyArray(entries, tableEntriesNum, node, &target->entriesMappedSize);
+        }
+    }
+
+    // copies an array into memory allocated with the huge page mode of the table, node -1 keeps the default placement
+    template <typename T>
+    T *copyArray(const T *source, size_t count, int node, size_t *mappedSize) {
+        T *copy = (T *) MemoryPlacement::allocate(count * sizeof(T), hugePages, mappedSize);
+        Util::checkAllocation(copy, "Could not allocate memory in IndexTable::copyArray");
+        if (node >= 0) {
+            MemoryPlacement::bindToNode(copy, *mappedSize, node);
+        }
+        // touch the pages in parallel, the policy set above decides where they end up
+        const size_t chunkSize = 1024 * 1024;
+        const size_t chunks = (count + chunkSize - 1) / chunkSize;
+#pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < chunks; i++) {
+            const size_t start = i * chunkSize;
+            const size_t end = std::min(start + chunkSize, count);
+            memcpy(copy + start, source + start, (end - start) * sizeof(T));
+        }
+        return copy;
+    }
 
     // sequence lookup
     SequenceLookup *sequenceLookup;
@@ -0,0 +1,160 @@
+#ifndef MMSEQS_POSTINGLISTCODEC_H
+#define MMSEQS_POSTINGLISTCODEC_H
+
+// Compressed k-mer posting lists for the IndexTable.
+// A list of n entries sorted by seqId is stored as
+//   varint n | (n + 3) / 4 control bytes | n positions (uint16) | seqId deltas
+// The deltas are Stream VByte encoded (Lemire et al. 2017): each control byte holds the
+// byte lengths - 1 of four deltas, so a group of four is decoded with a single shuffle.
+// The decoder reads up to 16 bytes past the last delta, buffers need PADDING extra bytes.
+
+#include "simd.h"
+
+#include <cstddef>
+#include <cstring>
+#include <stdint.h>
+
+class PostingListCodec {
+public:
+    static const size_t PADDING = 16;
+
+    template <typename Entry>
+    static size_t encodedSize(const Entry *entries, size_t n) {
+        size_t size = varintSize(n) + (n + 3) / 4 + n * sizeof(uint16_t);
+        unsigned int prev = 0;
+        for (size_t i = 0; i < n; i++) {
+            size += byteLength(entries[i].seqId - prev);
+            prev = entries[i].seqId;
+        }
+        return size;
+    }
+
+    // returns the end of the encoded list
+    template <typename Entry>
+    static unsigned char *encode(const Entry *entries, size_t n, unsigned char *out) {
+        out = writeVarint(n, out);
+        unsigned char *control = out;
+        unsigned char *positions = control + (n + 3) / 4;
+        unsigned char *data = positions + n * sizeof(uint16_t);
+        memset(control, 0, (n + 3) / 4);
+        unsigned int prev = 0;
+        for (size_t i = 0; i < n; i++) {
+            const unsigned int delta = entries[i].seqId - prev;
+            prev = entries[i].seqId;
+            const unsigned int length = byteLength(delta);
+            control[i / 4] |= (unsigned char) ((length - 1) << ((i % 4) * 2));
+            // little endian, the low bytes come first
+            memcpy(data, &delta, length);
+            data += length;
+            const uint16_t position = entries[i].position_j;
+            memcpy(positions + i * sizeof(uint16_t), &position, sizeof(uint16_t));
+        }
+        return data;
+    }
+
+    // reads the list length and moves in to the start of the encoded entries
+    static inline size_t readCount(const unsigned char *&in) {
+        size_t n = 0;
+        unsigned int shift = 0;
+        unsigned char byte;
+        do {
+            byte = *in++;
+            n |= (size_t) (byte & 0x7f) << shift;
+            shift += 7;
+        } while (byte & 0x80);
+        return n;
+    }
+
+    template <typename Entry>
+    static void decode(const unsigned char *in, size_t n, Entry *out) {
+        const unsigned char *control = in;
+        const unsigned char *positions = control + (n + 3) / 4;
+        const unsigned char *data = positions + n * sizeof(uint16_t);
+        unsigned int prev = 0;
+        size_t i = 0;
+#ifdef SSE
+        const DecodeTables &tables = getDecodeTables();
+        __m128i prevVec = _mm_setzero_si128();
+        unsigned int ids[4];
+        for (; i + 4 <= n; i += 4) {
+            const unsigned char code = control[i / 4];
+            __m128i values = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) data), tables.shuffle[code]);
+            data += tables.length[code];
+            // prefix sum of the four deltas plus the last id of the previous group
+            values = _mm_add_epi32(values, _mm_slli_si128(values, 4));
+            values = _mm_add_epi32(values, _mm_slli_si128(values, 8));
+            values = _mm_add_epi32(values, prevVec);
+            prevVec = _mm_shuffle_epi32(values, 0xFF);
+            _mm_storeu_si128((__m128i *) ids, values);
+            for (size_t j = 0; j < 4; j++) {
+                out[i + j].seqId = ids[j];
+                memcpy(&out[i + j].position_j, positions + (i + j) * sizeof(uint16_t), sizeof(uint16_t));
+            }
+        }
+        prev = (unsigned int) _mm_cvtsi128_si32(prevVec);
+#endif
+        for (; i < n; i++) {
+            const unsigned int length = ((control[i / 4] >> ((i % 4) * 2)) & 3) + 1;
+            unsigned int delta = 0;
+            memcpy(&delta, data, length);
+            data += length;
+            prev += delta;
+            out[i].seqId = prev;
+            memcpy(&out[i].position_j, positions + i * sizeof(uint16_t), sizeof(uint16_t));
+        }
+    }
+
+private:
+    static inline unsigned int byteLength(unsigned int value) {
+        return (value < (1u << 8)) ? 1 : (value < (1u << 16)) ? 2 : (value < (1u << 24)) ? 3 : 4;
+    }
+
+    static inline size_t varintSize(size_t value) {
+        size_t size = 1;
+        while (value >= 0x80) {
+            value >>= 7;
+            size++;
+        }
+        return size;
+    }
+
+    static inline unsigned char *writeVarint(size_t value, unsigned char *out) {
+        while (value >= 0x80) {
+            *out++ = (unsigned char) ((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        *out++ = (unsigned char) value;
+        return out;
+    }
+
+#ifdef SSE
+    struct DecodeTables {
+        __m128i shuffle[256];
+        unsigned char length[256];
+
+        DecodeTables() {
+            for (unsigned int code = 0; code < 256; code++) {
+                unsigned char mask[16];
+                unsigned char offset = 0;
+                for (unsigned int value = 0; value < 4; value++) {
+                    const unsigned int length = ((code >> (value * 2)) & 3) + 1;
+                    for (unsigned int byte = 0; byte < 4; byte++) {
+                        // 0x80 lets the shuffle write a zero byte
+                        mask[value * 4 + byte] = (byte < length) ? (unsigned char) (offset + byte) : 0x80;
+                    }
+                    offset += length;
+                }
+                shuffle[code] = _mm_loadu_si128((const __m128i *) mask);
+                length[code] = offset;
+            }
+        }
+    };
+
+    static const DecodeTables &getDecodeTables() {
+        static const DecodeTables tables;
+        return tables;
+    }
+#endif
+};
+
+#endif //MMSEQS_POSTINGLISTCODEC_H
@@ -43,6 +43,10 @@ Prefiltering::Prefiltering(const std::string &targetDB,
         aaBiasCorrection(par.compBiasCorrection != 0),
         covThr(par.covThr), covMode(par.covMode), includeIdentical(par.includeIdentity),
         noPreload(par.noPreload),
+        hugePages(par.hugePages),
+        numaMode(par.numaMode),
+        compressIndex(par.compressIndex != 0),
+        queryBatchSize(static_cast<size_t>(par.queryBatchSize)),
         threads(static_cast<unsigned int>(par.threads)) {
 #ifdef OPENMP
     Debug(Debug::INFO) << "Using " << threads << " threads.\n";
@@ -140,7 +144,7 @@ Prefiltering::Prefiltering(const std::string &targetDB,
     }
     setupSplit(*tdbr, alphabetSize - 1, querySeqType,
                threads, templateDBIsIndex, maxResListLen,
-               memoryLimit, &kmerSize, &splits, &splitMode);
+               memoryLimit, &kmerSize, &splits, &splitMode, compressIndex);
 
     if(targetSeqType != Sequence::NUCLEOTIDES){
         kmerThr = getKmerThreshold(sensitivity, querySeqType, kmerScore, kmerSize);
@@ -231,17 +235,17 @@ void Prefiltering::reopenTargetDb() {
 
 void Prefiltering::setupSplit(DBReader<unsigned int>& dbr, const int alphabetSize, const unsigned int querySeqTyp, const int threads,
                               const bool templateDBIsIndex, const size_t maxResListLen, const size_t memoryLimit,
-                              int *kmerSize, int *split, int *splitMode) {
+                              int *kmerSize, int *split, int *splitMode, bool compressIndex) {
     size_t neededSize = estimateMemoryConsumption(1,
                                                   dbr.getSize(), dbr.getAminoAcidDBSize(),  maxResListLen, alphabetSize,
                                                   *kmerSize == 0 ? // if auto detect kmerSize
                                                   IndexTable::computeKmerSize(dbr.getAminoAcidDBSize()) : *kmerSize, querySeqTyp,
-                                                  threads);
+                                                  threads, compressIndex);
     if (neededSize > 0.9 * memoryLimit) {
         // memory is not enough to compute everything at once
         //TODO add PROFILE_STATE (just 6-mers)
         std::pair<int, int> splitSettings = Prefiltering::optimizeSplit(memoryLimit, &dbr,
-                                                                        alphabetSize, *kmerSize, querySeqTyp, threads);
+                                                                        alphabetSize, *kmerSize, querySeqTyp, threads, compressIndex);
         if (splitSettings.second == -1) {
             Debug(Debug::ERROR) << "Can not fit databased into " << memoryLimit
                                 << " byte. Please use a computer with more main memory.\n";
@@ -287,7 +291,7 @@ void Prefiltering::setupSplit(DBReader<unsigned int>& dbr, const int alphabetSiz
     Debug(Debug::INFO) << "Use kmer size " << *kmerSize << " and split "
                        << *split << " using " << Parameters::getSplitModeName(*splitMode) << " split mode.\n";
     neededSize = estimateMemoryConsumption((*splitMode == Parameters::TARGET_DB_SPLIT) ? *split : 1, dbr.getSize(),
-                                           dbr.getAminoAcidDBSize(), maxResListLen, alphabetSize, *kmerSize, querySeqTyp, threads);
+                                           dbr.getAminoAcidDBSize(), maxResListLen, alphabetSize, *kmerSize, querySeqTyp, threads, compressIndex);
     Debug(Debug::INFO) << "Needed memory (" << neededSize << " byte) of total memory (" << memoryLimit
                        << " byte)\n";
     if (neededSize > 0.9 * memoryLimit) {
@@ -305,6 +309,7 @@ void Prefiltering::mergeOutput(const std::string &outDB, const std::string &outD
     if (filenames.size() < 2) {
         std::rename(filenames[0].first.c_str(), outDB.c_str());
         std::rename(filenames[0].second.c_str(), outDBIndex.c_str());
+        DBWriter::moveIndexSidecar(filenames[0].second, outDBIndex);
         Debug(Debug::INFO) << "No merging needed.\n";
         return;
     }
@@ -330,6 +335,7 @@ void Prefiltering::mergeOutput(const std::string &outDB, const std::string &outD
             Debug(Debug::ERROR) << "Error while deleting " << filenames[i].second << " in mergeOutput!\n";
             EXIT(EXIT_FAILURE);
         }
+        DBWriter::removeIndexSidecar(filenames[i].second);
     }
     // sort merged entries by evalue
     DBReader<unsigned int> dbr(out.first.c_str(), out.second.c_str());
@@ -375,6 +381,7 @@ void Prefiltering::mergeOutput(const std::string &outDB, const std::string &outD
         Debug(Debug::ERROR) << "Error while deleting " << out.second << " in mergeOutput!\n";
         EXIT(EXIT_FAILURE);
     }
+    DBWriter::removeIndexSidecar(out.second);
 
     Debug(Debug::INFO) << "\nTime for merging results: " << timer.lap() << "\n";
 }
@@ -410,7 +417,7 @@ ScoreMatrix *Prefiltering::getScoreMatrix(const BaseMatrix& matrix, const size_t
 // TODO reimplement split index feature
 void Prefiltering::getIndexTable(int /*split*/, size_t dbFrom, size_t dbSize) {
     if (templateDBIsIndex == true) {
-        indexTable = PrefilteringIndexReader::generateIndexTable(tidxdbr, false);
+        indexTable = PrefilteringIndexReader::generateIndexTable(tidxdbr, false, hugePages);
 
         if (maskMode == 0) {
             sequenceLookup = PrefilteringIndexReader::getUnmaskedSequenceLookup(tidxdbr, false);
@@ -429,22 +436,33 @@ void Prefiltering::getIndexTable(int /*split*/, size_t dbFrom, size_t dbSize) {
         // remove X or N for seeding
         int adjustAlphabetSize = (targetSeqType == Sequence::NUCLEOTIDES || targetSeqType == Sequence::AMINO_ACIDS)
                            ? alphabetSize -1 : alphabetSize;
-        indexTable = new IndexTable(adjustAlphabetSize, kmerSize, false);
+        indexTable = new IndexTable(adjustAlphabetSize, kmerSize, false, hugePages);
         SequenceLookup **maskedLookup   = maskMode == 1 ? &sequenceLookup : NULL;
         SequenceLookup **unmaskedLookup = maskMode == 0 ? &sequenceLookup : NULL;
 
         Debug(Debug::INFO) << "Index table k-mer threshold: " << localKmerThr << "\n";
-        IndexBuilder::fillDatabase(indexTable, maskedLookup, unmaskedLookup, *subMat,  &tseq, tdbr, dbFrom, dbFrom + dbSize, localKmerThr);
+        IndexBuilder::fillDatabase(indexTable, maskedLookup, unmaskedLookup, *subMat,  &tseq, tdbr, dbFrom, dbFrom + dbSize, localKmerThr, compressIndex);
 
         if (diagonalScoring == false) {
             delete sequenceLookup;
             sequenceLookup = NULL;
         }
 
-        indexTable->printStatistics(subMat->int2aa);
+        // the offsets of a table built compressed are byte offsets
+        if (indexTable->hasCompressedPostingLists() == false) {
+            indexTable->printStatistics(subMat->int2aa);
+        }
         tdbr->remapData();
         Debug(Debug::INFO) << "Time for index table init: " << timer.lap() << "\n";
     }
+    if (compressIndex == true && indexTable->hasCompressedPostingLists() == false) {
+        Timer timer;
+        indexTable->compressPostingLists();
+        Debug(Debug::INFO) << "Time for compressing index table: " << timer.lap() << "\n";
+    }
+    if (hugePages != MemoryPlacement::HUGE_PAGES_OFF || numaMode != MemoryPlacement::NUMA_OFF) {
+        indexTable->setMemoryPlacement(numaMode);
+    }
 
     // init the substitution matrices
     switch (querySeqType) {
@@ -716,51 +734,91 @@ bool Prefiltering::runSplit(DBReader<unsigned int>* qdbr, const std::string &res
 #endif
         Sequence seq(maxSeqLen, querySeqType, subMat, kmerSize, spacedKmer, aaBiasCorrection);
 
-        QueryMatcher matcher(indexTable, sequenceLookup, subMat, evaluer, tdbr->getSeqLens() + dbFrom, kmerThr, kmerMatchProb,
+        // the k-mer generator of profiles is bound to the profile matrix of seq, they are matched one by one
+        const bool isProfile = (querySeqType == Sequence::HMM_PROFILE || querySeqType == Sequence::PROFILE_STATE_PROFILE);
+        const size_t batchSize = isProfile ? 1 : queryBatchSize;
+        std::vector<Sequence *> batchSeqs;
+        for (size_t i = 1; i < batchSize; i++) {
+            batchSeqs.push_back(new Sequence(maxSeqLen, querySeqType, subMat, kmerSize, spacedKmer, aaBiasCorrection));
+        }
+        batchSeqs.insert(batchSeqs.begin(), &seq);
+
+        IndexTable *threadIndexTable = indexTable;
+        if (numaMode == MemoryPlacement::NUMA_REPLICATE) {
+            const size_t nodeIndex = MemoryPlacement::nodeIndexForThread(thread_idx, localThreads);
+            MemoryPlacement::pinThreadToNode(MemoryPlacement::getNodes()[nodeIndex]);
+            threadIndexTable = indexTable->getReplica(nodeIndex);
+        }
+
+        QueryMatcher matcher(threadIndexTable, sequenceLookup, subMat, evaluer, tdbr->getSeqLens() + dbFrom, kmerThr, kmerMatchProb,
                              kmerSize, dbSize, maxSeqLen, seq.getEffectiveKmerSize(),
                              maxResults, aaBiasCorrection, diagonalScoring, minDiagScoreThr, takeOnlyBestKmer);
 
-        if (querySeqType == Sequence::HMM_PROFILE || querySeqType == Sequence::PROFILE_STATE_PROFILE) {
+        if (isProfile) {
             matcher.setProfileMatrix(seq.profile_matrix);
         } else {
             matcher.setSubstitutionMatrix(_3merSubMatrix, _2merSubMatrix);
         }
 
-#pragma omp for schedule(dynamic, 10) reduction (+: kmersPerPos, resSize, dbMatches, doubleMatches, querySeqLenSum, diagonalOverflow)
-        for (size_t id = queryFrom; id < queryFrom + querySize; id++) {
-            Debug::printProgress(id);
-            // get query sequence
-            char *seqData = qdbr->getData(id);
-            unsigned int qKey = qdbr->getDbKey(id);
-            seq.mapSequence(id, qKey, seqData);
-            // only the corresponding split should include the id (hack for the hack)
-            size_t targetSeqId = UINT_MAX;
-            if (id >= dbFrom && id < (dbFrom + dbSize) && (sameQTDB || includeIdentical)) {
-                targetSeqId = tdbr->getId(seq.getDbKey());
-                if (targetSeqId != UINT_MAX) {
-                    targetSeqId = targetSeqId - dbFrom;
-                }
-            }
-            // calculate prefiltering results
-            std::pair<hit_t *, size_t> prefResults = matcher.matchQuery(&seq, targetSeqId);
-            size_t resultSize = prefResults.second;
-            // write
-            writePrefilterOutput(qdbr, &tmpDbw, thread_idx, id, prefResults, dbFrom, resListOffset, maxResults);
-
-            // update statistics counters
-            if (resultSize != 0) {
-                notEmpty[id - queryFrom] = 1;
+        const size_t batchCount = (querySize + batchSize - 1) / batchSize;
+#pragma omp for schedule(dynamic, 1) reduction (+: kmersPerPos, resSize, dbMatches, doubleMatches, querySeqLenSum, diagonalOverflow)
+        for (size_t batch = 0; batch < batchCount; batch++) {
+            const size_t batchFrom = queryFrom + batch * batchSize;
+            const size_t batchTo = std::min(batchFrom + batchSize, queryFrom + querySize);
+            // get query sequences
+            for (size_t id = batchFrom; id < batchTo; id++) {
+                char *seqData = qdbr->getData(id);
+                unsigned int qKey = qdbr->getDbKey(id);
+                batchSeqs[id - batchFrom]->mapSequence(id, qKey, seqData);
             }
 
-            kmersPerPos += (size_t) matcher.getStatistics()->kmersPerPos;
-            dbMatches += matcher.getStatistics()->dbMatches;
-            doubleMatches += matcher.getStatistics()->doubleMatches;
-            querySeqLenSum += seq.L;
-            diagonalOverflow += matcher.getStatistics()->diagonalOverflow;
-            resSize += resultSize;
-            realResSize += std::min(resultSize, maxResults);
-            reslens[thread_idx]->emplace_back(resultSize);
+            size_t prepared = 0;
+            for (size_t id = batchFrom; id < batchTo; id++) {
+                Debug::printProgress(id);
+                Sequence *querySeq = batchSeqs[id - batchFrom];
+                // the hits of all queries of a batch might not fit at once, the rest is matched in the next round
+                if (batchSize > 1 && prepared == 0) {
+                    prepared = matcher.prepareBatch(&batchSeqs[id - batchFrom], batchTo - id);
+                }
+                // only the corresponding split should include the id (hack for the hack)
+                size_t targetSeqId = UINT_MAX;
+                if (id >= dbFrom && id < (dbFrom + dbSize) && (sameQTDB || includeIdentical)) {
+                    targetSeqId = tdbr->getId(querySeq->getDbKey());
+                    if (targetSeqId != UINT_MAX) {
+                        targetSeqId = targetSeqId - dbFrom;
+                    }
+                }
+                // calculate prefiltering results
+                std::pair<hit_t *, size_t> prefResults;
+                if (batchSize > 1) {
+                    prefResults = matcher.matchBatchQuery(matcher.getBatchSize() - prepared, targetSeqId);
+                    prepared--;
+                } else {
+                    prefResults = matcher.matchQuery(querySeq, targetSeqId);
+                }
+                size_t resultSize = prefResults.second;
+                // write
+                writePrefilterOutput(qdbr, &tmpDbw, thread_idx, id, prefResults, dbFrom, resListOffset, maxResults);
+
+                // update statistics counters
+                if (resultSize != 0) {
+                    notEmpty[id - queryFrom] = 1;
+                }
+
+                kmersPerPos += (size_t) matcher.getStatistics()->kmersPerPos;
+                dbMatches += matcher.getStatistics()->dbMatches;
+                doubleMatches += matcher.getStatistics()->doubleMatches;
+                querySeqLenSum += querySeq->L;
+                diagonalOverflow += matcher.getStatistics()->diagonalOverflow;
+                resSize += resultSize;
+                realResSize += std::min(resultSize, maxResults);
+                reslens[thread_idx]->emplace_back(resultSize);
+            }
         } // step end
+
+        for (size_t i = 1; i < batchSeqs.size(); i++) {
+            delete batchSeqs[i];
+        }
     }
 
     if (Debug::debugLevel >= Debug::INFO) {
@@ -797,6 +855,7 @@ bool Prefiltering::runSplit(DBReader<unsigned int>* qdbr, const std::string &res
         remove(resultDBIndex.c_str());
         std::rename((resultDB + "_tmp").c_str(), resultDB.c_str());
         std::rename((resultDBIndex + "_tmp").c_str(), resultDBIndex.c_str());
+        DBWriter::moveIndexSidecar(resultDBIndex + "_tmp", resultDBIndex);
     }
 
     for (unsigned int i = 0; i < localThreads; i++) {
@@ -1004,12 +1063,21 @@ int Prefiltering::getKmerThreshold(const float sensitivity, const int querySeqTy
 size_t Prefiltering::estimateMemoryConsumption(int split, size_t dbSize, size_t resSize,
                                                size_t maxHitsPerQuery,
                                                int alphabetSize, int kmerSize, unsigned int querySeqType,
-                                               int threads) {
+                                               int threads, bool compressIndex) {
     // for each residue in the database we need 7 byte
     size_t dbSizeSplit = (dbSize) / split;
     size_t residueSize = (resSize / split * 7);
     // 21^7 * pointer size is needed for the index
     size_t indexTableSize = static_cast<size_t>(pow(alphabetSize, kmerSize)) * sizeof(size_t *);
+    // compressed entries need 2 byte for the position, a quarter control byte and 1-4 byte for the sequence id delta
+    // the average delta is the number of sequences divided by the average list length
+    size_t searchResidueSize = residueSize;
+    if (compressIndex) {
+        double listLength = std::max(static_cast<double>(resSize / split) / pow(alphabetSize, kmerSize), 1.0);
+        double averageDelta = static_cast<double>(dbSizeSplit) / listLength;
+        double deltaBytes = std::min(std::max(ceil(log2(averageDelta + 1.0) / 8.0), 1.0) + 0.5, 4.0);
+        searchResidueSize = static_cast<size_t>((resSize / split) * (1.0 + 2.25 + deltaBytes));
+    }
     // memory needed for the threads
     // This memory is an approx. for Countint32Array and QueryTemplateLocalFast
     size_t threadSize = threads * (
@@ -1028,6 +1096,19 @@ size_t Prefiltering::estimateMemoryConsumption(int split, size_t dbSize, size_t
     }
     // some memory needed to keep the index, ....
     size_t background = dbSize * 22;
+    if (compressIndex) {
+        // large tables are filled and encoded range by range (see IndexBuilder::fillDatabase) before the threads
+        // allocate their memory, one range needs its uncompressed and its encoded lists
+        const size_t entries = resSize / split;
+        const size_t passEntries = IndexBuilder::getCompressedPassEntries(entries);
+        const double encodedEntrySize = static_cast<double>(searchResidueSize) / std::max(entries, (size_t) 1);
+        size_t buildSize = static_cast<size_t>(passEntries * (7.0 + encodedEntrySize));
+        if (passEntries >= entries) {
+            // a table filled in one pass is compressed in place
+            buildSize = residueSize - std::min(residueSize, searchResidueSize);
+        }
+        return searchResidueSize + std::max(buildSize, threadSize) + indexTableSize + background + extendedMatrix;
+    }
     return residueSize + indexTableSize + threadSize + background + extendedMatrix;
 }
 
@@ -1038,14 +1119,15 @@ size_t Prefiltering::estimateHDDMemoryConsumption(size_t dbSize, size_t maxResLi
 }
 
 std::pair<int, int> Prefiltering::optimizeSplit(size_t totalMemoryInByte, DBReader<unsigned int> *tdbr,
-                                                int alphabetSize, int externalKmerSize, unsigned int querySeqType, unsigned int threads) {
+                                                int alphabetSize, int externalKmerSize, unsigned int querySeqType, unsigned int threads,
+                                                bool compressIndex) {
     for (int optSplit = 1; optSplit < 100; optSplit++) {
         for (int optKmerSize = 6; optKmerSize <= 7; optKmerSize++) {
             if (optKmerSize == externalKmerSize || externalKmerSize == 0) { // 0: set k-mer based on aa size in database
                 size_t aaUpperBoundForKmerSize = IndexTable::getUpperBoundAACountForKmerSize(optKmerSize);
                 if ((tdbr->getAminoAcidDBSize() / optSplit) < aaUpperBoundForKmerSize) {
                     size_t neededSize = estimateMemoryConsumption(optSplit, tdbr->getSize(), tdbr->getAminoAcidDBSize(),
-                                                                  0, alphabetSize, optKmerSize, querySeqType, threads);
+                                                                  0, alphabetSize, optKmerSize, querySeqType, threads, compressIndex);
                     if (neededSize < 0.9 * totalMemoryInByte) {
                         return std::make_pair(optKmerSize, optSplit);
                     }
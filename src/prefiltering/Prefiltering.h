@@ -46,7 +46,7 @@ public:
 
     static void setupSplit(DBReader<unsigned int>& dbr, const int alphabetSize, const unsigned int querySeqType, const int threads,
                            const bool templateDBIsIndex, const size_t maxResListLen, const size_t memoryLimit,
-                           int *kmerSize, int *split, int *splitMode);
+                           int *kmerSize, int *split, int *splitMode, bool compressIndex = false);
 
     static int getKmerThreshold(const float sensitivity, const int querySeqType,
                                 const int kmerScore, const int kmerSize);
@@ -92,6 +92,10 @@ private:
     const int covMode;
     const bool includeIdentical;
     const bool noPreload;
+    const int hugePages;
+    const int numaMode;
+    const bool compressIndex;
+    const size_t queryBatchSize;
     const unsigned int threads;
 
     bool runSplit(DBReader<unsigned int> *qdbr, const std::string &resultDB, const std::string &resultDBIndex,
@@ -99,13 +103,13 @@ private:
 
     // compute kmer size and split size for index table
     static std::pair<int, int> optimizeSplit(size_t totalMemoryInByte, DBReader<unsigned int> *tdbr, int alphabetSize, int kmerSize,
-                                             unsigned int querySeqType, unsigned int threads);
+                                             unsigned int querySeqType, unsigned int threads, bool compressIndex);
 
     // estimates memory consumption while runtime
     static size_t estimateMemoryConsumption(int split, size_t dbSize, size_t resSize,
                                             size_t maxHitsPerQuery,
                                             int alphabetSize, int kmerSize, unsigned int querySeqType,
-                                            int threads);
+                                            int threads, bool compressIndex);
 
     static size_t estimateHDDMemoryConsumption(size_t dbSize, size_t maxResListLen);
 
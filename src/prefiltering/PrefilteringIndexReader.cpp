@@ -272,7 +272,7 @@ SequenceLookup *PrefilteringIndexReader::getUnmaskedSequenceLookup(DBReader<unsi
     return sequenceLookup;
 }
 
-IndexTable *PrefilteringIndexReader::generateIndexTable(DBReader<unsigned int> *dbr, bool touch) {
+IndexTable *PrefilteringIndexReader::generateIndexTable(DBReader<unsigned int> *dbr, bool touch, int hugePages) {
     PrefilteringIndexData data = getMetadata(dbr);
     IndexTable *retTable;
     int adjustAlphabetSize;
@@ -281,7 +281,7 @@ IndexTable *PrefilteringIndexReader::generateIndexTable(DBReader<unsigned int> *
     } else {
         adjustAlphabetSize = data.alphabetSize;
     }
-    retTable = new IndexTable(adjustAlphabetSize, data.kmerSize, true);
+    retTable = new IndexTable(adjustAlphabetSize, data.kmerSize, true, hugePages);
 
     size_t entriesNumId = dbr->getId(ENTRIESNUM);
     int64_t entriesNum = *((int64_t *)dbr->getData(entriesNumId));
@@ -51,7 +51,7 @@ public:
 
     static SequenceLookup *getUnmaskedSequenceLookup(DBReader<unsigned int> *dbr, bool touch);
 
-    static IndexTable *generateIndexTable(DBReader<unsigned int> *dbr, bool touch);
+    static IndexTable *generateIndexTable(DBReader<unsigned int> *dbr, bool touch, int hugePages = MemoryPlacement::HUGE_PAGES_OFF);
 
     static void printSummary(DBReader<unsigned int> *dbr);
 
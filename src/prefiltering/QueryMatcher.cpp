@@ -122,27 +122,180 @@ size_t QueryMatcher::evaluateBins(IndexEntryLocal **hitsByIndex,
     return localResultSize;
 }
 
+void QueryMatcher::computeCompositionBias(Sequence *querySeq, float *bias) {
+    if(aaBiasCorrection == true){
+        if(querySeq->getSeqType() == Sequence::AMINO_ACIDS) {
+            SubstitutionMatrix::calcLocalAaBiasCorrection(m, querySeq->int_sequence, querySeq->L, bias);
+        }else{
+            memset(bias, 0, sizeof(float) * querySeq->L);
+        }
+    } else {
+        memset(bias, 0, sizeof(float) * querySeq->L);
+    }
+}
+
 std::pair<hit_t *, size_t> QueryMatcher::matchQuery (Sequence * querySeq, unsigned int identityId){
     querySeq->resetCurrPos();
 //    std::cout << "Id: " << querySeq->getId() << std::endl;
     memset(scoreSizes, 0, SCORE_RANGE * sizeof(unsigned int));
 
     // bias correction
-    if(aaBiasCorrection == true){
-        if(querySeq->getSeqType() == Sequence::AMINO_ACIDS) {
-            SubstitutionMatrix::calcLocalAaBiasCorrection(m, querySeq->int_sequence, querySeq->L, compositionBias);
-        }else{
-            memset(compositionBias, 0, sizeof(float) * querySeq->L);
+    computeCompositionBias(querySeq, compositionBias);
+
+    size_t resultSize = match(querySeq, compositionBias);
+    return scoreQuery(querySeq, identityId, compositionBias, resultSize);
+}
+
+size_t QueryMatcher::prepareBatch(Sequence **querySeqs, size_t count) {
+    batchRequests.clear();
+    batchQueries.clear();
+    batchBias.clear();
+    batchPositionStarts.clear();
+
+    Indexer idx(indexTable->getAlphabetSize(), kmerSize);
+    const int xIndex = m->aa2int[(int)'X'];
+    const bool compressedIndex = indexTable->hasCompressedPostingLists();
+    size_t totalHits = 0;
+    for (size_t q = 0; q < count; q++) {
+        Sequence *seq = querySeqs[q];
+        seq->resetCurrPos();
+        BatchQuery query;
+        query.seq = seq;
+        query.biasOffset = batchBias.size();
+        query.positionOffset = batchPositionStarts.size();
+        query.hitOffset = totalHits;
+        query.kmerListLen = 0;
+        query.overflow = false;
+        const size_t requestStart = batchRequests.size();
+
+        batchBias.resize(query.biasOffset + seq->L);
+        float *bias = &batchBias[query.biasOffset];
+        computeCompositionBias(seq, bias);
+
+        // same k-mer enumeration as match, but only the list sizes are looked up
+        size_t queryHits = 0;
+        while (seq->hasNextKmer()) {
+            const int *kmer = seq->nextKmer();
+            const unsigned char *pos = seq->getAAPosInSpacedPattern();
+            const unsigned short current_i = seq->getCurrentPosition();
+            batchPositionStarts.push_back(totalHits + queryHits);
+
+            float biasCorrection = 0;
+            int xCount = 0;
+            for (int i = 0; i < kmerSize; i++) {
+                xCount += (kmer[i] == xIndex);
+                biasCorrection += bias[current_i + static_cast<short>(pos[i])];
+            }
+            if (xCount > 0) {
+                continue;
+            }
+            short kmerBias = static_cast<short>((biasCorrection < 0.0) ? biasCorrection - 0.5 : biasCorrection + 0.5);
+            kmerGenerator->setThreshold(std::max(kmerThr - kmerBias, 0));
+
+            const unsigned int *index;
+            unsigned int exactKmer;
+            size_t kmerElementSize;
+            if (takeOnlyBestKmer) {
+                kmerElementSize = 1;
+                exactKmer = idx.int2index(kmer);
+                index = &exactKmer;
+            } else {
+                ScoreMatrix kmerList = kmerGenerator->generateKmerList(kmer);
+                kmerElementSize = kmerList.elementSize;
+                index = kmerList.index;
+            }
+            query.kmerListLen += kmerElementSize;
+            for (size_t kmerPos = 0; kmerPos < kmerElementSize; kmerPos++) {
+                size_t seqListSize;
+                if (compressedIndex) {
+                    indexTable->getCompressedDBSeqList(index[kmerPos], &seqListSize);
+                } else {
+                    indexTable->getDBSeqList(index[kmerPos], &seqListSize);
+                }
+                // most similar k-mers do not occur in the target database
+                if (seqListSize == 0) {
+                    continue;
+                }
+                KmerRequest request;
+                request.kmer = index[kmerPos];
+                request.hitOffset = totalHits + queryHits;
+                batchRequests.push_back(request);
+                queryHits += seqListSize;
+            }
         }
+        query.positionCount = batchPositionStarts.size() - query.positionOffset;
+        query.hitCount = queryHits;
+
+        // match needs several passes if the hits of a single query do not fit into databaseHits
+        if (queryHits >= maxDbMatches) {
+            if (q > 0) {
+                batchRequests.resize(requestStart);
+                batchPositionStarts.resize(query.positionOffset);
+                batchBias.resize(query.biasOffset);
+                break;
+            }
+            query.overflow = true;
+            batchRequests.clear();
+            batchQueries.push_back(query);
+            return 1;
+        }
+        if (totalHits + queryHits >= maxDbMatches) {
+            batchRequests.resize(requestStart);
+            batchPositionStarts.resize(query.positionOffset);
+            batchBias.resize(query.biasOffset);
+            break;
+        }
+        totalHits += queryHits;
+        batchQueries.push_back(query);
+    }
+
+    // read every distinct posting list once and copy it to the other queries that need it
+    std::sort(batchRequests.begin(), batchRequests.end(), KmerRequest::compareByKmer);
+    for (size_t i = 0; i < batchRequests.size(); i++) {
+        IndexEntryLocal *target = databaseHits + batchRequests[i].hitOffset;
+        size_t seqListSize;
+        if (compressedIndex) {
+            const unsigned char *entries = indexTable->getCompressedDBSeqList(batchRequests[i].kmer, &seqListSize);
+            if (i > 0 && batchRequests[i].kmer == batchRequests[i - 1].kmer) {
+                memcpy(target, databaseHits + batchRequests[i - 1].hitOffset, sizeof(IndexEntryLocal) * seqListSize);
+            } else {
+                PostingListCodec::decode(entries, seqListSize, target);
+            }
+        } else {
+            const IndexEntryLocal *entries = indexTable->getDBSeqList(batchRequests[i].kmer, &seqListSize);
+            memcpy(target, entries, sizeof(IndexEntryLocal) * seqListSize);
+        }
+    }
+    return batchQueries.size();
+}
+
+std::pair<hit_t *, size_t> QueryMatcher::matchBatchQuery(size_t batchIndex, unsigned int identityId) {
+    const BatchQuery &query = batchQueries[batchIndex];
+    if (query.overflow) {
+        return matchQuery(query.seq, identityId);
+    }
+    memset(scoreSizes, 0, SCORE_RANGE * sizeof(unsigned int));
+    stats->diagonalOverflow = false;
+    const size_t *positionStarts = batchPositionStarts.data() + query.positionOffset;
+    for (size_t i = 0; i < query.positionCount; i++) {
+        indexPointer[i] = databaseHits + positionStarts[i];
+    }
+    unsigned short indexTo = 0;
+    if (query.positionCount > 0) {
+        indexTo = static_cast<unsigned short>(query.positionCount - 1);
     } else {
-        memset(compositionBias, 0, sizeof(float) * querySeq->L);
+        indexPointer[0] = databaseHits + query.hitOffset;
     }
+    indexPointer[indexTo + 1] = databaseHits + query.hitOffset + query.hitCount;
+    size_t resultSize = evaluateHits(query.seq, 0, indexTo, 0, query.kmerListLen, query.hitCount);
+    return scoreQuery(query.seq, identityId, &batchBias[query.biasOffset], resultSize);
+}
 
-    size_t resultSize = match(querySeq, compositionBias);
+std::pair<hit_t *, size_t> QueryMatcher::scoreQuery(Sequence *querySeq, unsigned int identityId, float *bias, size_t resultSize) {
     std::pair<hit_t *, size_t > queryResult;
     if(diagonalScoring == true) {
         // write diagonal scores in count value
-        ungappedAlignment->processQuery(querySeq, compositionBias, foundDiagonals, resultSize);
+        ungappedAlignment->processQuery(querySeq, bias, foundDiagonals, resultSize);
         memset(scoreSizes, 0, SCORE_RANGE * sizeof(unsigned int));
 
 
@@ -211,6 +364,7 @@ size_t QueryMatcher::match(Sequence *seq, float *compositionBias) {
     unsigned short indexTo = 0;
     Indexer idx(indexTable->getAlphabetSize(), kmerSize);
     const int xIndex = m->aa2int[(int)'X'];
+    const bool compressedIndex = indexTable->hasCompressedPostingLists();
 
     while(seq->hasNextKmer()){
         const int * kmer = seq->nextKmer();
@@ -260,7 +414,13 @@ size_t QueryMatcher::match(Sequence *seq, float *compositionBias) {
 //                        idx.printKmer(index[kmerPos], kmerSize, m->int2aa);
 //                        std::cout << std::endl;
 
-            const IndexEntryLocal *entries = indexTable->getDBSeqList(index[kmerPos], &seqListSize);
+            const IndexEntryLocal *entries = NULL;
+            const unsigned char *compressedEntries = NULL;
+            if (compressedIndex) {
+                compressedEntries = indexTable->getCompressedDBSeqList(index[kmerPos], &seqListSize);
+            } else {
+                entries = indexTable->getDBSeqList(index[kmerPos], &seqListSize);
+            }
 
             /////DEBUG
            /* 
@@ -299,7 +459,11 @@ size_t QueryMatcher::match(Sequence *seq, float *compositionBias) {
                     goto outer;
                 }
             };
-            memcpy(sequenceHits, entries, sizeof(IndexEntryLocal) * seqListSize);
+            if (compressedIndex) {
+                PostingListCodec::decode(compressedEntries, seqListSize, sequenceHits);
+            } else {
+                memcpy(sequenceHits, entries, sizeof(IndexEntryLocal) * seqListSize);
+            }
             sequenceHits += seqListSize;
             numMatches += seqListSize;
         }
@@ -307,6 +471,11 @@ size_t QueryMatcher::match(Sequence *seq, float *compositionBias) {
     }
     outer:
     indexPointer[indexTo + 1] = databaseHits + numMatches;
+    return evaluateHits(seq, indexStart, indexTo, overflowHitCount, kmerListLen, overflowNumMatches + numMatches);
+}
+
+size_t QueryMatcher::evaluateHits(Sequence *seq, unsigned short indexStart, unsigned short indexTo,
+                                  size_t overflowHitCount, size_t kmerListLen, size_t dbMatches) {
     size_t hitCount = evaluateBins(indexPointer, foundDiagonals + overflowHitCount,
                                    counterResultSize - overflowHitCount, indexStart, indexTo,  (diagonalScoring == false));
     //fill the output
@@ -321,7 +490,7 @@ size_t QueryMatcher::match(Sequence *seq, float *compositionBias) {
     }
     stats->kmersPerPos   = ((double)kmerListLen/(double)seq->L);
     stats->querySeqLen   = seq->L;
-    stats->dbMatches     = overflowNumMatches + numMatches;
+    stats->dbMatches     = dbMatches;
     return hitCount;
 }
 
@@ -6,6 +6,7 @@
 #define MMSEQS_QUERYTEMPLATEMATCHEREXACTMATCH_H
 
 #include <cstdlib>
+#include <vector>
 #include "itoa.h"
 #include "EvalueComputation.h"
 #include "CacheFriendlyOperations.h"
@@ -85,6 +86,19 @@ public:
     // identityId is the id of the identitical sequence in the target database if there is any, UINT_MAX otherwise
     std::pair<hit_t *, size_t>  matchQuery(Sequence * querySeq, unsigned int identityId);
 
+    // Batched matching for many short queries: collects the similar k-mers of consecutive queries, sorts
+    // them by k-mer and reads every posting list only once for the whole batch.
+    // Returns how many of the count queries were prepared (at least one), the sequences have to stay mapped
+    // until matchBatchQuery was called for each of them.
+    size_t prepareBatch(Sequence **querySeqs, size_t count);
+
+    // same result as matchQuery for the batchIndex-th prepared query
+    std::pair<hit_t *, size_t>  matchBatchQuery(size_t batchIndex, unsigned int identityId);
+
+    size_t getBatchSize() {
+        return batchQueries.size();
+    }
+
     // find duplicates in the diagonal bins
     size_t evaluateBins(IndexEntryLocal **hitsByIndex, CounterResult *output,
                         size_t outputSize, unsigned short indexFrom, unsigned short indexTo, bool computeTotalScore);
@@ -257,6 +271,44 @@ protected:
     // match sequence against the IndexTable
     size_t match(Sequence *seq, float *pDouble);
 
+    void computeCompositionBias(Sequence *querySeq, float *bias);
+
+    // scores the resultSize diagonals in foundDiagonals and extracts the result list
+    std::pair<hit_t *, size_t> scoreQuery(Sequence *querySeq, unsigned int identityId, float *bias, size_t resultSize);
+
+    // finds duplicate diagonals of the hits in indexPointer and updates the statistics, shared by match and matchBatchQuery
+    size_t evaluateHits(Sequence *seq, unsigned short indexStart, unsigned short indexTo,
+                        size_t overflowHitCount, size_t kmerListLen, size_t dbMatches);
+
+    // one posting list copy into databaseHits of a batch
+    struct KmerRequest {
+        unsigned int kmer;
+        size_t hitOffset;
+
+        static bool compareByKmer(const KmerRequest &first, const KmerRequest &second) {
+            return first.kmer < second.kmer;
+        }
+    };
+
+    struct BatchQuery {
+        Sequence *seq;
+        // offsets into batchBias and batchPositionStarts
+        size_t biasOffset;
+        size_t positionOffset;
+        size_t positionCount;
+        size_t hitOffset;
+        size_t hitCount;
+        size_t kmerListLen;
+        // the query alone exceeds databaseHits, it is matched by matchQuery instead
+        bool overflow;
+    };
+
+    std::vector<KmerRequest> batchRequests;
+    std::vector<BatchQuery> batchQueries;
+    std::vector<float> batchBias;
+    // offset of the first hit of every query position in databaseHits
+    std::vector<size_t> batchPositionStarts;
+
     // extract result from databaseHits
     std::pair<hit_t *, size_t> getResult(CounterResult * results,
                                          size_t resultSize,
@@ -0,0 +1,112 @@
+#include "SequenceStore.h"
+#include "PrefilteringIndexReader.h"
+#include "Debug.h"
+#include "Util.h"
+#include "MemoryPlacement.h"
+
+#include <algorithm>
+
+SequenceStore::SequenceStore(const std::string &seqDB, const std::string &seqDBIndex, bool useIndex, bool preload, size_t cacheLimit)
+        : indexReader(NULL), reader(NULL), lookup(NULL), seqType(-1), data(NULL), dataSize(0), dataMappedSize(0),
+          dataUsed(0), entries(NULL), entriesMappedSize(0) {
+    std::string indexDB = useIndex ? PrefilteringIndexReader::searchForIndex(seqDB) : "";
+    if (indexDB.length() > 0) {
+        Debug(Debug::INFO) << "Use index  " << indexDB << "\n";
+
+        indexReader = new DBReader<unsigned int>(indexDB.c_str(), (indexDB + ".index").c_str());
+        indexReader->open(DBReader<unsigned int>::NOSORT);
+        if (PrefilteringIndexReader::checkIfIndexFile(indexReader) == true) {
+            lookup = PrefilteringIndexReader::getUnmaskedSequenceLookup(indexReader, preload);
+            if (lookup == NULL) {
+                Debug(Debug::WARNING) << "No unmasked index available. Falling back to sequence database.\n";
+            } else {
+                PrefilteringIndexReader::printSummary(indexReader);
+                PrefilteringIndexData meta = PrefilteringIndexReader::getMetadata(indexReader);
+                seqType = meta.seqType;
+                reader = PrefilteringIndexReader::openNewReader(indexReader, preload);
+                return;
+            }
+        }
+        indexReader->close();
+        delete indexReader;
+        indexReader = NULL;
+    }
+
+    reader = new DBReader<unsigned int>(seqDB.c_str(), seqDBIndex.c_str());
+    reader->open(DBReader<unsigned int>::NOSORT);
+    if (preload) {
+        reader->readMmapedDataInMemory();
+    }
+    seqType = reader->getDbtype();
+    if (seqType != Sequence::AMINO_ACIDS) {
+        return;
+    }
+
+    // the encoded sequence is never longer than its entry, so more than the database never has to be kept
+    dataSize = std::min(cacheLimit, reader->getAminoAcidDBSize());
+    if (dataSize == 0) {
+        return;
+    }
+    data = (unsigned char *) MemoryPlacement::allocate(dataSize, MemoryPlacement::HUGE_PAGES_OFF, &dataMappedSize);
+    Util::checkAllocation(data, "Could not allocate data memory in SequenceStore");
+    entries = (CacheEntry *) MemoryPlacement::allocate(reader->getSize() * sizeof(CacheEntry), MemoryPlacement::HUGE_PAGES_OFF, &entriesMappedSize);
+    Util::checkAllocation(entries, "Could not allocate entry memory in SequenceStore");
+}
+
+SequenceStore::~SequenceStore() {
+    MemoryPlacement::free(data, dataMappedSize);
+    MemoryPlacement::free(entries, entriesMappedSize);
+    reader->close();
+    delete reader;
+    if (indexReader != NULL) {
+        delete lookup;
+        indexReader->close();
+        delete indexReader;
+    }
+}
+
+std::string SequenceStore::getSubstitutionMatrixName() {
+    if (indexReader == NULL) {
+        return "";
+    }
+    return PrefilteringIndexReader::getSubstitutionMatrixName(indexReader);
+}
+
+void SequenceStore::mapSequence(Sequence &seq, size_t id, unsigned int key) {
+    if (lookup != NULL) {
+        seq.mapSequence(id, key, lookup->getSequence(id));
+        return;
+    }
+    if (entries != NULL && __atomic_load_n(&entries[id].state, __ATOMIC_ACQUIRE) == ENCODE_DONE) {
+        seq.mapSequence(id, key, std::pair<const unsigned char *, const unsigned int>(data + entries[id].offset, entries[id].length));
+        return;
+    }
+
+    char *seqData = reader->getData(id);
+    if (seqData == NULL) {
+        Debug(Debug::ERROR) << "ERROR: Sequence " << key << " is not contained in the sequence database!\n"
+                            << "Please check your database.\n";
+        EXIT(EXIT_FAILURE);
+    }
+    seq.mapSequence(id, key, seqData);
+
+    // the first thread that encoded the sequence stores it, a concurrent thread just uses its own copy
+    unsigned char expected = ENCODE_NONE;
+    if (entries == NULL || __atomic_load_n(&dataUsed, __ATOMIC_RELAXED) >= dataSize
+        || __atomic_compare_exchange_n(&entries[id].state, &expected, ENCODE_BUSY, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED) == false) {
+        return;
+    }
+    const size_t offset = __atomic_fetch_add(&dataUsed, static_cast<size_t>(seq.L), __ATOMIC_RELAXED);
+    if (offset + seq.L > dataSize) {
+        // the cache is full, this and all later sequences are encoded each time they are mapped
+        __atomic_store_n(&entries[id].state, ENCODE_NONE, __ATOMIC_RELEASE);
+        return;
+    }
+    unsigned char *encoded = data + offset;
+    for (int pos = 0; pos < seq.L; pos++) {
+        encoded[pos] = static_cast<unsigned char>(seq.int_sequence[pos]);
+    }
+    entries[id].offset = offset;
+    entries[id].length = static_cast<unsigned int>(seq.L);
+    __atomic_store_n(&entries[id].state, ENCODE_DONE, __ATOMIC_RELEASE);
+}
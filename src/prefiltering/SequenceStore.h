@@ -0,0 +1,73 @@
+#ifndef MMSEQS_SEQUENCESTORE_H
+#define MMSEQS_SEQUENCESTORE_H
+
+// Random access to the integer encoded sequences of a sequence database.
+// The unmasked sequences of a createindex index are used if there is one (memory mapped).
+// Otherwise each amino acid sequence is encoded the first time it is mapped and kept encoded,
+// so hits to the same target are not encoded again, until the encoded sequences fill the cache limit.
+// Other sequence types are mapped from the database.
+
+#include <string>
+#include <cstddef>
+
+#include "DBReader.h"
+#include "Sequence.h"
+#include "SequenceLookup.h"
+
+class SequenceStore {
+public:
+    // useIndex: look for an index of seqDB, preload: read the sequences into memory
+    // cacheLimit: bytes of encoded sequences that are kept, 0 encodes a sequence each time it is mapped
+    SequenceStore(const std::string &seqDB, const std::string &seqDBIndex, bool useIndex, bool preload, size_t cacheLimit);
+
+    ~SequenceStore();
+
+    bool isIndex() const {
+        return indexReader != NULL;
+    }
+
+    // reader for the keys and lengths, only the index entries are available for an index
+    DBReader<unsigned int> *getReader() {
+        return reader;
+    }
+
+    int getSeqType() const {
+        return seqType;
+    }
+
+    // substitution matrix the index was encoded with, empty without index
+    std::string getSubstitutionMatrixName();
+
+    // maps the sequence with the given id of getReader() into seq
+    // sequences encoded on the fly use the alphabet of the first Sequence they were mapped into
+    void mapSequence(Sequence &seq, size_t id, unsigned int key);
+
+private:
+    DBReader<unsigned int> *indexReader;
+    DBReader<unsigned int> *reader;
+    SequenceLookup *lookup;
+    int seqType;
+
+    struct CacheEntry {
+        size_t offset;
+        unsigned int length;
+        // ENCODE_NONE, ENCODE_BUSY or ENCODE_DONE
+        unsigned char state;
+    };
+
+    // encoded on the fly: sequences are appended to data in the order they are first mapped
+    // both are anonymous zero initialized mappings, only the pages of mapped sequences use memory
+    unsigned char *data;
+    size_t dataSize;
+    size_t dataMappedSize;
+    // bytes claimed in data, grows beyond dataSize once the cache is full
+    size_t dataUsed;
+    CacheEntry *entries;
+    size_t entriesMappedSize;
+
+    static const unsigned char ENCODE_NONE = 0;
+    static const unsigned char ENCODE_BUSY = 1;
+    static const unsigned char ENCODE_DONE = 2;
+};
+
+#endif //MMSEQS_SEQUENCESTORE_H
@@ -9,6 +9,7 @@
 #include "simd.h"
 #include "CacheFriendlyOperations.h"
 #include "SequenceLookup.h"
+#include "SimdKernels.h"
 class UngappedAlignment {
 
 public:
@@ -35,7 +36,15 @@ public:
 
 private:
     const static unsigned int DIAGONALCOUNT = 0xFFFF + 1;
-    const static unsigned int PROFILESIZE = 32;
+    const static unsigned int PROFILESIZE = SimdKernels::DIAGONAL_PROFILE_SIZE;
+    const static unsigned int MAX_LANES = MAX_ALIGN_INT;
+    // hits are binned in batches of this size per diagonal and batches with more than DIAGONAL_BATCH / 16 hits
+    // are scored by the byte kernels, both independent of the lane count so that the scores do not depend on the CPU
+    const static unsigned int DIAGONAL_BATCH = 32;
+
+    const SimdKernels &kernels;
+    // number of db sequences scored in parallel, depends on the instruction set of the kernels
+    const unsigned int lanes;
 
     unsigned int *score_arr;
     unsigned char *vectorSequence;
@@ -48,8 +57,8 @@ private:
     BaseMatrix *subMatrix;
     SequenceLookup *sequenceLookup;
 
-    // this function bins the hit_t by diagonals by distributing each hit in an array of 256 * 16(sse)/32(avx2)
-    // the function scoreDiagonalAndUpdateHits is called for each bin that reaches its maximum (16 or 32)
+    // this function bins the hit_t by diagonals by distributing each hit in an array of DIAGONALCOUNT * DIAGONAL_BATCH
+    // the function scoreDiagonalAndUpdateHits is called for each bin that reaches its maximum (DIAGONAL_BATCH)
     void computeScores(const char *queryProfile,
                        const unsigned int queryLen,
                        CounterResult * results,
@@ -61,10 +70,6 @@ private:
                                     const unsigned int seqLen,
                                     const unsigned char *dbSeq);
 
-    // scores the diagonal of  16/32 db sequences in parallel
-    simd_int vectorDiagonalScoring(const char *profile,
-                                         const char bias, const unsigned int seqLen, const unsigned char *dbSeq);
-
     std::pair<unsigned char *, unsigned int> mapSequences(std::pair<unsigned char *, unsigned int> * seqs, unsigned int seqCount);
 
     // calles vectorDiagonalScoring or scalarDiagonalScoring depending on the hitSize
@@ -73,14 +78,13 @@ private:
                                     const short diagonal, CounterResult **hits, const unsigned int hitSize,
                                     const short bias);
 
-#ifdef AVX2
-    __m256i Shuffle(const __m256i &value, const __m256i &shuffle);
-#endif
+    // scores up to lanes hits of one diagonal with the byte kernel, saturates at 255
+    void scoreDiagonalVector(const char *queryProfile, const unsigned int queryLen, const short diagonal,
+                             const unsigned short minDistToDiagonal, CounterResult **hits, const unsigned int hitSize,
+                             const short bias);
 
     unsigned short distanceFromDiagonal(const unsigned short diagonal);
 
-    void extractScores(unsigned int *score_arr, simd_int score);
-
     short createProfile(Sequence *seq, float *biasCorrection, short **subMat, int alphabetSize);
 
     unsigned int diagonalLength(const short diagonal, const unsigned int len, const unsigned int second);
@@ -1,6 +1,7 @@
 #include "NcbiTaxonomy.h"
 #include "Parameters.h"
 #include "DBWriter.h"
+#include "ResultCursor.h"
 #include "FileUtil.h"
 #include "Debug.h"
 #include "Util.h"
@@ -17,6 +18,7 @@ int lca(int argc, const char **argv, const Command& command) {
     omp_set_num_threads(par.threads);
 #endif
 
+    ResultCursor::requireText(par.db1);
     DBReader<unsigned int> reader(par.db1.c_str(), par.db1Index.c_str());
     reader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
 
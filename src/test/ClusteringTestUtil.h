@@ -0,0 +1,127 @@
+#ifndef MMSEQS_CLUSTERINGTESTUTIL_H
+#define MMSEQS_CLUSTERINGTESTUTIL_H
+
+// Synthetic sequence and alignment databases for the clustering tests (test_setcover, test_alignmentgraph,
+// test_connectedcomponent) and the command line and timing of their thread scaling runs.
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/time.h>
+
+#include "DBWriter.h"
+#include "FileUtil.h"
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+// one line of an alignment result as the clustering reads it, the e-value is always 1E-10
+struct TestAlignment {
+    unsigned int target;
+    int score;
+    double seqId;
+
+    TestAlignment(unsigned int target, int score, double seqId) : target(target), score(score), seqId(seqId) {}
+};
+
+// 64 bit LCG, the same state gives the same graph on every platform
+static inline size_t nextRandom(size_t &state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state >> 17;
+}
+
+static inline double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + 1e-6 * t.tv_usec;
+}
+
+// a new directory below /tmp for the databases of one test run, removed with the databases at the end
+class TestDirectory {
+public:
+    explicit TestDirectory(const std::string &name) {
+        std::string pattern = "/tmp/" + name + "_XXXXXX";
+        if (mkdtemp(&pattern[0]) == NULL) {
+            std::cout << "Could not create a directory for " << pattern << "\n";
+            exit(EXIT_FAILURE);
+        }
+        path = pattern;
+    }
+
+    ~TestDirectory() {
+        for (size_t i = 0; i < files.size(); i++) {
+            if (FileUtil::fileExists(files[i].c_str())) {
+                FileUtil::deleteFile(files[i]);
+            }
+        }
+        rmdir(path.c_str());
+    }
+
+    // path of a database in the directory, its data and index file are deleted with the directory
+    std::string database(const std::string &name) {
+        const std::string db = path + "/" + name;
+        files.push_back(db);
+        files.push_back(db + ".index");
+        return db;
+    }
+
+    const std::string &getPath() const {
+        return path;
+    }
+
+private:
+    std::string path;
+    std::vector<std::string> files;
+};
+
+// writes poly-A sequences of the given lengths with keys 0 to lengths.size() - 1 and their alignment results,
+// seqIdDigits controls how many different sequence identities the graph can have
+static void writeClusteringDatabases(const std::string &seqDB, const std::string &alnDB,
+                                     const std::vector<size_t> &lengths,
+                                     const std::vector<std::vector<TestAlignment> > &alignments,
+                                     int seqIdDigits = 3) {
+    DBWriter seqWriter(seqDB.c_str(), (seqDB + ".index").c_str());
+    seqWriter.open();
+    DBWriter alnWriter(alnDB.c_str(), (alnDB + ".index").c_str());
+    alnWriter.open();
+    std::string buffer;
+    for (size_t i = 0; i < lengths.size(); i++) {
+        const std::string sequence = std::string(lengths[i], 'A') + "\n";
+        seqWriter.writeData(sequence.c_str(), sequence.size(), static_cast<unsigned int>(i));
+
+        buffer.clear();
+        for (size_t j = 0; j < alignments[i].size(); j++) {
+            char line[64];
+            const int written = snprintf(line, sizeof(line), "%u\t%d\t%.*f\t1E-10\n", alignments[i][j].target,
+                                         alignments[i][j].score, seqIdDigits, alignments[i][j].seqId);
+            buffer.append(line, static_cast<size_t>(written));
+        }
+        alnWriter.writeData(buffer.c_str(), buffer.size(), static_cast<unsigned int>(i));
+    }
+    seqWriter.close();
+    alnWriter.close();
+}
+
+// usage of the scaling tests: test_<name> [sequences] [maxThreads], the thread count doubles up to maxThreads
+struct ScalingArguments {
+    size_t sequences;
+    int maxThreads;
+
+    ScalingArguments(int argc, const char *argv[], size_t defaultSequences)
+            : sequences((argc > 1) ? strtoull(argv[1], NULL, 10) : defaultSequences),
+              maxThreads((argc > 2) ? atoi(argv[2]) : 128) {}
+};
+
+static inline void setThreads(int threads) {
+#ifdef OPENMP
+    omp_set_num_threads(threads);
+#else
+    (void) threads;
+#endif
+}
+
+#endif //MMSEQS_CLUSTERINGTESTUTIL_H
@@ -0,0 +1,153 @@
+// Aligns the same queries and targets twice through the AlignmentCache and checks that the second run takes
+// every result from the cache and gives the same results, that results of targets that left the database are
+// dropped after maxAge runs and that results of other alignment parameters are dropped.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <unistd.h>
+
+#include "AlignmentCache.h"
+#include "EvalueComputation.h"
+#include "FileUtil.h"
+#include "Matcher.h"
+#include "Parameters.h"
+#include "Sequence.h"
+#include "SubstitutionMatrix.h"
+
+const char* binary_name = "test_alignmentcache";
+
+const char RESIDUES[] = "ACDEFGHIKLMNPQRSTVWY";
+
+std::string randomSequence(size_t length) {
+    std::string seq(length, 'A');
+    for (size_t i = 0; i < length; i++) {
+        seq[i] = RESIDUES[rand() % 20];
+    }
+    return seq;
+}
+
+// 20% substitutions
+std::string mutate(const std::string &seq) {
+    std::string result(seq);
+    for (size_t i = 0; i < result.size(); i++) {
+        if (rand() % 5 == 0) {
+            result[i] = RESIDUES[rand() % 20];
+        }
+    }
+    return result;
+}
+
+bool sameResult(const Matcher::result_t &a, const Matcher::result_t &b) {
+    return a.dbKey == b.dbKey && a.score == b.score && a.qcov == b.qcov && a.dbcov == b.dbcov && a.seqId == b.seqId
+           && a.eval == b.eval && a.alnLength == b.alnLength && a.qStartPos == b.qStartPos && a.qEndPos == b.qEndPos
+           && a.qLen == b.qLen && a.dbStartPos == b.dbStartPos && a.dbEndPos == b.dbEndPos && a.dbLen == b.dbLen
+           && a.backtrace == b.backtrace;
+}
+
+struct Run {
+    std::vector<Matcher::result_t> results;
+    size_t hits;
+    size_t records;
+};
+
+// aligns the first queryCount queries with the first targetCount targets
+Run align(const std::string &cacheDB, size_t parameterHash, unsigned int maxAge,
+          const std::vector<std::string> &queries, size_t queryCount,
+          const std::vector<std::string> &targets, size_t targetCount,
+          SubstitutionMatrix &subMat, EvalueComputation &evaluer) {
+    const double evalThr = 1000;
+    AlignmentCache cache(cacheDB, parameterHash, maxAge, 1);
+    AlignmentCache::QueryEntry entry;
+    Sequence qSeq(10000, Sequence::AMINO_ACIDS, &subMat, 0, false, false);
+    Sequence dbSeq(10000, Sequence::AMINO_ACIDS, &subMat, 0, false, false);
+    Matcher matcher(Sequence::AMINO_ACIDS, 10000, &subMat, &evaluer, false, Matcher::GAP_OPEN, Matcher::GAP_EXTEND);
+    Run run;
+    for (size_t q = 0; q < queryCount; q++) {
+        qSeq.mapSequence(q, static_cast<unsigned int>(q), queries[q].c_str());
+        matcher.initQuery(&qSeq);
+        cache.loadQuery(entry, qSeq);
+        for (size_t t = 0; t < targetCount; t++) {
+            dbSeq.mapSequence(t, static_cast<unsigned int>(t), targets[t].c_str());
+            const size_t targetHash = AlignmentCache::hashSequence(dbSeq);
+            Matcher::result_t res;
+            if (cache.lookup(entry, dbSeq, targetHash, 0, evaluer, evalThr, res, 0) == false) {
+                res = matcher.getSWResult(&dbSeq, 0, Parameters::COV_MODE_BIDIRECTIONAL, 0.0, evalThr,
+                                          Matcher::SCORE_COV_SEQID, Parameters::SEQ_ID_ALN_LEN, false);
+                cache.add(entry, targetHash, static_cast<unsigned int>(dbSeq.L), 0, matcher.getLastRawScore(), res);
+            }
+            run.results.push_back(res);
+        }
+        cache.writeQuery(entry, 0);
+    }
+    cache.close();
+    run.hits = cache.getCacheHits();
+    run.records = cache.getRecordCount();
+    return run;
+}
+
+bool check(const std::string &what, size_t value, size_t expected) {
+    std::cout << what << ": " << value << "\n";
+    if (value != expected) {
+        std::cout << "expected " << expected << "\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, const char *argv[]) {
+    srand(1);
+    char tmpDir[] = "/tmp/test_alignmentcache_XXXXXX";
+    const std::string cacheDB = std::string((argc > 1) ? argv[1] : mkdtemp(tmpDir)) + "/cache";
+
+    std::vector<std::string> queries;
+    for (size_t i = 0; i < 20; i++) {
+        queries.push_back(randomSequence(50 + rand() % 300) + "\n");
+    }
+    // every other target is a mutated copy of a query
+    std::vector<std::string> targets;
+    for (size_t i = 0; i < 30; i++) {
+        targets.push_back(((i % 2 == 0) ? mutate(queries[i % queries.size()]) : randomSequence(50 + rand() % 300)) + "\n");
+    }
+    SubstitutionMatrix subMat("blosum62.out", 2.0, 0.0);
+    EvalueComputation evaluer(100000, &subMat, Matcher::GAP_OPEN, Matcher::GAP_EXTEND, true);
+
+    const size_t pairs = queries.size() * targets.size();
+    const size_t kept = queries.size() * (targets.size() / 2);
+    const unsigned int maxAge = 1;
+    bool ok = true;
+
+    Run first = align(cacheDB, 1, maxAge, queries, queries.size(), targets, targets.size(), subMat, evaluer);
+    ok &= check("cache hits of the first run", first.hits, 0);
+    Run second = align(cacheDB, 1, maxAge, queries, queries.size(), targets, targets.size(), subMat, evaluer);
+    ok &= check("cache hits of the second run", second.hits, pairs);
+    ok &= check("records after the second run", second.records, pairs);
+    for (size_t i = 0; i < pairs; i++) {
+        if (sameResult(first.results[i], second.results[i]) == false) {
+            std::cout << "result " << i << " differs in the second run\n";
+            ok = false;
+        }
+    }
+
+    // half of the targets leave the database, their results are kept for maxAge runs
+    Run third = align(cacheDB, 1, maxAge, queries, queries.size(), targets, targets.size() / 2, subMat, evaluer);
+    ok &= check("cache hits with half of the targets", third.hits, kept);
+    ok &= check("records after one run without them", third.records, pairs);
+    Run fourth = align(cacheDB, 1, maxAge, queries, queries.size(), targets, targets.size() / 2, subMat, evaluer);
+    ok &= check("records after two runs without them", fourth.records, kept);
+
+    // other parameters do not see the results and replace them, also those of queries that are not aligned
+    Run other = align(cacheDB, 2, maxAge, queries, queries.size() / 2, targets, targets.size() / 2, subMat, evaluer);
+    ok &= check("cache hits with other parameters", other.hits, 0);
+    ok &= check("records with other parameters", other.records, kept / 2);
+
+    FileUtil::deleteFile(cacheDB);
+    FileUtil::deleteFile(cacheDB + ".index");
+    if (argc <= 1) {
+        rmdir(tmpDir);
+    }
+
+    std::cout << (ok ? "ok" : "failed") << "\n";
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
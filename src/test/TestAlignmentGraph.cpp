@@ -0,0 +1,144 @@
+// Checks the alignment graph of the clustering against a plain construction of the symmetric graph:
+// the results of each sequence in database order followed by the missing reverse links in the order of their sources.
+// The graph is built in memory and in mapped files, once with more than 256 different scores (16 bit)
+// and once with few scores (8 bit ranks).
+// usage: test_alignmentgraph [sequences]
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+
+#include "AlignmentGraph.h"
+#include "ClusteringTestUtil.h"
+#include "DBReader.h"
+#include "Parameters.h"
+#include "Util.h"
+
+const char* binary_name = "test_alignmentgraph";
+
+static void writeDatabases(const std::string &seqDB, const std::string &alnDB, size_t sequences, int scoreDigits) {
+    size_t state = 7;
+    std::vector<size_t> lengths(sequences);
+    std::vector<std::vector<TestAlignment> > alignments(sequences);
+    for (size_t i = 0; i < sequences; i++) {
+        lengths[i] = 20 + nextRandom(state) % 300;
+
+        // the sequence itself, some close keys and a few random ones, unsorted and in part one-sided
+        std::vector<unsigned int> targets;
+        targets.push_back(static_cast<unsigned int>(i));
+        const size_t count = nextRandom(state) % 12;
+        for (size_t j = 0; j < count; j++) {
+            const size_t target = (nextRandom(state) % 4 == 0) ? nextRandom(state) % sequences
+                                                                : (i + nextRandom(state) % 20) % sequences;
+            if (std::find(targets.begin(), targets.end(), target) == targets.end()) {
+                targets.push_back(static_cast<unsigned int>(target));
+            }
+        }
+        for (size_t j = 0; j < targets.size(); j++) {
+            const double seqId = (nextRandom(state) % 1001) / 1000.0;
+            alignments[i].push_back(TestAlignment(targets[j], static_cast<int>(nextRandom(state) % 400), seqId));
+        }
+    }
+    writeClusteringDatabases(seqDB, alnDB, lengths, alignments, scoreDigits);
+}
+
+static bool checkGraph(DBReader<unsigned int> &seqDbr, DBReader<unsigned int> &alnDbr, const std::string &graphDir,
+                       size_t expectedScoreBytes) {
+    const size_t dbSize = seqDbr.getSize();
+    std::vector<std::vector<unsigned int> > elements(dbSize);
+    std::vector<std::vector<short> > scores(dbSize);
+    for (size_t i = 0; i < dbSize; i++) {
+        char *data = alnDbr.getDataByDBKey(seqDbr.getDbKey(i));
+        char *words[4];
+        while (*data != '\0') {
+            Util::getWordsOfLine(data, words, 4);
+            elements[i].push_back(seqDbr.getId(static_cast<unsigned int>(strtoul(words[0], NULL, 10))));
+            scores[i].push_back(static_cast<short>(static_cast<unsigned short>(atof(words[2]) * 1000.0f)));
+            data = Util::skipLine(data);
+        }
+    }
+    const std::vector<std::vector<unsigned int> > forward = elements;
+    for (size_t setId = 0; setId < dbSize; setId++) {
+        for (size_t j = 0; j < forward[setId].size(); j++) {
+            const unsigned int currElm = forward[setId][j];
+            if (std::find(forward[currElm].begin(), forward[currElm].end(), setId) == forward[currElm].end()) {
+                elements[currElm].push_back(static_cast<unsigned int>(setId));
+                scores[currElm].push_back(scores[setId][j]);
+            }
+        }
+    }
+    std::vector<short> distinct;
+    for (size_t i = 0; i < dbSize; i++) {
+        distinct.insert(distinct.end(), scores[i].begin(), scores[i].end());
+    }
+    std::sort(distinct.begin(), distinct.end());
+    distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+
+    AlignmentGraph graph(&seqDbr, &alnDbr, 1, true, Parameters::APC_SEQID, graphDir);
+    const size_t *offsets = graph.getOffsets();
+    const unsigned int *graphElements = graph.getElements();
+    const unsigned char *scores8 = graph.getScores8();
+    const unsigned short *scores16 = graph.getScores16();
+    if ((expectedScoreBytes == 1 && scores8 == NULL) || (expectedScoreBytes == 2 && scores16 == NULL)) {
+        std::cout << "Scores are not stored in " << expectedScoreBytes << " bytes\n";
+        return false;
+    }
+    size_t maxDegree = 0;
+    for (size_t i = 0; i < dbSize; i++) {
+        maxDegree = std::max(maxDegree, elements[i].size());
+        if (offsets[i + 1] - offsets[i] != elements[i].size()) {
+            std::cout << "Set " << i << " has " << offsets[i + 1] - offsets[i] << " instead of "
+                      << elements[i].size() << " elements\n";
+            return false;
+        }
+        for (size_t j = 0; j < elements[i].size(); j++) {
+            const size_t pos = offsets[i] + j;
+            // 8 bit scores are the ranks of the scores
+            const short expectedScore = (scores8 != NULL) ? static_cast<short>(std::lower_bound(distinct.begin(), distinct.end(), scores[i][j]) - distinct.begin())
+                                                          : scores[i][j];
+            const short score = (scores8 != NULL) ? scores8[pos] : static_cast<short>(scores16[pos]);
+            if (graphElements[pos] != elements[i][j] || score != expectedScore) {
+                std::cout << "Set " << i << " element " << j << " is " << graphElements[pos] << " (" << score
+                          << ") instead of " << elements[i][j] << " (" << expectedScore << ")\n";
+                return false;
+            }
+        }
+    }
+    if (graph.getMaxDegree() != maxDegree) {
+        std::cout << "Max degree " << graph.getMaxDegree() << " instead of " << maxDegree << "\n";
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, const char *argv[]) {
+    const size_t sequences = (argc > 1) ? strtoull(argv[1], NULL, 10) : 5000;
+    TestDirectory directory("test_alignmentgraph");
+    const std::string seqDB = directory.database("seq");
+    const std::string alnDB = directory.database("aln");
+
+    int result = EXIT_SUCCESS;
+    // 3 digits give up to 1001 different sequence identities, 2 digits at most 101
+    for (int scoreDigits = 3; scoreDigits >= 2; scoreDigits--) {
+        writeDatabases(seqDB, alnDB, sequences, scoreDigits);
+        DBReader<unsigned int> seqDbr(seqDB.c_str(), (seqDB + ".index").c_str(), DBReader<unsigned int>::USE_INDEX);
+        seqDbr.open(DBReader<unsigned int>::SORT_BY_LENGTH);
+        DBReader<unsigned int> alnDbr(alnDB.c_str(), (alnDB + ".index").c_str());
+        alnDbr.open(DBReader<unsigned int>::NOSORT);
+        const size_t scoreBytes = (scoreDigits == 3) ? 2 : 1;
+        const std::string graphDirs[] = {"", directory.getPath()};
+        for (size_t i = 0; i < 2; i++) {
+            const bool ok = checkGraph(seqDbr, alnDbr, graphDirs[i], scoreBytes);
+            std::cout << (graphDirs[i].empty() ? "memory" : "mapped files") << ", " << scoreBytes * 8
+                      << " bit scores: " << (ok ? "ok" : "failed") << "\n";
+            if (ok == false) {
+                result = EXIT_FAILURE;
+            }
+        }
+        alnDbr.close();
+        seqDbr.close();
+    }
+    return result;
+}
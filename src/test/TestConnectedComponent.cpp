@@ -0,0 +1,152 @@
+// Compares the connected component clustering (ClusteringAlgorithms::execute(3)) with a breadth first search over
+// the alignment graph in the order of the previous implementation and reports its scaling with the number of threads.
+// The synthetic graph consists of chains and small families of consecutive ids with a few links between them,
+// so that some components are deeper than the search depth (--max-iterations).
+// usage: test_connectedcomponent [sequences] [maxThreads]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <queue>
+#include <algorithm>
+#include <cstdlib>
+#include <climits>
+#include <unordered_map>
+
+#include "AlignmentGraph.h"
+#include "ClusteringAlgorithms.h"
+#include "ClusteringTestUtil.h"
+#include "DBReader.h"
+#include "Parameters.h"
+
+const char* binary_name = "test_connectedcomponent";
+
+static void writeDatabases(const std::string &seqDB, const std::string &alnDB, size_t sequences) {
+    size_t state = 3;
+    // the first id of the block of each id, blocks are chains or families
+    std::vector<size_t> blockStart(sequences);
+    std::vector<bool> chain(sequences);
+    for (size_t i = 0; i < sequences; ) {
+        const bool isChain = nextRandom(state) % 10 == 0;
+        const size_t size = 1 + nextRandom(state) % (isChain ? 300 : 40);
+        for (size_t j = i; j < std::min(i + size, sequences); j++) {
+            blockStart[j] = i;
+            chain[j] = isChain;
+        }
+        i += size;
+    }
+    std::vector<std::vector<unsigned int> > links(sequences);
+    for (size_t i = 0; i < sequences; i++) {
+        links[i].push_back(static_cast<unsigned int>(i));
+        if (chain[i]) {
+            if (i + 1 < sequences && blockStart[i + 1] == blockStart[i]) {
+                links[i].push_back(static_cast<unsigned int>(i + 1));
+            }
+        } else if (i > blockStart[i]) {
+            links[i].push_back(static_cast<unsigned int>(blockStart[i] + nextRandom(state) % (i - blockStart[i])));
+        }
+        if (nextRandom(state) % 20000 == 0) {
+            links[i].push_back(static_cast<unsigned int>(nextRandom(state) % sequences));
+        }
+    }
+    std::vector<size_t> lengths(sequences);
+    std::vector<std::vector<TestAlignment> > alignments(sequences);
+    for (size_t i = 0; i < sequences; i++) {
+        lengths[i] = 20 + nextRandom(state) % 500;
+        for (size_t j = 0; j < links[i].size(); j++) {
+            alignments[i].push_back(TestAlignment(links[i][j], 100, 0.5));
+        }
+    }
+    writeClusteringDatabases(seqDB, alnDB, lengths, alignments);
+}
+
+// breadth first search of the previous implementation: starts at the unassigned sequence with the most links
+// (the larger id first among equals) and assigns everything up to maxIterations links away
+static std::vector<unsigned int> searchComponents(AlignmentGraph &graph, int maxIterations) {
+    const size_t dbSize = graph.getSize();
+    const size_t *offsets = graph.getOffsets();
+    const unsigned int *elements = graph.getElements();
+    std::vector<std::pair<size_t, unsigned int> > order(dbSize);
+    for (size_t i = 0; i < dbSize; i++) {
+        order[i] = std::make_pair(offsets[i + 1] - offsets[i], static_cast<unsigned int>(i));
+    }
+    std::sort(order.rbegin(), order.rend());
+    std::vector<unsigned int> assigned(dbSize, UINT_MAX);
+    for (size_t i = 0; i < dbSize; i++) {
+        const unsigned int representative = order[i].second;
+        if (assigned[representative] != UINT_MAX) {
+            continue;
+        }
+        assigned[representative] = representative;
+        std::queue<std::pair<unsigned int, int> > queue;
+        queue.push(std::make_pair(representative, 0));
+        while (queue.empty() == false) {
+            const unsigned int id = queue.front().first;
+            const int depth = queue.front().second;
+            queue.pop();
+            assigned[id] = representative;
+            for (size_t pos = offsets[id]; pos < offsets[id + 1]; pos++) {
+                if (assigned[elements[pos]] == UINT_MAX && depth < maxIterations) {
+                    queue.push(std::make_pair(elements[pos], depth + 1));
+                }
+                assigned[elements[pos]] = representative;
+            }
+        }
+    }
+    return assigned;
+}
+
+int main(int argc, const char *argv[]) {
+    const ScalingArguments arguments(argc, argv, 200000);
+    const size_t sequences = arguments.sequences;
+    TestDirectory directory("test_connectedcomponent");
+    const std::string seqDB = directory.database("seq");
+    const std::string alnDB = directory.database("aln");
+    writeDatabases(seqDB, alnDB, sequences);
+
+    DBReader<unsigned int> seqDbr(seqDB.c_str(), (seqDB + ".index").c_str(), DBReader<unsigned int>::USE_INDEX);
+    seqDbr.open(DBReader<unsigned int>::SORT_BY_LENGTH);
+    DBReader<unsigned int> alnDbr(alnDB.c_str(), (alnDB + ".index").c_str());
+    alnDbr.open(DBReader<unsigned int>::NOSORT);
+
+    int result = EXIT_SUCCESS;
+    std::cout << "maxIterations\tthreads\ttime\tspeedup\tclusters\n";
+    const int maxIterations[] = {1, 10, 1000};
+    for (size_t k = 0; k < 3; k++) {
+        std::vector<unsigned int> reference;
+        {
+            AlignmentGraph graph(&seqDbr, &alnDbr, 1, false, Parameters::APC_SEQID, "");
+            reference = searchComponents(graph, maxIterations[k]);
+        }
+        double referenceTime = 0.0;
+        for (int threads = 1; threads <= arguments.maxThreads; threads *= 2) {
+            setThreads(threads);
+            ClusteringAlgorithms algorithm(&seqDbr, &alnDbr, threads, Parameters::APC_SEQID, maxIterations[k], "");
+            const double start = now();
+            std::unordered_map<unsigned int, std::vector<unsigned int> > clusters = algorithm.execute(3);
+            const double time = now() - start;
+            if (threads == 1) {
+                referenceTime = time;
+            }
+            std::vector<unsigned int> assigned(sequences, UINT_MAX);
+            for (std::unordered_map<unsigned int, std::vector<unsigned int> >::const_iterator it = clusters.begin();
+                 it != clusters.end(); ++it) {
+                for (size_t j = 0; j < it->second.size(); j++) {
+                    assigned[it->second[j]] = it->first;
+                }
+            }
+            if (assigned != reference) {
+                std::cout << "The clustering with " << threads << " threads and max iterations " << maxIterations[k]
+                          << " differs from the breadth first search\n";
+                result = EXIT_FAILURE;
+            }
+            std::cout << maxIterations[k] << "\t" << threads << "\t" << std::fixed << std::setprecision(3) << time
+                      << "s\t" << referenceTime / time << "\t" << clusters.size() << "\n";
+        }
+    }
+
+    alnDbr.close();
+    seqDbr.close();
+    return result;
+}
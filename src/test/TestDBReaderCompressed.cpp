@@ -0,0 +1,116 @@
+// Writes a compressed database and checks that getData, getData with a buffer and getDataByDBKey inflate
+// the right entries, that an entry read into a buffer stays valid while others are read and that a stale .zdict is ignored.
+// usage: test_dbreadercompressed [output prefix]
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "DBReader.h"
+#include "DBWriter.h"
+#include "FileUtil.h"
+#include "Util.h"
+
+const char* binary_name = "test_dbreadercompressed";
+
+static std::string entryText(unsigned int key) {
+    std::string text;
+    for (unsigned int i = 0; i < 1 + key % 7; i++) {
+        text.append(SSTR(key)).append("\tACDEFGHIKLMNPQRSTVWY\t").append(SSTR(i * key)).append("\n");
+    }
+    return text;
+}
+
+static std::string readFile(const std::string &fileName) {
+    std::string content(FileUtil::getFileSize(fileName), '\0');
+    FILE *file = FileUtil::openFileOrDie(fileName.c_str(), "r", true);
+    if (content.empty() == false && fread(&content[0], sizeof(char), content.size(), file) != content.size()) {
+        std::cout << "could not read " << fileName << "\n";
+        exit(EXIT_FAILURE);
+    }
+    fclose(file);
+    return content;
+}
+
+static void writeDatabase(const std::string &name, size_t entries, size_t mode) {
+    DBWriter writer(name.c_str(), (name + ".index").c_str(), 1, mode);
+    writer.open();
+    for (unsigned int key = 0; key < entries; key++) {
+        std::string text = entryText(key);
+        writer.writeData(text.c_str(), text.length(), key);
+    }
+    writer.close();
+}
+
+int main(int argc, const char *argv[]) {
+    const std::string name = (argc > 1) ? argv[1] : "test_dbreadercompressed_db";
+    const size_t entries = 1000;
+    bool ok = true;
+
+    writeDatabase(name, entries, DBWriter::COMPRESSED_MODE);
+    DBReader<unsigned int> reader(name.c_str(), (name + ".index").c_str());
+    reader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
+    if (reader.isCompressed() == false) {
+        std::cout << "database is not compressed\n";
+        return EXIT_FAILURE;
+    }
+
+    // getData reuses one buffer per thread, getData with a buffer keeps the entry of the previous id valid
+    std::vector<char> buffer;
+    std::vector<char> previousBuffer;
+    const char *previous = NULL;
+    for (size_t id = 0; id < reader.getSize(); id++) {
+        const std::string expected = entryText(reader.getDbKey(id));
+        if (expected != reader.getData(id) || reader.getSeqLens(id) != expected.length() + 1) {
+            std::cout << "entry " << reader.getDbKey(id) << " differs\n";
+            ok = false;
+        }
+        if (expected != reader.getData(id, buffer)) {
+            std::cout << "entry " << reader.getDbKey(id) << " differs when read into a buffer\n";
+            ok = false;
+        }
+        if (previous != NULL && entryText(reader.getDbKey(id - 1)) != previous) {
+            std::cout << "entry " << reader.getDbKey(id - 1) << " was overwritten\n";
+            ok = false;
+        }
+        buffer.swap(previousBuffer);
+        previous = previousBuffer.data();
+    }
+    if (entryText(reader.getDbKey(0)) != reader.getDataByDBKey(reader.getDbKey(0))) {
+        std::cout << "entry " << reader.getDbKey(0) << " differs when read by key\n";
+        ok = false;
+    }
+    reader.close();
+
+    // a new uncompressed database with the dictionary of the old one, which claims the size of the new data
+    const std::string dictFileName = DBReader<unsigned int>::compressionDictFileName(name.c_str());
+    const std::string dictionary = readFile(dictFileName);
+    writeDatabase(name, entries, DBWriter::ASCII_MODE);
+    DBReader<unsigned int>::CompressionDictHeader header;
+    memcpy(&header, dictionary.data(), sizeof(DBReader<unsigned int>::CompressionDictHeader));
+    header.dataFileSize = FileUtil::getFileSize(name);
+    FILE *dictFile = FileUtil::openFileOrDie(dictFileName.c_str(), "w", false);
+    fwrite(&header, sizeof(DBReader<unsigned int>::CompressionDictHeader), 1, dictFile);
+    fwrite(dictionary.data() + sizeof(DBReader<unsigned int>::CompressionDictHeader), sizeof(char),
+           dictionary.size() - sizeof(DBReader<unsigned int>::CompressionDictHeader), dictFile);
+    fclose(dictFile);
+    DBReader<unsigned int> plainReader(name.c_str(), (name + ".index").c_str());
+    plainReader.open(DBReader<unsigned int>::NOSORT);
+    if (plainReader.isCompressed() == true) {
+        std::cout << "stale dictionary was used\n";
+        ok = false;
+    }
+    for (size_t id = 0; id < plainReader.getSize(); id++) {
+        if (entryText(plainReader.getDbKey(id)) != plainReader.getData(id)) {
+            std::cout << "entry " << plainReader.getDbKey(id) << " of the uncompressed database differs\n";
+            ok = false;
+        }
+    }
+    plainReader.close();
+
+    std::cout << (ok ? "ok" : "failed") << "\n";
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
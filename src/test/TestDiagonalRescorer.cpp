@@ -0,0 +1,114 @@
+// Compares the diagonal scores of DiagonalRescorer with DistanceCalculator::computeSubstitutionStartEndDistance
+// and their speed for hits on the same diagonal as rescorediagonal sees them in linclust.
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+#include "DiagonalRescorer.h"
+#include "DistanceCalculator.h"
+#include "SubstitutionMatrix.h"
+#include "Util.h"
+#include "Timer.h"
+
+const char* binary_name = "test_diagonalrescorer";
+
+const char RESIDUES[] = "ACDEFGHIKLMNPQRSTVWYX";
+
+std::string randomSequence(size_t length) {
+    std::string seq(length, 'A');
+    for (size_t i = 0; i < length; i++) {
+        seq[i] = RESIDUES[rand() % 20];
+    }
+    return seq;
+}
+
+// 10% substitutions
+std::string mutate(const std::string &seq) {
+    std::string result(seq);
+    for (size_t i = 0; i < result.size(); i++) {
+        if (rand() % 10 == 0) {
+            result[i] = RESIDUES[rand() % 21];
+        }
+    }
+    return result;
+}
+
+bool sameAlignment(const DistanceCalculator::LocalAlignment &a, const DistanceCalculator::LocalAlignment &b) {
+    return a.score == b.score && a.startPos == b.startPos && a.endPos == b.endPos;
+}
+
+int main(int, const char**) {
+    srand(1);
+    SubstitutionMatrix subMat("blosum62.out", 2.0, 0.0);
+    SubstitutionMatrix::FastMatrix fastMatrix = SubstitutionMatrix::createAsciiSubMat(subMat);
+    DiagonalRescorer rescorer(subMat);
+
+    // the last query is long enough to saturate the 16 bit scores
+    std::vector<std::string> queries;
+    for (size_t i = 0; i < 1000; i++) {
+        queries.push_back(randomSequence(100 + rand() % 900));
+    }
+    queries.push_back(randomSequence(10000));
+
+    // half of the targets are mutated copies of the query, the other half random, all start on diagonal 0
+    std::vector<std::vector<std::string> > targets(queries.size());
+    for (size_t i = 0; i < queries.size(); i++) {
+        const size_t count = (i + 1 == queries.size()) ? rescorer.getLanes() : 1 + rand() % (3 * rescorer.getLanes());
+        for (size_t t = 0; t < count; t++) {
+            const std::string target = (t % 2 == 0) ? mutate(queries[i]) : randomSequence(queries[i].size());
+            targets[i].push_back(target.substr(0, 1 + rand() % target.size()));
+        }
+    }
+
+    std::vector<DistanceCalculator::LocalAlignment> expected;
+    Timer timer;
+    for (size_t i = 0; i < queries.size(); i++) {
+        for (size_t t = 0; t < targets[i].size(); t++) {
+            expected.push_back(DistanceCalculator::computeSubstitutionStartEndDistance(
+                    queries[i].c_str(), targets[i][t].c_str(), targets[i][t].size(), fastMatrix.matrix));
+        }
+    }
+    std::cout << "scalar: " << expected.size() << " diagonals in " << timer.lap() << "\n";
+
+    std::vector<DistanceCalculator::LocalAlignment> rescored;
+    std::vector<DistanceCalculator::LocalAlignment> batchResults;
+    timer.reset();
+    for (size_t i = 0; i < queries.size(); i++) {
+        rescorer.initQuery(queries[i].c_str(), queries[i].size());
+        for (size_t t = 0; t < targets[i].size(); t++) {
+            rescorer.addTarget(targets[i][t].c_str(), targets[i][t].size());
+            if (rescorer.getTargetCount() == rescorer.getLanes() || t + 1 == targets[i].size()) {
+                rescorer.rescore(0, batchResults);
+                rescored.insert(rescored.end(), batchResults.begin(), batchResults.end());
+            }
+        }
+    }
+    std::cout << "DiagonalRescorer (" << rescorer.getLanes() << " lanes): " << rescored.size() << " diagonals in " << timer.lap() << "\n";
+
+    for (size_t i = 0; i < expected.size(); i++) {
+        if (sameAlignment(expected[i], rescored[i]) == false) {
+            std::cout << "Diagonal " << i << ": score " << rescored[i].score << " (" << rescored[i].startPos << "-" << rescored[i].endPos
+                      << ") instead of " << expected[i].score << " (" << expected[i].startPos << "-" << expected[i].endPos << ")\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    // a diagonal that does not start at the first query position
+    const std::string &query = queries[0];
+    const std::string target = mutate(query.substr(10));
+    rescorer.initQuery(query.c_str(), query.size());
+    rescorer.addTarget(target.c_str(), target.size());
+    rescorer.rescore(10, batchResults);
+    if (sameAlignment(batchResults[0], DistanceCalculator::computeSubstitutionStartEndDistance(
+            query.c_str() + 10, target.c_str(), target.size(), fastMatrix.matrix)) == false) {
+        std::cout << "Wrong score of a shifted diagonal\n";
+        return EXIT_FAILURE;
+    }
+
+    delete[] fastMatrix.matrix;
+    delete[] fastMatrix.matrixData;
+    std::cout << "All diagonals are identical\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,126 @@
+// Compares the windowed nucleotide extension of BandedNucleotideAligner (--extension-window) with the extension
+// in one piece on long diverged copies of a random sequence.
+// Prints the time, the score relative to the extension in one piece and the query coverage for several window sizes.
+// The sequences are short enough for the 16 bit scores of s_align.
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <sys/time.h>
+
+#include "BandedNucleotideAligner.h"
+#include "NucleotideMatrix.h"
+#include "EvalueComputation.h"
+#include "Sequence.h"
+
+const char* binary_name = "test_extensionwindow";
+
+const char BASES[] = "ACGT";
+
+std::string randomSequence(size_t length) {
+    std::string seq(length, 'A');
+    for (size_t i = 0; i < length; i++) {
+        seq[i] = BASES[rand() % 4];
+    }
+    return seq;
+}
+
+// 5% substitutions and 0.5% insertions or deletions of up to 4 bases
+std::string mutate(const std::string &seq) {
+    std::string result;
+    for (size_t i = 0; i < seq.size(); i++) {
+        const int r = rand() % 1000;
+        if (r < 3) {
+            i += rand() % 4;
+            continue;
+        } else if (r < 5) {
+            result.append(randomSequence(1 + rand() % 4));
+        }
+        result.push_back(r < 55 ? BASES[rand() % 4] : seq[i]);
+    }
+    return result;
+}
+
+double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + 1e-6 * t.tv_usec;
+}
+
+int main(int, const char**) {
+    srand(1);
+    const int maxSeqLen = 70000;
+    NucleotideMatrix subMat("nucleotide.out", 1.0, 0.0);
+    EvalueComputation evaluer(100000000, &subMat, 7, 1, true);
+    BandedNucleotideAligner aligner(&subMat, maxSeqLen, 7, 1);
+    Sequence query(maxSeqLen, Sequence::NUCLEOTIDES, &subMat, 0, false, false);
+    Sequence target(maxSeqLen, Sequence::NUCLEOTIDES, &subMat, 0, false, false);
+
+    // the targets have the diverged copy between random flanks
+    std::vector<std::string> queries;
+    std::vector<std::string> targets;
+    for (size_t i = 0; i < 5; i++) {
+        queries.push_back(randomSequence(30000 + rand() % 30000));
+        targets.push_back(randomSequence(1000) + mutate(queries.back()) + randomSequence(1000));
+    }
+
+    const int windows[] = {0, 20000, 5000, 1000};
+    std::vector<s_align> reference;
+    std::cout << "window\ttime\tscore\tquery cov\n";
+    for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+        aligner.setExtensionWindow(windows[w]);
+        std::vector<s_align> results;
+        const double start = now();
+        for (size_t i = 0; i < queries.size(); i++) {
+            query.mapSequence(i, i, queries[i].c_str());
+            target.mapSequence(i, i, targets[i].c_str());
+            aligner.initQuery(&query);
+            results.push_back(aligner.align(&target, -1000, &evaluer));
+        }
+        const double time = now() - start;
+
+        double scoreRatio = 0.0;
+        double queryCov = 0.0;
+        for (size_t i = 0; i < results.size(); i++) {
+            // the cigar has to span the aligned positions
+            int queryCols = 0;
+            int targetCols = 0;
+            for (int32_t c = 0; c < results[i].cigarLen; c++) {
+                const char op = SmithWaterman::cigar_int_to_op(results[i].cigar[c]);
+                const int len = static_cast<int>(SmithWaterman::cigar_int_to_len(results[i].cigar[c]));
+                queryCols += (op != 'D') ? len : 0;
+                targetCols += (op != 'I') ? len : 0;
+            }
+            if (queryCols != results[i].qEndPos1 - results[i].qStartPos1 + 1
+                || targetCols != results[i].dbEndPos1 - results[i].dbStartPos1 + 1) {
+                std::cout << "Cigar of target " << i << " with window " << windows[w]
+                          << " does not match its start and end positions\n";
+                return EXIT_FAILURE;
+            }
+            queryCov += results[i].qCov;
+            if (windows[w] > 0) {
+                scoreRatio += results[i].score1 / static_cast<double>(reference[i].score1);
+            }
+        }
+        if (windows[w] == 0) {
+            reference = results;
+            scoreRatio = results.size();
+        } else {
+            for (size_t i = 0; i < results.size(); i++) {
+                delete [] results[i].cigar;
+            }
+        }
+        std::cout << windows[w] << "\t" << std::fixed << std::setprecision(3) << time << "s\t"
+                  << scoreRatio / results.size() << "\t" << queryCov / results.size() << "\n";
+        if (scoreRatio / results.size() < 0.95) {
+            std::cout << "Windowed extension lost too much score\n";
+            return EXIT_FAILURE;
+        }
+    }
+    for (size_t i = 0; i < reference.size(); i++) {
+        delete [] reference[i].cigar;
+    }
+    return EXIT_SUCCESS;
+}
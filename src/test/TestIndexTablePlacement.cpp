@@ -0,0 +1,96 @@
+// Benchmarks random k-mer lookups in an IndexTable for every huge page and NUMA placement mode.
+// usage: test_indextableplacement [kmerSize] [entriesPerKmer] [lookupsPerThread]
+
+#include <iostream>
+#include <cstdlib>
+
+#include "IndexTable.h"
+#include "MemoryPlacement.h"
+#include "Timer.h"
+
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+const char* binary_name = "test_indextableplacement";
+
+static inline size_t nextRandom(size_t &state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state >> 17;
+}
+
+static IndexTable *createTable(int alphabetSize, int kmerSize, size_t entriesPerKmer, int hugePages) {
+    IndexTable *table = new IndexTable(alphabetSize, kmerSize, false, hugePages);
+    const size_t tableSize = table->getTableSize();
+    const size_t entryCount = tableSize * entriesPerKmer;
+
+    size_t *offsets = table->getOffsets();
+    size_t state = 1;
+    for (size_t i = 0; i < entryCount; i++) {
+        offsets[nextRandom(state) % tableSize]++;
+    }
+    table->initMemory(entryCount / 100);
+    table->init();
+
+    IndexEntryLocal *entries = table->getEntries();
+    state = 1;
+    for (size_t i = 0; i < entryCount; i++) {
+        size_t kmer = nextRandom(state) % tableSize;
+        IndexEntryLocal *entry = &entries[offsets[kmer]++];
+        entry->seqId = (unsigned int) (i / 100);
+        entry->position_j = (unsigned short) i;
+    }
+    table->revertPointer();
+    return table;
+}
+
+int main(int argc, const char *argv[]) {
+    int kmerSize = (argc > 1) ? atoi(argv[1]) : 5;
+    size_t entriesPerKmer = (argc > 2) ? strtoull(argv[2], NULL, 10) : 4;
+    size_t lookups = (argc > 3) ? strtoull(argv[3], NULL, 10) : 10000000;
+    const int alphabetSize = 20;
+
+    unsigned int threads = 1;
+#ifdef OPENMP
+    threads = omp_get_max_threads();
+#endif
+    std::cout << "NUMA nodes: " << MemoryPlacement::getNodes().size() << ", threads: " << threads << "\n";
+
+    const char *hugePageNames[] = {"off", "transparent", "2MB", "1GB"};
+    const char *numaNames[] = {"off", "interleave", "replicate"};
+    for (int hugePages = MemoryPlacement::HUGE_PAGES_OFF; hugePages <= MemoryPlacement::HUGE_PAGES_1G; hugePages++) {
+        for (int numaMode = MemoryPlacement::NUMA_OFF; numaMode <= MemoryPlacement::NUMA_REPLICATE; numaMode++) {
+            IndexTable *table = createTable(alphabetSize, kmerSize, entriesPerKmer, hugePages);
+            table->setMemoryPlacement(numaMode);
+
+            Timer timer;
+            size_t checksum = 0;
+#pragma omp parallel reduction(+: checksum)
+            {
+                unsigned int thread_idx = 0;
+#ifdef OPENMP
+                thread_idx = static_cast<unsigned int>(omp_get_thread_num());
+#endif
+                IndexTable *threadTable = table;
+                if (numaMode == MemoryPlacement::NUMA_REPLICATE) {
+                    const size_t nodeIndex = MemoryPlacement::nodeIndexForThread(thread_idx, threads);
+                    MemoryPlacement::pinThreadToNode(MemoryPlacement::getNodes()[nodeIndex]);
+                    threadTable = table->getReplica(nodeIndex);
+                }
+                size_t state = thread_idx + 1;
+                const size_t tableSize = threadTable->getTableSize();
+                for (size_t i = 0; i < lookups; i++) {
+                    size_t listSize;
+                    IndexEntryLocal *list = threadTable->getDBSeqList(nextRandom(state) % tableSize, &listSize);
+                    for (size_t j = 0; j < listSize; j++) {
+                        checksum += list[j].seqId;
+                    }
+                }
+            }
+            std::cout << "huge pages: " << hugePageNames[hugePages] << "\tnuma: " << numaNames[numaMode]
+                      << "\ttime: " << timer.lap() << "\tchecksum: " << checksum << "\n";
+            delete table;
+        }
+    }
+    return 0;
+}
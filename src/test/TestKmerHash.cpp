@@ -0,0 +1,53 @@
+// Compares the k-mer hashes of computeKmerHashes with rolling circ_hash_next over each sequence
+// for random sequences and the combinations of k-mer size and hash shift.
+// usage: test_kmerhash [sequences]
+
+#include <iostream>
+#include <vector>
+#include <cstdlib>
+
+#include "kmermatcher.h"
+#include "simd.h"
+
+const char* binary_name = "test_kmerhash";
+
+static inline size_t nextRandom(size_t &state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state >> 17;
+}
+
+int main(int argc, const char *argv[]) {
+    const size_t sequences = (argc > 1) ? strtoull(argv[1], NULL, 10) : 200;
+    const int maxLen = 1000;
+    size_t state = 5;
+    std::vector<int> sequence(maxLen);
+    std::vector<unsigned short> residueHash(maxLen + VECSIZE_INT * 2);
+    std::vector<unsigned short> kmerHash(maxLen + VECSIZE_INT * 2);
+    size_t failed = 0;
+    for (int kmerSize = 5; kmerSize <= 32; kmerSize++) {
+        for (unsigned int rol = 1; rol <= 20; rol++) {
+            for (size_t i = 0; i < sequences; i++) {
+                const int L = static_cast<int>(nextRandom(state) % maxLen);
+                for (int pos = 0; pos < L; pos++) {
+                    sequence[pos] = static_cast<int>(nextRandom(state) % 21);
+                }
+                computeKmerHashes(&sequence[0], L, kmerSize, rol, &residueHash[0], &kmerHash[0]);
+                if (L < kmerSize) {
+                    continue;
+                }
+                unsigned short h = circ_hash(&sequence[0], kmerSize, rol);
+                for (int pos = 1; pos + kmerSize <= L; pos++) {
+                    h = circ_hash_next(&sequence[pos], kmerSize, sequence[pos - 1], h, rol);
+                    if (kmerHash[pos] != h) {
+                        std::cout << "k-mer size " << kmerSize << ", hash shift " << rol << ", length " << L
+                                  << ": hash at " << pos << " is " << kmerHash[pos] << " instead of " << h << "\n";
+                        failed++;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+    std::cout << (failed == 0 ? "ok" : "failed") << "\n";
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
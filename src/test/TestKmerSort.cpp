@@ -0,0 +1,81 @@
+// Compares the radix sort of the k-mer positions (sortKmerPositions) with sorting by the comparators
+// for kmers from a small and a large range, rep. sequence ids with many members and equal kmers.
+// usage: test_kmersort [elements]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <sys/time.h>
+
+#include "kmermatcher.h"
+#include "omptl/omptl_algorithm"
+
+const char* binary_name = "test_kmersort";
+
+double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + 1e-6 * t.tv_usec;
+}
+
+static inline size_t nextRandom(size_t &state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state >> 17;
+}
+
+static std::vector<KmerPosition> generate(size_t elements, size_t kmerRange, size_t kmerBase) {
+    size_t state = 11;
+    std::vector<KmerPosition> kmers(elements);
+    for (size_t i = 0; i < elements; i++) {
+        const size_t kmer = kmerBase + ((kmerRange > 0) ? nextRandom(state) % kmerRange : 0);
+        const unsigned int id = static_cast<unsigned int>(nextRandom(state) % (elements / 4 + 1));
+        // the length belongs to the sequence
+        const unsigned short seqLen = static_cast<unsigned short>(20 + id % 1000);
+        kmers[i] = KmerPosition(kmer, id, seqLen, static_cast<short>(nextRandom(state) % 2000) - 1000);
+    }
+    return kmers;
+}
+
+template <typename Compare>
+static bool check(const std::string &name, const std::vector<KmerPosition> &kmers, Compare comp) {
+    std::vector<KmerPosition> expected = kmers;
+    const double comparisonStart = now();
+    omptl::sort(expected.begin(), expected.end(), comp);
+    const double comparisonTime = now() - comparisonStart;
+
+    std::vector<KmerPosition> sorted = kmers;
+    const double radixStart = now();
+    sortKmerPositions(sorted.data(), sorted.size(), comp);
+    const double radixTime = now() - radixStart;
+
+    const bool ok = memcmp(sorted.data(), expected.data(), sizeof(KmerPosition) * kmers.size()) == 0;
+    std::cout << name << "\t" << std::fixed << std::setprecision(3) << comparisonTime << "s\t" << radixTime << "s\t"
+              << (ok ? "ok" : "failed") << "\n";
+    return ok;
+}
+
+int main(int argc, const char *argv[]) {
+    const size_t elements = (argc > 1) ? strtoull(argv[1], NULL, 10) : 10000000;
+    bool ok = true;
+    std::cout << "keys\tomptl::sort\tradix sort\n";
+    // 13^14 different k-mers as in linclust
+    std::vector<KmerPosition> kmers = generate(elements, 3937376385699289ULL, 0);
+    ok &= check("k-mers", kmers, KmerPosition::compareRepSequenceAndIdAndPos);
+    // identity k-mers above the k-mer range and few different values
+    kmers = generate(elements, 1000, 3937376385699289ULL);
+    ok &= check("few k-mers", kmers, KmerPosition::compareRepSequenceAndIdAndPos);
+    kmers = generate(elements, 0, 42);
+    ok &= check("equal k-mers", kmers, KmerPosition::compareRepSequenceAndIdAndPos);
+    // rep. sequence ids
+    kmers = generate(elements, elements / 20 + 1, 0);
+    ok &= check("rep. sequences", kmers, KmerPosition::compareRepSequenceAndIdAndDiag);
+    kmers = generate(100, 1 << 20, 0);
+    ok &= check("small", kmers, KmerPosition::compareRepSequenceAndIdAndDiag);
+    kmers = generate(0, 1, 0);
+    ok &= check("empty", kmers, KmerPosition::compareRepSequenceAndIdAndDiag);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,72 @@
+// Round trip of random sorted posting lists through the PostingListCodec and decoding throughput.
+
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+
+#include "IndexTable.h"
+#include "PostingListCodec.h"
+#include "Timer.h"
+
+const char* binary_name = "test_postinglistcodec";
+
+int main(int, const char**) {
+    srand(1);
+    const size_t listSizes[] = {0, 1, 3, 4, 5, 17, 1000, 100000};
+    const unsigned int maxIds[] = {100, 70000, 20000000, 4000000000u};
+    for (size_t s = 0; s < sizeof(listSizes) / sizeof(listSizes[0]); s++) {
+        for (size_t m = 0; m < sizeof(maxIds) / sizeof(maxIds[0]); m++) {
+            const size_t n = listSizes[s];
+            std::vector<IndexEntryLocal> entries(n);
+            for (size_t i = 0; i < n; i++) {
+                entries[i].seqId = (unsigned int) (((size_t) rand() * RAND_MAX + rand()) % maxIds[m]);
+                entries[i].position_j = (unsigned short) rand();
+            }
+            std::sort(entries.begin(), entries.end(), IndexEntryLocal::comapreByIdAndPos);
+
+            const size_t size = PostingListCodec::encodedSize(entries.data(), n);
+            std::vector<unsigned char> buffer(size + PostingListCodec::PADDING);
+            unsigned char *end = PostingListCodec::encode(entries.data(), n, buffer.data());
+            if ((size_t) (end - buffer.data()) != size) {
+                std::cout << "Wrong encoded size for " << n << " entries\n";
+                return EXIT_FAILURE;
+            }
+
+            const unsigned char *in = buffer.data();
+            const size_t decodedSize = PostingListCodec::readCount(in);
+            std::vector<IndexEntryLocal> decoded(decodedSize);
+            PostingListCodec::decode(in, decodedSize, decoded.data());
+            for (size_t i = 0; i < n; i++) {
+                if (decodedSize != n || decoded[i].seqId != entries[i].seqId || decoded[i].position_j != entries[i].position_j) {
+                    std::cout << "Mismatch at " << i << " of " << n << " entries\n";
+                    return EXIT_FAILURE;
+                }
+            }
+            if (n == 100000) {
+                std::cout << "max id " << maxIds[m] << ": " << (double) size / n << " byte per entry instead of "
+                          << sizeof(IndexEntryLocal) << "\n";
+            }
+        }
+    }
+
+    const size_t n = 1000;
+    std::vector<IndexEntryLocal> entries(n);
+    for (size_t i = 0; i < n; i++) {
+        entries[i].seqId = (unsigned int) (i * 1000 + rand() % 1000);
+        entries[i].position_j = (unsigned short) rand();
+    }
+    std::vector<unsigned char> buffer(PostingListCodec::encodedSize(entries.data(), n) + PostingListCodec::PADDING);
+    PostingListCodec::encode(entries.data(), n, buffer.data());
+    std::vector<IndexEntryLocal> decoded(n);
+    Timer timer;
+    size_t checksum = 0;
+    for (size_t rep = 0; rep < 100000; rep++) {
+        const unsigned char *in = buffer.data();
+        const size_t decodedSize = PostingListCodec::readCount(in);
+        PostingListCodec::decode(in, decodedSize, decoded.data());
+        checksum += decoded[rep % n].seqId;
+    }
+    std::cout << "Decoded " << n * 100000 << " entries in " << timer.lap() << " (checksum " << checksum << ")\n";
+    return EXIT_SUCCESS;
+}
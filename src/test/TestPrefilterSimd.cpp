@@ -0,0 +1,155 @@
+// Runs the ungapped diagonal scoring of the prefilter once for each instruction set (MMSEQS_SIMD=sse41|avx2|avx512)
+// supported by the CPU and checks that all of them give the same scores. The targets are mutated copies of the
+// queries and random sequences spread over diagonals with between one and more than 64 hits, so that
+// both the scalar and the byte kernel path are taken and scores saturate.
+// usage: test_prefiltersimd [scores]
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+
+#include "SimdKernels.h"
+#include "SequenceLookup.h"
+#include "SubstitutionMatrix.h"
+#include "UngappedAlignment.h"
+#include "Parameters.h"
+
+const char* binary_name = "test_prefiltersimd";
+
+static const char *AMINO_ACIDS = "ACDEFGHIKLMNPQRSTVWY";
+
+static inline size_t nextRandom(size_t &state) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    return state >> 17;
+}
+
+static std::string randomSequence(size_t &state, size_t length) {
+    std::string seq(length, 'A');
+    for (size_t i = 0; i < length; i++) {
+        seq[i] = AMINO_ACIDS[nextRandom(state) % 20];
+    }
+    return seq;
+}
+
+// prints one line per hit: query, target, diagonal and score
+static void printScores() {
+    const size_t queryCount = 8;
+    const size_t targetsPerQuery = 160;
+    const size_t maxLen = 2048;
+    Parameters &par = Parameters::getInstance();
+    SubstitutionMatrix subMat(par.scoringMatrixFile.c_str(), 8.0, -0.2f);
+
+    size_t state = 42;
+    std::vector<std::string> queries;
+    std::vector<std::string> targets;
+    // target i belongs to query i / targetsPerQuery and is found on diagonal diagonals[i]
+    std::vector<short> diagonals;
+    for (size_t q = 0; q < queryCount; q++) {
+        queries.push_back(randomSequence(state, 50 + nextRandom(state) % 600));
+        const std::string &query = queries.back();
+        for (size_t t = 0; t < targetsPerQuery; t++) {
+            if (t % 2 == 0) {
+                // a copy with 10% substitutions behind a random prefix, the prefix length is the negative diagonal
+                const size_t prefix = (t < 80) ? 0 : ((t < 120) ? 1 : t % 7);
+                std::string target = randomSequence(state, prefix) + query;
+                for (size_t i = prefix; i < target.size(); i++) {
+                    if (nextRandom(state) % 10 == 0) {
+                        target[i] = AMINO_ACIDS[nextRandom(state) % 20];
+                    }
+                }
+                targets.push_back(target);
+                diagonals.push_back(-static_cast<short>(prefix));
+            } else {
+                targets.push_back(randomSequence(state, 20 + nextRandom(state) % 1000));
+                const short unrelated[] = {0, 0, 3, -1, 17, -250};
+                diagonals.push_back((t % 13 == 1) ? static_cast<short>(500 + t) : unrelated[t % 6]);
+            }
+        }
+    }
+
+    size_t totalLen = 0;
+    std::vector<Sequence *> targetSeqs;
+    for (size_t i = 0; i < targets.size(); i++) {
+        Sequence *seq = new Sequence(maxLen, Sequence::AMINO_ACIDS, &subMat, 6, true, false);
+        seq->mapSequence(i, i, targets[i].c_str());
+        totalLen += seq->L;
+        targetSeqs.push_back(seq);
+    }
+    SequenceLookup lookup(targets.size(), totalLen);
+    for (size_t i = 0; i < targetSeqs.size(); i++) {
+        lookup.addSequence(targetSeqs[i]);
+    }
+
+    UngappedAlignment matcher(maxLen, &subMat, &lookup);
+    Sequence query(maxLen, Sequence::AMINO_ACIDS, &subMat, 6, true, false);
+    float *compositionBias = new float[maxLen];
+    std::vector<CounterResult> hits(targetsPerQuery);
+    for (size_t q = 0; q < queryCount; q++) {
+        query.mapSequence(q, q, queries[q].c_str());
+        SubstitutionMatrix::calcLocalAaBiasCorrection(&subMat, query.int_sequence, query.L, compositionBias);
+        for (size_t t = 0; t < targetsPerQuery; t++) {
+            const size_t id = q * targetsPerQuery + t;
+            hits[t].id = id;
+            hits[t].diagonal = static_cast<unsigned short>(diagonals[id]);
+            hits[t].count = 0;
+        }
+        matcher.processQuery(&query, compositionBias, hits.data(), hits.size());
+        for (size_t t = 0; t < targetsPerQuery; t++) {
+            std::cout << q << "\t" << hits[t].id << "\t" << static_cast<short>(hits[t].diagonal) << "\t"
+                      << static_cast<int>(hits[t].count) << "\n";
+        }
+    }
+    delete[] compositionBias;
+    for (size_t i = 0; i < targetSeqs.size(); i++) {
+        delete targetSeqs[i];
+    }
+}
+
+static bool runScores(const std::string &binary, const std::string &name, std::string &output) {
+    const std::string command = "MMSEQS_SIMD=" + name + " '" + binary + "' scores";
+    FILE *pipe = popen(command.c_str(), "r");
+    if (pipe == NULL) {
+        return false;
+    }
+    char buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, sizeof(char), sizeof(buffer), pipe)) > 0) {
+        output.append(buffer, read);
+    }
+    return pclose(pipe) == 0;
+}
+
+int main(int argc, const char *argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "scores") {
+        printScores();
+        return EXIT_SUCCESS;
+    }
+
+    bool ok = true;
+    std::string reference;
+    std::string referenceName;
+    const char *names[] = {"avx2", "sse41", "avx512"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (SimdKernels::get(names[i]) == NULL) {
+            std::cout << names[i] << "\tnot supported\n";
+            continue;
+        }
+        std::string output;
+        if (runScores(argv[0], names[i], output) == false || output.empty()) {
+            std::cout << names[i] << "\tcould not run\n";
+            ok = false;
+            continue;
+        }
+        if (referenceName.empty()) {
+            reference = output;
+            referenceName = names[i];
+        }
+        const bool same = (output == reference);
+        std::cout << names[i] << "\t" << (same ? "ok" : "differs from " + referenceName) << "\n";
+        ok &= same;
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
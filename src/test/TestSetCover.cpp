@@ -0,0 +1,105 @@
+// Scaling of the set cover clustering (ClusteringAlgorithms::execute(1)) with the number of threads on a synthetic
+// alignment graph of dense families of up to 1500 members and a few links between them.
+// The clustering with every thread count has to be identical to the one with a single thread.
+// The time includes building the alignment graph. Only the neighbor scan of setCover runs in parallel, its
+// selection is sequential, so the set cover alone is logged as "Time for set cover".
+// usage: test_setcover [sequences] [maxThreads]
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstdlib>
+#include <unordered_map>
+
+#include "ClusteringAlgorithms.h"
+#include "ClusteringTestUtil.h"
+#include "DBReader.h"
+
+const char* binary_name = "test_setcover";
+
+int main(int argc, const char *argv[]) {
+    const ScalingArguments arguments(argc, argv, 20000);
+    const size_t sequences = arguments.sequences;
+    TestDirectory directory("test_setcover");
+    const std::string seqDB = directory.database("seq");
+    const std::string alnDB = directory.database("aln");
+
+    // families of consecutive ids, every tenth one large
+    size_t state = 1;
+    std::vector<size_t> family(sequences);
+    std::vector<size_t> familyStart;
+    for (size_t i = 0; i < sequences; ) {
+        const size_t size = 1 + nextRandom(state) % ((nextRandom(state) % 10 == 0) ? 1500 : 30);
+        familyStart.push_back(i);
+        for (size_t j = i; j < std::min(i + size, sequences); j++) {
+            family[j] = familyStart.size() - 1;
+        }
+        i += size;
+    }
+    familyStart.push_back(sequences);
+
+    std::vector<size_t> lengths(sequences);
+    std::vector<std::vector<TestAlignment> > alignments(sequences);
+    size_t edges = 0;
+    std::vector<unsigned int> targets;
+    for (size_t i = 0; i < sequences; i++) {
+        lengths[i] = 50 + nextRandom(state) % 500;
+
+        // the sequence itself, a third of its family and rarely a sequence of another family
+        targets.clear();
+        targets.push_back(static_cast<unsigned int>(i));
+        for (size_t j = familyStart[family[i]]; j < familyStart[family[i] + 1]; j++) {
+            if (j != i && nextRandom(state) % 3 == 0) {
+                targets.push_back(static_cast<unsigned int>(j));
+            }
+        }
+        if (nextRandom(state) % 20 == 0) {
+            targets.push_back(static_cast<unsigned int>(nextRandom(state) % sequences));
+        }
+        std::sort(targets.begin() + 1, targets.end());
+        targets.erase(std::unique(targets.begin() + 1, targets.end()), targets.end());
+        if (targets.size() > 1 && targets[1] == i) {
+            targets.erase(targets.begin() + 1);
+        }
+
+        for (size_t j = 0; j < targets.size(); j++) {
+            const int score = static_cast<int>(100 + nextRandom(state) % 400);
+            alignments[i].push_back(TestAlignment(targets[j], score, 0.3 + (nextRandom(state) % 700) / 1000.0));
+        }
+        edges += targets.size();
+    }
+    writeClusteringDatabases(seqDB, alnDB, lengths, alignments);
+    std::cout << sequences << " sequences, " << familyStart.size() - 1 << " families, " << edges << " alignments\n";
+
+    DBReader<unsigned int> seqDbr(seqDB.c_str(), (seqDB + ".index").c_str(), DBReader<unsigned int>::USE_INDEX);
+    seqDbr.open(DBReader<unsigned int>::SORT_BY_LENGTH);
+    DBReader<unsigned int> alnDbr(alnDB.c_str(), (alnDB + ".index").c_str());
+    alnDbr.open(DBReader<unsigned int>::NOSORT);
+
+    std::unordered_map<unsigned int, std::vector<unsigned int> > reference;
+    double referenceTime = 0.0;
+    int result = EXIT_SUCCESS;
+    std::cout << "threads\ttime\tspeedup\tclusters\n";
+    for (int threads = 1; threads <= arguments.maxThreads; threads *= 2) {
+        setThreads(threads);
+        ClusteringAlgorithms algorithm(&seqDbr, &alnDbr, threads, 0, 1, "");
+        const double start = now();
+        std::unordered_map<unsigned int, std::vector<unsigned int> > clusters = algorithm.execute(1);
+        const double time = now() - start;
+        if (threads == 1) {
+            reference = clusters;
+            referenceTime = time;
+        } else if (clusters != reference) {
+            std::cout << "The clustering with " << threads << " threads differs from the one with 1 thread\n";
+            result = EXIT_FAILURE;
+        }
+        std::cout << threads << "\t" << std::fixed << std::setprecision(3) << time << "s\t"
+                  << referenceTime / time << "\t" << clusters.size() << "\n";
+    }
+
+    alnDbr.close();
+    seqDbr.close();
+    return result;
+}
@@ -0,0 +1,343 @@
+// Compares the Smith-Waterman and diagonal scores of all SimdKernels supported by the CPU and their speed.
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+
+#include "SimdKernels.h"
+#include "simd.h"
+#include "Util.h"
+#include "Timer.h"
+
+const char* binary_name = "test_simdkernels";
+
+const int ALPHABET_SIZE = 21;
+const uint8_t GAP_OPEN = 11;
+const uint8_t GAP_EXTEND = 1;
+
+struct Kernel {
+    const SimdKernels *kernels;
+    SimdKernels::Workspace workspace;
+    void *profileByte;
+    void *profileWord;
+};
+
+// striped layout of Farrar: lane l of segment i holds query position i + l * segLen
+template <typename T>
+void createProfile(T *profile, size_t lanes, const std::vector<int> &query, const int *mat, int bias) {
+    const size_t segLen = (query.size() + lanes - 1) / lanes;
+    for (int aa = 0; aa < ALPHABET_SIZE; aa++) {
+        for (size_t i = 0; i < segLen; i++) {
+            for (size_t lane = 0; lane < lanes; lane++) {
+                const size_t j = i + lane * segLen;
+                *profile++ = (T) ((j >= query.size()) ? bias : mat[aa * ALPHABET_SIZE + query[j]] + bias);
+            }
+        }
+    }
+}
+
+std::vector<int> randomSequence(size_t length) {
+    std::vector<int> seq(length);
+    for (size_t i = 0; i < length; i++) {
+        seq[i] = rand() % (ALPHABET_SIZE - 1);
+    }
+    return seq;
+}
+
+// similar sequences give scores above 255 and test the word kernels
+std::vector<int> mutate(const std::vector<int> &seq) {
+    std::vector<int> result;
+    for (size_t i = 0; i < seq.size(); i++) {
+        const int r = rand() % 10;
+        if (r == 0) {
+            continue;
+        } else if (r == 1) {
+            result.push_back(rand() % (ALPHABET_SIZE - 1));
+        }
+        result.push_back(r == 2 ? rand() % (ALPHABET_SIZE - 1) : seq[i]);
+    }
+    return result;
+}
+
+bool sameEnd(const SimdKernels::alignment_end &a, const SimdKernels::alignment_end &b) {
+    return a.score == b.score && a.ref == b.ref && a.read == b.read;
+}
+
+int main(int, const char**) {
+    srand(1);
+    int mat[ALPHABET_SIZE * ALPHABET_SIZE];
+    for (int i = 0; i < ALPHABET_SIZE; i++) {
+        for (int j = 0; j < ALPHABET_SIZE; j++) {
+            mat[i * ALPHABET_SIZE + j] = (i == j) ? 5 : -(i + j) % 4;
+        }
+    }
+    const int bias = 3;
+    const size_t maxLen = 2048;
+
+    std::vector<Kernel> kernels;
+    const char *names[] = {"sse41", "avx2", "avx512"};
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        const SimdKernels *k = SimdKernels::get(names[i]);
+        if (k == NULL) {
+            std::cout << names[i] << " not supported\n";
+            continue;
+        }
+        Kernel kernel;
+        kernel.kernels = k;
+        const size_t bytes = (maxLen + k->vectorSize / 2 - 1) / (k->vectorSize / 2) * k->vectorSize;
+        kernel.workspace.vHStore = mem_align(MAX_ALIGN_INT, bytes);
+        kernel.workspace.vHLoad = mem_align(MAX_ALIGN_INT, bytes);
+        kernel.workspace.vE = mem_align(MAX_ALIGN_INT, bytes);
+        kernel.workspace.vHmax = mem_align(MAX_ALIGN_INT, bytes);
+        kernel.workspace.maxColumn = new uint8_t[maxLen * sizeof(uint16_t)];
+        kernel.profileByte = mem_align(MAX_ALIGN_INT, bytes * ALPHABET_SIZE);
+        kernel.profileWord = mem_align(MAX_ALIGN_INT, bytes * ALPHABET_SIZE);
+        kernels.push_back(kernel);
+    }
+
+    for (size_t test = 0; test < 500; test++) {
+        const std::vector<int> query = randomSequence(1 + rand() % (maxLen / 2));
+        const std::vector<int> target = (test % 2 == 0) ? mutate(query) : randomSequence(1 + rand() % (maxLen / 2));
+        SimdKernels::alignment_end first = {0, 0, 0};
+        SimdKernels::alignment_end firstWord = {0, 0, 0};
+        int firstUngapped = 0;
+        for (size_t k = 0; k < kernels.size(); k++) {
+            Kernel &kernel = kernels[k];
+            createProfile((int8_t *) kernel.profileByte, kernel.kernels->vectorSize, query, mat, bias);
+            createProfile((int16_t *) kernel.profileWord, kernel.kernels->vectorSize / 2, query, mat, 0);
+            SimdKernels::alignment_end *byteEnd = kernel.kernels->swByte(kernel.workspace, target.data(), 0, target.size(), query.size(),
+                                                                         GAP_OPEN, GAP_EXTEND, kernel.profileByte, -1, bias, query.size() / 2);
+            SimdKernels::alignment_end *wordEnd = kernel.kernels->swWord(kernel.workspace, target.data(), 0, target.size(), query.size(),
+                                                                         GAP_OPEN, GAP_EXTEND, kernel.profileWord, -1, query.size() / 2);
+            // continuing in 16 bit before the byte scores overflow has to give the scores of the word kernel
+            SimdKernels::alignment_end *byteWordEnd = kernel.kernels->swByteWord(kernel.workspace, target.data(), target.size(), query.size(),
+                                                                                 GAP_OPEN, GAP_EXTEND, kernel.profileByte, bias,
+                                                                                 kernel.profileWord, 5, query.size() / 2);
+            if (!sameEnd(byteWordEnd[0], wordEnd[0])) {
+                std::cout << kernel.kernels->name << ": byte with word scores and word end differ in test " << test << "\n";
+                return EXIT_FAILURE;
+            }
+            free(byteWordEnd);
+            const int ungapped = kernel.kernels->ungapped(kernel.workspace, target.data(), target.size(), kernel.profileByte, query.size(), bias);
+            if (byteEnd[0].score != 255 && byteEnd[0].score > 0 && (byteEnd[0].score != wordEnd[0].score || byteEnd[0].ref != wordEnd[0].ref)) {
+                std::cout << kernel.kernels->name << ": byte and word score differ in test " << test << "\n";
+                return EXIT_FAILURE;
+            }
+            // the padding lanes behind the query carry scores into the next column, so the second best
+            // alignment depends on the number of lanes, only the best one has to be identical
+            if (k == 0) {
+                first = byteEnd[0];
+                firstWord = wordEnd[0];
+                firstUngapped = ungapped;
+            } else if (!sameEnd(first, byteEnd[0]) || !sameEnd(firstWord, wordEnd[0]) || firstUngapped != ungapped) {
+                std::cout << kernel.kernels->name << " differs from " << kernels[0].kernels->name << " in test " << test << "\n";
+                return EXIT_FAILURE;
+            }
+            free(byteEnd);
+            free(wordEnd);
+        }
+    }
+
+    // diagonal scores of one query against a full vector of targets
+    const size_t queryLen = 300;
+    char *diagonalProfile = (char *) mem_align(MAX_ALIGN_INT, queryLen * SimdKernels::DIAGONAL_PROFILE_SIZE);
+    memset(diagonalProfile, 0, queryLen * SimdKernels::DIAGONAL_PROFILE_SIZE);
+    const std::vector<int> query = randomSequence(queryLen);
+    for (size_t pos = 0; pos < queryLen; pos++) {
+        for (int aa = 0; aa < ALPHABET_SIZE; aa++) {
+            diagonalProfile[pos * SimdKernels::DIAGONAL_PROFILE_SIZE + aa] = (char) (mat[aa * ALPHABET_SIZE + query[pos]] + bias);
+        }
+    }
+    unsigned char *dbSeq = (unsigned char *) mem_align(MAX_ALIGN_INT, queryLen * MAX_ALIGN_INT);
+    for (size_t i = 0; i < queryLen * MAX_ALIGN_INT; i++) {
+        dbSeq[i] = (unsigned char) (rand() % ALPHABET_SIZE);
+    }
+    for (size_t k = 0; k < kernels.size(); k++) {
+        const unsigned int lanes = kernels[k].kernels->vectorSize;
+        std::vector<unsigned int> scores(lanes);
+        kernels[k].kernels->diagonalScores(diagonalProfile, bias, queryLen, dbSeq, scores.data());
+        for (unsigned int lane = 0; lane < lanes; lane++) {
+            int score = 0;
+            int max = 0;
+            for (size_t pos = 0; pos < queryLen; pos++) {
+                score += diagonalProfile[pos * SimdKernels::DIAGONAL_PROFILE_SIZE + dbSeq[pos * lanes + lane]] - bias;
+                score = (score < 0) ? 0 : score;
+                max = (score > max) ? score : max;
+            }
+            if (scores[lane] != (unsigned int) std::min(max, 255)) {
+                std::cout << kernels[k].kernels->name << ": wrong diagonal score in lane " << lane << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    // exact diagonal scores with start and end of one query against a full vector of word lanes,
+    // the scores of the similar targets exceed a byte
+    char *rescoreProfile = (char *) mem_align(MAX_ALIGN_INT, queryLen * 2 * SimdKernels::DIAGONAL_PROFILE_SIZE);
+    for (size_t pos = 0; pos < queryLen; pos++) {
+        for (size_t aa = 0; aa < SimdKernels::DIAGONAL_PROFILE_SIZE; aa++) {
+            const short score = (aa < (size_t) ALPHABET_SIZE) ? (short) mat[aa * ALPHABET_SIZE + query[pos]] : -128;
+            rescoreProfile[pos * 2 * SimdKernels::DIAGONAL_PROFILE_SIZE + aa] = (char) (score & 0xFF);
+            rescoreProfile[(pos * 2 + 1) * SimdKernels::DIAGONAL_PROFILE_SIZE + aa] = (char) ((score >> 8) & 0xFF);
+        }
+    }
+    for (size_t k = 0; k < kernels.size(); k++) {
+        const unsigned int lanes = kernels[k].kernels->vectorSize / 2;
+        std::vector<std::vector<int> > targets;
+        for (unsigned int lane = 0; lane < lanes; lane++) {
+            std::vector<int> target = (lane % 2 == 0) ? query : randomSequence(queryLen);
+            for (size_t pos = 0; lane % 2 == 0 && pos < queryLen; pos += 1 + rand() % 20) {
+                target[pos] = rand() % (ALPHABET_SIZE - 1);
+            }
+            target.resize(1 + rand() % queryLen);
+            targets.push_back(target);
+        }
+        std::vector<std::string> targetSeqs(lanes);
+        std::vector<const char *> targetPointers(lanes);
+        std::vector<short> lengths(lanes);
+        for (unsigned int lane = 0; lane < lanes; lane++) {
+            targetSeqs[lane].assign(targets[lane].begin(), targets[lane].end());
+            targetPointers[lane] = targetSeqs[lane].c_str();
+            lengths[lane] = (short) targets[lane].size();
+        }
+        std::vector<short> scores(lanes);
+        std::vector<short> starts(lanes);
+        std::vector<short> ends(lanes);
+        kernels[k].kernels->diagonalRescore(rescoreProfile, targetPointers.data(), lengths.data(), queryLen,
+                                            scores.data(), starts.data(), ends.data());
+        for (unsigned int lane = 0; lane < lanes; lane++) {
+            int score = 0;
+            int max = 0;
+            int minPos = -1;
+            int start = 0;
+            int end = 0;
+            for (size_t pos = 0; pos < targets[lane].size(); pos++) {
+                score += mat[targets[lane][pos] * ALPHABET_SIZE + query[pos]];
+                if (score <= 0) {
+                    score = 0;
+                    minPos = (int) pos;
+                }
+                if (score > max) {
+                    max = score;
+                    start = minPos + 1;
+                    end = (int) pos;
+                }
+            }
+            if (scores[lane] != max || starts[lane] != start || ends[lane] != end) {
+                std::cout << kernels[k].kernels->name << ": wrong exact diagonal score in lane " << lane << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+    }
+    free(rescoreProfile);
+
+    // inter-sequence scores of one query against a full vector of targets
+    const int32_t interQueryLen = 120;
+    const std::vector<int> interQuery = randomSequence(interQueryLen);
+    char *scoreRows = (char *) mem_align(MAX_ALIGN_INT, SimdKernels::DIAGONAL_PROFILE_SIZE * SimdKernels::DIAGONAL_PROFILE_SIZE);
+    memset(scoreRows, 0, SimdKernels::DIAGONAL_PROFILE_SIZE * SimdKernels::DIAGONAL_PROFILE_SIZE);
+    for (int aa = 0; aa < ALPHABET_SIZE; aa++) {
+        for (int target = 0; target < ALPHABET_SIZE; target++) {
+            scoreRows[aa * SimdKernels::DIAGONAL_PROFILE_SIZE + target] = (char) (mat[target * ALPHABET_SIZE + aa] + bias);
+        }
+    }
+    std::vector<unsigned char> interQuerySeq(interQuery.begin(), interQuery.end());
+    std::vector<unsigned char> positionBias(interQueryLen, 0);
+    for (size_t k = 0; k < kernels.size(); k++) {
+        const int32_t lanes = kernels[k].kernels->vectorSize;
+        std::vector<std::vector<int> > targets;
+        int32_t maxTargetLen = 0;
+        for (int32_t lane = 0; lane < lanes; lane++) {
+            targets.push_back((lane % 2 == 0) ? mutate(interQuery) : randomSequence(1 + rand() % 200));
+            maxTargetLen = std::max(maxTargetLen, (int32_t) targets.back().size());
+        }
+        unsigned char *interleaved = (unsigned char *) mem_align(MAX_ALIGN_INT, maxTargetLen * lanes);
+        memset(interleaved, SimdKernels::PADDING_RESIDUE, maxTargetLen * lanes);
+        for (int32_t lane = 0; lane < lanes; lane++) {
+            for (size_t i = 0; i < targets[lane].size(); i++) {
+                interleaved[i * lanes + lane] = (unsigned char) targets[lane][i];
+            }
+        }
+        SimdKernels::InterSequenceWorkspace workspace;
+        workspace.vH = mem_align(MAX_ALIGN_INT, interQueryLen * lanes);
+        workspace.vE = mem_align(MAX_ALIGN_INT, interQueryLen * lanes);
+        workspace.vPositionBias = mem_align(MAX_ALIGN_INT, interQueryLen * lanes);
+        workspace.vScores = mem_align(MAX_ALIGN_INT, SimdKernels::DIAGONAL_PROFILE_SIZE * lanes);
+        std::vector<uint8_t> scores(lanes);
+        std::vector<int32_t> dbEnds(lanes);
+        kernels[k].kernels->interSequence(workspace, scoreRows, ALPHABET_SIZE, interQuerySeq.data(), positionBias.data(),
+                                          interQueryLen, interleaved, maxTargetLen, GAP_OPEN, GAP_EXTEND, bias,
+                                          scores.data(), dbEnds.data());
+        // scalar Gotoh with the same first-maximum convention
+        for (int32_t lane = 0; lane < lanes; lane++) {
+            const std::vector<int> &target = targets[lane];
+            std::vector<int> H(interQueryLen + 1, 0);
+            std::vector<int> E(interQueryLen + 1, 0);
+            int best = 0;
+            int bestEnd = -1;
+            for (size_t i = 0; i < target.size(); i++) {
+                int diagonal = 0;
+                int F = 0;
+                for (int32_t j = 1; j <= interQueryLen; j++) {
+                    int h = std::max(0, diagonal + mat[target[i] * ALPHABET_SIZE + interQuery[j - 1]]);
+                    h = std::max(h, std::max(E[j], F));
+                    diagonal = H[j];
+                    H[j] = h;
+                    E[j] = std::max(E[j] - GAP_EXTEND, h - GAP_OPEN);
+                    F = std::max(F - GAP_EXTEND, h - GAP_OPEN);
+                    if (h > best) {
+                        best = h;
+                        bestEnd = (int) i;
+                    }
+                }
+            }
+            if (best + bias < 255 && (scores[lane] != best || dbEnds[lane] != bestEnd)) {
+                std::cout << kernels[k].kernels->name << ": wrong inter-sequence score in lane " << lane << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+        free(workspace.vH);
+        free(workspace.vE);
+        free(workspace.vPositionBias);
+        free(workspace.vScores);
+        free(interleaved);
+    }
+    free(scoreRows);
+
+    const std::vector<int> timingQuery = randomSequence(350);
+    std::vector<std::vector<int> > targets;
+    for (size_t i = 0; i < 2000; i++) {
+        targets.push_back(randomSequence(100 + rand() % 400));
+    }
+    for (size_t k = 0; k < kernels.size(); k++) {
+        Kernel &kernel = kernels[k];
+        createProfile((int8_t *) kernel.profileByte, kernel.kernels->vectorSize, timingQuery, mat, bias);
+        Timer timer;
+        size_t cells = 0;
+        size_t checksum = 0;
+        for (size_t i = 0; i < targets.size(); i++) {
+            SimdKernels::alignment_end *end = kernel.kernels->swByte(kernel.workspace, targets[i].data(), 0, targets[i].size(), timingQuery.size(),
+                                                                     GAP_OPEN, GAP_EXTEND, kernel.profileByte, -1, bias, timingQuery.size() / 2);
+            checksum += end[0].score;
+            cells += targets[i].size() * timingQuery.size();
+            free(end);
+        }
+        std::cout << kernel.kernels->name << ": " << cells << " cells in " << timer.lap() << " (checksum " << checksum << ")\n";
+    }
+
+    for (size_t k = 0; k < kernels.size(); k++) {
+        free(kernels[k].workspace.vHStore);
+        free(kernels[k].workspace.vHLoad);
+        free(kernels[k].workspace.vE);
+        free(kernels[k].workspace.vHmax);
+        delete[] kernels[k].workspace.maxColumn;
+        free(kernels[k].profileByte);
+        free(kernels[k].profileWord);
+    }
+    free(diagonalProfile);
+    free(dbSeq);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+// Compares the banded X-drop alignment of Matcher (--xdrop-band) with full Smith-Waterman on long multi-domain targets.
+// Each target has mutated copies of the query embedded in random residues, the first copy is the seed diagonal.
+// Prints the time and the share of hits that still pass the e-value threshold for several band widths and X-drops.
+//
+// test_xdropalignment [domains.fasta]
+// the sequences of the FASTA file (at least 50 residues) are used as queries instead of random sequences
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "kseq.h"
+#include "Matcher.h"
+#include "Sequence.h"
+#include "SubstitutionMatrix.h"
+#include "EvalueComputation.h"
+#include "Util.h"
+
+const char* binary_name = "test_xdropalignment";
+
+KSEQ_INIT(int, read)
+
+const char RESIDUES[] = "ACDEFGHIKLMNPQRSTVWY";
+
+struct Hit {
+    std::string target;
+    int diagonal;
+};
+
+std::string randomSequence(size_t length) {
+    std::string seq(length, 'A');
+    for (size_t i = 0; i < length; i++) {
+        seq[i] = RESIDUES[rand() % 20];
+    }
+    return seq;
+}
+
+// 30% substitutions and 4% insertions or deletions
+std::string mutate(const std::string &seq) {
+    std::string result;
+    for (size_t i = 0; i < seq.size(); i++) {
+        const int r = rand() % 100;
+        if (r < 2) {
+            continue;
+        } else if (r < 4) {
+            result.push_back(RESIDUES[rand() % 20]);
+        }
+        result.push_back(r < 34 ? RESIDUES[rand() % 20] : seq[i]);
+    }
+    return result;
+}
+
+std::vector<std::string> readSequences(const char *fastaFile, size_t maxCount) {
+    std::vector<std::string> sequences;
+    FILE *file = fopen(fastaFile, "r");
+    if (file == NULL) {
+        std::cout << "Could not open " << fastaFile << "\n";
+        EXIT(EXIT_FAILURE);
+    }
+    kseq_t *seq = kseq_init(fileno(file));
+    while (kseq_read(seq) >= 0 && sequences.size() < maxCount) {
+        if (seq->seq.l >= 50 && seq->seq.l < 1000) {
+            sequences.push_back(seq->seq.s);
+        }
+    }
+    kseq_destroy(seq);
+    fclose(file);
+    return sequences;
+}
+
+double now() {
+    struct timeval t;
+    gettimeofday(&t, NULL);
+    return t.tv_sec + 1e-6 * t.tv_usec;
+}
+
+int main(int argc, const char **argv) {
+    srand(1);
+    const size_t queryCount = 200;
+    const int maxSeqLen = 20000;
+    const double evalThr = 0.001;
+
+    std::vector<std::string> queries;
+    if (argc > 1) {
+        queries = readSequences(argv[1], queryCount);
+    } else {
+        for (size_t i = 0; i < queryCount; i++) {
+            queries.push_back(randomSequence(100 + rand() % 300));
+        }
+    }
+
+    // targets of 5000 to 8000 residues with one to three copies of the query
+    std::vector<std::vector<Hit> > hits(queries.size());
+    for (size_t i = 0; i < queries.size(); i++) {
+        for (size_t t = 0; t < 5; t++) {
+            const size_t targetLen = 5000 + rand() % 3000;
+            const size_t copies = 1 + rand() % 3;
+            Hit hit;
+            hit.diagonal = 0;
+            for (size_t c = 0; c < copies; c++) {
+                hit.target.append(randomSequence((targetLen - queries[i].size()) / copies));
+                if (c == 0) {
+                    hit.diagonal = -static_cast<int>(hit.target.size());
+                }
+                hit.target.append(mutate(queries[i]));
+            }
+            hits[i].push_back(hit);
+        }
+    }
+
+    SubstitutionMatrix subMat("blosum62.out", 2.0, 0.0);
+    EvalueComputation evaluer(100000000, &subMat, Matcher::GAP_OPEN, Matcher::GAP_EXTEND, true);
+    Sequence query(maxSeqLen, Sequence::AMINO_ACIDS, &subMat, 0, false, true);
+    Sequence target(maxSeqLen, Sequence::AMINO_ACIDS, &subMat, 0, false, true);
+    Matcher matcher(Sequence::AMINO_ACIDS, maxSeqLen, &subMat, &evaluer, true, Matcher::GAP_OPEN, Matcher::GAP_EXTEND);
+
+    const int bandWidths[] = {0, 8, 16, 32, 64};
+    const float xdrops[] = {15.0f, 25.0f, 40.0f};
+    std::vector<Matcher::result_t> reference;
+    double referenceTime = 0.0;
+    std::cout << "band\txdrop\ttime\tspeedup\tsensitivity\tsame score\n";
+    for (size_t b = 0; b < sizeof(bandWidths) / sizeof(bandWidths[0]); b++) {
+        for (size_t x = 0; x < sizeof(xdrops) / sizeof(xdrops[0]); x++) {
+            if (bandWidths[b] == 0 && x > 0) {
+                break;
+            }
+            matcher.setXdropBand(bandWidths[b], xdrops[x]);
+            std::vector<Matcher::result_t> results;
+            const double start = now();
+            for (size_t i = 0; i < queries.size(); i++) {
+                query.mapSequence(i, i, queries[i].c_str());
+                matcher.initQuery(&query);
+                for (size_t t = 0; t < hits[i].size(); t++) {
+                    target.mapSequence(t, t, hits[i][t].target.c_str());
+                    results.push_back(matcher.getSWResult(&target, hits[i][t].diagonal, 0, 0.0, evalThr,
+                                                          Matcher::SCORE_COV_SEQID, 0, false));
+                }
+            }
+            const double time = now() - start;
+
+            if (bandWidths[b] == 0) {
+                reference = results;
+                referenceTime = time;
+                std::cout << "full\t-\t" << std::fixed << std::setprecision(3) << time << "s\t1.00\t1.000\t1.000\n";
+                continue;
+            }
+            size_t passed = 0;
+            size_t found = 0;
+            size_t sameScore = 0;
+            for (size_t i = 0; i < results.size(); i++) {
+                if (results[i].score > reference[i].score) {
+                    std::cout << "Banded score " << results[i].score << " is above the full score "
+                              << reference[i].score << " of hit " << i << "\n";
+                    return EXIT_FAILURE;
+                }
+                // the backtrace has to span the aligned positions
+                size_t queryCols = 0;
+                size_t targetCols = 0;
+                for (size_t pos = 0; pos < results[i].backtrace.size(); pos++) {
+                    queryCols += (results[i].backtrace[pos] != 'D') ? 1 : 0;
+                    targetCols += (results[i].backtrace[pos] != 'I') ? 1 : 0;
+                }
+                if (results[i].backtrace.empty() == false
+                    && (queryCols != static_cast<size_t>(results[i].qEndPos - results[i].qStartPos + 1)
+                        || targetCols != static_cast<size_t>(results[i].dbEndPos - results[i].dbStartPos + 1))) {
+                    std::cout << "Backtrace of hit " << i << " does not match its start and end positions\n";
+                    return EXIT_FAILURE;
+                }
+                passed += (reference[i].eval <= evalThr) ? 1 : 0;
+                found += (reference[i].eval <= evalThr && results[i].eval <= evalThr) ? 1 : 0;
+                sameScore += (results[i].score == reference[i].score) ? 1 : 0;
+            }
+            std::cout << bandWidths[b] << "\t" << std::setprecision(0) << xdrops[x] << "\t"
+                      << std::setprecision(3) << time << "s\t" << std::setprecision(2) << referenceTime / time << "\t"
+                      << std::setprecision(3) << found / static_cast<double>(std::max(passed, (size_t) 1)) << "\t"
+                      << sameScore / static_cast<double>(results.size()) << "\n";
+        }
+    }
+    return EXIT_SUCCESS;
+}
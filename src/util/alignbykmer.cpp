@@ -5,6 +5,7 @@
 #include "Debug.h"
 #include "DBReader.h"
 #include "DBWriter.h"
+#include "SequenceStore.h"
 #include "QueryMatcher.h"
 #include "NucleotideMatrix.h"
 #include "ReducedMatrix.h"
@@ -32,11 +33,23 @@ int alignbykmer(int argc, const char **argv, const Command &command) {
 #endif
 
 
+    Debug(Debug::INFO) << "Target  file: " << par.db2 << "\n";
+    // the targets are encoded with the (reduced) alphabet of this run, an index can not be used
+    SequenceStore tStore(par.db2, par.db2Index, false, true, static_cast<size_t>(par.seqCacheLimit) * 1024 * 1024);
+    DBReader<unsigned int> *tdbr = tStore.getReader();
+
     Debug(Debug::INFO) << "Query  file: " << par.db1 << "\n";
-    DBReader<unsigned int> *qdbr = new DBReader<unsigned int>(par.db1.c_str(), (par.db1 + ".index").c_str());
-    qdbr->open(DBReader<unsigned int>::NOSORT);
+    DBReader<unsigned int> *qdbr = NULL;
+    bool sameDB = false;
+    if (par.db1.compare(par.db2) == 0) {
+        sameDB = true;
+        qdbr = tdbr;
+    } else {
+        qdbr = new DBReader<unsigned int>(par.db1.c_str(), (par.db1 + ".index").c_str());
+        qdbr->open(DBReader<unsigned int>::NOSORT);
+        qdbr->readMmapedDataInMemory();
+    }
     const int querySeqType = qdbr->getDbtype();
-    qdbr->readMmapedDataInMemory();
 
     BaseMatrix *subMat;
     if (querySeqType == Sequence::NUCLEOTIDES) {
@@ -52,18 +65,6 @@ int alignbykmer(int argc, const char **argv, const Command &command) {
     }
     ScoreMatrix * _2merSubMatrix =  ExtendedSubstitutionMatrix::calcScoreMatrix(*subMat, 2);
 
-    Debug(Debug::INFO) << "Target  file: " << par.db2 << "\n";
-    DBReader<unsigned int> *tdbr = NULL;
-    bool sameDB = false;
-    if (par.db1.compare(par.db2) == 0) {
-        sameDB = true;
-        tdbr = qdbr;
-    } else {
-        tdbr = new DBReader<unsigned int>(par.db2.c_str(), par.db2Index.c_str());
-        tdbr->open(DBReader<unsigned int>::NOSORT);
-        tdbr->readMmapedDataInMemory();
-    }
-
     EvalueComputation evaluer(tdbr->getAminoAcidDBSize(), subMat, Matcher::GAP_OPEN, Matcher::GAP_EXTEND, true);
 
     Debug(Debug::INFO) << "Prefilter database: " << par.db3 << "\n";
@@ -201,9 +202,8 @@ int alignbykmer(int argc, const char **argv, const Command &command) {
                     Util::parseKey(data, dbKeyBuffer);
                     const unsigned int dbKey = (unsigned int) strtoul(dbKeyBuffer, NULL, 10);
                     unsigned int targetId = tdbr->getId(dbKey);
-                    char *targetSeq = tdbr->getData(targetId);
                     const bool isIdentity = (queryId == targetId && (par.includeIdentity || sameDB)) ? true : false;
-                    target.mapSequence(targetId, dbKey, targetSeq);
+                    tStore.mapSequence(target, targetId, dbKey);
                     size_t kmerPosSize = 0;
                     while (target.hasNextKmer()) {
                         const int *kmer = target.nextKmer();
@@ -476,17 +476,14 @@ int alignbykmer(int argc, const char **argv, const Command &command) {
     Debug(Debug::INFO) << "Done." << "\n";
     resultWriter.close();
     dbr_res.close();
-    qdbr->close();
+    if (sameDB == false) {
+        qdbr->close();
+        delete qdbr;
+    }
 
-    delete qdbr;
     delete subMat;
     ScoreMatrix::cleanup(_2merSubMatrix);
 
-    if (sameDB == false) {
-        tdbr->close();
-        delete tdbr;
-    }
-
     return EXIT_SUCCESS;
 }
 
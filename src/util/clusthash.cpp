@@ -90,6 +90,8 @@ int clusthash(int argc, const char **argv, const Command& command) {
     {
         std::vector<unsigned int> setIds;
         std::vector<bool> found;
+        // the query stays in use while the targets are read from the same database
+        std::vector<char> queryBuffer;
 
 #pragma omp for schedule(dynamic, 2)
         for(size_t hashId = 0; hashId < uniqHashes; hashId++) {
@@ -108,7 +110,7 @@ int clusthash(int argc, const char **argv, const Command& command) {
             }
             for(size_t i = 0; i < setIds.size(); i++) {
                 unsigned int queryLength = std::max(seqDbr.getSeqLens(setIds[i]), 3ul) - 2;
-                const char * querySeq =  seqDbr.getData(setIds[i]);
+                const char * querySeq =  seqDbr.getData(setIds[i], queryBuffer);
                 std::stringstream swResultsSs;
                 swResultsSs << seqDbr.getDbKey(setIds[i]) << "\t";
                 swResultsSs << 255 << "\t";
@@ -5,12 +5,14 @@
 
 #include <cstring>
 #include <cstdio>
+#include <string>
 
 #include "Parameters.h"
 #include "DBReader.h"
 #include "Debug.h"
 #include "Util.h"
 #include "FileUtil.h"
+#include "Bgzf.h"
 
 const char header_start[] = {'>'};
 const char newline[] = {'\n'};
@@ -26,6 +28,18 @@ int convert2fasta(int argc, const char **argv, const Command& command) {
     db_header.open(DBReader<unsigned int>::NOSORT);
 
     FILE *fastaFP =  FileUtil::openFileOrDie(par.db2.c_str(), "w", false);
+    // a .gz output is written as BGZF, so that it can be split and inflated in parallel downstream
+#ifdef HAVE_ZLIB
+    BgzfWriter *bgzfWriter = NULL;
+    if (Util::endsWith(".gz", par.db2)) {
+        bgzfWriter = new BgzfWriter(fastaFP, par.threads);
+    }
+#else
+    if (Util::endsWith(".gz", par.db2)) {
+        Debug(Debug::ERROR) << "MMseqs was not compiled with zlib support. Can not write compressed output!\n";
+        EXIT(EXIT_FAILURE);
+    }
+#endif
 
     DBReader<unsigned int>* from = &db;
     if(par.useHeaderFile) {
@@ -33,20 +47,37 @@ int convert2fasta(int argc, const char **argv, const Command& command) {
     }
 
     Debug(Debug::INFO) << "Start writing file to " << par.db2 << "\n";
+    std::string entry;
     for(size_t i = 0; i < from->getSize(); i++){
         unsigned int key = from->getDbKey(i);
 
         const char* header_data = db_header.getDataByDBKey(key);
 
-        fwrite(header_start, sizeof(char), 1, fastaFP);
-        fwrite(header_data, sizeof(char), strlen(header_data) - 1, fastaFP);
-        fwrite(newline, sizeof(char), 1, fastaFP);
+        entry.append(header_start, 1);
+        entry.append(header_data, strlen(header_data) - 1);
+        entry.append(newline, 1);
 
         const char* body_data = db.getDataByDBKey(key);
-        fwrite(body_data, sizeof(char), strlen(body_data) - 1, fastaFP);
-        fwrite(newline, sizeof(char), 1, fastaFP);
+        entry.append(body_data, strlen(body_data) - 1);
+        entry.append(newline, 1);
+
+#ifdef HAVE_ZLIB
+        if (bgzfWriter != NULL) {
+            bgzfWriter->write(entry.c_str(), entry.length());
+            entry.clear();
+            continue;
+        }
+#endif
+        fwrite(entry.c_str(), sizeof(char), entry.length(), fastaFP);
+        entry.clear();
     }
 
+#ifdef HAVE_ZLIB
+    if (bgzfWriter != NULL) {
+        bgzfWriter->close();
+        delete bgzfWriter;
+    }
+#endif
     fclose(fastaFP);
     db_header.close();
     db.close();
@@ -137,6 +137,7 @@ int convertalignments(int argc, const char **argv, const Command &command) {
     Debug(Debug::INFO) << "Alignment database: " << par.db3 << "\n";
     DBReader<unsigned int> alnDbr(par.db3.c_str(), par.db3Index.c_str());
     alnDbr.open(DBReader<unsigned int>::LINEAR_ACCCESS);
+    const bool binaryInput = (alnDbr.getDbtype() == Sequence::ALIGNMENT_RES_BINARY);
 
 #ifdef OPENMP
     unsigned int totalThreads = par.threads;
@@ -188,7 +189,11 @@ int convertalignments(int argc, const char **argv, const Command &command) {
             }
 
             std::string queryId = qHeaderDbr.getId(queryKey);
-            Matcher::readAlignmentResults(results, data, true);
+            if (binaryInput) {
+                Matcher::readBinaryAlignmentResults(results, data, alnDbr.getSeqLens(i) - 1, true);
+            } else {
+                Matcher::readAlignmentResults(results, data, true);
+            }
             unsigned int missMatchCount;
             for (size_t j = 0; j < results.size(); j++) {
                 const Matcher::result_t &res = results[j];
@@ -312,6 +317,7 @@ int convertalignments(int argc, const char **argv, const Command &command) {
     // tsv output
     if (isDb == false) {
         FileUtil::deleteFile(par.db4Index);
+        DBWriter::removeIndexSidecar(par.db4Index);
     }
 
     alnDbr.close();
@@ -21,6 +21,119 @@
 #include "Util.h"
 #include "KSeqWrapper.h"
 
+#ifdef OPENMP
+#include <omp.h>
+#endif
+
+struct CreateDbEntry {
+    std::string header;
+    std::string sequence;
+    // key of the first (split) entry, before the identifier offset is added
+    unsigned int firstEntry;
+    size_t splitCnt;
+};
+
+struct CreateDbBatch {
+    CreateDbBatch() : size(0) {}
+    // entries are reused between batches to keep their string buffers allocated
+    std::vector<CreateDbEntry> entries;
+    size_t size;
+};
+
+struct CreateDbReaderState {
+    CreateDbReaderState(size_t fileCount)
+            : kseq(NULL), fileIdx(0), entries_num(0), count(0), sampleCount(0), isNuclCnt(0) {
+        // keep number of entries in each file
+        fileToNumEntries = new unsigned int[fileCount];
+        std::fill(fileToNumEntries, fileToNumEntries + fileCount, 0);
+    }
+
+    KSeqWrapper *kseq;
+    size_t fileIdx;
+    unsigned int entries_num;
+    size_t count;
+    size_t sampleCount;
+    size_t isNuclCnt;
+    unsigned int *fileToNumEntries;
+};
+
+static const size_t testForNucSequence = 100;
+
+// Reads the next batch of entries from the input files. Keys are assigned here in input order,
+// so the output keys do not depend on which thread later writes an entry.
+static void readBatch(Parameters &par, const std::vector<std::string> &filenames,
+                      CreateDbReaderState &state, CreateDbBatch &batch) {
+    const size_t maxBatchEntries = 16384;
+    const size_t maxBatchResidues = 64 * 1024 * 1024;
+    size_t residues = 0;
+    batch.size = 0;
+    while (state.fileIdx < filenames.size() && batch.size < maxBatchEntries && residues < maxBatchResidues) {
+        if (state.kseq == NULL) {
+            state.kseq = KSeqFactory(filenames[state.fileIdx].c_str(), par.threads);
+        }
+        if (state.kseq->ReadEntry() == false) {
+            delete state.kseq;
+            state.kseq = NULL;
+            state.fileIdx++;
+            continue;
+        }
+
+        Debug::printProgress(state.count);
+        const KSeqWrapper::KSeqEntry &e = state.kseq->entry;
+        if (e.name.l == 0) {
+            Debug(Debug::ERROR) << "Fasta entry: " << state.entries_num << " is invalid.\n";
+            EXIT(EXIT_FAILURE);
+        }
+
+        if (batch.size == batch.entries.size()) {
+            batch.entries.push_back(CreateDbEntry());
+        }
+        CreateDbEntry &entry = batch.entries[batch.size];
+        batch.size++;
+
+        entry.splitCnt = 1;
+        if (par.splitSeqByLen == true) {
+            entry.splitCnt = (size_t) ceilf(static_cast<float>(e.sequence.l) / static_cast<float>(par.maxSeqLen));
+        }
+        entry.firstEntry = state.entries_num;
+
+        // header
+        entry.header.assign(e.name.s, e.name.l);
+        if (e.comment.l > 0) {
+            entry.header.append(" ", 1);
+            entry.header.append(e.comment.s, e.comment.l);
+        }
+        entry.sequence.assign(e.sequence.s, e.sequence.l);
+        residues += e.sequence.l;
+
+        for (size_t split = 0; split < entry.splitCnt; split++) {
+            // check for the first 10 sequences if they are nucleotide sequences
+            if ((state.count % 100) == 0) {
+                if (state.sampleCount < testForNucSequence) {
+                    size_t cnt = 0;
+                    for (size_t i = 0; i < e.sequence.l; i++) {
+                        switch (toupper(e.sequence.s[i])) {
+                            case 'T':
+                            case 'A':
+                            case 'G':
+                            case 'C':
+                            case 'N': cnt++;
+                                break;
+                        }
+                    }
+                    if (cnt == e.sequence.l) {
+                        state.isNuclCnt += true;
+                    }
+                }
+                state.sampleCount++;
+            }
+            state.entries_num++;
+            state.fileToNumEntries[state.fileIdx]++;
+            state.count++;
+        }
+    }
+}
+
 int createdb(int argn, const char **argv, const Command& command) {
     Parameters &par = Parameters::getInstance();
     par.parseParameters(argn, argv, command, 2, true, Parameters::PARSE_VARIADIC);
@@ -60,139 +173,102 @@ int createdb(int argn, const char **argv, const Command& command) {
         }
     }
 
-    DBWriter out_writer(data_filename.c_str(), index_filename.c_str());
-    DBWriter out_hdr_writer(data_filename_hdr.c_str(), index_filename_hdr.c_str());
+#ifdef OPENMP
+    unsigned int threads = par.threads;
+#else
+    unsigned int threads = 1;
+#endif
+
+    // a shuffled database is rewritten below, only compress the final output
+    const size_t writerMode = (par.compressed && par.shuffleDatabase == false) ? DBWriter::COMPRESSED_MODE : DBWriter::ASCII_MODE;
+    DBWriter out_writer(data_filename.c_str(), index_filename.c_str(), threads, writerMode);
+    DBWriter out_hdr_writer(data_filename_hdr.c_str(), index_filename_hdr.c_str(), threads, writerMode);
     out_writer.open();
     out_hdr_writer.open();
 
-    unsigned int entries_num = 0;
-    size_t count = 0;
-    size_t sampleCount = 0;
-
-    const size_t testForNucSequence = 100;
-    size_t isNuclCnt = 0;
-
-    // keep number of entries in each file
-    unsigned int numEntriesInCurrFile = 0;
-    unsigned int * fileToNumEntries =  new unsigned int[filenames.size()];
-    for (size_t i = 0; i < filenames.size(); i++) {
-        numEntriesInCurrFile = 0;
-        std::string splitHeader;
-        splitHeader.reserve(1024);
-        std::string header;
-        header.reserve(1024);
-        std::string splitId;
-        splitId.reserve(1024);
-        KSeqWrapper *kseq = KSeqFactory(filenames[i].c_str());
-        while (kseq->ReadEntry()) {
-            Debug::printProgress(count);
-            const KSeqWrapper::KSeqEntry &e = kseq->entry;
-            if (e.name.l == 0) {
-                Debug(Debug::ERROR) << "Fasta entry: " << entries_num << " is invalid.\n";
-                EXIT(EXIT_FAILURE);
-            }
-
-            size_t splitCnt = 1;
-            if (par.splitSeqByLen == true) {
-                splitCnt = (size_t) ceilf(static_cast<float>(e.sequence.l) / static_cast<float>(par.maxSeqLen));
-            }
-
-            // header
-            header.append(e.name.s, e.name.l);
-            if (e.comment.l > 0) {
-                header.append(" ", 1);
-                header.append(e.comment.s,e.comment.l);
-            }
-
-            std::string headerId = Util::parseFastaHeader(header);
-            if (headerId == "") {
-                // An identifier is necessary for these two cases, so we should just give up
-                Debug(Debug::WARNING) << "Could not extract identifier from entry " << entries_num << ".\n";
-
-            }
-            for (size_t split = 0; split < splitCnt; split++) {
-                splitId.append(headerId);
-                if (splitCnt > 1) {
-                    splitId.append("_");
-                    splitId.append(SSTR(split));
+    CreateDbReaderState state(filenames.size());
+    // two batches: the reader fills one while the workers write out the other
+    CreateDbBatch batches[2];
+    size_t currBatch = 0;
+    readBatch(par, filenames, state, batches[currBatch]);
+    while (batches[currBatch].size > 0) {
+        CreateDbBatch &batch = batches[currBatch];
+        CreateDbBatch &nextBatch = batches[currBatch ^ 1];
+#pragma omp parallel num_threads(threads)
+        {
+            unsigned int thread_idx = 0;
+#ifdef OPENMP
+            thread_idx = (unsigned int) omp_get_thread_num();
+#endif
+            std::string splitHeader;
+            splitHeader.reserve(1024);
+            std::string splitId;
+            splitId.reserve(1024);
+
+#pragma omp single nowait
+            readBatch(par, filenames, state, nextBatch);
+
+#pragma omp for schedule(dynamic, 16)
+            for (size_t i = 0; i < batch.size; i++) {
+                const CreateDbEntry &e = batch.entries[i];
+                std::string headerId = Util::parseFastaHeader(e.header);
+                if (headerId == "") {
+                    // An identifier is necessary for these two cases, so we should just give up
+                    Debug(Debug::WARNING) << "Could not extract identifier from entry " << e.firstEntry << ".\n";
                 }
-
-                unsigned int id = par.identifierOffset + entries_num;
-
-
-                // For split entries replace the found identifier by identifier_splitNumber
-                // Also add another hint that it was split to the end of the header
-                splitHeader.append(header);
-                if (par.splitSeqByLen == true && splitCnt > 1) {
-                    if (headerId != "") {
-                        size_t pos = splitHeader.find(headerId);
-                        if (pos != std::string::npos) {
-                            splitHeader.erase(pos, headerId.length());
-                            splitHeader.insert(pos, splitId);
-                        }
+                for (size_t split = 0; split < e.splitCnt; split++) {
+                    splitId.append(headerId);
+                    if (e.splitCnt > 1) {
+                        splitId.append("_");
+                        splitId.append(SSTR(split));
                     }
-                    splitHeader.append(" Split=");
-                    splitHeader.append(SSTR(split));
-                }
 
-                // space is needed for later parsing
-                splitHeader.append(" ", 1);
-                splitHeader.append("\n");
-
-                // Finally write down the entry
-                out_hdr_writer.writeData(splitHeader.c_str(), splitHeader.length(), id);
-                splitHeader.clear();
-                splitId.clear();
-
-                // check for the first 10 sequences if they are nucleotide sequences
-                if((count % 100) == 0){
-                    if(sampleCount < testForNucSequence){
-                        size_t cnt=0;
-                        for(size_t i = 0; i < e.sequence.l; i++){
-                            switch(toupper(e.sequence.s[i]))
-                            {
-                                case 'T':
-                                case 'A':
-                                case 'G':
-                                case 'C':
-                                case 'N': cnt++;
-                                    break;
+                    unsigned int id = par.identifierOffset + e.firstEntry + split;
+
+                    // For split entries replace the found identifier by identifier_splitNumber
+                    // Also add another hint that it was split to the end of the header
+                    splitHeader.append(e.header);
+                    if (par.splitSeqByLen == true && e.splitCnt > 1) {
+                        if (headerId != "") {
+                            size_t pos = splitHeader.find(headerId);
+                            if (pos != std::string::npos) {
+                                splitHeader.erase(pos, headerId.length());
+                                splitHeader.insert(pos, splitId);
                             }
                         }
-                        if(cnt == e.sequence.l){
-                            isNuclCnt += true;
-                        }
+                        splitHeader.append(" Split=");
+                        splitHeader.append(SSTR(split));
                     }
-                    sampleCount++;
-                }
 
-                if (par.splitSeqByLen) {
-                    size_t len = std::min(par.maxSeqLen, e.sequence.l - split * par.maxSeqLen);
-                    out_writer.writeStart(0);
-                    out_writer.writeAdd(e.sequence.s + split * par.maxSeqLen, len, 0);
-                    char newLine = '\n';
-                    out_writer.writeAdd(&newLine, 1, 0);
-                    out_writer.writeEnd(id, 0, true);
-                } else {
-                    out_writer.writeStart(0);
-                    out_writer.writeAdd(e.sequence.s, e.sequence.l, 0);
+                    // space is needed for later parsing
+                    splitHeader.append(" ", 1);
+                    splitHeader.append("\n");
+
+                    // Finally write down the entry
+                    out_hdr_writer.writeData(splitHeader.c_str(), splitHeader.length(), id, thread_idx);
+                    splitHeader.clear();
+                    splitId.clear();
+
+                    size_t start = 0;
+                    size_t len = e.sequence.length();
+                    if (par.splitSeqByLen) {
+                        start = split * par.maxSeqLen;
+                        len = std::min(par.maxSeqLen, e.sequence.length() - start);
+                    }
+                    out_writer.writeStart(thread_idx);
+                    out_writer.writeAdd(e.sequence.c_str() + start, len, thread_idx);
                     char newLine = '\n';
-                    out_writer.writeAdd(&newLine, 1, 0);
-                    out_writer.writeEnd(id, 0, true);
+                    out_writer.writeAdd(&newLine, 1, thread_idx);
+                    out_writer.writeEnd(id, thread_idx, true);
                 }
-
-                entries_num++;
-                numEntriesInCurrFile++;
-                count++;
             }
-            header.clear();
         }
-        fileToNumEntries[i] = numEntriesInCurrFile;
-        delete kseq;
+        currBatch ^= 1;
     }
+    unsigned int *fileToNumEntries = state.fileToNumEntries;
 
     int dbType = Sequence::AMINO_ACIDS;
-    if (isNuclCnt == sampleCount || isNuclCnt == testForNucSequence) {
+    if (state.isNuclCnt == state.sampleCount || state.isNuclCnt == testForNucSequence) {
         dbType = Sequence::NUCLEOTIDES;
     }
     out_hdr_writer.close();
@@ -234,7 +310,8 @@ int createdb(int argn, const char **argv, const Command& command) {
             std::swap(lengthHeader[n_new], lengthHeader[n]);
             std::swap(keyToFileAfterShuf[n_new], keyToFileAfterShuf[n]);
         }
-        DBWriter out_writer_shuffled(data_filename.c_str(), index_filename.c_str());
+        const size_t shuffledMode = par.compressed ? DBWriter::COMPRESSED_MODE : DBWriter::ASCII_MODE;
+        DBWriter out_writer_shuffled(data_filename.c_str(), index_filename.c_str(), threads, shuffledMode);
         out_writer_shuffled.open();
         for (unsigned int n = 0; n < readerSequence.getSize(); n++) {
             unsigned int id = par.identifierOffset + n;
@@ -244,7 +321,7 @@ int createdb(int argn, const char **argv, const Command& command) {
         readerSequence.close();
         out_writer_shuffled.close(dbType);
 
-        DBWriter out_hdr_writer_shuffled(data_filename_hdr.c_str(), index_filename_hdr.c_str());
+        DBWriter out_hdr_writer_shuffled(data_filename_hdr.c_str(), index_filename_hdr.c_str(), threads, shuffledMode);
         out_hdr_writer_shuffled.open();
         readerHeader.readMmapedDataInMemory();
         char lookupBuffer[32768];
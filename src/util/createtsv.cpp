@@ -3,6 +3,8 @@
 #include "DBWriter.h"
 #include "Debug.h"
 #include "Util.h"
+#include "Matcher.h"
+#include "Bgzf.h"
 
 #ifdef OPENMP
 #include <omp.h>
@@ -47,6 +49,7 @@ int createtsv(int argc, const char **argv, const Command &command) {
         reader = new DBReader<unsigned int>(par.db2.c_str(), par.db2Index.c_str());
     }
     reader->open(DBReader<unsigned int>::LINEAR_ACCCESS);
+    const bool binaryInput = (reader->getDbtype() == Sequence::ALIGNMENT_RES_BINARY);
 
     DBWriter *writer;
     if (hasTargetDB) {
@@ -73,6 +76,11 @@ int createtsv(int argc, const char **argv, const Command &command) {
         std::string outputBuffer;
         outputBuffer.reserve(10 * 1024);
 
+        // binary alignment results are converted back into their text representation first
+        std::string textResults;
+        std::vector<Matcher::result_t> results;
+        char *resultBuffer = new char[1024 + 32768];
+
 #pragma omp for schedule(dynamic, 1000)
         for (size_t i = 0; i < reader->getSize(); ++i) {
             unsigned int queryKey = reader->getDbKey(i);
@@ -96,6 +104,17 @@ int createtsv(int argc, const char **argv, const Command &command) {
             size_t entryIndex = 0;
 
             char *data = reader->getData(i);
+            if (binaryInput) {
+                Matcher::readBinaryAlignmentResults(results, data, reader->getSeqLens(i) - 1, true);
+                textResults.clear();
+                for (size_t j = 0; j < results.size(); j++) {
+                    bool hasBacktrace = results[j].backtrace.size() > 0;
+                    size_t len = Matcher::resultToBuffer(resultBuffer, results[j], hasBacktrace, false);
+                    textResults.append(resultBuffer, len);
+                }
+                results.clear();
+                data = (char *) textResults.c_str();
+            }
             while (*data != '\0') {
                 if(targetColumn != SIZE_T_MAX){
                     size_t foundElements = Util::getWordsOfLine(data, columnPointer, 255);
@@ -152,6 +171,7 @@ int createtsv(int argc, const char **argv, const Command &command) {
             writer->writeData(outputBuffer.c_str(), outputBuffer.length(), queryKey, thread_idx, par.dbOut);
             outputBuffer.clear();
         }
+        delete[] resultBuffer;
         delete[] dbKey;
         delete[] columnPointer;
     };
@@ -160,10 +180,25 @@ int createtsv(int argc, const char **argv, const Command &command) {
     Debug(Debug::INFO) << "Done.\n";
 
     if (par.dbOut == false) {
-        if (hasTargetDB) {
-            std::remove(par.db4Index.c_str());
-        } else {
-            std::remove(par.db3Index.c_str());
+        std::string outFile = hasTargetDB ? par.db4 : par.db3;
+        std::string outIndex = hasTargetDB ? par.db4Index : par.db3Index;
+        std::remove(outIndex.c_str());
+        DBWriter::removeIndexSidecar(outIndex);
+
+        // a .gz output is compressed as BGZF, so that it can be split and inflated in parallel downstream
+        if (Util::endsWith(".gz", outFile)) {
+#ifdef HAVE_ZLIB
+            std::string plainFile = outFile + "_plain";
+            if (std::rename(outFile.c_str(), plainFile.c_str()) != 0) {
+                Debug(Debug::ERROR) << "Could not move " << outFile << " to " << plainFile << "!\n";
+                EXIT(EXIT_FAILURE);
+            }
+            BgzfWriter::compressFile(plainFile.c_str(), outFile.c_str(), par.threads);
+            std::remove(plainFile.c_str());
+#else
+            Debug(Debug::ERROR) << "MMseqs was not compiled with zlib support. Can not write compressed output!\n";
+            EXIT(EXIT_FAILURE);
+#endif
         }
     }
 
@@ -4,6 +4,7 @@
 #include "DBReader.h"
 #include "Util.h"
 #include "Matcher.h"
+#include "ResultCursor.h"
 #include "FileUtil.h"
 
 #ifdef OPENMP
@@ -33,6 +34,7 @@ int doExtractAlignedRegion(Parameters &par) {
     }
 
     Debug(Debug::INFO) << "Alignment database: " << par.db3 << "\n";
+    ResultCursor::requireText(par.db3);
     DBReader<unsigned int> alndbr(par.db3.c_str(), par.db3Index.c_str());
     alndbr.open(DBReader<unsigned int>::LINEAR_ACCCESS);
 
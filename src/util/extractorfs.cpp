@@ -152,6 +152,7 @@ int extractorfs(int argc, const char **argv, const Command& command) {
                 fclose(hIndex);
                 orfHeaderReader.close();
                 std::rename((par.hdr2Index + "_tmp").c_str(), par.hdr2Index.c_str());
+                DBWriter::removeIndexSidecar(par.hdr2Index);
             }
 
 #pragma omp task
@@ -179,6 +180,7 @@ int extractorfs(int argc, const char **argv, const Command& command) {
                 fclose(sIndex);
                 orfSequenceReader.close();
                 std::rename((par.db2Index + "_tmp").c_str(), par.db2Index.c_str());
+                DBWriter::removeIndexSidecar(par.db2Index);
             }
         }
     }
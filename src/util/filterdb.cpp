@@ -1,5 +1,6 @@
 #include "Parameters.h"
 #include "DBReader.h"
+#include "ResultCursor.h"
 #include "DBWriter.h"
 #include "Util.h"
 #include "Debug.h"
@@ -34,6 +35,7 @@ struct compareFirstEntryDecreasing {
 
 
 int ffindexFilter::initFiles() {
+	ResultCursor::requireText(inDB);
 	dataDb=new DBReader<unsigned int>(inDB.c_str(),(std::string(inDB).append(".index")).c_str());
 	dataDb->open(DBReader<unsigned int>::LINEAR_ACCCESS);
 
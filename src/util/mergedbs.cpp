@@ -13,12 +13,23 @@ int mergedbs(int argc, const char **argv, const Command& command) {
         EXIT(EXIT_FAILURE);
     }
 
+    // binary alignment results are concatenated record by record and can not be mixed with text results
+    const bool binary = DBReader<unsigned int>::parseDbType(par.filenames[2].c_str()) == Sequence::ALIGNMENT_RES_BINARY;
     std::vector<std::pair<std::string, std::string>> filenames;
     for (size_t i = 2; i < par.filenames.size(); ++i) {
+        const bool fileBinary = DBReader<unsigned int>::parseDbType(par.filenames[i].c_str()) == Sequence::ALIGNMENT_RES_BINARY;
+        if (fileBinary != binary) {
+            Debug(Debug::ERROR) << "Can not merge binary and text alignment results: " << par.filenames[i] << "\n";
+            EXIT(EXIT_FAILURE);
+        }
         filenames.emplace_back(par.filenames[i], par.filenames[i] + ".index");
     }
 
     std::vector<std::string> prefixes = Util::split(par.mergePrefixes, ",");
+    if (binary && prefixes.empty() == false) {
+        Debug(Debug::ERROR) << "Prefixes can not be added to binary alignment results.\n";
+        EXIT(EXIT_FAILURE);
+    }
 
     DBReader<unsigned int> qdbr(par.db1.c_str(), par.db1Index.c_str(), DBReader<unsigned int>::USE_INDEX);
     qdbr.open(DBReader<unsigned int>::NOSORT);
@@ -26,7 +37,7 @@ int mergedbs(int argc, const char **argv, const Command& command) {
     DBWriter writer(par.db2.c_str(), par.db2Index.c_str());
     writer.open();
     writer.mergeFiles(qdbr, filenames, prefixes);
-    writer.close();
+    writer.close(binary ? Sequence::ALIGNMENT_RES_BINARY : -1);
 
     qdbr.close();
 
@@ -1,6 +1,7 @@
 #include "Debug.h"
 #include "DBReader.h"
 #include "DBWriter.h"
+#include "ResultCursor.h"
 #include "Parameters.h"
 #include "Util.h"
 
@@ -19,6 +20,7 @@ int mergeresultsbyset(int argc, const char **argv, const Command &command) {
     DBReader<unsigned int> setReader(par.db1.c_str(), par.db1Index.c_str());
     setReader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
 
+    ResultCursor::requireText(par.db2);
     DBReader<unsigned int> resultReader(par.db2.c_str(), par.db2Index.c_str());
     resultReader.open(DBReader<unsigned int>::NOSORT);
 
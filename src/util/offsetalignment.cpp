@@ -4,6 +4,7 @@
 #include "Debug.h"
 #include "DBReader.h"
 #include "DBWriter.h"
+#include "ResultCursor.h"
 #include "Orf.h"
 #include "AlignmentSymmetry.h"
 #include "Timer.h"
@@ -12,10 +13,14 @@
 #include <omp.h>
 #endif
 
-void updateOffset(char* data, std::vector<Matcher::result_t> &results,
+void updateOffset(ResultCursor &cursor, size_t id, std::vector<Matcher::result_t> &results,
                   const Orf::SequenceLocation *qloc, DBReader<unsigned int>& tHeaderDbr) {
     size_t startPos = results.size();
-    Matcher::readAlignmentResults(results, data, true);
+    cursor.reset(id);
+    Matcher::result_t result;
+    while (cursor.next(result, true)) {
+        results.push_back(result);
+    }
     size_t endPos = results.size();
     for (size_t i = startPos; i < endPos; i++) {
         Matcher::result_t &res = results[i];
@@ -70,6 +75,8 @@ int offsetalignment(int argc, const char **argv, const Command &command) {
     Debug(Debug::INFO) << "Result database: " << par.db3 << "\n";
     DBReader<unsigned int> alnDbr(par.db3.c_str(), par.db3Index.c_str());
     alnDbr.open(DBReader<unsigned int>::LINEAR_ACCCESS);
+    // the shifted results are written in the format of the input
+    const bool binary = alnDbr.getDbtype() == Sequence::ALIGNMENT_RES_BINARY;
 
 #ifdef OPENMP
     unsigned int totalThreads = par.threads;
@@ -143,6 +150,7 @@ int offsetalignment(int argc, const char **argv, const Command &command) {
         std::string ss;
         ss.reserve(1024);
 
+        ResultCursor cursor(&alnDbr);
         std::vector<Matcher::result_t> results;
         results.reserve(300);
 
@@ -166,23 +174,22 @@ int offsetalignment(int argc, const char **argv, const Command &command) {
                 for (unsigned int j = 0; j < orfCount; ++j) {
                     unsigned int orfKey = orfKeys[j];
                     size_t orfId = alnDbr.getId(orfKey);
-                    char *data = alnDbr.getData(orfId);
 
                     size_t queryId = qHeaderDbr.getId(orfKey);
                     char *header = qHeaderDbr.getData(queryId);
                     Orf::SequenceLocation qloc = Orf::parseOrfHeader(header);
-                    updateOffset(data, results, &qloc, tHeaderDbr);
+                    updateOffset(cursor, orfId, results, &qloc, tHeaderDbr);
                 }
             } else {
                 queryKey = alnDbr.getDbKey(i);
-                char *data = alnDbr.getData(i);
-                updateOffset(data, results, NULL, tHeaderDbr);
+                updateOffset(cursor, i, results, NULL, tHeaderDbr);
             }
             std::stable_sort(results.begin(), results.end(), Matcher::compareHits);
             for(size_t i = 0; i < results.size(); i++){
                 Matcher::result_t &res = results[i];
                 bool hasBacktrace = (res.backtrace.size() > 0);
-                size_t len = Matcher::resultToBuffer(buffer, res, hasBacktrace, false);
+                size_t len = binary ? Matcher::resultToBinaryBuffer(buffer, res, hasBacktrace, false)
+                                    : Matcher::resultToBuffer(buffer, res, hasBacktrace, false);
                 ss.append(buffer, len);
             }
             resultWriter.writeData(ss.c_str(), ss.length(), queryKey, thread_idx);
@@ -191,7 +198,7 @@ int offsetalignment(int argc, const char **argv, const Command &command) {
         }
     }
     Debug(Debug::INFO) << "\n";
-    resultWriter.close();
+    resultWriter.close(binary ? Sequence::ALIGNMENT_RES_BINARY : -1);
 
     if (contigLookup != NULL) {
         delete[] contigLookup;
@@ -87,6 +87,7 @@ int profile2pssm(int argc, const char **argv, const Command &command) {
     writer.close();
     if (isDbOutput == false) {
         remove(par.db2Index.c_str());
+        DBWriter::removeIndexSidecar(par.db2Index);
     }
 
     Debug(Debug::INFO) << "\nDone.\n";
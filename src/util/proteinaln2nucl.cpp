@@ -5,6 +5,7 @@
 #include "Debug.h"
 #include "DBReader.h"
 #include "DBWriter.h"
+#include "ResultCursor.h"
 
 #ifdef OPENMP
 #include <omp.h>
@@ -36,6 +37,7 @@ int proteinaln2nucl(int argc, const char **argv, const Command &command) {
 
 
     Debug(Debug::INFO) << "Alignment database: " << par.db3 << "\n";
+    ResultCursor::requireText(par.db3);
     DBReader<unsigned int> alnDbr(par.db3.c_str(), par.db3Index.c_str());
     alnDbr.open(DBReader<unsigned int>::LINEAR_ACCCESS);
 
@@ -60,6 +62,9 @@ int proteinaln2nucl(int argc, const char **argv, const Command &command) {
         std::string newBacktrace;
         newBacktrace.reserve(1024);
 
+        // the query stays in use while the targets are read, which can come from the same database
+        std::vector<char> queryBuffer;
+
 #pragma omp for schedule(dynamic, 10)
         for (size_t i = 0; i < alnDbr.getSize(); i++) {
             Debug::printProgress(i);
@@ -68,7 +73,7 @@ int proteinaln2nucl(int argc, const char **argv, const Command &command) {
             char *data = alnDbr.getData(i);
 
             unsigned int queryId = qdbr->getId(alnKey);
-            char *querySeq = qdbr->getData(queryId);
+            char *querySeq = qdbr->getData(queryId, queryBuffer);
 
             Matcher::readAlignmentResults(results, data, true);
             for (size_t j = 0; j < results.size(); j++) {
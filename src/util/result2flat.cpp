@@ -2,6 +2,7 @@
 #include <Parameters.h>
 
 #include "DBReader.h"
+#include "ResultCursor.h"
 #include "Debug.h"
 #include "Util.h"
 
@@ -21,6 +22,7 @@ int result2flat(int argc, const char **argv, const Command &command) {
     targetdb_header.readMmapedDataInMemory();
 
     Debug(Debug::INFO) << "Data file is " << par.db3 << "\n";
+    ResultCursor::requireText(par.db3);
     DBReader<unsigned int> dbr_data(par.db3.c_str(), par.db3Index.c_str());
     dbr_data.open(DBReader<unsigned int>::LINEAR_ACCCESS);
 
@@ -3,6 +3,7 @@
 #include <string>
 #include <vector>
 #include <sstream>
+#include <climits>
 
 #include "MsaFilter.h"
 #include "Parameters.h"
@@ -10,6 +11,8 @@
 #include "DBReader.h"
 #include "DBConcat.h"
 #include "DBWriter.h"
+#include "ResultCursor.h"
+#include "SequenceStore.h"
 #include "HeaderSummarizer.h"
 #include "CompressedA3M.h"
 #include "Debug.h"
@@ -39,15 +42,14 @@ int result2msa(Parameters &par, const std::string &resultData, const std::string
     // NOSORT because the index should be in the same order as resultReader
     queryHeaderReader.open(DBReader<unsigned int>::NOSORT);
 
-    DBReader<unsigned int> *tDbr = &qDbr;
+    // targets are encoded once, even if they are part of many alignments, up to --seq-cache-limit
+    SequenceStore tStore(par.db2, par.db2Index, false, par.noPreload == false, static_cast<size_t>(par.seqCacheLimit) * 1024 * 1024);
+    DBReader<unsigned int> *tDbr = tStore.getReader();
     DBReader<unsigned int> *tempateHeaderReader = &queryHeaderReader;
 
     unsigned int maxSequenceLength = 0;
     const bool sameDatabase = (par.db1.compare(par.db2) == 0) ? true : false;
     if (!sameDatabase) {
-        tDbr = new DBReader<unsigned int>(par.db2.c_str(), par.db2Index.c_str());
-        tDbr->open(DBReader<unsigned int>::NOSORT);
-
         unsigned int *lengths = qDbr.getSeqLens();
         for (size_t i = 0; i < qDbr.getSize(); i++) {
             maxSequenceLength = std::max(lengths[i], maxSequenceLength);
@@ -78,7 +80,7 @@ int result2msa(Parameters &par, const std::string &resultData, const std::string
     resultWriter.open();
 
     // + 1 for query
-    size_t maxSetSize = resultReader.maxCount('\n') + 1;
+    size_t maxSetSize = ResultCursor(&resultReader).maxRecordCount() + 1;
 
     // adjust score of each match state by -0.2 to trim alignment
     SubstitutionMatrix subMat(par.scoringMatrixFile.c_str(), 2.0f, -0.2f);
@@ -106,6 +108,7 @@ int result2msa(Parameters &par, const std::string &resultData, const std::string
         MsaFilter filter(maxSequenceLength, maxSetSize, &subMat);
         UniprotHeaderSummarizer summarizer;
         Sequence centerSequence(maxSequenceLength, qDbr.getDbtype(), &subMat, 0, false, par.compBiasCorrection);
+        ResultCursor cursor(&resultReader);
 
         // which sequences where kept after filtering
         bool *kept = new bool[maxSetSize];
@@ -139,32 +142,24 @@ int result2msa(Parameters &par, const std::string &resultData, const std::string
             }
             char *centerSequenceHeader = queryHeaderReader.getDataByDBKey(queryKey);
 
-            char *results = resultReader.getData(id);
+            cursor.reset(id);
             std::vector<Matcher::result_t> alnResults;
             std::vector<Sequence *> seqSet;
-            while (*results != '\0') {
-                char dbKey[255 + 1];
-                Util::parseKey(results, dbKey);
-                const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
+            Matcher::result_t alnResult;
+            while (cursor.next(alnResult)) {
+                const unsigned int key = alnResult.dbKey;
                 // in the same database case, we have the query repeated
                 if ((key == queryKey && sameDatabase == true)) {
-                    results = Util::skipLine(results);
                     continue;
                 }
 
-                char *entry[255];
-                const size_t columns = Util::getWordsOfLine(results, entry, 255);
-                if (columns > Matcher::ALN_RES_WITH_OUT_BT_COL_CNT) {
-                    Matcher::result_t res = Matcher::parseAlignmentRecord(results);
-                    alnResults.push_back(res);
+                // prefilter hits and results without backtrace are realigned below
+                if (alnResult.backtrace.empty() == false) {
+                    alnResults.push_back(alnResult);
                 }
 
                 const size_t edgeId = tDbr->getId(key);
-                Sequence *edgeSequence = new Sequence(tDbr->getSeqLens(edgeId), Sequence::AMINO_ACIDS, &subMat, 0, false, false);
-
-
-                char *dbSeqData = tDbr->getData(edgeId);
-                if (dbSeqData == NULL) {
+                if (edgeId == UINT_MAX) {
 #pragma omp critical
                     {
                         Debug(Debug::ERROR) << "ERROR: Sequence " << key << " is required in the prefiltering,"
@@ -173,10 +168,9 @@ int result2msa(Parameters &par, const std::string &resultData, const std::string
                         EXIT(EXIT_FAILURE);
                     }
                 }
-                edgeSequence->mapSequence(0, key, dbSeqData);
+                Sequence *edgeSequence = new Sequence(tDbr->getSeqLens(edgeId), Sequence::AMINO_ACIDS, &subMat, 0, false, false);
+                tStore.mapSequence(*edgeSequence, edgeId, key);
                 seqSet.push_back(edgeSequence);
-
-                results = Util::skipLine(results);
             }
 
             // Recompute if not all the backtraces are present
@@ -309,8 +303,6 @@ int result2msa(Parameters &par, const std::string &resultData, const std::string
     if (!sameDatabase) {
         tempateHeaderReader->close();
         delete tempateHeaderReader;
-        tDbr->close();
-        delete tDbr;
     }
 
     Debug(Debug::INFO) << "\nDone.\n";
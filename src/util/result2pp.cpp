@@ -7,6 +7,7 @@
 #include "PSSMCalculator.h"
 #include "DBWriter.h"
 #include "DBReader.h"
+#include "ResultCursor.h"
 #include "DBConcat.h"
 #include "HeaderSummarizer.h"
 #include "CompressedA3M.h"
@@ -48,6 +49,7 @@ int computeProfileProfile(Parameters &par,const std::string &outpath,
         tDbr->open(DBReader<unsigned int>::NOSORT);
     }
 
+    ResultCursor::requireText(par.db3);
     DBReader<unsigned int> *resultReader = new DBReader<unsigned int>(par.db3.c_str(), par.db3Index.c_str());
     resultReader->open(DBReader<unsigned int>::LINEAR_ACCCESS);
     DBWriter resultWriter(outpath.c_str(), (outpath + ".index").c_str(), par.threads, DBWriter::BINARY_MODE);
@@ -5,6 +5,7 @@
 #include "PSSMCalculator.h"
 #include "DBReader.h"
 #include "DBWriter.h"
+#include "ResultCursor.h"
 #include "Debug.h"
 #include "Util.h"
 #include "PrefilteringIndexReader.h"
@@ -119,7 +120,7 @@ int result2profile(DBReader<unsigned int> &resultReader, Parameters &par, const
     }
 
     // + 1 for query
-    size_t maxSetSize = resultReader.maxCount('\n') + 1;
+    size_t maxSetSize = ResultCursor(&resultReader).maxRecordCount() + 1;
 
     // adjust score of each match state by -0.2 to trim alignment
     SubstitutionMatrix subMat(scoringMatrixFile.c_str(), 2.0f, -0.2f);
@@ -150,6 +151,7 @@ int result2profile(DBReader<unsigned int> &resultReader, Parameters &par, const
         PSSMCalculator calculator(&subMat, maxSequenceLength, maxSetSize, par.pca, par.pcb);
         MsaFilter filter(maxSequenceLength, maxSetSize, &subMat);
         Sequence centerSequence(maxSequenceLength, qDbr->getDbtype(), &subMat, 0, false, par.compBiasCorrection);
+        ResultCursor cursor(&resultReader);
         std::string result;
         result.reserve(par.maxSeqLen * Sequence::PROFILE_READIN_SIZE * sizeof(char));
         char *charSequence = new char[maxSequenceLength];
@@ -184,24 +186,20 @@ int result2profile(DBReader<unsigned int> &resultReader, Parameters &par, const
                 centerSequence.mapSequence(0, queryKey, dbSeqData);
             }
 
-            char *results = resultReader.getData(id);
+            cursor.reset(id);
             std::vector<Matcher::result_t> alnResults;
             std::vector<Sequence *> seqSet;
-            while (*results != '\0') {
-                char dbKey[255 + 1];
-                Util::parseKey(results, dbKey);
-                const unsigned int key = (unsigned int) strtoul(dbKey, NULL, 10);
+            Matcher::result_t alnResult;
+            while (cursor.next(alnResult)) {
+                const unsigned int key = alnResult.dbKey;
                 // in the same database case, we have the query repeated
                 if ((key == queryKey && sameDatabase == true)) {
-                    results = Util::skipLine(results);
                     continue;
                 }
 
-                char *entry[255];
-                const size_t columns = Util::getWordsOfLine(results, entry, 255);
-                if (columns > Matcher::ALN_RES_WITH_OUT_BT_COL_CNT) {
-                    Matcher::result_t res = Matcher::parseAlignmentRecord(results);
-                    alnResults.push_back(res);
+                // prefilter hits and results without backtrace are realigned below
+                if (alnResult.backtrace.empty() == false) {
+                    alnResults.push_back(alnResult);
                 }
 
                 const size_t edgeId = tDbr->getId(key);
@@ -226,7 +224,6 @@ int result2profile(DBReader<unsigned int> &resultReader, Parameters &par, const
                 }
 
                 seqSet.push_back(edgeSequence);
-                results = Util::skipLine(results);
             }
 
             // Recompute if not all the backtraces are present
@@ -1,6 +1,7 @@
 #include "result2stats.h"
 
 #include "Alignment.h"
+#include "ResultCursor.h"
 #include "AminoAcidLookupTables.h"
 
 #include "Debug.h"
@@ -56,6 +57,7 @@ StatsComputer::StatsComputer(const Parameters &par)
         : stat(MapStatString(par.stat)),
           queryDb(par.db1), queryDbIndex(par.db1Index),
           targetDb(par.db2), targetDbIndex(par.db2Index) {
+    ResultCursor::requireText(par.db3);
     resultReader = new DBReader<unsigned int>(par.db3.c_str(), par.db3Index.c_str());
     resultReader->open(DBReader<unsigned int>::LINEAR_ACCCESS);
 
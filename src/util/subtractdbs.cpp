@@ -7,6 +7,7 @@
 #include <vector>
 #include <Matcher.h>
 #include "DBReader.h"
+#include "ResultCursor.h"
 #include "Debug.h"
 #include "DBWriter.h"
 #include "Util.h"
@@ -24,11 +25,12 @@ void dosubstractresult(std::string leftDb, std::string rightDb, std::string outD
     leftDbr.open(DBReader<unsigned int>::NOSORT);
     DBReader<unsigned int> rightDbr(rightDb.c_str(), (rightDb + std::string(".index")).c_str());
     rightDbr.open(DBReader<unsigned int>::NOSORT);
+    // the records of the left database are copied verbatim, so the output keeps its format
+    const bool binary = leftDbr.getDbtype() == Sequence::ALIGNMENT_RES_BINARY;
 
     Debug(Debug::INFO) << "Output databse: " << outDb << "\n";
     DBWriter writer(outDb.c_str(), (outDb + std::string(".index")).c_str(), threads);
     writer.open();
-    const size_t LINE_BUFFER_SIZE = 1000000;
 #pragma omp parallel
     {
         int thread_idx = 0;
@@ -36,85 +38,58 @@ void dosubstractresult(std::string leftDb, std::string rightDb, std::string outD
         thread_idx = omp_get_thread_num();
 #endif
 
-        char * lineBuffer = new char[LINE_BUFFER_SIZE];
-        char * key = new char[255];
+        ResultCursor leftCursor(&leftDbr);
+        ResultCursor rightCursor(&rightDbr);
+        // prefilter records have no e-value and are always used
+        Matcher::result_t res;
         std::string minusResultsOutString;
         minusResultsOutString.reserve(maxLineLength);
 #pragma omp  for schedule(dynamic, 10)
         for (size_t id = 0; id < leftDbr.getSize(); id++) {
             std::map<unsigned int, bool> elementLookup;
-            const char *leftData = leftDbr.getData(id);
             unsigned int leftDbKey = leftDbr.getDbKey(id);
 
             // fill element id look up with left side elementLookup
-            {
-                char *data = (char *) leftData;
-                char *entry[255];
-                while (*data != '\0') {
-                    Util::parseKey(data, key);
-                    unsigned int dbKey = std::strtoul(key, NULL, 10);
-                    double evalue = 0.0;
-                    const size_t columns = Util::getWordsOfLine(data, entry, 255);
-                    // its an aln result (parse e-value)
-                    if (columns >= Matcher::ALN_RES_WITH_OUT_BT_COL_CNT) {
-                        evalue = strtod(entry[3], NULL);
-                    }
-                    if(evalue <= evalThreshold){
-                        elementLookup[dbKey] = true;
-                    }
-                    data = Util::skipLine(data);
+            leftCursor.reset(id);
+            while (leftCursor.next(res, false, false)) {
+                if (res.eval <= evalThreshold) {
+                    elementLookup[res.dbKey] = true;
                 }
             }
             // get all data for the leftDbkey from rightDbr
             // check if right ids are in elementsId
-            char *data = rightDbr.getDataByDBKey(leftDbKey);
-            char *entry[255];
-
-            if (data != NULL) {
-                while (*data != '\0') {
-                    Util::parseKey(data, key);
-                    unsigned int element = std::strtoul(key, NULL, 10);
-                    double evalue = 0.0;
-                    const size_t columns = Util::getWordsOfLine(data, entry, 255);
-                    if (columns >= Matcher::ALN_RES_WITH_OUT_BT_COL_CNT) {
-                        evalue = strtod(entry[3], NULL);
-                    }
-                    if(evalue <= evalThreshold) {
-                        elementLookup[element] = false;
+            const size_t rightId = rightDbr.getId(leftDbKey);
+            if (rightId != UINT_MAX) {
+                rightCursor.reset(rightId);
+                while (rightCursor.next(res, false, false)) {
+                    if (res.eval <= evalThreshold) {
+                        elementLookup[res.dbKey] = false;
                     }
-                    data = Util::skipLine(data);
                 }
             }
             // write only elementLookup that are not found in rightDbr (id != UINT_MAX)
-            {
-                char *data = (char *) leftData;
-                size_t dataLength = leftDbr.getSeqLens(id);
-
-                while (*data != '\0') {
-                    Util::parseKey(data, key);
-                    if (!Util::getLine(data, dataLength, lineBuffer, LINE_BUFFER_SIZE)) {
-                        Debug(Debug::WARNING) << "Warning: Identifier was too long and was cut off!\n";
-                        data = Util::skipLine(data);
-                        continue;
-                    }
-                    unsigned int elementIdx = std::strtoul(key, NULL, 10);
-                    if (elementLookup[elementIdx]) {
-                        minusResultsOutString.append(lineBuffer);
+            leftCursor.reset(id);
+            unsigned int elementKey;
+            char *recordStart = leftCursor.getPosition();
+            while (leftCursor.nextKey(elementKey)) {
+                char *recordEnd = leftCursor.getPosition();
+                if (elementLookup[elementKey]) {
+                    minusResultsOutString.append(recordStart, recordEnd - recordStart);
+                    // the last text line of an entry may lack its line break
+                    if (binary == false && recordEnd[-1] != '\n') {
                         minusResultsOutString.append("\n");
                     }
-                    data = Util::skipLine(data);
                 }
+                recordStart = recordEnd;
             }
-            
+
             // write result
             char *mergeResultsOutData = (char *) minusResultsOutString.c_str();
             writer.writeData(mergeResultsOutData, minusResultsOutString.length(), leftDbKey, thread_idx);
             minusResultsOutString.clear();
         }
-        delete [] lineBuffer;
-        delete [] key;
     }
-    writer.close();
+    writer.close(binary ? Sequence::ALIGNMENT_RES_BINARY : -1);
 
     leftDbr.close();
     rightDbr.close();
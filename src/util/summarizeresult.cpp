@@ -5,6 +5,7 @@
 #include "DBWriter.h"
 #include "MathUtil.h"
 #include "Matcher.h"
+#include "ResultCursor.h"
 
 #ifdef OPENMP
 #include <omp.h>
@@ -36,6 +37,8 @@ int doSummarize(Parameters &par, DBReader<unsigned int> &resultReader,
         localThreads = resultReader.getSize();
     }
 
+    // the kept results are written in the format of the input
+    const bool binary = resultReader.getDbtype() == Sequence::ALIGNMENT_RES_BINARY;
     Debug(Debug::INFO) << "Start writing to file " << resultdb.first << "\n";
     DBWriter writer(resultdb.first.c_str(), resultdb.second.c_str(), localThreads);
     writer.open();
@@ -47,6 +50,8 @@ int doSummarize(Parameters &par, DBReader<unsigned int> &resultReader,
 #endif
         char buffer[32768];
 
+        ResultCursor cursor(&resultReader);
+        Matcher::result_t result;
         std::vector<Matcher::result_t> alnResults;
         alnResults.reserve(300);
 
@@ -58,8 +63,10 @@ int doSummarize(Parameters &par, DBReader<unsigned int> &resultReader,
             Debug::printProgress(i);
 
             unsigned int id = resultReader.getDbKey(i);
-            char *tabData = resultReader.getData(i);
-            Matcher::readAlignmentResults(alnResults, tabData);
+            cursor.reset(i);
+            while (cursor.next(result)) {
+                alnResults.push_back(result);
+            }
             if (alnResults.size() == 0) {
                 Debug(Debug::WARNING) << "Could not map any alingment results for entry " << id << "!\n";
                 continue;
@@ -90,7 +97,8 @@ int doSummarize(Parameters &par, DBReader<unsigned int> &resultReader,
                     for (int j = domain.qStartPos; j < domain.qEndPos; ++j) {
                         covered[j] = true;
                     }
-                    size_t len = Matcher::resultToBuffer(buffer, domain, par.addBacktrace);
+                    size_t len = binary ? Matcher::resultToBinaryBuffer(buffer, domain, par.addBacktrace)
+                                        : Matcher::resultToBuffer(buffer, domain, par.addBacktrace);
                     annotation.append(buffer, len);
                 }
             }
@@ -110,6 +118,7 @@ int doSummarize(Parameters &par, const unsigned int mpiRank, const unsigned int
     DBReader<unsigned int> reader(par.db1.c_str(), par.db1Index.c_str());
     reader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
 
+    const int dbType = reader.getDbtype();
     size_t dbFrom = 0;
     size_t dbSize = 0;
     Util::decomposeDomainByAminoAcid(reader.getAminoAcidDBSize(), reader.getSeqLens(), reader.getSize(),
@@ -131,6 +140,9 @@ int doSummarize(Parameters &par, const unsigned int mpiRank, const unsigned int
             splitFiles.push_back(std::make_pair(tmpFile.first, tmpFile.second));
         }
         DBWriter::mergeResults(par.db2, par.db2Index, splitFiles);
+        if (dbType == Sequence::ALIGNMENT_RES_BINARY) {
+            DBWriter::writeDbtypeFile(par.db2.c_str(), dbType);
+        }
     }
     return status;
 }
@@ -140,6 +152,9 @@ int doSummarize(Parameters &par) {
     reader.open(DBReader<unsigned int>::LINEAR_ACCCESS);
     size_t resultSize = reader.getSize();
     int status = doSummarize(par, reader, std::make_pair(par.db2, par.db2Index), 0, resultSize);
+    if (reader.getDbtype() == Sequence::ALIGNMENT_RES_BINARY) {
+        DBWriter::writeDbtypeFile(par.db2.c_str(), reader.getDbtype());
+    }
     reader.close();
     return status;
 }
@@ -2,6 +2,7 @@
 #include "SubstitutionMatrix.h"
 #include "DBReader.h"
 #include "DBWriter.h"
+#include "ResultCursor.h"
 #include "Debug.h"
 #include "Util.h"
 #include "QueryMatcher.h"
@@ -91,16 +92,15 @@ int doswap(Parameters& par, bool isGeneralMode) {
         //search for the maxTargetId (value of first column) in parallel
 #pragma omp parallel
         {
-            char key[255];
+            ResultCursor cursor(false);
 #pragma omp for schedule(dynamic, 100) reduction(max:maxTargetId)
             for (size_t i = 0; i < resultReader.getSize(); ++i) {
                 Debug::printProgress(i);
                 char *data = resultReader.getData(i);
-                while (*data != '\0') {
-                    Util::parseKey(data, key);
-                    unsigned int dbKey = std::strtoul(key, NULL, 10);
+                cursor.reset(data, strlen(data));
+                unsigned int dbKey;
+                while (cursor.nextKey(dbKey)) {
                     maxTargetId = std::max(maxTargetId, dbKey);
-                    data = Util::skipLine(data);
                 }
             }
         };
@@ -128,31 +128,37 @@ int doswap(Parameters& par, bool isGeneralMode) {
     Debug(Debug::INFO) << "Result database: " << parResultDbStr << "\n";
     DBReader<unsigned int> resultDbr(parResultDb, parResultDbIndex);
     resultDbr.open(DBReader<unsigned int>::LINEAR_ACCCESS);
+    // binary records keep their size when the key is swapped
+    const bool binaryInput = (isGeneralMode == false && resultDbr.getDbtype() == Sequence::ALIGNMENT_RES_BINARY);
 
     const size_t resultSize = resultDbr.getSize();
     Debug(Debug::INFO) << "Computing offsets.\n";
     size_t *targetElementSize = new size_t[maxTargetId + 2]; // extra element for offset + 1 index id
     memset(targetElementSize, 0, sizeof(size_t) * (maxTargetId + 2));
-#pragma omp parallel for schedule(dynamic, 100)
-    for (size_t i = 0; i < resultSize; ++i) {
-        Debug::printProgress(i);
-        const unsigned int resultId = resultDbr.getDbKey(i);
-        char queryKeyStr[1024];
-        char *tmpBuff = Itoa::u32toa_sse2((uint32_t) resultId, queryKeyStr);
-        *(tmpBuff) = '\0';
-        size_t queryKeyLen = strlen(queryKeyStr);
-        char *data = resultDbr.getData(i);
-        char dbKeyBuffer[255 + 1];
-        while (*data != '\0') {
-            Util::parseKey(data, dbKeyBuffer);
-            size_t targetKeyLen = strlen(dbKeyBuffer);
-            const unsigned int dbKey = (unsigned int) strtoul(dbKeyBuffer, NULL, 10);
-            char *nextLine = Util::skipLine(data);
-            size_t lineLen = nextLine - data;
-            lineLen -= targetKeyLen;
-            lineLen += queryKeyLen;
-            __sync_fetch_and_add(&(targetElementSize[dbKey]), lineLen);
-            data = nextLine;
+#pragma omp parallel
+    {
+        ResultCursor cursor(binaryInput);
+#pragma omp for schedule(dynamic, 100)
+        for (size_t i = 0; i < resultSize; ++i) {
+            Debug::printProgress(i);
+            const unsigned int resultId = resultDbr.getDbKey(i);
+            char queryKeyStr[1024];
+            char *tmpBuff = Itoa::u32toa_sse2((uint32_t) resultId, queryKeyStr);
+            *(tmpBuff) = '\0';
+            size_t queryKeyLen = strlen(queryKeyStr);
+            cursor.reset(resultDbr.getData(i), resultDbr.getSeqLens(i) - 1);
+            char *record = cursor.getPosition();
+            unsigned int dbKey;
+            while (cursor.nextKey(dbKey)) {
+                size_t recordLen = cursor.getPosition() - record;
+                if (binaryInput == false) {
+                    // the key of the text line is replaced by the query key
+                    recordLen -= Util::skipNoneWhitespace(record);
+                    recordLen += queryKeyLen;
+                }
+                __sync_fetch_and_add(&(targetElementSize[dbKey]), recordLen);
+                record = cursor.getPosition();
+            }
         }
     }
 
@@ -186,32 +192,43 @@ int doswap(Parameters& par, bool isGeneralMode) {
         char *tmpData = new char[bytesToWrite];
         Util::checkAllocation(tmpData, "Could not allocate tmpData memory in doswap");
         Debug(Debug::INFO) << "\nReading results.\n";
-#pragma omp parallel for schedule(dynamic, 10)
-        for (size_t i = 0; i < resultSize; ++i) {
-            Debug::printProgress(i);
-            char *data = resultDbr.getData(i);
-            unsigned int queryKey = resultDbr.getDbKey(i);
-            char queryKeyStr[1024];
-            char *tmpBuff = Itoa::u32toa_sse2((uint32_t) queryKey, queryKeyStr);
-            *(tmpBuff) = '\0';
-            size_t queryKeyLen = strlen(queryKeyStr);
-            char dbKeyBuffer[255 + 1];
-            while (*data != '\0') {
-                Util::parseKey(data, dbKeyBuffer);
-                size_t targetKeyLen = strlen(dbKeyBuffer);
-                char *nextLine = Util::skipLine(data);
-                size_t oldLineLen = nextLine - data;
-                size_t newLineLen = oldLineLen;
-                newLineLen -= targetKeyLen;
-                newLineLen += queryKeyLen;
-                const unsigned int dbKey = (unsigned int) strtoul(dbKeyBuffer, NULL, 10);
-                // update offset but do not copy memory
-                size_t offset = __sync_fetch_and_add(&(targetElementSize[dbKey]), newLineLen) - prevBytesToWrite;
-                if(dbKey >= prevDbKeyToWrite && dbKey <=  dbKeyToWrite){
-                    memcpy(&tmpData[offset], queryKeyStr, queryKeyLen);
-                    memcpy(&tmpData[offset + queryKeyLen], data + targetKeyLen, oldLineLen - targetKeyLen);
+#pragma omp parallel
+        {
+            ResultCursor cursor(binaryInput);
+#pragma omp for schedule(dynamic, 10)
+            for (size_t i = 0; i < resultSize; ++i) {
+                Debug::printProgress(i);
+                unsigned int queryKey = resultDbr.getDbKey(i);
+                char queryKeyStr[1024];
+                char *tmpBuff = Itoa::u32toa_sse2((uint32_t) queryKey, queryKeyStr);
+                *(tmpBuff) = '\0';
+                size_t queryKeyLen = strlen(queryKeyStr);
+                cursor.reset(resultDbr.getData(i), resultDbr.getSeqLens(i) - 1);
+                char *record = cursor.getPosition();
+                unsigned int dbKey;
+                while (cursor.nextKey(dbKey)) {
+                    const size_t oldRecordLen = cursor.getPosition() - record;
+                    if (binaryInput) {
+                        size_t offset = __sync_fetch_and_add(&(targetElementSize[dbKey]), oldRecordLen) - prevBytesToWrite;
+                        if (dbKey >= prevDbKeyToWrite && dbKey <= dbKeyToWrite) {
+                            // binary records keep their size, only the key is swapped
+                            memcpy(&tmpData[offset], record, oldRecordLen);
+                            memcpy(&tmpData[offset + offsetof(Matcher::binary_result_t, dbKey)], &queryKey, sizeof(unsigned int));
+                        }
+                    } else {
+                        const size_t targetKeyLen = Util::skipNoneWhitespace(record);
+                        size_t newRecordLen = oldRecordLen;
+                        newRecordLen -= targetKeyLen;
+                        newRecordLen += queryKeyLen;
+                        // update offset but do not copy memory
+                        size_t offset = __sync_fetch_and_add(&(targetElementSize[dbKey]), newRecordLen) - prevBytesToWrite;
+                        if (dbKey >= prevDbKeyToWrite && dbKey <= dbKeyToWrite) {
+                            memcpy(&tmpData[offset], queryKeyStr, queryKeyLen);
+                            memcpy(&tmpData[offset + queryKeyLen], record + targetKeyLen, oldRecordLen - targetKeyLen);
+                        }
+                    }
+                    record = cursor.getPosition();
                 }
-                data = nextLine;
             }
         }
         //revert offsets
@@ -224,7 +241,11 @@ int doswap(Parameters& par, bool isGeneralMode) {
         char *entry[255];
         bool isAlignmentResult = false;
         bool hasBacktrace = false;
-        for (size_t i = 0; i < resultDbr.getSize(); i++){
+        if (binaryInput) {
+            isAlignmentResult = true;
+            hasBacktrace = true;
+        }
+        for (size_t i = 0; binaryInput == false && i < resultDbr.getSize(); i++){
             if (resultDbr.getSeqLens(i) <= 1){
                 continue;
             }
@@ -250,6 +271,7 @@ int doswap(Parameters& par, bool isGeneralMode) {
             // qcov is used for pScore because its the first float value
             // and alnLength for diagonal because its the first int value after
             std::vector<Matcher::result_t> curRes;
+            ResultCursor cursor(binaryInput);
             char buffer[1024+32768];
             std::string ss;
             ss.reserve(100000);
@@ -269,14 +291,15 @@ int doswap(Parameters& par, bool isGeneralMode) {
                 }
 
                 bool evalBreak = false;
-                while (dataSize > 0) {
-                    if (isAlignmentResult) {
-                        Matcher::result_t res = Matcher::parseAlignmentRecord(data, true);
+                cursor.reset(data, dataSize);
+                if (isAlignmentResult) {
+                    Matcher::result_t res;
+                    while (cursor.next(res, true)) {
                         double rawScore = evaluer.computeRawScoreFromBitScore(res.score);
                         res.eval = evaluer.computeEvalue(rawScore, res.dbLen);
                         if (res.eval > par.evalThr) {
                             evalBreak = true;
-                            goto outer;
+                            continue;
                         }
                         unsigned int qstart = res.qStartPos;
                         unsigned int qend = res.qEndPos;
@@ -297,16 +320,13 @@ int doswap(Parameters& par, bool isGeneralMode) {
                             }
                         }
                         curRes.emplace_back(res);
-                    } else {
-                        hit_t hit = QueryMatcher::parsePrefilterHit(data);
+                    }
+                } else {
+                    hit_t hit;
+                    while (cursor.next(hit)) {
                         hit.diagonal = static_cast<unsigned short>(static_cast<short>(hit.diagonal) * -1);
                         curRes.emplace_back(hit.seqId, 0, hit.pScore, 0, 0, -hit.pScore, hit.diagonal, 0, 0, 0, 0, 0, 0, "");
                     }
-                    outer:
-                    char *nextLine = Util::skipLine(data);
-                    size_t lineLen = nextLine - data;
-                    dataSize -= lineLen;
-                    data = nextLine;
                 }
 
                 if (curRes.empty() == false) {
@@ -316,7 +336,10 @@ int doswap(Parameters& par, bool isGeneralMode) {
 
                     for (size_t j = 0; j < curRes.size(); j++) {
                         const Matcher::result_t &res = curRes[j];
-                        if (isAlignmentResult) {
+                        if (binaryInput) {
+                            size_t len = Matcher::resultToBinaryBuffer(buffer, res, hasBacktrace, false);
+                            ss.append(buffer, len);
+                        } else if (isAlignmentResult) {
                             size_t len = Matcher::resultToBuffer(buffer, res, hasBacktrace, false);
                             ss.append(buffer, len);
                         } else {
@@ -346,6 +369,9 @@ int doswap(Parameters& par, bool isGeneralMode) {
         delete[] tmpData;
     }
     DBWriter::mergeResults(parOutDbStr, parOutDbIndexStr, splitFileNames);
+    if (binaryInput) {
+        DBWriter::writeDbtypeFile(parOutDbStr.c_str(), Sequence::ALIGNMENT_RES_BINARY);
+    }
 
     resultDbr.close();
     if (targetElementExists != NULL) {
@@ -76,6 +76,13 @@ int search(int argc, const char **argv, const Command& command) {
         EXIT(EXIT_FAILURE);
     }
 
+    // the sliced target-profile search sorts and truncates the alignment results with filterdb
+    if (par.binaryResult && targetDbType == Sequence::HMM_PROFILE && par.sliceSearch) {
+        par.printUsageMessage(command, MMseqsParameter::COMMAND_ALIGN|MMseqsParameter::COMMAND_PREFILTER);
+        Debug(Debug::ERROR) << "Cannot write binary results in a sliced target-profile search.\n";
+        EXIT(EXIT_FAILURE);
+    }
+
     // validate and set parameters for iterative search
     if (par.numIterations > 1) {
         if (targetDbType == Sequence::HMM_PROFILE) {